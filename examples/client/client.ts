@@ -1,136 +1,166 @@
 class MCPClient {
-    constructor(url) {
-        this.url = url;
-        this.ws = null;
+    constructor(baseUrl) {
+        this.baseUrl = baseUrl;
+        this.endpoint = baseUrl + '/mcp';
         this.requestId = 1;
-        this.callbacks = new Map();
+        this.events = null;
         this.subscriptions = new Map();
-        this.reconnectAttempts = 0;
-        this.maxReconnectAttempts = 5;
-        this.reconnectDelay = 1000;
-        this.heartbeatInterval = null;
+        this.toolsEtag = null;
+        this.tools = null;
+        this.requestTimeout = 5000;
     }
-    
-    connect() {
-        return new Promise((resolve, reject) => {
-            this.ws = new WebSocket(this.url);
-            
-            this.ws.onopen = () => {
-                console.log('Connected to MCP server');
-                this.reconnectAttempts = 0;
-                this.startHeartbeat();
-                this.initialize().then(resolve).catch(reject);
-            };
-            
-            this.ws.onmessage = (event) => {
-                try {
-                    const message = JSON.parse(event.data);
-                    this.handleMessage(message);
-                } catch (error) {
-                    console.error('Error parsing message:', error);
-                }
-            };
-            
-            this.ws.onclose = () => {
-                console.log('Connection closed');
-                this.stopHeartbeat();
-                this.handleReconnect();
-            };
-            
-            this.ws.onerror = (error) => {
-                console.error('WebSocket error:', error);
-                reject(error);
-            };
-        });
+
+    async connect() {
+        const response = await this.initialize();
+        console.log('Connected to MCP server:', response.result.serverInfo);
+        return response;
     }
-    
+
     disconnect() {
-        if (this.ws) {
-            this.ws.close();
-            this.stopHeartbeat();
+        if (this.events) {
+            this.events.close();
+            this.events = null;
         }
+        this.subscriptions.clear();
+        this.endpoint = this.baseUrl + '/mcp';
     }
-    
-    async initialize() {
-        const response = await this.sendRequest('initialize', {});
-        console.log('Server initialized:', response);
-        return response;
+
+    initialize() {
+        return this.sendRequest('initialize', {});
+    }
+
+    // Polls GET /mcp/tools; the server answers 304 while the tool set is unchanged
+    async listTools() {
+        const headers = {};
+        if (this.toolsEtag) {
+            headers['If-None-Match'] = this.toolsEtag;
+        }
+        const response = await fetch(this.baseUrl + '/mcp/tools', { headers });
+        if (response.status === 304) {
+            return this.tools;
+        }
+        if (!response.ok) {
+            throw new Error(`tools request failed: HTTP ${response.status}`);
+        }
+        this.toolsEtag = response.headers.get('ETag');
+        this.tools = (await response.json()).tools;
+        return this.tools;
+    }
+
+    async callTool(name, args = {}) {
+        const response = await this.sendRequest('tools/call', { name, arguments: args });
+        return JSON.parse(response.result.content[0].text);
+    }
+
+    // Runs the calls in order in one round trip, e.g.
+    // [['turnOn', {}], ['setMode', {mode: 1}], ['setTemperature', {temperature: 24}]]
+    async callTools(calls) {
+        const batch = calls.map(([name, args]) => this.message('tools/call', { name, arguments: args || {} }));
+        const replies = await this.post(batch);
+        const byId = new Map(replies.map((reply) => [reply.id, reply]));
+        return batch.map((request) => {
+            const reply = byId.get(request.id);
+            if (reply.error) {
+                throw new Error(reply.error.message);
+            }
+            return JSON.parse(reply.result.content[0].text);
+        });
     }
-    
+
     async listResources() {
         const response = await this.sendRequest('resources/list', {});
-        return response.result.data.resources;
+        return response.result.resources;
     }
-    
+
     async readResource(uri) {
         const response = await this.sendRequest('resources/read', { uri });
-        return response.result.data;
+        return response.result;
     }
-    
+
+    // Updates arrive on the event stream, which is opened on first use
     async subscribe(uri, callback) {
-        const response = await this.sendRequest('resources/subscribe', { uri });
-        if (response.result.success) {
-            this.subscriptions.set(uri, callback);
-        }
-        return response.result.success;
+        await this.openEvents();
+        await this.sendRequest('resources/subscribe', { uri });
+        this.subscriptions.set(uri, callback);
+        return true;
     }
-    
+
     async unsubscribe(uri) {
-        const response = await this.sendRequest('resources/unsubscribe', { uri });
-        if (response.result.success) {
-            this.subscriptions.delete(uri);
-        }
-        return response.result.success;
+        await this.sendRequest('resources/unsubscribe', { uri });
+        this.subscriptions.delete(uri);
+        return true;
     }
-    
-    sendRequest(method, params) {
+
+    // The first event names the endpoint to post to, with this stream's session id
+    openEvents() {
+        if (this.events) {
+            return Promise.resolve();
+        }
         return new Promise((resolve, reject) => {
-            if (!this.ws || this.ws.readyState !== WebSocket.OPEN) {
-                reject(new Error('WebSocket is not connected'));
-                return;
-            }
-            
-            const id = this.requestId++;
-            const request = {
-                jsonrpc: '2.0',
-                method: method,
-                params: params,
-                id: id
-            };
-            
-            this.callbacks.set(id, { resolve, reject });
-            this.ws.send(JSON.stringify(request));
-            
-            // Set timeout for request
-            setTimeout(() => {
-                if (this.callbacks.has(id)) {
-                    this.callbacks.delete(id);
-                    reject(new Error('Request timeout'));
+            this.events = new EventSource(this.baseUrl + '/mcp/events');
+
+            this.events.addEventListener('endpoint', (event) => {
+                this.endpoint = this.baseUrl + event.data;
+                resolve();
+            });
+
+            this.events.addEventListener('message', (event) => {
+                try {
+                    this.handleNotification(JSON.parse(event.data));
+                } catch (error) {
+                    console.error('Error parsing event:', error);
                 }
-            }, 5000);
+            });
+
+            this.events.onerror = (error) => {
+                // The session and its subscriptions end with the stream
+                console.error('Event stream error:', error);
+                this.disconnect();
+                reject(error);
+            };
         });
     }
-    
-    handleMessage(message) {
-        // Handle notifications
-        if (message.method && message.method.startsWith('notifications/')) {
-            this.handleNotification(message);
-            return;
+
+    message(method, params) {
+        return {
+            jsonrpc: '2.0',
+            method: method,
+            params: params,
+            id: this.requestId++
+        };
+    }
+
+    async sendRequest(method, params) {
+        const response = await this.post(this.message(method, params));
+        if (response.error) {
+            throw new Error(response.error.message);
         }
-        
-        // Handle responses
-        if (message.id && this.callbacks.has(message.id)) {
-            const { resolve, reject } = this.callbacks.get(message.id);
-            this.callbacks.delete(message.id);
-            
-            if (message.error) {
-                reject(new Error(message.error.message));
-            } else {
-                resolve(message);
+        return response;
+    }
+
+    async post(body) {
+        const controller = new AbortController();
+        const timer = setTimeout(() => controller.abort(), this.requestTimeout);
+        try {
+            const response = await fetch(this.endpoint, {
+                method: 'POST',
+                headers: { 'Content-Type': 'application/json' },
+                body: JSON.stringify(body),
+                signal: controller.signal
+            });
+            if (response.status === 429 || response.status === 503) {
+                const retryAfter = response.headers.get('Retry-After');
+                throw new Error(`Server busy (HTTP ${response.status})` + (retryAfter ? `, retry in ${retryAfter}s` : ''));
+            }
+            if (response.status === 202) {
+                return null;   // Notifications only
             }
+            return await response.json();
+        } finally {
+            clearTimeout(timer);
         }
     }
-    
+
     handleNotification(message) {
         if (message.method === 'notifications/resources/updated') {
             const uri = message.params.uri;
@@ -140,58 +170,35 @@ class MCPClient {
             }
         }
     }
-    
-    handleReconnect() {
-        if (this.reconnectAttempts >= this.maxReconnectAttempts) {
-            console.error('Max reconnection attempts reached');
-            return;
-        }
-        
-        this.reconnectAttempts++;
-        const delay = this.reconnectDelay * Math.pow(2, this.reconnectAttempts - 1);
-        
-        console.log(`Reconnecting in ${delay}ms (attempt ${this.reconnectAttempts})`);
-        setTimeout(() => this.connect(), delay);
-    }
-    
-    startHeartbeat() {
-        this.heartbeatInterval = setInterval(() => {
-            if (this.ws && this.ws.readyState === WebSocket.OPEN) {
-                this.ws.send(JSON.stringify({ type: 'ping' }));
-            }
-        }, 30000);
-    }
-    
-    stopHeartbeat() {
-        if (this.heartbeatInterval) {
-            clearInterval(this.heartbeatInterval);
-            this.heartbeatInterval = null;
-        }
-    }
 }
 
 // Example usage:
 async function connectToMCP() {
-    const client = new MCPClient('ws://your-esp32-ip:9000');
-    
+    const client = new MCPClient('http://your-esp32-ip:9000');
+
     try {
-        // Connect and initialize
+        // Initialize
         await client.connect();
-        
-        // List available resources
+
+        // List available tools and resources
+        const tools = await client.listTools();
+        console.log('Available tools:', tools.map((tool) => tool.name));
         const resources = await client.listResources();
         console.log('Available resources:', resources);
-        
-        // Subscribe to system info updates
-        await client.subscribe('system://info', (data) => {
-            console.log('System info updated:', data);
+
+        // Turn on, cool, 24°C in one request
+        await client.callTools([['turnOn', {}], ['setMode', { mode: 1 }], ['setTemperature', { temperature: 24 }]]);
+
+        // Get notified when the AC state changes
+        await client.subscribe('ac://state', (data) => {
+            console.log('AC state updated:', data);
         });
-        
-        // Read current network status
-        const networkStatus = await client.readResource('system://network');
-        console.log('Network status:', networkStatus);
-        
+
+        // Read the current state
+        const status = await client.callTool('getStatus');
+        console.log('AC status:', status);
+
     } catch (error) {
         console.error('Error:', error);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,134 @@
+#ifndef AC_RESULT_H
+#define AC_RESULT_H
+
+#include <ArduinoJson.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 空调操作结果码
+enum ACResultCode {
+    AC_OK = 0,                  // 成功
+    AC_ERR_INVALID_MODE,        // 无效的空调模式
+    AC_ERR_TEMPERATURE_RANGE,   // 温度超出范围
+    AC_ERR_NOT_RUNNING,         // 空调未开启
+    AC_ERR_UNKNOWN_DEVICE,      // 没有该设备
+    AC_ERR_INVALID_SCHEDULE,    // 无效的定时设置
+    AC_ERR_SCHEDULE_FULL,       // 定时任务已满
+    AC_ERR_UNKNOWN_SCHEDULE     // 没有该定时任务
+};
+
+// 空调工作模式枚举
+enum ACMode {
+    AC_MODE_AUTO = 0,        // 自动模式
+    AC_MODE_COOL = 1,        // 制冷模式
+    AC_MODE_HEAT = 2,        // 制热模式
+    AC_MODE_DEHUMIDIFY = 3   // 抽湿模式
+};
+
+// 空调状态快照
+struct ACState {
+    bool running;       // 工作状态
+    int mode;           // 工作模式 (ACMode)
+    int temperature;    // 设定温度
+    uint32_t version;   // 状态版本号，每次状态变化递增
+};
+
+/**
+ * 空调操作结果
+ * 由 AirConditioner 直接返回，工具处理函数将其写入响应文档，
+ * 不再经过 JSON 字符串拼接和解析
+ */
+struct ACResult {
+    ACResultCode error;
+    ACState state;      // 操作后的状态
+
+    bool ok() const { return error == AC_OK; }
+    int code() const { return ok() ? 0 : 1; }   // 协议状态码: 0 成功, 1 失败
+};
+
+// 工作模式名称 (静态字符串)
+inline const char* acModeName(int mode) {
+    switch (mode) {
+        case 0: return "auto";
+        case 1: return "cool";
+        case 2: return "heat";
+        case 3: return "humdify";
+        default: return "unknown";
+    }
+}
+
+// 错误提示信息 (静态字符串)
+inline const char* acErrorMessage(ACResultCode error) {
+    switch (error) {
+        case AC_ERR_INVALID_MODE: return "无效的空调模式";
+        case AC_ERR_TEMPERATURE_RANGE: return "温度超出范围";
+        case AC_ERR_NOT_RUNNING: return "空调未开启，请先开启空调";
+        case AC_ERR_UNKNOWN_DEVICE: return "未知的空调设备";
+        case AC_ERR_INVALID_SCHEDULE: return "无效的定时设置";
+        case AC_ERR_SCHEDULE_FULL: return "定时任务已满";
+        case AC_ERR_UNKNOWN_SCHEDULE: return "没有该定时任务";
+        default: return "";
+    }
+}
+
+/*
+    写入失败结果 (未执行操作时，如设备不存在)
+    输出：
+        code: 1
+        msg: 错误信息
+*/
+inline void writeErrorResult(ACResultCode error, JsonObject out) {
+    out["code"] = 1;
+    out["msg"] = acErrorMessage(error);
+}
+
+/*
+    写入 setMode 结果
+    输出：
+        code: 状态码，0表示成功，1表示失败
+        msg: 结果信息
+*/
+inline void writeModeResult(const ACResult& result, JsonObject out) {
+    out["code"] = result.code();
+    if (!result.ok()) {
+        out["msg"] = acErrorMessage(result.error);
+        return;
+    }
+    char msg[64];
+    snprintf(msg, sizeof(msg), "空调模式已设置为: %s", acModeName(result.state.mode));
+    out["msg"] = msg;
+}
+
+/*
+    写入 setTemperature 结果
+    输出：
+        code: 状态码，0表示成功，1表示失败
+        msg: 结果信息
+*/
+inline void writeTemperatureResult(const ACResult& result, JsonObject out) {
+    out["code"] = result.code();
+    if (!result.ok()) {
+        out["msg"] = acErrorMessage(result.error);
+        return;
+    }
+    char msg[64];
+    snprintf(msg, sizeof(msg), "空调温度已设置为: %d°C", result.state.temperature);
+    out["msg"] = msg;
+}
+
+/*
+    写入空调状态
+    输出：
+        running: true 为开机状态, false 为关机状态
+        mode: 空调工作模式，0表示自动，1表示制冷，2表示制热，3表示抽湿
+        modeString: 工作模式名称
+        temperature: 空调目标温度
+*/
+inline void writeACState(const ACState& state, JsonObject out) {
+    out["running"] = state.running;
+    out["mode"] = state.mode;
+    out["modeString"] = acModeName(state.mode);
+    out["temperature"] = state.temperature;
+}
+
+#endif // AC_RESULT_H
@@ -0,0 +1,267 @@
+#ifndef AC_SCHEDULER_H
+#define AC_SCHEDULER_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "ACResult.h"
+#include "TimerWheel.h"
+
+// 定时任务的电源动作
+enum ACSchedulePower {
+    AC_POWER_KEEP = 0,      // 不改变开关状态
+    AC_POWER_ON = 1,        // 开机
+    AC_POWER_OFF = 2        // 关机
+};
+
+/**
+ * 空调定时任务，例如 "每天 18:00 制冷 24°C"、"工作日 23:00 关机"
+ * 时间为本地时间；开机、模式、温度可以组合，关机时不能同时设置模式或温度。
+ * 不带开机的模式、温度只在设备运行时生效，设备关机时执行失败 (见 failures())
+ */
+struct ACSchedule {
+    static const size_t DEVICE_ID_SIZE = 16;
+
+    uint32_t id;                    // 由 ACScheduler::add 分配
+    char device[DEVICE_ID_SIZE];    // 设备ID (最长 15 个字符)
+    uint16_t minuteOfDay;           // 执行时间: 0-1439 (本地时间)
+    uint8_t days;                   // 星期掩码: bit0 周日 ... bit6 周六; 0 表示只执行一次
+    uint8_t power;                  // ACSchedulePower
+    int8_t mode;                    // 工作模式，-1 表示不修改
+    int8_t temperature;             // 设定温度，0 表示不修改
+};
+
+/**
+ * 定时任务使用的时钟
+ * 返回本地时间的秒数 (从 1970-01-01 本地零点起算)，时区和夏令时已计入
+ */
+class ScheduleClock {
+public:
+    virtual ~ScheduleClock() = default;
+
+    /**
+     * @return 时间尚未同步 (例如 NTP 未完成) 时返回 false
+     */
+    virtual bool now(uint32_t& localSeconds) = 0;
+
+    // 公历日期时间 -> 本地秒数
+    static uint32_t fromCivil(int year, int month, int day, int hour, int minute, int second);
+};
+
+/**
+ * 主机替身: 测试手动设置和拨动时间
+ */
+class VirtualClock : public ScheduleClock {
+public:
+    VirtualClock() : seconds(0), valid(false) {}
+
+    void set(uint32_t localSeconds) {
+        seconds = localSeconds;
+        valid = true;
+    }
+    void advance(uint32_t delta) { seconds += delta; }
+    void invalidate() { valid = false; }
+
+    bool now(uint32_t& localSeconds) override {
+        localSeconds = seconds;
+        return valid;
+    }
+
+private:
+    uint32_t seconds;
+    bool valid;
+};
+
+#ifdef ARDUINO
+/**
+ * 设备时钟: 系统时间 (NTP 同步) 按 TZ 转换为本地时间
+ */
+class SystemScheduleClock : public ScheduleClock {
+public:
+    bool now(uint32_t& localSeconds) override;
+};
+#endif
+
+/**
+ * 定时任务文件的存储
+ */
+class ScheduleStore {
+public:
+    virtual ~ScheduleStore() = default;
+
+    /**
+     * @return 文件不存在时返回 false
+     */
+    virtual bool load(std::vector<uint8_t>& data) = 0;
+
+    /**
+     * 整体替换文件内容
+     */
+    virtual bool save(const std::vector<uint8_t>& data) = 0;
+};
+
+/**
+ * 主机替身: 文件内容保存在内存中
+ */
+class MemoryScheduleStore : public ScheduleStore {
+public:
+    MemoryScheduleStore() : present(false), saveCount(0) {}
+
+    bool load(std::vector<uint8_t>& out) override {
+        out = data;
+        return present;
+    }
+    bool save(const std::vector<uint8_t>& in) override {
+        data = in;
+        present = true;
+        saveCount++;
+        return true;
+    }
+
+    std::vector<uint8_t>& contents() { return data; }
+    uint32_t saves() const { return saveCount; }
+
+private:
+    std::vector<uint8_t> data;
+    bool present;
+    uint32_t saveCount;
+};
+
+#ifdef ARDUINO
+/**
+ * 设备端存储: LittleFS 文件 /schedules.bin，先写临时文件再改名替换
+ */
+class LittleFSScheduleStore : public ScheduleStore {
+public:
+    bool load(std::vector<uint8_t>& data) override;
+    bool save(const std::vector<uint8_t>& data) override;
+};
+#endif
+
+/**
+ * 空调定时任务调度
+ *
+ * 每个任务在分层时间轮 (mcp::TimerWheel，1 秒一格) 中只有一个定时器，
+ * 指向它的下一次执行时间；添加、删除、到期都是 O(1)。主循环调用 run()，
+ * 代价只与经过的秒数和到期的任务数有关，不会逐个检查任务。
+ * 周期任务执行后按星期掩码排到下一次，只执行一次的任务执行后删除
+ *
+ * 时钟未同步时不排程；时钟回拨或前跳超过 MAX_CATCH_UP_S 时重新排程，
+ * 错过的任务不补执行 (夏令时前跳一小时以内的任务仍会执行)
+ *
+ * 任务列表保存为紧凑的二进制文件: 8 字节文件头, 每个任务 28 字节,
+ * 末尾 CRC32。修改后由 run() 在主循环中保存，不在请求路径上写闪存
+ *
+ * add/remove/list 可在任意任务中调用；动作在 run() 中、释放内部锁后执行
+ */
+class ACScheduler {
+public:
+    static const size_t MAX_SCHEDULES = 256;
+    static const uint32_t MAX_CATCH_UP_S = 3600;
+    static const size_t HEADER_SIZE = 8;
+    static const size_t RECORD_SIZE = 28;
+
+    // 到期任务的执行者 (在调用 run() 的任务中调用)，返回执行结果；
+    // 不是 AC_OK 时计入 failures()
+    using ActionSink = std::function<ACResultCode(const ACSchedule& schedule)>;
+
+    /**
+     * @param store 为空时不保存
+     */
+    explicit ACScheduler(ScheduleClock& clock, ScheduleStore* store = nullptr);
+
+    void setActionSink(ActionSink sink);
+
+    /**
+     * 读取保存的任务，替换当前任务 (启动时调用)
+     * @return 文件不存在或损坏时返回 false，任务列表为空
+     */
+    bool load();
+
+    /**
+     * 添加任务，成功时写回分配的 id
+     * @return AC_OK、AC_ERR_INVALID_SCHEDULE 或 AC_ERR_SCHEDULE_FULL
+     */
+    ACResultCode add(ACSchedule& schedule);
+
+    /**
+     * @return 没有该任务时返回 false
+     */
+    bool remove(uint32_t id);
+
+    /**
+     * 当前任务，按执行时间排序
+     * @param device 只列出该设备的任务，为空时列出全部
+     */
+    std::vector<ACSchedule> list(const char* device = nullptr) const;
+
+    /**
+     * 距离下一次执行的秒数
+     * @return 任务不存在或时钟未同步时返回 false
+     */
+    bool nextRunIn(uint32_t id, uint32_t& seconds) const;
+
+    /**
+     * 主循环中调用: 推进时间轮，执行到期任务，保存修改
+     * @return 执行的任务数
+     */
+    size_t run();
+
+    size_t size() const;
+    uint32_t runs() const;
+
+    /**
+     * 执行失败的次数 (例如设备关机时设置模式、设备已不存在)
+     */
+    uint32_t failures() const { return failureCount.load(std::memory_order_relaxed); }
+
+    static bool valid(const ACSchedule& schedule);
+
+    // 下一次执行时间 (本地秒数，严格晚于 localSeconds)
+    static uint32_t nextOccurrence(const ACSchedule& schedule, uint32_t localSeconds);
+
+    // "HH:MM" <-> 一天中的分钟数
+    static bool parseTime(const char* text, uint16_t& minuteOfDay);
+    static void formatTime(uint16_t minuteOfDay, char* out, size_t size);
+
+    // "daily"、"weekdays"、"weekends"、"once" 或 "mon,wed,fri" <-> 星期掩码
+    static bool parseDays(const char* text, uint8_t& days);
+    static void formatDays(uint8_t days, char* out, size_t size);
+
+    static void encode(const std::vector<ACSchedule>& schedules, std::vector<uint8_t>& out);
+    static bool decode(const std::vector<uint8_t>& data, std::vector<ACSchedule>& schedules);
+
+private:
+    struct Entry {
+        ACSchedule schedule;
+        bool used;
+        uint32_t generation;                // 每次占用递增，id = generation << 8 | 槽位
+        mcp::TimerWheel::TimerId timer;
+    };
+
+    // 以下调用方持有锁
+    void arm(size_t slot);
+    void armAll(uint32_t localSeconds);
+    void release(size_t slot);
+    void fire(size_t slot);
+    void collect(std::vector<ACSchedule>& out) const;
+
+    mutable std::mutex mutex;
+    ScheduleClock& clock;
+    ScheduleStore* store;
+    ActionSink sink;
+
+    std::vector<Entry> entries;
+    std::vector<uint16_t> freeSlots;
+    mcp::TimerWheel wheel;      // 载荷为槽位
+    bool armed;                 // 时间轮已按同步后的时钟排程
+    bool dirty;                 // 有尚未保存的修改
+    std::vector<ACSchedule> due;
+    uint32_t runCount;
+    std::atomic<uint32_t> failureCount;     // 在锁外由 run() 更新
+};
+
+#endif // AC_SCHEDULER_H
@@ -0,0 +1,144 @@
+#ifndef AC_STATE_JOURNAL_H
+#define AC_STATE_JOURNAL_H
+
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ACResult.h"
+
+/**
+ * 空调状态日志的存储
+ * 每台设备两个槽位，每个槽位保存一条定长记录；设备端用 LittleFS 文件，
+ * 主机测试用 MemoryJournalStore
+ */
+class ACJournalStore {
+public:
+    virtual ~ACJournalStore() = default;
+
+    /**
+     * 读取槽位中的记录
+     * @return 槽位不存在或长度不足时返回 false
+     */
+    virtual bool read(const char* unitId, int slot, uint8_t* data, size_t size) = 0;
+
+    /**
+     * 整体覆盖槽位中的记录
+     * @return 未完整写入时返回 false
+     */
+    virtual bool write(const char* unitId, int slot, const uint8_t* data, size_t size) = 0;
+};
+
+/**
+ * 主机替身: 记录保存在内存中，测试可以损坏槽位或让写入失败
+ */
+class MemoryJournalStore : public ACJournalStore {
+public:
+    MemoryJournalStore() : writeCount(0), failWrites(false) {}
+
+    bool read(const char* unitId, int slot, uint8_t* data, size_t size) override;
+    bool write(const char* unitId, int slot, const uint8_t* data, size_t size) override;
+
+    // 翻转槽位中的一个字节，模拟写到一半断电
+    bool corrupt(const char* unitId, int slot, size_t offset);
+    void setFailWrites(bool fail) { failWrites = fail; }
+    uint32_t writes() const { return writeCount; }
+
+private:
+    std::map<std::string, std::vector<uint8_t>> slots;  // "设备ID/槽位" -> 记录
+    uint32_t writeCount;
+    bool failWrites;
+};
+
+#ifdef ARDUINO
+/**
+ * 设备端存储: 每个槽位一个 LittleFS 文件 (/ac_<设备ID>_<槽位>.bin)
+ * 调用方需先挂载 LittleFS
+ */
+class LittleFSJournalStore : public ACJournalStore {
+public:
+    bool read(const char* unitId, int slot, uint8_t* data, size_t size) override;
+    bool write(const char* unitId, int slot, const uint8_t* data, size_t size) override;
+};
+#endif
+
+/**
+ * 空调状态日志 (双缓冲)
+ * 每次保存一条 16 字节定长记录，带序号和 CRC32，轮流写入两个槽位:
+ * 写入总是覆盖较旧的槽位，写到一半断电时另一个槽位仍保存着上一次的状态。
+ * 恢复时取校验通过且序号较新的一条
+ *
+ * 保存只在状态内容变化后进行，并做防抖: 状态稳定 debounceMs 后才写入，
+ * 连续变化时最迟 maxDelayMs 写入一次；变化后又改回已保存的状态则不写
+ *
+ * 只在主循环中调用，不加锁；状态来自 AirConditioner::getState() 快照
+ */
+class ACStateJournal {
+public:
+    static const size_t RECORD_SIZE = 16;
+    static const uint32_t DEBOUNCE_MS = 2000;   // 状态稳定多久后写入
+    static const uint32_t MAX_DELAY_MS = 10000; // 连续变化时最迟多久写入一次
+
+    ACStateJournal(ACJournalStore& store, const char* unitId,
+                   uint32_t debounceMs = DEBOUNCE_MS, uint32_t maxDelayMs = MAX_DELAY_MS);
+
+    /**
+     * 读取两个槽位，取出最新的有效记录
+     * @param state 恢复的状态 (version 不保存，置 0)
+     * @return 两个槽位都没有有效记录时返回 false
+     */
+    bool restore(ACState& state);
+
+    /**
+     * 主循环中定期调用: 记下状态变化，防抖时间到后写入
+     * @return 本次调用写入了记录时返回 true
+     */
+    bool poll(const ACState& state, uint32_t nowMs);
+
+    /**
+     * 立即写入尚未保存的变化 (例如重启前)
+     * @return 写入失败时返回 false；没有需要保存的变化时返回 true
+     */
+    bool flush(const ACState& state);
+
+    uint32_t writes() const { return writeCount; }
+    uint32_t failures() const { return failureCount; }
+    uint32_t sequence() const { return lastSequence; }
+
+    /**
+     * 编码一条记录
+     * 布局 (小端): 标识 2 字节, 格式版本 1 字节, 运行标志 1 字节, 序号 4 字节,
+     *             模式 1 字节, 温度 1 字节, 保留 2 字节, CRC32 4 字节
+     */
+    static void encode(const ACState& state, uint32_t sequence, uint8_t* record);
+
+    /**
+     * 解码一条记录
+     * @return 标识、格式版本或 CRC 不符时返回 false
+     */
+    static bool decode(const uint8_t* record, ACState& state, uint32_t& sequence);
+
+    static uint32_t crc32(const uint8_t* data, size_t size);
+
+private:
+    static bool sameSetting(const ACState& a, const ACState& b);
+    bool commit(const ACState& state);
+
+    ACJournalStore& store;
+    std::string unit;
+    uint32_t debounceMs;
+    uint32_t maxDelayMs;
+
+    ACState saved;          // 已保存的状态
+    bool hasSaved;
+    uint32_t lastSequence;  // 已保存记录的序号，下一条写入槽位 (序号+1) & 1
+    uint32_t seenVersion;   // 上次 poll 看到的状态版本
+    bool dirty;             // 有尚未保存的变化
+    uint32_t dirtySinceMs;  // 首次出现未保存变化的时间
+    uint32_t lastChangeMs;  // 最近一次状态变化的时间
+    uint32_t writeCount;
+    uint32_t failureCount;
+};
+
+#endif // AC_STATE_JOURNAL_H
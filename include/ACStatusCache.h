@@ -0,0 +1,87 @@
+#ifndef AC_STATUS_CACHE_H
+#define AC_STATUS_CACHE_H
+
+#include <ArduinoJson.h>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "ACResult.h"
+
+/**
+ * getStatus 输出缓存
+ * 状态输出按 ACState::version 缓存为序列化文本，版本不变时直接复用；
+ * 客户端带上次的 ETag 轮询且状态未变时，只返回 notModified
+ *
+ * ETag 由启动标识和版本号组成，重启后版本号从 0 开始也不会与旧 ETag 冲突
+ */
+class ACStatusCache {
+public:
+    explicit ACStatusCache(uint32_t bootId) : boot(bootId), valid(false), version(0), rebuildCount(0) {
+        etag[0] = '\0';
+    }
+
+    /*
+        写入 getStatus 结果
+        参数：
+            state: 当前状态快照
+            ifNoneMatch: 客户端持有的 ETag，可为空
+        输出：
+            未修改: notModified: true, etag
+            否则: running, mode, modeString, temperature, version, etag
+        返回：
+            true 表示状态未修改
+    */
+    bool write(const ACState& state, const char* ifNoneMatch, JsonDocument& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!valid || version != state.version) {
+            rebuild(state);
+        }
+        if (ifNoneMatch && strcmp(ifNoneMatch, etag) == 0) {
+            result.set(serialized(notModified));
+            return true;
+        }
+        result.set(serialized(payload));
+        return false;
+    }
+
+    // 状态输出重新序列化的次数
+    uint32_t rebuilds() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rebuildCount;
+    }
+
+private:
+    void rebuild(const ACState& state) {
+        snprintf(etag, sizeof(etag), "\"%08x-%u\"", static_cast<unsigned>(boot), static_cast<unsigned>(state.version));
+
+        JsonDocument doc;
+        JsonObject out = doc.to<JsonObject>();
+        writeACState(state, out);
+        out["version"] = state.version;
+        out["etag"] = static_cast<const char*>(etag);
+        payload.clear();
+        serializeJson(doc, payload);
+
+        doc.clear();
+        doc["notModified"] = true;
+        doc["etag"] = static_cast<const char*>(etag);
+        notModified.clear();
+        serializeJson(doc, notModified);
+
+        version = state.version;
+        valid = true;
+        rebuildCount++;
+    }
+
+    mutable std::mutex mutex;   // 工具可能在网络任务和工作线程上执行
+    uint32_t boot;              // 启动标识
+    bool valid;
+    uint32_t version;           // payload 对应的状态版本
+    char etag[24];              // "启动标识-版本号" (带引号)
+    std::string payload;        // 序列化的状态输出
+    std::string notModified;    // 序列化的未修改输出
+    uint32_t rebuildCount;
+};
+
+#endif // AC_STATUS_CACHE_H
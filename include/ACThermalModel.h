@@ -0,0 +1,105 @@
+#ifndef AC_THERMAL_MODEL_H
+#define AC_THERMAL_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ACResult.h"
+#include "SeqLock.h"
+
+/**
+ * 房间热模型的参数
+ * 温度为 Q16.16 定点数 (°C × 65536)，见 ACThermalModel::fromTenths
+ */
+struct ACThermalParams {
+    int32_t outsideMean;        // 室外日平均温度
+    int32_t outsideSwing;       // 室外温度日变化幅度 (04:00 最低, 16:00 最高)
+    int32_t initialRoom;        // 模拟开始时的室温
+    uint32_t startSecondOfDay;  // 模拟开始时的本地时刻 (秒)
+    uint32_t insulationS;       // 房间热时间常数: 室内外温差每过这么久缩小约 63%
+    int32_t capacityPerHour;    // 压缩机满负荷时每小时改变的室温
+    int32_t bandWidth;          // 比例带: 偏离设定温度这么多时比例项为满负荷
+    uint32_t integralS;         // 积分时间: 持续偏离一个比例带时积分项涨满所需秒数
+    uint32_t rampS;             // 压缩机负荷从 0 升到满负荷至少需要的秒数
+
+    // 夏季: 室外 30±5°C，室温从 30°C 开始，热时间常数 3 小时，满负荷 8°C/h
+    static ACThermalParams defaults();
+};
+
+/**
+ * 模型读数快照 (通过顺序锁发布，任意任务无锁读取)
+ */
+struct ACThermalReading {
+    int32_t room;               // 室温 (Q16.16)
+    int32_t outside;            // 室外温度 (Q16.16)
+    int32_t duty;               // 压缩机负荷 (Q16.16，0 到 ONE)
+    uint32_t seconds;           // 已模拟的秒数
+};
+
+/**
+ * 房间热模拟: 室温、室外温度和压缩机负荷，由空调状态驱动
+ *
+ * 每步 (TICK_S 秒) 只用整数运算: 室温按热时间常数向室外温度靠拢，
+ * 压缩机按 PI 调节 (比例带 + 积分，负荷限幅并限速) 制冷或制热。
+ * 温度变化率以 "每小时" 为单位累加，除不尽的余数留到下一步，
+ * 长时间运行也没有截断误差累积；没有浮点运算，适合无 FPU 的路径
+ *
+ * 模式: 制冷、制热按设定温度调节；自动模式室温高于设定 0.5°C 以上制冷，
+ * 低于 0.5°C 以上制热，其间保持原方向；抽湿模式制冷，负荷不超过一半。
+ * 关机时负荷按爬升速度降到 0
+ *
+ * step() 只在一个任务中调用 (主循环)；reading() 可在任意任务中调用
+ */
+class ACThermalModel {
+public:
+    static const int FRAC_BITS = 16;
+    static const int32_t ONE = 1 << FRAC_BITS;
+    static const uint32_t TICK_S = 1;
+
+    /**
+     * @param params 为 0 的时间常数、比例带按 1 处理
+     */
+    explicit ACThermalModel(const ACThermalParams& params = ACThermalParams::defaults());
+
+    ACThermalModel(const ACThermalModel&) = delete;
+    ACThermalModel& operator=(const ACThermalModel&) = delete;
+
+    /**
+     * 推进一步 (TICK_S 秒)
+     */
+    void step(const ACState& state);
+
+    /**
+     * 推进 ticks 步，只在最后发布一次读数
+     */
+    void advance(const ACState& state, uint32_t ticks);
+
+    ACThermalReading reading() const { return published.load(); }
+
+    // °C 的十分之一 <-> Q16.16 (四舍五入)
+    static int32_t fromTenths(int32_t tenths);
+    static int32_t toTenths(int32_t fixed);
+
+    // Q16.16 -> 百分比 (四舍五入)，用于压缩机负荷
+    static int32_t toPercent(int32_t fixed);
+
+private:
+    void integrate(const ACState& state);
+    int32_t targetDuty(const ACState& state);
+    int32_t outsideAt(uint32_t secondOfDay) const;
+
+    ACThermalParams params;
+
+    // 以下只在调用 step() 的任务中访问
+    int32_t room;
+    int32_t duty;
+    int32_t integral;           // 积分项 (Q16.16 负荷)
+    int64_t carry;              // 室温变化率累加的余数 (Q16.16 °C·秒/小时)
+    int8_t direction;           // -1 制冷, 1 制热, 0 未定 (自动模式)
+    uint32_t seconds;
+    uint32_t secondOfDay;
+    int32_t outside;
+
+    mcp::SeqLock<ACThermalReading> published;
+};
+
+#endif // AC_THERMAL_MODEL_H
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "SystemProfiler.h"
+
+namespace mcp {
+
+/**
+ * Per-client token buckets in front of the MCP endpoint.
+ *
+ * Each client (remote IPv4 address) owns a bucket of `burst` tokens
+ * refilled at `ratePerSecond`; a request takes one token or is throttled.
+ * Sessions do not get buckets of their own: a client could open several
+ * event streams and spread its requests over them. Tokens are kept in thousandths, so refill is
+ * integer arithmetic on the elapsed milliseconds. Buckets live in a fixed
+ * table: a new client takes a free slot or the least recently seen one,
+ * and admit() never allocates.
+ *
+ * The check runs before the body is buffered, so a client in a tight loop
+ * only costs a table lookup per throttled request. Counts are kept in
+ * atomics and published with publish().
+ */
+class AdmissionControl {
+public:
+    static const size_t MAX_CLIENTS = 16;
+    static const uint32_t DEFAULT_RATE = 10;     // Requests per second
+    static const uint32_t DEFAULT_BURST = 20;
+
+    struct Decision {
+        bool admitted;
+        uint32_t retryAfterMs;   // When the next token is due; 0 if admitted
+    };
+
+    struct Stats {
+        uint64_t admitted;
+        uint64_t throttled;
+        uint64_t evictions;      // Buckets reused for a new client
+        size_t clients;          // Buckets in use
+    };
+
+    explicit AdmissionControl(uint32_t ratePerSecond = DEFAULT_RATE, uint32_t burst = DEFAULT_BURST);
+
+    /**
+     * Change the limits. Existing buckets are refilled to the new burst.
+     * @param ratePerSecond Sustained requests per second; 0 admits everything
+     */
+    void configure(uint32_t ratePerSecond, uint32_t burst);
+
+    /**
+     * Take a token for `client`
+     * @param client Remote IPv4 address
+     * @param nowMs Current time in milliseconds
+     */
+    Decision admit(uint32_t client, uint32_t nowMs);
+
+    Stats getStats() const;
+
+    /**
+     * Publish mcp.admitted and mcp.throttled (since boot).
+     * Register with SystemProfiler::addCollector.
+     */
+    void publish(const SystemProfiler::GaugeSink& gauges) const;
+
+private:
+    struct Bucket {
+        uint32_t client;
+        uint32_t tokens;         // Thousandths of a token
+        uint32_t lastMs;         // Last refill
+        bool used;
+    };
+
+    Bucket& bucketLocked(uint32_t client, uint32_t nowMs);
+
+    uint32_t rate;
+    uint32_t capacity;           // burst * 1000
+    Bucket buckets[MAX_CLIENTS];
+    std::atomic<uint64_t> admittedCount;
+    std::atomic<uint64_t> throttledCount;
+    uint64_t evictionCount;
+    mutable std::mutex mutex;
+};
+
+} // namespace mcp
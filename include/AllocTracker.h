@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mcp {
+
+/**
+ * Opt-in heap allocation accounting.
+ *
+ * Build with -D MCP_ALLOC_TRACKING (and the --wrap linker flags listed in
+ * platformio.ini) to route malloc/calloc/realloc and operator new through
+ * AllocTracker::onAllocate(). Each allocation is attributed to the tag of the
+ * innermost AllocScope active on the calling thread ("untagged" otherwise).
+ * Without the flag, ALLOC_SCOPE compiles to nothing.
+ */
+class AllocTracker {
+public:
+    static const size_t MAX_TAGS = 16;
+
+    struct TagStats {
+        const char* tag;
+        uint64_t allocations;
+        uint64_t bytes;
+    };
+
+    /**
+     * Called for every finished scope that was opened with report = true
+     */
+    using Reporter = void (*)(const char* tag, uint32_t allocations, uint32_t bytes);
+
+    // Singleton instance access
+    static AllocTracker& getInstance() {
+        static AllocTracker instance;
+        return instance;
+    }
+
+    /**
+     * True if the allocation hooks are compiled in
+     */
+    static constexpr bool isCompiledIn() {
+#ifdef MCP_ALLOC_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Account one allocation to the current thread's scope. Called from the
+     * allocation hooks; must not allocate.
+     */
+    static void onAllocate(size_t size);
+
+    /**
+     * Allocations/bytes made by the calling thread since it started
+     */
+    static uint32_t threadAllocations();
+    static uint32_t threadBytes();
+
+    /**
+     * Totals for one tag (zeroes if the tag never allocated)
+     */
+    TagStats getTagStats(const char* tag) const;
+
+    /**
+     * Copy the totals of all tags seen so far
+     * @return Number of entries written
+     */
+    size_t getStats(TagStats* out, size_t max) const;
+
+    /**
+     * Zero all totals (tags stay registered)
+     */
+    void reset();
+
+    void setReporter(Reporter callback) { reporter.store(callback, std::memory_order_relaxed); }
+    Reporter getReporter() const { return reporter.load(std::memory_order_relaxed); }
+
+#ifdef ARDUINO
+    /**
+     * Reporter recording alloc.<tag>.count / alloc.<tag>.bytes histograms in MetricsSystem
+     */
+    static void metricsReporter(const char* tag, uint32_t allocations, uint32_t bytes);
+#endif
+
+private:
+    AllocTracker();
+    AllocTracker(const AllocTracker&) = delete;
+    AllocTracker& operator=(const AllocTracker&) = delete;
+
+    struct Slot {
+        std::atomic<const char*> tag;
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> bytes;
+    };
+
+    Slot* findSlot(const char* tag, bool create);
+
+    Slot slots[MAX_TAGS];
+    std::atomic<Reporter> reporter;
+};
+
+/**
+ * RAII scope attributing the thread's allocations to a tag.
+ * Scopes nest; the innermost tag wins.
+ */
+class AllocScope {
+public:
+    /**
+     * @param tag Static string naming the subsystem, e.g. "mcp.request"
+     * @param report If true, the scope's counts are passed to the tracker's reporter on exit
+     */
+    explicit AllocScope(const char* tag, bool report = false);
+    ~AllocScope();
+
+    /**
+     * Allocations/bytes made on this thread since the scope was opened
+     */
+    uint32_t allocations() const;
+    uint32_t bytes() const;
+
+private:
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+    const char* tag;
+    const char* previousTag;
+    uint32_t startAllocations;
+    uint32_t startBytes;
+    bool report;
+};
+
+#ifndef MCP_CONCAT
+#define MCP_CONCAT_INNER(a, b) a##b
+#define MCP_CONCAT(a, b) MCP_CONCAT_INNER(a, b)
+#endif
+
+// The scope variable is named after the line, so scopes can be stacked
+#ifdef MCP_ALLOC_TRACKING
+#define ALLOC_SCOPE(tag) mcp::AllocScope MCP_CONCAT(allocScope_, __LINE__)(tag)
+#define ALLOC_SCOPE_REPORT(tag) mcp::AllocScope MCP_CONCAT(allocScope_, __LINE__)(tag, true)
+#else
+#define ALLOC_SCOPE(tag)
+#define ALLOC_SCOPE_REPORT(tag)
+#endif
+
+} // namespace mcp
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Concurrency flavor of a BoundedRequestQueue
+ */
+enum class QueueConcurrency {
+    SPSC,   // Exactly one producer and one consumer thread
+    MPMC    // Any number of producers and consumers
+};
+
+/**
+ * Fixed-capacity, allocation-free, lock-free variant of RequestQueue.
+ *
+ * Items live in an inline ring buffer and are moved in and out, so pushing
+ * never touches the heap. Capacity must be a power of two. The SPSC flavor
+ * is a plain head/tail ring; the MPMC flavor uses per-cell sequence numbers
+ * (Vyukov's bounded queue) so producers and consumers only contend on one
+ * compare-and-swap each.
+ */
+template<typename T, size_t Capacity, QueueConcurrency Mode = QueueConcurrency::MPMC>
+class BoundedRequestQueue;
+
+namespace queue_detail {
+
+// Keep producer and consumer indices on separate cache lines
+static constexpr size_t CACHE_LINE = 64;
+
+template<typename T>
+struct Storage {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type bytes;
+
+    T* get() { return reinterpret_cast<T*>(&bytes); }
+};
+
+} // namespace queue_detail
+
+template<typename T, size_t Capacity>
+class BoundedRequestQueue<T, Capacity, QueueConcurrency::SPSC> {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    BoundedRequestQueue() : head(0), tail(0), cachedHead(0), cachedTail(0) {}
+    ~BoundedRequestQueue() { clear(); }
+
+    BoundedRequestQueue(const BoundedRequestQueue&) = delete;
+    BoundedRequestQueue& operator=(const BoundedRequestQueue&) = delete;
+
+    bool push(const T& item) { return emplace(item); }
+    bool push(T&& item) { return emplace(std::move(item)); }
+
+    /**
+     * Move the oldest item into `item`
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (!readable(h)) {
+            return false;
+        }
+        T* slot = buffer[h & MASK].get();
+        item = std::move(*slot);
+        slot->~T();
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) { return try_pop(item); }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    /**
+     * Drop all items. Must be called from the consumer thread.
+     */
+    void clear() {
+        size_t h = head.load(std::memory_order_relaxed);
+        while (readable(h)) {
+            buffer[h & MASK].get()->~T();
+            head.store(++h, std::memory_order_release);
+        }
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    bool readable(size_t h) {
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+        }
+        return h != cachedTail;
+    }
+
+    template<typename U>
+    bool emplace(U&& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) {
+                return false;
+            }
+        }
+        new (buffer[t & MASK].get()) T(std::forward<U>(item));
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    alignas(queue_detail::CACHE_LINE) std::atomic<size_t> head;   // Written by consumer
+    alignas(queue_detail::CACHE_LINE) std::atomic<size_t> tail;   // Written by producer
+    alignas(queue_detail::CACHE_LINE) size_t cachedHead;          // Producer's view of head
+    alignas(queue_detail::CACHE_LINE) size_t cachedTail;          // Consumer's view of tail
+    queue_detail::Storage<T> buffer[Capacity];
+};
+
+template<typename T, size_t Capacity>
+class BoundedRequestQueue<T, Capacity, QueueConcurrency::MPMC> {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    BoundedRequestQueue() : enqueuePos(0), dequeuePos(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~BoundedRequestQueue() { clear(); }
+
+    BoundedRequestQueue(const BoundedRequestQueue&) = delete;
+    BoundedRequestQueue& operator=(const BoundedRequestQueue&) = delete;
+
+    bool push(const T& item) { return emplace(item); }
+    bool push(T&& item) { return emplace(std::move(item)); }
+
+    /**
+     * Move the oldest item into `item`
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& item) {
+        size_t pos;
+        Cell* cell = claimForPop(pos);
+        if (!cell) {
+            return false;
+        }
+        T* slot = cell->storage.get();
+        item = std::move(*slot);
+        slot->~T();
+        cell->sequence.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) { return try_pop(item); }
+
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Approximate number of queued items (exact when quiescent)
+     */
+    size_t size() const {
+        size_t enq = enqueuePos.load(std::memory_order_acquire);
+        size_t deq = dequeuePos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    void clear() {
+        size_t pos;
+        while (Cell* cell = claimForPop(pos)) {
+            cell->storage.get()->~T();
+            cell->sequence.store(pos + Capacity, std::memory_order_release);
+        }
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        queue_detail::Storage<T> storage;
+    };
+
+    // Reserve the oldest published cell for this consumer, nullptr if empty
+    Cell* claimForPop(size_t& pos) {
+        pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell* cell = &cells[pos & MASK];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return cell;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template<typename U>
+    bool emplace(U&& item) {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & MASK];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;   // Full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage.get()) T(std::forward<U>(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    Cell cells[Capacity];
+    alignas(queue_detail::CACHE_LINE) std::atomic<size_t> enqueuePos;
+    alignas(queue_detail::CACHE_LINE) std::atomic<size_t> dequeuePos;
+};
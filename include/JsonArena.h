@@ -0,0 +1,157 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * ArduinoJson allocator backed by malloc/free/realloc
+ */
+class HeapJsonAllocator : public ArduinoJson::Allocator {
+public:
+    static HeapJsonAllocator* instance() {
+        static HeapJsonAllocator allocator;
+        return &allocator;
+    }
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+};
+
+/**
+ * Bump allocator over a fixed buffer, for the JsonDocuments of one request.
+ *
+ * Allocation moves a cursor forward. Freeing or resizing the most recent
+ * block happens in place, which covers ArduinoJson's string building and
+ * shrink-to-fit; any other free is a no-op. The whole arena is recycled by
+ * reset() when the request ends, so request documents never touch the
+ * general heap and cannot fragment it.
+ *
+ * When the buffer is exhausted, allocations fall through to `fallback` and
+ * are counted as overflows. Not thread-safe: one request owns an arena at a
+ * time.
+ */
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    static const size_t ALIGNMENT = 8;
+
+    JsonArena(uint8_t* buffer, size_t capacity, ArduinoJson::Allocator* fallback = HeapJsonAllocator::instance());
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+    /**
+     * Recycle the whole buffer. Documents using the arena must be gone.
+     */
+    void reset();
+
+    bool owns(const void* ptr) const {
+        return ptr >= buffer && ptr < buffer + bufferCapacity;
+    }
+
+    size_t used() const { return offset; }
+    size_t capacity() const { return bufferCapacity; }
+    size_t highWater() const { return peak; }
+    uint32_t overflows() const { return overflowCount; }
+
+private:
+    // Precedes every block so reallocate() knows how much to copy
+    struct alignas(ALIGNMENT) BlockHeader {
+        uint32_t size;
+    };
+
+    static size_t align(size_t size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+    static BlockHeader* headerOf(void* ptr) { return static_cast<BlockHeader*>(ptr) - 1; }
+
+    uint8_t* buffer;
+    size_t bufferCapacity;
+    ArduinoJson::Allocator* fallback;
+    size_t offset;
+    uint8_t* lastBlock;       // Most recent block, the only one that can change in place
+    size_t peak;
+    uint32_t overflowCount;
+};
+
+/**
+ * Fixed set of JsonArenas carved out of one allocation made at startup.
+ *
+ *   JsonArenaPool::Lease arena = pool.acquire();
+ *   JsonDocument doc(arena.allocator());
+ *
+ * The lease returns the arena, reset, when it goes out of scope, so it must
+ * be declared before the documents that use it. When every arena is leased,
+ * acquire() hands out the heap allocator instead, so a burst of requests
+ * degrades to the old behaviour rather than failing.
+ */
+class JsonArenaPool {
+public:
+    static const size_t DEFAULT_ARENA_COUNT = 4;
+    static const size_t DEFAULT_ARENA_SIZE = 4096;
+
+    struct Stats {
+        uint64_t acquired;      // Leases served from an arena
+        uint64_t exhausted;     // Leases served from the heap because all arenas were busy
+        uint64_t overflows;     // Allocations that did not fit their arena
+        size_t highWater;       // Most bytes one request used in an arena
+        size_t available;       // Arenas currently free
+    };
+
+    class Lease {
+    public:
+        Lease() : pool(nullptr), arena(nullptr) {}
+        Lease(Lease&& other) : pool(other.pool), arena(other.arena) { other.arena = nullptr; }
+        Lease& operator=(Lease&& other);
+        ~Lease() { release(); }
+
+        /**
+         * Allocator to pass to JsonDocument
+         */
+        ArduinoJson::Allocator* allocator() const {
+            return arena ? static_cast<ArduinoJson::Allocator*>(arena) : HeapJsonAllocator::instance();
+        }
+
+        bool pooled() const { return arena != nullptr; }
+
+    private:
+        friend class JsonArenaPool;
+        Lease(JsonArenaPool* owner, JsonArena* leased) : pool(owner), arena(leased) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        void release();
+
+        JsonArenaPool* pool;
+        JsonArena* arena;
+    };
+
+    JsonArenaPool(size_t arenaCount = DEFAULT_ARENA_COUNT, size_t arenaSize = DEFAULT_ARENA_SIZE);
+    ~JsonArenaPool();
+
+    Lease acquire();
+
+    Stats getStats() const;
+
+private:
+    JsonArenaPool(const JsonArenaPool&) = delete;
+    JsonArenaPool& operator=(const JsonArenaPool&) = delete;
+
+    void release(JsonArena* arena);
+
+    uint8_t* storage;
+    std::vector<JsonArena> arenas;
+    std::vector<JsonArena*> freeArenas;
+
+    mutable std::mutex mutex;
+    uint64_t acquired;
+    uint64_t exhausted;
+    uint64_t overflows;
+    size_t highWater;
+};
+
+} // namespace mcp
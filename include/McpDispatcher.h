@@ -0,0 +1,191 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <string>
+#include "JsonArena.h"
+#include "ResourceHub.h"
+#include "ResponseBody.h"
+#include "ToolRegistry.h"
+
+namespace mcp {
+
+/**
+ * Result of handling one JSON-RPC message
+ */
+struct McpResponse {
+    int status;             // HTTP status: 200, 202 (notification), 400, 503
+    std::string body;       // JSON-RPC response, empty for 202/503
+    std::string etag;       // Set for tools/list
+    std::shared_ptr<ResponseBody> stream;   // Set instead of `body` when streaming
+
+    bool hasBody() const { return stream || !body.empty(); }
+
+    /**
+     * Copy body bytes at [index, index + maxLen), from `stream` or `body`
+     * @return Bytes copied; 0 at the end
+     */
+    size_t read(uint8_t* buffer, size_t maxLen, size_t index) const;
+
+    /**
+     * Whole body as a string
+     */
+    std::string text() const { return stream ? stream->toString() : body; }
+};
+
+/**
+ * Hooks around the tool calls of one request or one whole batch
+ */
+class DispatchObserver {
+public:
+    virtual ~DispatchObserver() = default;
+
+    /**
+     * Called before the first tools/call, e.g. to take the device lock
+     */
+    virtual void beginCalls() = 0;
+
+    /**
+     * Called after the last tools/call, e.g. to flush deferred updates
+     * @param calls Number of tools/call messages executed
+     */
+    virtual void endCalls(size_t calls) = 0;
+};
+
+/**
+ * JSON-RPC dispatcher for the MCP methods this device serves:
+ * initialize, ping, tools/list and tools/call, plus resources/list,
+ * resources/read and resources/(un)subscribe when a ResourceHub is set.
+ *
+ * Transport independent; McpEndpoint feeds it HTTP bodies. tools/list is
+ * answered from the registry's pre-rendered payload and carries its ETag;
+ * conditional requests are a transport matter (GET /mcp/tools), since a
+ * JSON-RPC request always gets a JSON-RPC response.
+ *
+ * JSON-RPC 2.0 batches are executed in order inside a single
+ * DispatchObserver scope, so an agent can send turnOn, setMode and
+ * setTemperature in one round trip and the device refreshes once.
+ */
+class McpDispatcher {
+public:
+    static const char* PROTOCOL_VERSION;
+    static const size_t MAX_BATCH_SIZE = 16;
+
+    // Arenas one request can hold at once: the request document, which its
+    // replies share, and the output of a streamed tools/call, which lives
+    // until the transport has sent it
+    static const size_t LEASES_PER_REQUEST = 2;
+
+    McpDispatcher(ToolRegistry& registry, const char* serverName, const char* serverVersion);
+
+    /**
+     * Handle one request body
+     * @param body JSON-RPC message
+     * @param length Body length in bytes
+     * @param session Event stream session of the client, 0 if none;
+     *                resources/subscribe needs one
+     */
+    McpResponse handle(const char* body, size_t length, uint32_t session = 0);
+
+    /**
+     * Handle an already parsed request (single message or batch)
+     * @param arena Lease `request` was parsed into (see acquireArena); the
+     *              reply documents are built in the same arena instead of
+     *              leasing a second one
+     */
+    McpResponse handle(JsonDocument& request, const JsonArenaPool::Lease& arena, uint32_t session = 0);
+
+    /**
+     * True if the request, or any message of a batch, is a tools/call.
+     * Requests without tool calls never touch the device and are cheap
+     * enough to answer on the network task.
+     */
+    static bool hasToolCalls(const JsonDocument& request);
+
+    /**
+     * True if every tools/call in the request names a readOnly tool.
+     * Such requests cannot change device state and may wait behind
+     * requests that do.
+     */
+    bool readsOnly(const JsonDocument& request) const;
+
+    /**
+     * Coalescing key of a single tools/call that expects a response (see
+     * ToolRegistry::coalesceKey). Batches and notifications never coalesce.
+     * @return Empty if the request must run as sent
+     */
+    std::string coalesceKey(const JsonDocument& request) const;
+
+    /**
+     * Copy of a response addressed to another request: the same status
+     * and reply, under the JSON-RPC id `idJson` (see serializeId)
+     */
+    static McpResponse withId(const McpResponse& response, const std::string& idJson);
+
+    /**
+     * A request's id as it appears in the reply envelope
+     */
+    static std::string serializeId(JsonVariantConst id);
+
+    /**
+     * Response for a body that is not valid JSON
+     */
+    static McpResponse parseError();
+
+    void setObserver(DispatchObserver* dispatchObserver) { observer = dispatchObserver; }
+
+    /**
+     * Serve the hub's resources and advertise resource subscriptions
+     */
+    void setResources(ResourceHub* hub) { resources = hub; }
+
+    /**
+     * Build the documents of each request in arenas from `pool` instead of
+     * on the heap
+     */
+    void setArenaPool(JsonArenaPool* pool) { arenaPool = pool; }
+
+    /**
+     * Answer single tools/call and tools/list requests with a ResponseBody
+     * that the transport reads in chunks, instead of a serialized `body`.
+     * Batches are always serialized.
+     */
+    void setStreaming(bool enabled) { streaming = enabled; }
+
+    /**
+     * Arena for a document that belongs to one request, e.g. the parsed
+     * body. Without a pool the lease hands out the heap allocator.
+     */
+    JsonArenaPool::Lease acquireArena() { return arenaPool ? arenaPool->acquire() : JsonArenaPool::Lease(); }
+
+    // JSON-RPC error codes
+    static const int PARSE_ERROR = -32700;
+    static const int INVALID_REQUEST = -32600;
+    static const int METHOD_NOT_FOUND = -32601;
+    static const int INVALID_PARAMS = -32602;
+    static const int RATE_LIMITED = -32029;       // Server error range; sent by McpEndpoint
+
+private:
+    McpResponse dispatch(JsonDocument& request, uint32_t session, Allocator* allocator);
+    McpResponse handleBatch(JsonArrayConst batch, uint32_t session, Allocator* allocator);
+    McpResponse handleMessage(JsonVariantConst message, uint32_t session, size_t& calls,
+                              Allocator* allocator, bool stream);
+    void handleInitialize(JsonObject result);
+    bool handleResources(const char* method, JsonVariantConst params, uint32_t session, JsonObject result,
+                         std::string& error, Allocator* allocator);
+    bool handleToolsCall(JsonVariantConst params, JsonObject result, std::string& error, Allocator* allocator);
+    McpResponse streamToolsCall(JsonVariantConst id, JsonVariantConst params, Allocator* allocator);
+    McpResponse toolsList(JsonVariantConst id, bool stream);
+
+    static McpResponse errorResponse(JsonVariantConst id, int code, const char* message,
+                                     Allocator* allocator = HeapJsonAllocator::instance());
+
+    ToolRegistry& registry;
+    DispatchObserver* observer;
+    ResourceHub* resources;
+    JsonArenaPool* arenaPool;
+    bool streaming;
+    std::string name;
+    std::string version;
+};
+
+} // namespace mcp
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "AdmissionControl.h"
+#include "McpDispatcher.h"
+#include "ResourceHub.h"
+#include "ToolRegistry.h"
+#include "ToolWorker.h"
+
+namespace mcp {
+
+/**
+ * HTTP transport for McpDispatcher.
+ *
+ * POST /mcp         JSON-RPC request
+ * GET  /mcp/tools   tools/list payload only, with ETag / If-None-Match so
+ *                   polling clients get a 304 while the tool set is unchanged
+ * GET  /mcp/events  Server-sent events. The first event names the endpoint
+ *                   to post to (/mcp?sessionId=N); resources subscribed with
+ *                   that session id are announced on this stream as
+ *                   notifications/resources/updated on its next poll
+ *
+ * With a ToolWorker attached, requests containing tools/call are executed
+ * on the worker; everything else is still answered directly on the network
+ * task. Nothing is sent for a worker request until its reply is ready, so
+ * the status line is the reply's own (200, 202 for notifications only, 503
+ * if the worker stopped). The worker only marks the reply ready; the
+ * response sends it from the async_tcp task on the connection's next ACK or
+ * poll (AsyncTCP polls every 500 ms).
+ *
+ * With AdmissionControl attached, POST /mcp and GET /mcp/tools take a token
+ * from the remote address's bucket first; POST takes it on the first body
+ * chunk, so a throttled request's body is neither buffered nor parsed. It
+ * gets a prebuilt 429 with a JSON-RPC error and Retry-After.
+ */
+class McpEndpoint {
+public:
+    static const size_t MAX_BODY_SIZE = 8192;
+
+    McpEndpoint(uint16_t port, ToolRegistry& registry, const char* serverName, const char* serverVersion);
+
+    void begin();
+
+    McpDispatcher& getDispatcher() { return dispatcher; }
+
+    /**
+     * Run tool calls on `toolWorker` instead of the network task
+     */
+    void setWorker(ToolWorker* toolWorker) { worker = toolWorker; }
+
+    /**
+     * Serve `hub`'s resources and their event streams
+     */
+    void setResources(ResourceHub* hub);
+
+    /**
+     * Rate-limit clients with `control`
+     */
+    void setAdmission(AdmissionControl* control) { admission = control; }
+
+private:
+    AdmissionControl::Decision admit(AsyncWebServerRequest* request);
+    void sendThrottled(AsyncWebServerRequest* request, uint32_t retryAfterMs);
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
+    void handleRequest(AsyncWebServerRequest* request);
+    void handleToolsGet(AsyncWebServerRequest* request);
+    void handleEventsGet(AsyncWebServerRequest* request);
+    void dispatchToWorker(AsyncWebServerRequest* request, JsonDocument&& parsed, JsonArenaPool::Lease&& arena,
+                          uint32_t session);
+    void send(AsyncWebServerRequest* request, McpResponse&& response);
+
+    static const char* ifNoneMatch(AsyncWebServerRequest* request);
+    static uint32_t sessionId(AsyncWebServerRequest* request);
+
+    AsyncWebServer server;
+    ToolRegistry& registry;
+    McpDispatcher dispatcher;
+    ToolWorker* worker;
+    ResourceHub* resources;
+    AdmissionControl* admission;
+};
+
+} // namespace mcp
@@ -7,6 +7,7 @@
 #include <mutex>
 #include <memory>
 #include "uLogger.h"
+#include "SpanTracer.h"
 
 namespace mcp{
 struct MetricValue {
@@ -112,6 +113,17 @@ public:
      */
     void recordHistogram(const String& name, double value);
 
+    /**
+     * Append what changed since the last flush to the metrics log: one
+     * record per metric (counter delta, last gauge value, histogram
+     * summary of the window), in a single file append. Samples only
+     * update RAM; updateSystemMetrics() calls this every FLUSH_INTERVAL_MS.
+     * @return Number of records written
+     */
+    size_t flush();
+
+    static const uint32_t FLUSH_INTERVAL_MS = 30000;
+
     /**
      * Get current value of a metric
      * @param name Metric identifier
@@ -174,7 +186,7 @@ private:
     MetricsSystem(const MetricsSystem&) = delete;
     MetricsSystem& operator=(const MetricsSystem&) = delete;
 
-    static std::mutex metricsMutex;
+    static std::recursive_mutex metricsMutex;
     bool initialized;
     uint32_t lastSaveTime;
 
@@ -182,6 +194,14 @@ private:
     std::map<String, MetricValue> bootMetrics;
     uLogger logger;
 
+    // Samples not yet in the log, by metric
+    struct PendingValue {
+        bool dirty;
+        MetricValue value;
+    };
+    std::map<String, PendingValue> pending;
+    uint32_t lastFlushTime;
+
     void initializeSystemMetrics();
     void registerMetric(const String& name, MetricType type, const String& description,
                        const String& unit = "", const String& category = "");
@@ -189,7 +209,9 @@ private:
 };
 
 /**
- * Helper class for timing operations and recording them as histogram metrics
+ * Helper class for timing operations and recording them as histogram metrics.
+ * Each timer also opens a trace span of the same name, so nested timers show
+ * up as nested spans in the SpanTracer dump.
  */
 class MetricTimer {
 public:
@@ -198,19 +220,19 @@ public:
      * @param metricName Name of histogram metric to record to
      */
     MetricTimer(const String& metricName) 
-        : name(metricName), startTime(micros()) {}
+        : name(metricName), span(name.c_str()) {}
     
     /**
      * Stop timing and record duration
      */
     ~MetricTimer() {
-        uint32_t duration = micros() - startTime;
+        uint64_t duration = traceNowMicros() - span.startMicros();
         MetricsSystem::getInstance().recordHistogram(name, duration / 1000.0); // Convert to ms
     }
 
 private:
     String name;
-    uint32_t startTime;
+    TraceSpan span;
 };
 
 // Macro for timing a scoped operation
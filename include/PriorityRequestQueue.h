@@ -0,0 +1,321 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/**
+ * Capacity and scheduling weight of one priority lane
+ */
+struct QueueLaneConfig {
+    size_t capacity;    // Maximum items waiting in this lane
+    uint32_t weight;    // Share of dequeues when several lanes are busy
+};
+
+/**
+ * Backpressure counters of one lane
+ */
+struct QueueLaneStats {
+    uint64_t pushed;        // Items accepted
+    uint64_t rejected;      // Items refused because the lane was full
+    size_t depth;           // Items currently waiting
+    size_t highWater;       // Largest depth seen
+    uint64_t dequeued;      // Items handed to consumers
+    uint64_t waitTotalUs;   // Sum of queue wait times
+    uint32_t waitMaxUs;     // Longest queue wait
+    uint64_t superseded;    // Items replaced by a newer item before they left
+};
+
+/**
+ * How a coalescing push treats one waiting item (see pushCoalescing)
+ */
+enum class QueueCoalesce {
+    Replace,   // The new item supersedes it: removed and absorbed into the new item
+    Pass,      // Unrelated: the new item may move ahead of it
+    Stop       // Order matters: it and everything older stay where they are
+};
+
+/**
+ * Receives queue events, called outside the queue lock
+ */
+class QueueObserver {
+public:
+    virtual ~QueueObserver() = default;
+    virtual void onRejected(size_t lane) = 0;
+    virtual void onHighWater(size_t lane, size_t depth) = 0;
+    virtual void onDequeued(size_t lane, uint32_t waitUs) = 0;
+};
+
+/**
+ * RequestQueue with several priority lanes.
+ *
+ * Each lane has its own capacity, so a flood of low-priority work cannot
+ * crowd out a high-priority command. Busy lanes are served by smooth
+ * weighted round-robin: with weights 4:1, four items leave the first lane
+ * for every one from the second, interleaved rather than in runs, and no
+ * lane starves. Lane 0 wins ties.
+ */
+template<typename T, size_t Lanes>
+class PriorityRequestQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Config = std::array<QueueLaneConfig, Lanes>;
+
+    explicit PriorityRequestQueue(const Config& config,
+                                  QueueObserver* queueObserver = nullptr)
+        : observer(queueObserver) {
+        for (size_t i = 0; i < Lanes; i++) {
+            lanes[i].config = config[i];
+            lanes[i].credit = 0;
+            lanes[i].stats = QueueLaneStats{0, 0, 0, 0, 0, 0, 0, 0};
+        }
+    }
+
+    bool push(const T& item, size_t lane) { return emplace(item, lane); }
+    bool push(T&& item, size_t lane) { return emplace(std::move(item), lane); }
+
+    /**
+     * Push with last-write-wins coalescing. Walking back from the lane's
+     * tail, `relation(waiting, item)` classifies each waiting item until it
+     * returns Stop. Items it replaces are removed and handed to
+     * `absorb(item, std::move(waiting))`, oldest first, so the new item can
+     * take over their obligations; then the new item joins the tail. The
+     * replaced items free their slots before the capacity check.
+     * @param relation QueueCoalesce(const T& waiting, const T& item)
+     * @param absorb void(T& item, T&& waiting)
+     * @return false if the lane is still full
+     */
+    template<typename Relation, typename Absorb>
+    bool pushCoalescing(T&& item, size_t lane, Relation relation, Absorb absorb) {
+        if (lane >= Lanes) {
+            lane = Lanes - 1;
+        }
+
+        bool rejected = false;
+        size_t newHighWater = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Lane& l = lanes[lane];
+            const T& incoming = item;
+
+            // Oldest item the new one may overtake
+            size_t first = l.items.size();
+            while (first > 0 && relation(static_cast<const T&>(l.items[first - 1].item), incoming) !=
+                                    QueueCoalesce::Stop) {
+                first--;
+            }
+            size_t replaced = 0;
+            for (auto it = l.items.begin() + first; it != l.items.end();) {
+                if (relation(static_cast<const T&>(it->item), incoming) == QueueCoalesce::Replace) {
+                    absorb(item, std::move(it->item));
+                    it = l.items.erase(it);
+                    replaced++;
+                } else {
+                    ++it;
+                }
+            }
+            totalDepth -= replaced;
+            l.stats.superseded += replaced;
+            rejected = !insertLocked(l, std::forward<T>(item), newHighWater);
+        }
+        return notify(lane, rejected, newHighWater);
+    }
+
+    /**
+     * Take the next item according to the lane weights
+     * @param lane Optional, receives the lane the item came from
+     * @return false if all lanes are empty
+     */
+    bool pop(T& item, size_t* lane = nullptr) {
+        size_t from;
+        uint32_t waitUs;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!takeLocked(item, from, waitUs)) {
+                return false;
+            }
+        }
+        if (lane) {
+            *lane = from;
+        }
+        if (observer) {
+            observer->onDequeued(from, waitUs);
+        }
+        return true;
+    }
+
+    bool try_pop(T& item, size_t* lane = nullptr) {
+        return pop(item, lane);
+    }
+
+    /**
+     * Block until an item is available or the timeout expires
+     * @return false on timeout
+     */
+    template<typename Rep, typename Period>
+    bool pop_wait(T& item, const std::chrono::duration<Rep, Period>& timeout, size_t* lane = nullptr) {
+        size_t from;
+        uint32_t waitUs;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!available.wait_for(lock, timeout, [this] { return totalDepth > 0; })) {
+                return false;
+            }
+            takeLocked(item, from, waitUs);
+        }
+        if (lane) {
+            *lane = from;
+        }
+        if (observer) {
+            observer->onDequeued(from, waitUs);
+        }
+        return true;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totalDepth == 0;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return totalDepth;
+    }
+
+    size_t size(size_t lane) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lane < Lanes ? lanes[lane].items.size() : 0;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& l : lanes) {
+            l.items.clear();
+            l.credit = 0;
+            l.stats.depth = 0;
+        }
+        totalDepth = 0;
+    }
+
+    /**
+     * Snapshot of one lane's counters
+     */
+    QueueLaneStats stats(size_t lane) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lane < Lanes ? lanes[lane].stats : QueueLaneStats{0, 0, 0, 0, 0, 0, 0, 0};
+    }
+
+    static constexpr size_t laneCount() { return Lanes; }
+
+private:
+    struct Entry {
+        T item;
+        Clock::time_point enqueued;
+    };
+
+    struct Lane {
+        QueueLaneConfig config;
+        std::deque<Entry> items;
+        int64_t credit;            // Smooth weighted round-robin state
+        QueueLaneStats stats;
+    };
+
+    template<typename U>
+    bool emplace(U&& item, size_t lane) {
+        if (lane >= Lanes) {
+            lane = Lanes - 1;
+        }
+
+        bool rejected;
+        size_t newHighWater = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            rejected = !insertLocked(lanes[lane], std::forward<U>(item), newHighWater);
+        }
+        return notify(lane, rejected, newHighWater);
+    }
+
+    template<typename U>
+    bool insertLocked(Lane& l, U&& item, size_t& newHighWater) {
+        if (l.items.size() >= l.config.capacity) {
+            l.stats.rejected++;
+            return false;
+        }
+        l.items.push_back(Entry{std::forward<U>(item), Clock::now()});
+        l.stats.pushed++;
+        l.stats.depth = l.items.size();
+        totalDepth++;
+        if (l.stats.depth > l.stats.highWater) {
+            l.stats.highWater = l.stats.depth;
+            newHighWater = l.stats.depth;
+        }
+        return true;
+    }
+
+    // Observer and consumer side of a push, outside the lock
+    bool notify(size_t lane, bool rejected, size_t newHighWater) {
+        if (rejected) {
+            if (observer) {
+                observer->onRejected(lane);
+            }
+            return false;
+        }
+        available.notify_one();
+        if (newHighWater && observer) {
+            observer->onHighWater(lane, newHighWater);
+        }
+        return true;
+    }
+
+    bool takeLocked(T& item, size_t& from, uint32_t& waitUs) {
+        if (totalDepth == 0) {
+            return false;
+        }
+
+        // Smooth weighted round-robin over the non-empty lanes
+        int64_t totalWeight = 0;
+        Lane* best = nullptr;
+        for (size_t i = 0; i < Lanes; i++) {
+            Lane& l = lanes[i];
+            if (l.items.empty()) {
+                continue;
+            }
+            l.credit += l.config.weight;
+            totalWeight += l.config.weight;
+            if (!best || l.credit > best->credit) {
+                best = &l;
+                from = i;
+            }
+        }
+        best->credit -= totalWeight;
+
+        Entry& entry = best->items.front();
+        item = std::move(entry.item);
+        auto waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - entry.enqueued);
+        waitUs = static_cast<uint32_t>(waited.count());
+        best->items.pop_front();
+        totalDepth--;
+
+        QueueLaneStats& stats = best->stats;
+        stats.depth = best->items.size();
+        stats.dequeued++;
+        stats.waitTotalUs += waitUs;
+        if (waitUs > stats.waitMaxUs) {
+            stats.waitMaxUs = waitUs;
+        }
+        if (best->items.empty()) {
+            best->credit = 0;   // An idle lane does not bank credit
+        }
+        return true;
+    }
+
+    std::array<Lane, Lanes> lanes;
+    size_t totalDepth = 0;
+    QueueObserver* observer;
+    mutable std::mutex mutex;
+    std::condition_variable available;
+};
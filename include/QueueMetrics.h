@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "PriorityRequestQueue.h"
+#include "SystemProfiler.h"
+
+namespace mcp {
+
+/**
+ * QueueObserver that keeps lane backpressure in RAM and publishes it as
+ * gauges from a SystemProfiler collector:
+ *   queue.<name>.<lane>.rejected      items refused since boot
+ *   queue.<name>.<lane>.high_water    largest depth since boot
+ *   queue.<name>.<lane>.wait_avg_ms   mean wait since the last publish
+ *   queue.<name>.<lane>.wait_max_ms   longest wait since the last publish
+ *
+ * Events only update atomics, so the queue's hot path never touches
+ * MetricsSystem or the file system.
+ */
+class MetricsQueueObserver : public QueueObserver {
+public:
+    /**
+     * @param queueName Name used in the metric names
+     * @param laneNames One name per lane, e.g. {"control", "status"}
+     */
+    MetricsQueueObserver(const std::string& queueName, const std::vector<std::string>& laneNames);
+
+    void onRejected(size_t lane) override;
+    void onHighWater(size_t lane, size_t depth) override;
+    void onDequeued(size_t lane, uint32_t waitUs) override;
+
+    /**
+     * Publish every lane through `sink` and start a new wait window.
+     * Register with SystemProfiler::addCollector.
+     */
+    void publish(const SystemProfiler::GaugeSink& sink);
+
+private:
+    struct LaneMetrics {
+        // Names are built once so publishing does not allocate
+        std::string rejectedName;
+        std::string highWaterName;
+        std::string waitAvgName;
+        std::string waitMaxName;
+
+        std::atomic<uint32_t> rejected{0};
+        std::atomic<uint32_t> highWater{0};
+        std::atomic<uint64_t> waitTotalUs{0};
+        std::atomic<uint32_t> waitCount{0};
+        std::atomic<uint32_t> waitMaxUs{0};
+    };
+
+    std::vector<std::unique_ptr<LaneMetrics>> lanes;
+};
+
+} // namespace mcp
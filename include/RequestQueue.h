@@ -2,6 +2,9 @@
 
 #include <queue>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
 
 template<typename T>
 class RequestQueue {
@@ -9,11 +12,26 @@ public:
     RequestQueue(size_t maxSize = 32) : maxQueueSize(maxSize) {}
     
     bool push(const T& item) {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (queue.size() >= maxQueueSize) {
-            return false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() >= maxQueueSize) {
+                return false;
+            }
+            queue.push(item);
         }
-        queue.push(item);
+        available.notify_one();
+        return true;
+    }
+
+    bool push(T&& item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() >= maxQueueSize) {
+                return false;
+            }
+            queue.push(std::move(item));
+        }
+        available.notify_one();
         return true;
     }
     
@@ -22,10 +40,46 @@ public:
         if (queue.empty()) {
             return false;
         }
-        item = queue.front();
+        item = std::move(queue.front());
+        queue.pop();
+        return true;
+    }
+
+    bool try_pop(T& item) {
+        return pop(item);
+    }
+
+    /**
+     * Block until an item is available or the timeout expires.
+     * The calling task sleeps instead of polling.
+     * @return false on timeout
+     */
+    template<typename Rep, typename Period>
+    bool pop_wait(T& item, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!available.wait_for(lock, timeout, [this] { return !queue.empty(); })) {
+            return false;
+        }
+        item = std::move(queue.front());
         queue.pop();
         return true;
     }
+
+    /**
+     * Move up to `max` queued items to `out` under a single lock
+     * @return Number of items moved
+     */
+    template<typename OutputIt>
+    size_t drain(OutputIt out, size_t max) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = 0;
+        while (count < max && !queue.empty()) {
+            *out++ = std::move(queue.front());
+            queue.pop();
+            count++;
+        }
+        return count;
+    }
     
     bool empty() const {
         std::lock_guard<std::mutex> lock(mutex);
@@ -46,5 +100,6 @@ public:
 private:
     std::queue<T> queue;
     mutable std::mutex mutex;
+    std::condition_variable available;
     const size_t maxQueueSize;
 };
\ No newline at end of file
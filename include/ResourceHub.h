@@ -0,0 +1,198 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * Resource as advertised in resources/list
+ */
+struct ResourceDefinition {
+    std::string uri;
+    std::string name;
+    std::string description;
+    std::string mimeType;
+    std::function<void(JsonDocument& contents)> read;   // Writes the current contents
+};
+
+class ResourceHub;
+
+/**
+ * One client's event stream (SSE), and the resources it subscribed to.
+ *
+ * The transport pulls bytes with read() whenever it can send. Updates are
+ * not queued per change: each subscription remembers the resource revision
+ * it last announced, and read() emits one notifications/resources/updated
+ * for every subscription that is behind. Any number of changes between two
+ * reads collapse into one event, and a stalled client costs nothing.
+ */
+class EventSession {
+public:
+    static const uint32_t KEEPALIVE_MS = 15000;
+
+    EventSession(ResourceHub& resourceHub, uint32_t sessionId, size_t slot, void* stream);
+    ~EventSession();
+
+    EventSession(const EventSession&) = delete;
+    EventSession& operator=(const EventSession&) = delete;
+
+    uint32_t id() const { return sessionId; }
+
+    /**
+     * Copy pending event bytes into `buffer`. The first event is the
+     * endpoint the client posts to, carrying the session id.
+     * @param nowMs Current time, for keep-alive comments
+     * @return Bytes copied; 0 when there is nothing to send yet
+     */
+    size_t read(uint8_t* buffer, size_t maxLen, uint32_t nowMs);
+
+    /**
+     * @return Events queued for sending so far, excluding keep-alives
+     */
+    uint32_t eventCount() const;
+
+private:
+    friend class ResourceHub;
+
+    struct Subscription {
+        size_t resource;     // Index in the hub
+        uint32_t announced;  // Revision last announced
+    };
+
+    void collectLocked(uint32_t nowMs);
+
+    ResourceHub& hub;
+    uint32_t sessionId;
+    size_t slot;            // Index in the hub's stream table
+    void* stream;           // Transport handle passed to the hub's waker
+    mutable std::mutex mutex;
+    std::vector<Subscription> subscriptions;
+    std::string outbox;     // Frames being sent
+    size_t sent;            // Bytes of `outbox` already read
+    bool greeted;
+    uint32_t lastSendMs;
+    uint32_t events;
+};
+
+/**
+ * MCP resources and their subscribers.
+ *
+ * A device change calls notifyUpdated(), which only bumps the resource's
+ * revision atomically: the mutating call never waits on a lock or a
+ * client. Fan-out happens when each session's transport next reads; the
+ * stream waker, if set, tells the transports of subscribed sessions to
+ * read now rather than at their next poll.
+ *
+ * Session ids are the only credential for subscribing on a stream, so they
+ * come from a random source instead of a counter.
+ *
+ * Resources are registered at boot, before sessions are opened.
+ */
+class ResourceHub {
+public:
+    static const size_t MAX_SESSIONS = 4;
+
+    /**
+     * Source of session ids, e.g. esp_random
+     */
+    using IdSource = std::function<uint32_t()>;
+
+    /**
+     * Asks the transport behind a stream handle (see openSession) to read
+     * its session now. Called from notifyUpdated, so it must be safe from
+     * any task and must not block.
+     */
+    using StreamWaker = std::function<void(void* stream)>;
+
+    /**
+     * @param sessionIds Random id source; std::random_device when empty
+     */
+    explicit ResourceHub(IdSource sessionIds = nullptr);
+
+    /**
+     * Set at boot, before sessions are opened
+     */
+    void setStreamWaker(StreamWaker waker) { streamWaker = std::move(waker); }
+
+    void addResource(ResourceDefinition resource);
+
+    /**
+     * Mark a resource changed and wake the streams subscribed to it.
+     * Lock-free; safe from any task.
+     * @return false if no resource has this URI
+     */
+    bool notifyUpdated(const char* uri);
+
+    /**
+     * Open an event stream session. The hub only keeps a weak reference,
+     * so the session ends when the transport drops it.
+     * @param stream Transport handle for the stream waker, or nullptr
+     * @return nullptr if MAX_SESSIONS are open
+     */
+    std::shared_ptr<EventSession> openSession(void* stream = nullptr);
+
+    /**
+     * @return false if the session or the resource does not exist
+     */
+    bool subscribe(uint32_t sessionId, const char* uri);
+    bool unsubscribe(uint32_t sessionId, const char* uri);
+
+    /**
+     * Write {"resources":[...]} for resources/list
+     */
+    void list(JsonObject result) const;
+
+    /**
+     * Write {"contents":[...]} for resources/read
+     * @return false if no resource has this URI
+     */
+    bool read(const char* uri, JsonObject result, Allocator* allocator) const;
+
+    size_t sessionCount();
+
+    /**
+     * @return true while the session's event stream is open
+     */
+    bool hasSession(uint32_t sessionId);
+
+private:
+    friend class EventSession;
+
+    struct Entry {
+        ResourceDefinition definition;
+        std::atomic<uint32_t> revision;
+
+        explicit Entry(ResourceDefinition resource) : definition(std::move(resource)), revision(0) {}
+    };
+
+    // One per open session. The handle and interest are read by
+    // notifyUpdated without the lock.
+    struct Stream {
+        std::weak_ptr<EventSession> session;    // Guarded by sessionMutex
+        std::atomic<void*> handle{nullptr};
+        std::atomic<uint32_t> interest{0};      // Bit (index % 32) per subscribed resource
+    };
+
+    static uint32_t interestBit(size_t resource) { return 1u << (resource % 32); }
+
+    int find(const char* uri) const;
+    std::shared_ptr<EventSession> findSession(uint32_t sessionId);
+    bool idInUseLocked(uint32_t sessionId) const;
+
+    std::deque<Entry> resources;   // Entries never move, so revisions can be read without a lock
+    IdSource idSource;
+    StreamWaker streamWaker;
+    std::mutex sessionMutex;
+    Stream streams[MAX_SESSIONS];
+};
+
+} // namespace mcp
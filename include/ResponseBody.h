@@ -0,0 +1,158 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "JsonArena.h"
+#include "ToolRegistry.h"
+
+namespace mcp {
+
+/**
+ * ArduinoJson writer that keeps only the bytes at [offset, offset + capacity)
+ * of what is written through it.
+ *
+ * Serializing a document through a window yields one chunk of its output
+ * without materializing the rest, so a response can be produced chunk by
+ * chunk into the transport's buffer.
+ */
+class ChunkWindow {
+public:
+    ChunkWindow(uint8_t* windowBuffer, size_t windowCapacity, size_t windowOffset)
+        : buffer(windowBuffer), capacity(windowCapacity), offset(windowOffset), seen(0), copied(0) {}
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length);
+    size_t write(const char* text) { return write(reinterpret_cast<const uint8_t*>(text), strlen(text)); }
+
+    size_t filled() const { return copied; }
+    bool full() const { return copied == capacity; }
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t offset;
+    size_t seen;      // Bytes written through the window so far
+    size_t copied;    // Bytes that landed in the buffer
+};
+
+/**
+ * ArduinoJson writer that escapes its input as the inside of a JSON string,
+ * the same way serializeJson() escapes string values (other control
+ * characters pass through, as they do there)
+ */
+template<typename Writer>
+class EscapingWriter {
+public:
+    explicit EscapingWriter(Writer& out) : target(out) {}
+
+    size_t write(uint8_t c) {
+        const char* escape = nullptr;
+        switch (c) {
+            case '"': escape = "\\\""; break;
+            case '\\': escape = "\\\\"; break;
+            case '\b': escape = "\\b"; break;
+            case '\f': escape = "\\f"; break;
+            case '\n': escape = "\\n"; break;
+            case '\r': escape = "\\r"; break;
+            case '\t': escape = "\\t"; break;
+            default: break;
+        }
+        if (escape) {
+            target.write(reinterpret_cast<const uint8_t*>(escape), 2);
+        } else if (c == 0) {
+            target.write(reinterpret_cast<const uint8_t*>("\\u0000"), 6);
+        } else {
+            target.write(&c, 1);
+        }
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            write(data[i]);
+        }
+        return length;
+    }
+
+private:
+    Writer& target;
+};
+
+/**
+ * Response body produced on demand, chunk by chunk, instead of being held
+ * in one string. Transports call read() with their own bounded buffer.
+ */
+class ResponseBody {
+public:
+    virtual ~ResponseBody() = default;
+
+    /**
+     * Copy the body bytes at [index, index + maxLen) into `buffer`
+     * @return Bytes copied; 0 once `index` is past the end
+     */
+    virtual size_t read(uint8_t* buffer, size_t maxLen, size_t index) = 0;
+
+    /**
+     * Whole body as a string, for batches and tests
+     */
+    std::string toString();
+};
+
+/**
+ * tools/list reply: the JSON-RPC envelope around the registry's cached
+ * payload, read in place without copying the payload
+ */
+class ToolsListBody : public ResponseBody {
+public:
+    ToolsListBody(const std::string& idJson, std::shared_ptr<const ToolsListCache> toolsList);
+
+    size_t read(uint8_t* buffer, size_t maxLen, size_t index) override;
+
+private:
+    std::string prefix;
+    std::shared_ptr<const ToolsListCache> list;
+};
+
+/**
+ * tools/call reply. The tool writes its output into output(); the envelope
+ * and the output, escaped as the content text, are serialized straight into
+ * each chunk, so neither the text nor the reply is ever built as a string.
+ *
+ * A serializer cannot be paused, so each refill re-serializes the output
+ * from the start and keeps only a READ_AHEAD window, which later chunks are
+ * served from. Memory stays bounded by READ_AHEAD whatever the output size;
+ * the price is CPU proportional to output size x refills.
+ */
+class ToolCallBody : public ResponseBody {
+public:
+    static const size_t READ_AHEAD = 4096;
+
+    ToolCallBody(JsonArenaPool::Lease&& outputArena, const std::string& idJson);
+
+    JsonDocument& output() { return document; }
+
+    size_t read(uint8_t* buffer, size_t maxLen, size_t index) override;
+
+    /**
+     * Times the output was serialized so far
+     */
+    uint32_t refills() const { return refillCount; }
+
+private:
+    size_t serializeWindow(uint8_t* buffer, size_t maxLen, size_t index);
+
+    JsonArenaPool::Lease arena;   // Outlives `document`
+    JsonDocument document;
+    std::string prefix;
+
+    std::unique_ptr<uint8_t[]> cache;
+    size_t cacheStart;
+    size_t cacheLength;
+    uint32_t refillCount;
+};
+
+} // namespace mcp
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace mcp {
+
+/**
+ * Sequence lock around a small trivially copyable value.
+ *
+ * Readers never block and never write shared memory: they copy the value
+ * and retry if a store overlapped the copy, detected by the sequence
+ * number being odd or having moved. Writers must be serialized by the
+ * caller (e.g. by the object's own mutex); a store is a handful of
+ * relaxed word stores between two sequence bumps.
+ *
+ * The value is held as atomic 32-bit words, so an overlapping copy is a
+ * detected retry rather than a data race.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable value");
+
+public:
+    explicit SeqLock(const T& initial = T()) : sequence(0) {
+        store(initial);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    /**
+     * Publish a new value. Callers must not store concurrently.
+     */
+    void store(const T& value) {
+        uint32_t copy[WORDS] = {};
+        memcpy(copy, &value, sizeof(T));
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(copy[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Copy a consistent value, giving up after `attempts` overlapped tries.
+     * A reader that can preempt the writer on the same core should fall
+     * back to the writers' lock when this fails rather than spin.
+     * @return false if every attempt overlapped a store
+     */
+    bool tryLoad(T& value, uint32_t attempts) const {
+        uint32_t copy[WORDS];
+        for (uint32_t attempt = 0; attempt < attempts; attempt++) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; i++) {
+                copy[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                memcpy(&value, copy, sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Copy a consistent value, yielding between overlapped tries
+     */
+    T load() const {
+        T value;
+        while (!tryLoad(value, SPIN_ATTEMPTS)) {
+            std::this_thread::yield();
+        }
+        return value;
+    }
+
+    /**
+     * Incremented twice per store; odd while a store is in progress
+     */
+    uint32_t version() const { return sequence.load(std::memory_order_acquire); }
+
+    static const uint32_t SPIN_ATTEMPTS = 64;
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> words[WORDS];
+};
+
+} // namespace mcp
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * 64-bit monotonic timestamp in microseconds.
+ * Uses esp_timer on the device (does not wrap like micros()) and
+ * std::chrono::steady_clock on the host.
+ */
+uint64_t traceNowMicros();
+
+/**
+ * Identifier of the calling thread (FreeRTOS task on the device)
+ */
+uint32_t traceThreadId();
+
+/**
+ * Core the calling thread is currently running on
+ */
+uint8_t traceCoreId();
+
+/**
+ * One completed span as stored in the trace ring buffer
+ */
+struct SpanRecord {
+    static const size_t MAX_NAME_LENGTH = 32;
+
+    uint64_t start;                // Start timestamp (us)
+    uint32_t duration;             // Duration (us)
+    uint32_t threadId;             // Thread/task identifier
+    uint16_t depth;                // Nesting depth (0 = outermost span)
+    uint8_t core;                  // Core the span finished on
+    char name[MAX_NAME_LENGTH];    // Span name (truncated)
+};
+
+/**
+ * Lock-free span recorder.
+ *
+ * Completed spans are written into a fixed ring buffer: writers claim a slot
+ * with a single atomic increment and publish it with a per-slot sequence
+ * number, so recording never blocks and never allocates. When the buffer
+ * wraps, the oldest spans are overwritten.
+ */
+class SpanTracer {
+public:
+    static const size_t CAPACITY = 512;   // Must be a power of two
+
+    using Writer = std::function<void(const char* data, size_t length)>;
+
+    // Singleton instance access
+    static SpanTracer& getInstance() {
+        static SpanTracer instance;
+        return instance;
+    }
+
+    /**
+     * Enable or disable recording (enabled by default)
+     */
+    void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * Record a completed span
+     * @param name Span name (copied, may be truncated)
+     * @param start Start timestamp in microseconds
+     * @param end End timestamp in microseconds
+     * @param depth Nesting depth of the span on its thread
+     */
+    void record(const char* name, uint64_t start, uint64_t end, uint16_t depth);
+
+    /**
+     * Copy all currently published spans, oldest first
+     * @param out Vector receiving the spans (cleared first)
+     * @return Number of spans copied
+     */
+    size_t snapshot(std::vector<SpanRecord>& out) const;
+
+    /**
+     * Export the buffer as Chrome trace-event JSON (chrome://tracing, Perfetto)
+     * @param write Sink receiving the JSON text in pieces
+     * @return Number of span events written
+     */
+    size_t exportChromeTrace(const Writer& write) const;
+
+    /**
+     * Drop all recorded spans
+     */
+    void clear();
+
+    /**
+     * Total number of spans recorded since the last clear (including overwritten ones)
+     */
+    uint32_t totalRecorded() const { return head.load(std::memory_order_relaxed); }
+
+private:
+    SpanTracer();
+    SpanTracer(const SpanTracer&) = delete;
+    SpanTracer& operator=(const SpanTracer&) = delete;
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;   // 0 = empty/being written, else ticket + 1
+        SpanRecord record;
+    };
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    Slot slots[CAPACITY];
+    std::atomic<uint32_t> head;
+    std::atomic<bool> enabled;
+};
+
+/**
+ * RAII span: records the enclosing scope into the SpanTracer.
+ * Spans opened while another span is active on the same thread are nested.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* spanName);
+    ~TraceSpan();
+
+    uint64_t startMicros() const { return start; }
+
+private:
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    const char* name;
+    uint64_t start;
+    uint16_t depth;
+};
+
+#ifndef MCP_CONCAT
+#define MCP_CONCAT_INNER(a, b) a##b
+#define MCP_CONCAT(a, b) MCP_CONCAT_INNER(a, b)
+#endif
+
+// Macro for tracing a scoped operation; the variable is named after the
+// line, so several spans can be opened in one scope
+#define TRACE_SPAN(name) mcp::TraceSpan MCP_CONCAT(traceSpan_, __LINE__)(name)
+} // namespace mcp
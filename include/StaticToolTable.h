@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mcp {
+
+/**
+ * FNV-1a over a NUL-terminated name, usable in constant expressions
+ */
+constexpr uint32_t toolNameHash(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= static_cast<uint8_t>(*name++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+constexpr size_t toolTableSize(size_t n) {
+    size_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+constexpr bool toolNameEquals(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/**
+ * Minimal perfect hash over a fixed set of tool names.
+ *
+ * Built with hash-and-displace: names are grouped into buckets by their
+ * hash, and each bucket gets a displacement chosen so that every name lands
+ * in its own slot. The constructor is constexpr, so for names known at
+ * compile time the whole table is generated by the compiler:
+ *
+ *   static constexpr const char* NAMES[] = {"turnOn", "turnOff"};
+ *   static constexpr mcp::StaticToolTable<2> TABLE(NAMES);
+ *   static_assert(TABLE.valid(), "tool names collide");
+ *
+ * A lookup is one pass over the name to hash it, two array reads and one
+ * compare; there is no probing and nothing is allocated.
+ */
+template<size_t N>
+class StaticToolTable {
+    static_assert(N > 0, "StaticToolTable needs at least one name");
+    static_assert(N < 0xFFFF, "StaticToolTable holds at most 65534 names");
+
+public:
+    static constexpr uint16_t EMPTY = 0xFFFF;
+    static constexpr uint32_t MAX_DISPLACEMENT = 0xFFFF;
+
+    // Slots: power of two with load factor <= 0.5. Buckets: ~4 names each.
+    static constexpr size_t SLOTS = toolTableSize(N * 2);
+    static constexpr size_t BUCKETS = toolTableSize((N + 3) / 4);
+
+    constexpr explicit StaticToolTable(const char* const (&toolNames)[N])
+        : names{}, displacement{}, slots{}, built(false) {
+        for (size_t i = 0; i < N; i++) {
+            names[i] = toolNames[i];
+        }
+        built = build();
+    }
+
+    /**
+     * True if every name got its own slot (false for duplicate names)
+     */
+    constexpr bool valid() const { return built; }
+
+    static constexpr size_t size() { return N; }
+
+    constexpr const char* name(size_t index) const { return names[index]; }
+
+    /**
+     * @return Index of `name` in the constructor's array, or -1
+     */
+    constexpr int find(const char* name) const {
+        if (!built || !name) {
+            return -1;
+        }
+        uint32_t hash = toolNameHash(name);
+        uint16_t index = slots[slotOf(hash, displacement[hash & (BUCKETS - 1)])];
+        if (index == EMPTY || !toolNameEquals(names[index], name)) {
+            return -1;
+        }
+        return index;
+    }
+
+    /**
+     * Type-erased find, for holders that do not know N
+     */
+    static int findIn(const void* table, const char* name) {
+        return static_cast<const StaticToolTable*>(table)->find(name);
+    }
+
+private:
+    static constexpr size_t slotOf(uint32_t hash, uint32_t d) {
+        uint32_t mixed = (hash ^ (d * 0x9E3779B9u)) * 0x85EBCA6Bu;
+        return (mixed ^ (mixed >> 15)) & (SLOTS - 1);
+    }
+
+    constexpr bool build() {
+        uint32_t hashes[N] = {};
+        size_t bucketSize[BUCKETS] = {};
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = toolNameHash(names[i]);
+            bucketSize[hashes[i] & (BUCKETS - 1)]++;
+        }
+        size_t largest = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            largest = bucketSize[b] > largest ? bucketSize[b] : largest;
+        }
+        for (size_t s = 0; s < SLOTS; s++) {
+            slots[s] = EMPTY;
+        }
+
+        // Place the fullest buckets first, while most slots are still free
+        for (size_t size = largest; size > 0; size--) {
+            for (size_t b = 0; b < BUCKETS; b++) {
+                if (bucketSize[b] == size && !placeBucket(b, hashes)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    constexpr bool placeBucket(size_t bucket, const uint32_t* hashes) {
+        for (uint32_t d = 0; d <= MAX_DISPLACEMENT; d++) {
+            size_t chosen[N] = {};
+            size_t placed = 0;
+            bool fits = true;
+            for (size_t i = 0; i < N && fits; i++) {
+                if ((hashes[i] & (BUCKETS - 1)) != bucket) {
+                    continue;
+                }
+                size_t slot = slotOf(hashes[i], d);
+                fits = slots[slot] == EMPTY;
+                for (size_t p = 0; p < placed && fits; p++) {
+                    fits = chosen[p] != slot;
+                }
+                chosen[placed++] = slot;
+            }
+            if (!fits) {
+                continue;
+            }
+
+            placed = 0;
+            for (size_t i = 0; i < N; i++) {
+                if ((hashes[i] & (BUCKETS - 1)) == bucket) {
+                    slots[chosen[placed++]] = static_cast<uint16_t>(i);
+                }
+            }
+            displacement[bucket] = static_cast<uint16_t>(d);
+            return true;
+        }
+        return false;
+    }
+
+    const char* names[N];
+    uint16_t displacement[BUCKETS];
+    uint16_t slots[SLOTS];
+    bool built;
+};
+
+} // namespace mcp
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * Raw per-task counters as reported by the scheduler
+ */
+struct TaskSample {
+    static const size_t MAX_NAME_LENGTH = 16;
+
+    uint32_t id;                    // Task number (stable across samples)
+    char name[MAX_NAME_LENGTH];     // Task name
+    uint32_t runtime;               // Accumulated run-time counter
+    uint32_t stackHighWater;        // Minimum free stack seen (bytes)
+};
+
+/**
+ * Heap and PSRAM state at one point in time
+ */
+struct HeapSample {
+    size_t freeBytes;               // Free internal heap
+    size_t minFreeBytes;            // Lowest free heap since boot
+    size_t largestFreeBlock;        // Largest allocatable block
+    size_t psramTotal;              // PSRAM size (0 if not fitted)
+    size_t psramFree;               // Free PSRAM
+};
+
+/**
+ * Source of system statistics. The device implementation reads FreeRTOS and
+ * heap_caps; HostStatsSource is a settable stand-in for tests on Linux.
+ */
+class SystemStatsSource {
+public:
+    virtual ~SystemStatsSource() = default;
+
+    /**
+     * Read all tasks
+     * @param tasks Vector receiving one sample per task (cleared first)
+     * @param totalRuntime Receives the run-time counter of the scheduler clock
+     * @return true if run-time statistics are available
+     */
+    virtual bool sampleTasks(std::vector<TaskSample>& tasks, uint32_t& totalRuntime) = 0;
+
+    /**
+     * Read heap state
+     */
+    virtual HeapSample sampleHeap() = 0;
+};
+
+/**
+ * Host stand-in: returns whatever the test put into it
+ */
+class HostStatsSource : public SystemStatsSource {
+public:
+    HostStatsSource() : totalRuntime(0), heap{0, 0, 0, 0, 0} {}
+
+    /**
+     * Add or update a task; runtime is the absolute counter value
+     */
+    void setTask(uint32_t id, const char* name, uint32_t runtime, uint32_t stackHighWater);
+    void setTotalRuntime(uint32_t runtime) { totalRuntime = runtime; }
+    void setHeap(const HeapSample& sample) { heap = sample; }
+
+    bool sampleTasks(std::vector<TaskSample>& out, uint32_t& total) override;
+    HeapSample sampleHeap() override { return heap; }
+
+private:
+    std::vector<TaskSample> tasks;
+    uint32_t totalRuntime;
+    HeapSample heap;
+};
+
+#ifdef ARDUINO
+/**
+ * Device source backed by uxTaskGetSystemState() and heap_caps
+ */
+class EspStatsSource : public SystemStatsSource {
+public:
+    bool sampleTasks(std::vector<TaskSample>& tasks, uint32_t& totalRuntime) override;
+    HeapSample sampleHeap() override;
+};
+#endif
+
+/**
+ * Periodic collector for runtime system metrics.
+ *
+ * Every interval it samples per-task CPU share and stack high-water marks,
+ * heap fragmentation, PSRAM usage and the main loop latency, and publishes
+ * them as gauges through the sink.
+ *
+ * Samples are taken from one task at a time (tick() or the profiler task).
+ * The lock is only held to swap the loop counters and results, never while
+ * the sink or a collector runs, so recordLoopIteration() does not wait on a
+ * sample in progress.
+ */
+class SystemProfiler {
+public:
+    using GaugeSink = std::function<void(const char* name, double value)>;
+
+    // Publishes another component's statistics through the sink
+    using Collector = std::function<void(const GaugeSink& sink)>;
+
+    struct TaskUsage {
+        char name[TaskSample::MAX_NAME_LENGTH];
+        double cpuPercent;           // Share of one core since the last sample
+        uint32_t stackHighWater;     // Bytes
+    };
+
+    static const uint32_t DEFAULT_INTERVAL_MS = 5000;
+    static const size_t MAX_TRACKED_TASKS = 12;   // Keeps the gauge count bounded
+
+    SystemProfiler(SystemStatsSource& source, GaugeSink sink);
+    ~SystemProfiler();
+
+    /**
+     * Set the sampling interval
+     */
+    void setInterval(uint32_t intervalMs) { interval = intervalMs; }
+    uint32_t getInterval() const { return interval; }
+
+    /**
+     * Sample if at least one interval has passed since the last sample
+     * @param nowMs Current time in milliseconds
+     * @return true if a sample was taken
+     */
+    bool tick(uint64_t nowMs);
+
+    /**
+     * Take a sample immediately and publish it
+     */
+    void sample();
+
+    /**
+     * Run `collector` on every sample, after the system gauges. Components
+     * keep hot-path statistics in RAM (atomics, running sums) and publish
+     * them here, at the profiler's cadence, instead of per event.
+     */
+    void addCollector(Collector collector);
+
+    /**
+     * Report the duration of one main loop iteration
+     * @param micros Iteration duration in microseconds
+     */
+    void recordLoopIteration(uint32_t micros);
+
+    /**
+     * Per-task usage from the last sample, busiest first
+     */
+    std::vector<TaskUsage> getTaskUsage() const;
+
+    /**
+     * Heap fragmentation from the last sample: 1 - largestFreeBlock / freeBytes
+     */
+    double getFragmentation() const;
+
+#ifdef ARDUINO
+    /**
+     * Run the collector in its own FreeRTOS task at the configured interval
+     * @param core Core to pin the task to
+     * @return true if the task was created
+     */
+    bool start(uint8_t core = 1);
+
+    /**
+     * Ask the task to exit and wait until it has left sample(); the task
+     * deletes itself, so it never dies holding the lock
+     */
+    void stop();
+
+    /**
+     * Sink that registers and updates gauges in MetricsSystem
+     */
+    static GaugeSink metricsSink();
+#endif
+
+private:
+    SystemProfiler(const SystemProfiler&) = delete;
+    SystemProfiler& operator=(const SystemProfiler&) = delete;
+
+    void publishTasks();
+    void publishHeap();
+    void publishLoop(uint64_t sum, uint32_t count, uint32_t max);
+
+    SystemStatsSource& source;
+    GaugeSink sink;
+    uint32_t interval;
+    uint64_t lastSampleTime;
+    bool sampled;
+
+    // Only touched by the sampling task
+    std::vector<TaskSample> taskBuffer;
+    std::map<uint32_t, uint32_t> lastRuntime;   // Task id -> runtime at last sample
+    uint32_t lastTotalRuntime;
+    std::vector<TaskUsage> usageBuffer;
+
+    // Guarded by mutex
+    mutable std::mutex mutex;
+    std::vector<TaskUsage> taskUsage;
+    double fragmentation;
+    std::shared_ptr<const std::vector<Collector>> collectors;   // Replaced, never modified
+
+    // Loop latency accumulated since the last sample
+    uint64_t loopSum;
+    uint32_t loopCount;
+    uint32_t loopMax;
+
+#ifdef ARDUINO
+    void* taskHandle;
+    std::atomic<bool> stopping;
+    std::atomic<bool> stopped;
+    static void taskEntry(void* arg);
+#endif
+};
+
+} // namespace mcp
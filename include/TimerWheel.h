@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * Hierarchical timer wheel over a fixed pool of timers.
+ *
+ * Four levels of 64 slots cover 2^24 ticks; a timer goes into the level
+ * whose span holds its delay and is moved down a level when the wheel
+ * reaches its block, so schedule, cancel and fire are O(1) and each timer
+ * is cascaded at most three times. Timers further out than MAX_DELAY
+ * ticks wait in the top level and are re-placed until they are in range.
+ *
+ * Time only moves when advance() is called; its cost is the number of
+ * ticks passed plus the timers fired, independent of how many timers are
+ * pending. Ticks are compared modulo 2^32, so expiries must be within
+ * 2^31 ticks of now.
+ *
+ * Not thread-safe: callers serialize access. Timers are preallocated,
+ * so scheduling never allocates.
+ */
+class TimerWheel {
+public:
+    /**
+     * Handle of a scheduled timer: pool index plus a generation, so a
+     * handle kept after its timer fired or was cancelled never matches a
+     * newer timer. 0 is never a valid handle.
+     */
+    using TimerId = uint32_t;
+
+    /**
+     * Called for each expired timer, after it has been removed; may
+     * schedule or cancel timers
+     */
+    using FireFunc = std::function<void(TimerId id, uint32_t payload)>;
+
+    static const TimerId INVALID = 0;
+    static const uint32_t SLOT_BITS = 6;
+    static const uint32_t SLOTS = 1u << SLOT_BITS;
+    static const uint32_t LEVELS = 4;
+    static const uint32_t MAX_DELAY = (1u << (SLOT_BITS * LEVELS)) - 1;
+
+    /**
+     * @param capacity Maximum number of pending timers (at most 65535)
+     * @param startTick Initial value of the clock
+     */
+    explicit TimerWheel(size_t capacity, uint32_t startTick = 0);
+
+    /**
+     * Schedule a timer. One at or before now() fires on the next advance().
+     * @param expiry Tick at which the timer fires
+     * @param payload Value handed back when it fires
+     * @return INVALID if all timers are in use
+     */
+    TimerId schedule(uint32_t expiry, uint32_t payload);
+
+    /**
+     * @return false if the timer already fired or was cancelled
+     */
+    bool cancel(TimerId id);
+
+    bool pending(TimerId id) const;
+
+    /**
+     * Move the clock forward to `tick`, firing every timer that expires
+     * on the way, in expiry order. A tick before now() fires only timers
+     * already due.
+     * @return Number of timers fired
+     */
+    size_t advance(uint32_t tick, const FireFunc& fire);
+
+    /**
+     * Drop every timer and restart the clock at `tick`
+     */
+    void reset(uint32_t tick);
+
+    uint32_t now() const { return current; }
+    size_t size() const { return active; }
+    size_t capacity() const { return nodes.size(); }
+
+private:
+    // Wheel slots, then timers due on the next advance, then timers being fired
+    static const int DUE = LEVELS * SLOTS;
+    static const int FIRING = DUE + 1;
+    static const int BUCKETS = FIRING + 1;
+
+    struct Node {
+        uint32_t expiry;
+        uint32_t payload;
+        int32_t prev;
+        int32_t next;
+        int16_t bucket;         // -1 while free
+        uint16_t generation;
+    };
+
+    void place(int32_t index);
+    void link(int32_t index, int bucket);
+    void unlink(int32_t index);
+    void release(int32_t index);
+    void cascade(uint32_t level);
+    size_t fireBucket(int bucket, const FireFunc& fire);
+    TimerId idOf(int32_t index) const;
+    int32_t indexOf(TimerId id) const;
+
+    std::vector<Node> nodes;
+    int32_t heads[BUCKETS];
+    int32_t tails[BUCKETS];
+    int32_t freeList;
+    size_t active;
+    uint32_t current;
+};
+
+} // namespace mcp
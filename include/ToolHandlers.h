@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <functional>
+#include <utility>
+#include "AllocTracker.h"
+
+namespace mcp {
+
+/**
+ * Tool handler that reads params through a read-only view and writes its
+ * response into a document owned by the caller.
+ *
+ * Nothing is copied on the way in and the caller decides where the result
+ * lives, so a tools/call costs only the allocations the handler itself makes.
+ */
+class ViewToolHandler {
+public:
+    virtual ~ViewToolHandler() = default;
+
+    /**
+     * Run the tool
+     * @param params Arguments of the call (null if none were sent)
+     * @param result Empty document receiving the response
+     */
+    virtual void invoke(JsonVariantConst params, JsonDocument& result) = 0;
+};
+
+/**
+ * ViewToolHandler wrapping a lambda
+ */
+class SimpleToolHandler : public ViewToolHandler {
+public:
+    using HandlerFunc = std::function<void(JsonVariantConst params, JsonDocument& result)>;
+
+    explicit SimpleToolHandler(HandlerFunc func) : func_(std::move(func)) {}
+
+    void invoke(JsonVariantConst params, JsonDocument& result) override {
+        ALLOC_SCOPE_REPORT("mcp.request");
+        func_(params, result);
+    }
+
+private:
+    HandlerFunc func_;
+};
+
+} // namespace mcp
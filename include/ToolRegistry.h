@@ -0,0 +1,166 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "StaticToolTable.h"
+#include "ToolHandlers.h"
+#include "ToolValidator.h"
+
+namespace mcp {
+
+/**
+ * One input parameter of a tool
+ */
+struct ToolParam {
+    std::string name;
+    std::string type;          // JSON schema type, e.g. "integer"
+    std::string description;
+    bool required;
+    bool bounded = false;      // Enforce [minimum, maximum] on numbers
+    double minimum = 0;
+    double maximum = 0;
+};
+
+/**
+ * Tool as advertised in tools/list
+ */
+struct ToolDefinition {
+    std::string name;
+    std::string description;
+    std::vector<ToolParam> params;
+    bool readOnly = false;     // Only reads state; advertised as annotations.readOnlyHint
+    std::string coalesceParam; // Last write wins: a newer call differing only in this argument
+                               // makes a queued one redundant (see ToolWorker)
+    std::shared_ptr<ViewToolHandler> handler;
+    std::shared_ptr<const ToolValidator> validator;   // Compiled from params by addTool
+};
+
+/**
+ * Why callTool() did not run a tool
+ */
+struct ToolRejection {
+    const char* message = nullptr;                     // Prepared message; nullptr if no tool has the name
+    std::shared_ptr<const ToolValidator> validator;    // Keeps `message` alive if the tool is replaced
+};
+
+/**
+ * Pre-rendered tools/list result
+ */
+struct ToolsListCache {
+    std::string body;       // {"tools":[...]}
+    std::string etag;       // Quoted hash of body
+    uint32_t revision;      // Registry revision the body was rendered from
+};
+
+/**
+ * Registered MCP tools.
+ *
+ * Tool definitions do not change after boot, so the tools/list payload is
+ * rendered once into a buffer and served as-is until a tool is added or
+ * removed. Callers get a shared snapshot and can send it without holding
+ * the registry lock.
+ *
+ * Names covered by a StaticToolTable are resolved through its compile-time
+ * perfect hash; any other tool is found through a hash index rebuilt on
+ * every add/remove.
+ *
+ * Each tool's params are compiled into a ToolValidator when it is added,
+ * and callTool() rejects arguments that do not match before the handler
+ * runs, so handlers can read their fields without checking them again.
+ */
+class ToolRegistry {
+public:
+    ToolRegistry();
+
+    /**
+     * Resolve the table's names through its perfect hash.
+     * The table must outlive the registry (declare it static constexpr).
+     */
+    template<size_t N>
+    void setStaticTable(const StaticToolTable<N>& table) {
+        std::lock_guard<std::mutex> lock(mutex);
+        staticTable = &table;
+        staticFind = &StaticToolTable<N>::findIn;
+        staticToTool.assign(N, -1);
+        rebuildIndexLocked();
+    }
+
+    /**
+     * Register a tool, replacing any tool with the same name.
+     * Compiles the tool's params into its validator.
+     */
+    void addTool(ToolDefinition tool);
+
+    /**
+     * @return false if no tool has this name
+     */
+    bool removeTool(const char* name);
+
+    bool hasTool(const char* name) const;
+
+    /**
+     * @return true if the tool exists and is marked readOnly
+     */
+    bool isReadOnly(const char* name) const;
+
+    /**
+     * Key under which a call of a coalescing tool (one with a
+     * coalesceParam) supersedes queued calls with the same key: the tool
+     * name and every argument except the coalesceParam
+     * @return Empty if the tool does not coalesce or the arguments would be
+     *         rejected, so such calls always run
+     */
+    std::string coalesceKey(const char* name, JsonVariantConst arguments) const;
+
+    size_t size() const;
+
+    /**
+     * Incremented on every add/remove
+     */
+    uint32_t revision() const;
+
+    /**
+     * tools/list payload, rendered on first use after a change
+     */
+    std::shared_ptr<const ToolsListCache> toolsList();
+
+    /**
+     * Run a tool
+     * @param name Tool name
+     * @param arguments Call arguments (may be null)
+     * @param result Document receiving the tool's response
+     * @param rejection If not null, set to why the call was rejected
+     * @return false if no tool has this name or the arguments do not match
+     *         its schema; the handler is not run
+     */
+    bool callTool(const char* name, JsonVariantConst arguments, JsonDocument& result,
+                  ToolRejection* rejection = nullptr);
+
+    /**
+     * Write one tool's schema object into `out`
+     */
+    static void writeTool(const ToolDefinition& tool, JsonObject out);
+
+private:
+    const ToolDefinition* findLocked(const char* name) const;
+    void rebuildIndexLocked();
+    std::shared_ptr<const ToolsListCache> renderLocked() const;
+
+    std::vector<ToolDefinition> tools;   // In registration order
+
+    // Name lookup: static perfect hash first, then open-addressed index
+    const void* staticTable;
+    int (*staticFind)(const void* table, const char* name);
+    std::vector<int> staticToTool;       // Static table index -> tools index
+    std::vector<int> dynamicIndex;       // Hash slot -> tools index, -1 if empty
+
+    uint32_t currentRevision;
+    std::shared_ptr<const ToolsListCache> cache;
+    mutable std::mutex mutex;
+};
+
+} // namespace mcp
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mcp {
+
+struct ToolParam;
+
+/**
+ * A tool's input schema, compiled once at registration.
+ *
+ * Each declared parameter becomes one fixed-size check (name, type tag,
+ * required flag, optional range) in a flat array, with a name-sorted index
+ * over it. Validating a call is one pass over the members the client sent,
+ * each looked up in that index by binary search; required parameters are
+ * ticked off in a bit mask, so nothing scans the arguments object per
+ * parameter. Undeclared arguments are ignored. Rejection messages are
+ * complete, prefixed strings prepared at compile time and returned as is,
+ * so a rejected call formats and allocates nothing.
+ */
+class ToolValidator {
+public:
+    enum class FieldType : uint8_t {
+        Any,        // Unknown schema type: presence only
+        Integer,
+        Number,
+        String,
+        Boolean,
+        Object,
+        Array
+    };
+
+    struct FieldCheck {
+        std::string name;
+        FieldType type;
+        bool required;
+        bool bounded;
+        double minimum;
+        double maximum;
+    };
+
+    // Rejection messages, formatted once when the check is compiled
+    struct FieldErrors {
+        std::string missing;
+        std::string wrongType;
+        std::string outOfRange;
+    };
+
+    /**
+     * @param messagePrefix Prepended to every rejection message, e.g.
+     *        "Invalid arguments for setMode: "
+     */
+    static ToolValidator compile(const std::vector<ToolParam>& params, const std::string& messagePrefix = "");
+
+    /**
+     * Check call arguments against the schema
+     * @param arguments Arguments of the call (null if none were sent)
+     * @return nullptr if the call may reach the handler, otherwise the
+     *         prepared message for the first failing check; it lives as
+     *         long as the validator
+     */
+    const char* validate(JsonVariantConst arguments) const;
+
+    const std::vector<FieldCheck>& checks() const { return fields; }
+
+    static FieldType parseType(const std::string& type);
+    static const char* typeName(FieldType type);
+
+private:
+    // Required fields past this many are checked by lookup instead of the mask
+    static const size_t MASK_FIELDS = 64;
+
+    static bool matches(FieldType type, JsonVariantConst value);
+    int find(const char* name) const;
+
+    std::vector<FieldCheck> fields;     // In declaration order
+    std::vector<FieldErrors> errors;    // Parallel to `fields`
+    std::vector<uint16_t> byName;       // Indexes into `fields`, sorted by name
+    uint64_t requiredMask;              // Bit i: fields[i] is required
+    std::string notObject;
+};
+
+} // namespace mcp
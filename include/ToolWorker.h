@@ -0,0 +1,180 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "JsonArena.h"
+#include "McpDispatcher.h"
+#include "PriorityRequestQueue.h"
+#include "SystemProfiler.h"
+
+namespace mcp {
+
+/**
+ * Runs tool calls on a dedicated thread, off the network task.
+ *
+ * The HTTP endpoint parses a request on the AsyncTCP task (core 0) and, if
+ * it contains a tools/call, submits it here instead of dispatching inline.
+ * The worker dispatches it on its own thread (pinned to core 1 on the
+ * device) and hands the response to the request's completion callback, so
+ * a slow handler or LCD refresh never stalls other connections.
+ *
+ * Jobs run one at a time. submit() sorts each request into one of two
+ * lanes: CONTROL_LANE if any of its tool calls can change device state
+ * (turnOff, setMode, ...), STATUS_LANE if all of them are readOnly tools.
+ * Busy lanes are served 4:1 in favour of control, so a command is not stuck
+ * behind a burst of status polls; within a lane jobs run in submission
+ * order. Each lane is bounded; submit() refuses work when the request's lane
+ * is full so the caller can answer 503.
+ *
+ * Control calls of last-write-wins tools (setTemperature, setMode: see
+ * ToolDefinition::coalesceParam) coalesce while they wait: a newer call with
+ * the same key replaces the queued one, which then never runs. It may move
+ * past other waiting coalescing calls but never past anything else, so a
+ * queued sweep 20, 21, 22 costs one handler run and one LCD refresh and
+ * still lands after a turnOn sent before it. When the surviving call
+ * finishes, each caller it replaced gets its result under their own
+ * JSON-RPC id, oldest first, which is the state they would have seen had
+ * every call run. Queue depth and wait time are
+ * reported per lane through the QueueObserver; execution time is kept in
+ * Stats and published with publish().
+ */
+class ToolWorker {
+public:
+    using Completion = std::function<void(McpResponse&& response)>;
+    using ExecutionSink = std::function<void(uint32_t executionUs, size_t queueDepth)>;
+
+    struct Stats {
+        uint64_t submitted;     // Jobs accepted
+        uint64_t rejected;      // Jobs refused because the queue was full
+        uint64_t executed;      // Jobs dispatched
+        size_t depth;           // Jobs currently waiting
+        size_t highWater;       // Sum of the lanes' largest depths
+        uint64_t waitTotalUs;   // Sum of queue wait times
+        uint32_t waitMaxUs;     // Longest queue wait
+        uint64_t execTotalUs;   // Sum of execution times
+        uint32_t execMaxUs;     // Longest execution
+        uint64_t coalesced;     // Jobs answered with a newer job's result instead of running
+    };
+
+    enum Lane : size_t {
+        CONTROL_LANE = 0,   // Requests with a state-changing tool call
+        STATUS_LANE = 1,    // Requests that only call readOnly tools
+        LANE_COUNT = 2
+    };
+
+    static const size_t DEFAULT_QUEUE_SIZE = 8;   // Per lane
+    static const uint32_t CONTROL_WEIGHT = 4;
+    static const uint32_t STATUS_WEIGHT = 1;
+    static const uint32_t STACK_SIZE = 8192;
+
+    /**
+     * @param queueSize Capacity of each lane
+     * @param queueObserver Receives lane events; lanes are numbered as in Lane
+     */
+    ToolWorker(McpDispatcher& dispatcher, size_t queueSize = DEFAULT_QUEUE_SIZE,
+               QueueObserver* queueObserver = nullptr);
+
+    /**
+     * Arenas a JsonArenaPool needs so tool requests never fall back to the
+     * heap: every request both lanes can hold, the one running and the one
+     * being parsed on the network task, each with all of its leases
+     */
+    static constexpr size_t arenasFor(size_t queueSize) {
+        return (LANE_COUNT * queueSize + 2) * McpDispatcher::LEASES_PER_REQUEST;
+    }
+    ~ToolWorker();
+
+    /**
+     * Start the worker thread
+     * @param core Core to pin the thread to (device only)
+     * @return true if the worker is running
+     */
+    bool start(uint8_t core = 1);
+
+    /**
+     * Stop the worker; jobs still queued are answered with 503
+     */
+    void stop();
+
+    bool isRunning() const { return running.load(); }
+
+    /**
+     * Queue a parsed request in the lane McpDispatcher::readsOnly picks
+     * @param request Request document, moved into the job
+     * @param done Called on the worker thread with the response
+     * @param arena Arena the request was parsed into, released after the job
+     * @param session Event stream session of the client, 0 if none
+     * @return false if the request's lane is full or the worker is stopped
+     */
+    bool submit(JsonDocument&& request, Completion done, JsonArenaPool::Lease&& arena = JsonArenaPool::Lease(),
+                uint32_t session = 0);
+
+    void setExecutionSink(ExecutionSink executionSink) { sink = executionSink; }
+
+    /**
+     * Coalesce queued last-write-wins calls (on by default); off, every
+     * job runs as submitted
+     */
+    void setCoalescing(bool enabled) { coalescing.store(enabled); }
+
+    /**
+     * Totals over both lanes
+     */
+    Stats getStats() const;
+
+    QueueLaneStats laneStats(Lane lane) const { return queue.stats(lane); }
+
+    /**
+     * Publish mcp.worker.executed, mcp.worker.coalesced,
+     * mcp.worker.exec_avg_ms, mcp.worker.exec_max_ms (since boot) and
+     * mcp.worker.queue_depth.
+     * Register with SystemProfiler::addCollector.
+     */
+    void publish(const SystemProfiler::GaugeSink& gauges) const;
+
+private:
+    ToolWorker(const ToolWorker&) = delete;
+    ToolWorker& operator=(const ToolWorker&) = delete;
+
+    // Caller of a job that was replaced before it ran
+    struct Superseded {
+        std::string idJson;
+        Completion done;
+    };
+
+    struct Job {
+        JsonArenaPool::Lease arena;   // Outlives `request`
+        JsonDocument request;
+        Completion done;
+        uint32_t session = 0;
+        std::string coalesceKey;             // Empty unless the job may be coalesced
+        std::vector<Superseded> superseded;  // Answered with this job's result
+    };
+
+    void run();
+    void execute(Job& job);
+    bool push(Job&& job, Lane lane);
+
+    static McpResponse unavailable();
+
+    McpDispatcher& dispatcher;
+    PriorityRequestQueue<Job, LANE_COUNT> queue;
+    ExecutionSink sink;
+    std::atomic<bool> running;
+    std::atomic<bool> coalescing;
+    std::mutex lifecycleMutex;   // Orders submit() against stop()
+    std::thread thread;
+
+    mutable std::mutex statsMutex;
+    uint64_t executed;
+    uint64_t execTotalUs;
+    uint32_t execMaxUs;
+};
+
+} // namespace mcp
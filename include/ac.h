@@ -2,14 +2,11 @@
 #define AC_H
 
 #include <Arduino.h>
-
-// 空调工作模式枚举
-enum ACMode {
-    AC_MODE_AUTO = 0,        // 自动模式
-    AC_MODE_COOL = 1,        // 制冷模式
-    AC_MODE_HEAT = 2,        // 制热模式
-    AC_MODE_DEHUMIDIFY = 3   // 抽湿模式
-};
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include "ACResult.h"
+#include "SeqLock.h"
 
 // 温度范围常量
 const int MIN_TEMPERATURE = 16;  // 最低温度
@@ -18,17 +15,34 @@ const int MAX_TEMPERATURE = 30;  // 最高温度
 /**
  * 空调模拟类
  * 提供空调的基本功能和状态管理
+ *
+ * 写操作在状态锁内修改状态，并通过顺序锁 (SeqLock) 发布状态快照；
+ * 读取 (getState、各 get 方法、LCD刷新、getStatus) 只读快照，不加锁，
+ * 也不会读到写了一半的状态
  */
 class AirConditioner {
 private:
+    // 以下状态只在状态锁内读写，读者使用 published
     int mode;           // 工作模式 (使用ACMode枚举)
     int temperature;    // 设定温度
     bool isRunning;     // 工作状态 (true=运行中, false=已关闭)
+    uint32_t stateVersion; // 状态版本号 (每次状态变化递增)
+    mcp::SeqLock<ACState> published; // 已发布的状态快照 (无锁读取)
     
     // LCD相关
-    bool lcdEnabled;         // LCD是否启用
-    unsigned long lastUpdate; // 上次更新时间
+    std::atomic<bool> lcdEnabled; // LCD是否启用
+    unsigned long lastUpdate; // 上次更新时间 (LCD锁内访问)
     static const unsigned long UPDATE_INTERVAL = 1000; // 更新间隔(ms)
+    std::mutex lcdMutex;     // LCD锁: 串行化绘制，不阻塞状态读写
+    void refreshLCD(bool force); // 按快照绘制LCD
+
+    // 批量操作
+    mutable std::recursive_mutex stateMutex; // 状态锁 (网络任务与主循环共用)
+    int batchDepth;          // 批量操作嵌套层数
+    bool lcdPending;         // 批量操作期间推迟的LCD刷新
+
+    void markChanged();      // 状态已变化: 递增版本号、发布快照并通知监听者 (调用方持有状态锁)
+    std::function<void()> changeListener; // 状态变化监听者
 
 public:
     // 构造函数
@@ -36,14 +50,14 @@ public:
     
     // 协议中要求的获取描述的方法
     String description();
-    String listTools();
+    const String& listTools();          // 工具列表 (首次调用时生成)
     // 模式控制
-    String setMode(int newMode);          // 设置工作模式
+    ACResult setMode(int newMode);        // 设置工作模式
     int getMode() const;                // 获取工作模式
     String getModeString() const;       // 获取工作模式字符串
     
     // 温度控制
-    String setTemperature(int temp);      // 设置温度
+    ACResult setTemperature(int temp);    // 设置温度
     int getTemperature() const;         // 获取温度
     
     // 电源控制
@@ -53,13 +67,22 @@ public:
     String getStatusString() const;     // 获取状态字符串
     
     // 状态信息
+    ACState getState() const;           // 获取状态快照 (无锁)
+    uint32_t getStateVersion() const;   // 获取状态版本号
+    // 设置状态变化监听者: 在状态锁内调用，必须立即返回 (不可阻塞或回调空调)
+    void setChangeListener(std::function<void()> listener);
     String getFullStatus() const;       // 获取完整状态信息
     void reset();                       // 重置为默认设置
+    ACResult restoreState(const ACState& saved); // 恢复保存的状态 (启动时，不检查是否开机)
     
     // JSON接口
     String getStatusJSON() const;       // 获取JSON格式的状态信息
     bool setFromJSON(const String& jsonStr); // 从JSON字符串设置状态
     
+    // 批量操作: 期间持有状态锁，LCD刷新合并到 endBatch 时执行一次
+    void beginBatch();
+    void endBatch();
+    
     // LCD显示功能
     void clearLCD();
     bool initLCD(); // 初始化LCD
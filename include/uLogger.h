@@ -48,6 +48,13 @@ public:
      */
     bool logMetric(const char* name, const void* data, size_t dataSize);
 
+    /**
+     * Log several records with one open/append/close of the log file
+     * @param records Records to append, timestamps already set
+     * @return true if all records were written
+     */
+    bool logMetrics(const std::vector<Record>& records);
+
     /**
      * Query metric records
      * @param name Metric name (empty string for all metrics)
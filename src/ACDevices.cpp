@@ -0,0 +1,144 @@
+#include "ACDevices.h"
+#include <cstring>
+#include "StaticToolTable.h"
+
+static void storeMax(std::atomic<uint32_t>& max, uint32_t value) {
+    uint32_t seen = max.load(std::memory_order_relaxed);
+    while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+ACDevice::ACDevice(const char* deviceId, uint32_t bootId)
+    : id(deviceId), statusCache(bootId), toolCalls(0), lockWaitUs(0), lockWaits(0), maxLockWaitUs(0),
+      toolCallsName("ac." + id + ".tool_calls"), lockWaitAvgName("ac." + id + ".lock_wait_avg_us"),
+      lockWaitMaxName("ac." + id + ".lock_wait_max_us"), roomTemperatureName("ac." + id + ".room_temperature"),
+      outsideTemperatureName("ac." + id + ".outside_temperature"),
+      compressorDutyName("ac." + id + ".compressor_duty"), windowMaxLockWaitUs(0), publishedLockWaitUs(0),
+      publishedLockWaits(0) {}
+
+void ACDevice::recordLockWait(uint32_t waitUs) {
+    lockWaitUs.fetch_add(waitUs, std::memory_order_relaxed);
+    lockWaits.fetch_add(1, std::memory_order_relaxed);
+    storeMax(maxLockWaitUs, waitUs);
+    storeMax(windowMaxLockWaitUs, waitUs);
+}
+
+void ACDevice::publish(const mcp::SystemProfiler::GaugeSink& sink) {
+    uint64_t waitUs = lockWaitUs.load(std::memory_order_relaxed);
+    uint32_t waits = lockWaits.load(std::memory_order_relaxed);
+    uint32_t windowWaits = waits - publishedLockWaits;
+    sink(toolCallsName.c_str(), toolCalls.load(std::memory_order_relaxed));
+    sink(lockWaitAvgName.c_str(),
+         windowWaits ? static_cast<double>(waitUs - publishedLockWaitUs) / windowWaits : 0.0);
+    sink(lockWaitMaxName.c_str(), windowMaxLockWaitUs.exchange(0, std::memory_order_relaxed));
+    publishedLockWaitUs = waitUs;
+    publishedLockWaits = waits;
+
+    ACThermalReading reading = thermal.reading();
+    sink(roomTemperatureName.c_str(), ACThermalModel::toTenths(reading.room) / 10.0);
+    sink(outsideTemperatureName.c_str(), ACThermalModel::toTenths(reading.outside) / 10.0);
+    sink(compressorDutyName.c_str(), ACThermalModel::toPercent(reading.duty));
+}
+
+ACDeviceRegistry::ACDeviceRegistry() : simulating(false), simulatedMs(0) {}
+
+ACDevice* ACDeviceRegistry::add(const char* id) {
+    if (!id || !*id || strchr(id, '.') || strchr(id, '/') || find(id)) {
+        return nullptr;
+    }
+    // Random boot id per unit, so etags never match across units or reboots
+    devices.emplace_back(id, esp_random());
+    rebuildIndex();
+    return &devices.back();
+}
+
+ACDevice* ACDeviceRegistry::find(const char* id) const {
+    if (!id || index.empty()) {
+        return nullptr;
+    }
+    size_t mask = index.size() - 1;
+    for (size_t slot = mcp::toolNameHash(id) & mask;; slot = (slot + 1) & mask) {
+        int found = index[slot];
+        if (found < 0) {
+            return nullptr;
+        }
+        if (devices[found].id == id) {
+            return const_cast<ACDevice*>(&devices[found]);
+        }
+    }
+}
+
+ACDevice* ACDeviceRegistry::resolve(JsonVariantConst arguments) const {
+    JsonVariantConst device = arguments["device"];
+    if (device.isNull()) {
+        return defaultDevice();
+    }
+    return find(device.as<const char*>());
+}
+
+size_t ACDeviceRegistry::restoreStates(ACJournalStore& store) {
+    size_t restored = 0;
+    for (ACDevice& device : devices) {
+        device.journal.reset(new ACStateJournal(store, device.id.c_str()));
+        ACState saved;
+        if (device.journal->restore(saved) && device.ac.restoreState(saved).ok()) {
+            restored++;
+        }
+    }
+    return restored;
+}
+
+size_t ACDeviceRegistry::persistStates(uint32_t nowMs) {
+    size_t written = 0;
+    for (ACDevice& device : devices) {
+        if (device.journal && device.journal->poll(device.ac.getState(), nowMs)) {
+            written++;
+        }
+    }
+    return written;
+}
+
+uint32_t ACDeviceRegistry::simulate(uint32_t nowMs) {
+    const uint32_t tickMs = ACThermalModel::TICK_S * 1000;
+    if (!simulating) {
+        simulating = true;
+        simulatedMs = nowMs;
+        return 0;
+    }
+    uint32_t ticks = (nowMs - simulatedMs) / tickMs;
+    if (ticks == 0) {
+        return 0;
+    }
+    if (ticks > MAX_SIMULATION_TICKS) {
+        ticks = MAX_SIMULATION_TICKS;
+        simulatedMs = nowMs;
+    } else {
+        simulatedMs += ticks * tickMs;
+    }
+    for (ACDevice& device : devices) {
+        device.thermal.advance(device.ac.getState(), ticks);
+    }
+    return ticks;
+}
+
+void ACDeviceRegistry::publish(const mcp::SystemProfiler::GaugeSink& sink) {
+    for (ACDevice& device : devices) {
+        device.publish(sink);
+    }
+}
+
+ACDevice* ACDeviceRegistry::defaultDevice() const {
+    return devices.empty() ? nullptr : const_cast<ACDevice*>(&devices.front());
+}
+
+void ACDeviceRegistry::rebuildIndex() {
+    index.assign(mcp::toolTableSize(devices.size() * 2 + 1), -1);
+    size_t mask = index.size() - 1;
+    for (size_t i = 0; i < devices.size(); i++) {
+        size_t slot = mcp::toolNameHash(devices[i].id.c_str()) & mask;
+        while (index[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = static_cast<int>(i);
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <ArduinoJson.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ACStateJournal.h"
+#include "ACStatusCache.h"
+#include "ACThermalModel.h"
+#include "SystemProfiler.h"
+#include "ac.h"
+
+/**
+ * One indoor unit behind the gateway, with its own state, lock and
+ * getStatus cache
+ */
+struct ACDevice {
+    std::string id;
+    AirConditioner ac;
+    ACStatusCache statusCache;
+    std::unique_ptr<ACStateJournal> journal;   // Set by restoreStates()
+    ACThermalModel thermal;                    // Simulated room, stepped by simulate()
+
+    // Per-device counters since boot; only atomics are touched per call,
+    // publish() turns them into ac.<id>.* gauges
+    std::atomic<uint32_t> toolCalls;
+    std::atomic<uint64_t> lockWaitUs;      // Total time requests waited for this unit's lock
+    std::atomic<uint32_t> lockWaits;
+    std::atomic<uint32_t> maxLockWaitUs;
+
+    ACDevice(const char* deviceId, uint32_t bootId);
+
+    void recordLockWait(uint32_t waitUs);
+
+    /**
+     * Publish ac.<id>.tool_calls, .lock_wait_avg_us and .lock_wait_max_us
+     * over the time since the previous publish, and the room model's
+     * latest reading as .room_temperature, .outside_temperature and
+     * .compressor_duty. Call from one task (the profiler's).
+     */
+    void publish(const mcp::SystemProfiler::GaugeSink& sink);
+
+private:
+    // Gauge names, built once so publishing formats nothing
+    std::string toolCallsName;
+    std::string lockWaitAvgName;
+    std::string lockWaitMaxName;
+    std::string roomTemperatureName;
+    std::string outsideTemperatureName;
+    std::string compressorDutyName;
+
+    std::atomic<uint32_t> windowMaxLockWaitUs;   // Reset by publish()
+    uint64_t publishedLockWaitUs;                // Totals at the previous publish
+    uint32_t publishedLockWaits;
+};
+
+/**
+ * Indoor units served by this gateway.
+ *
+ * Tools pick a unit by their `device` argument or by a namespaced tool
+ * name ("bedroom.setMode"); calls without either go to the default unit,
+ * the first one added, which is also the one shown on the LCD.
+ *
+ * Units are added at boot, before the server starts, and never removed:
+ * they live in a deque so references handed to tools stay valid.
+ */
+class ACDeviceRegistry {
+public:
+    ACDeviceRegistry();
+
+    /**
+     * Add a unit
+     * @param id Unit name, used in tool names and resource URIs
+     * @return nullptr if the id is empty, contains '.' or '/', or is taken
+     */
+    ACDevice* add(const char* id);
+
+    /**
+     * @return nullptr if no unit has this id
+     */
+    ACDevice* find(const char* id) const;
+
+    /**
+     * Unit named by arguments["device"], or the default unit if the call
+     * has no device argument
+     * @return nullptr if the named unit does not exist
+     */
+    ACDevice* resolve(JsonVariantConst arguments) const;
+
+    /**
+     * Give every unit a state journal in `store` and restore the state it
+     * saved before the last reboot. Call once all units are added.
+     * @return Number of units whose state was restored
+     */
+    size_t restoreStates(ACJournalStore& store);
+
+    /**
+     * Save units whose state changed, once it has settled; call from the
+     * main loop
+     * @return Number of records written
+     */
+    size_t persistStates(uint32_t nowMs);
+
+    /**
+     * Step every unit's room model by the whole ticks elapsed since the
+     * last call; call from the main loop. After a stall longer than
+     * MAX_SIMULATION_TICKS the rest of the gap is skipped. Readings are
+     * only published into the models' snapshots; publish() reports them.
+     * @return Ticks stepped per unit (0 on the first call)
+     */
+    uint32_t simulate(uint32_t nowMs);
+
+    /**
+     * Publish every unit's gauges (see ACDevice::publish); register as a
+     * SystemProfiler collector
+     */
+    void publish(const mcp::SystemProfiler::GaugeSink& sink);
+
+    static const uint32_t MAX_SIMULATION_TICKS = 60;
+
+    ACDevice* defaultDevice() const;
+    size_t size() const { return devices.size(); }
+    ACDevice& at(size_t index) { return devices[index]; }
+
+private:
+    void rebuildIndex();
+
+    std::deque<ACDevice> devices;
+    std::vector<int> index;    // Hash slot -> devices index, -1 if empty
+    bool simulating;
+    uint32_t simulatedMs;      // Time up to which the models have been stepped
+};
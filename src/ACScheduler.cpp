@@ -0,0 +1,478 @@
+#include "ACScheduler.h"
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "ACStateJournal.h"
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#include <time.h>
+#endif
+
+static const uint8_t FILE_MAGIC_0 = 'S';
+static const uint8_t FILE_MAGIC_1 = 'C';
+static const uint8_t FILE_FORMAT = 1;
+static const uint32_t SECONDS_PER_DAY = 86400;
+static const uint8_t EVERY_DAY = 0x7F;
+static const uint8_t WEEKDAYS = 0x3E;   // 周一至周五
+static const uint8_t WEEKENDS = 0x41;   // 周六、周日
+static const char* DAY_NAMES[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+static_assert(ACScheduler::MAX_SCHEDULES <= 256, "schedule ids keep the slot in their low 8 bits");
+
+static void putU16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void putU32(uint8_t* out, uint32_t value) {
+    putU16(out, value & 0xFFFF);
+    putU16(out + 2, value >> 16);
+}
+
+static uint16_t getU16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return getU16(in) | (static_cast<uint32_t>(getU16(in + 2)) << 16);
+}
+
+uint32_t ScheduleClock::fromCivil(int year, int month, int day, int hour, int minute, int second) {
+    // 公历日期 -> 1970-01-01 起的天数
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = static_cast<int64_t>(era) * 146097 + dayOfEra - 719468;
+    return static_cast<uint32_t>(days * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second);
+}
+
+#ifdef ARDUINO
+// 早于此时间说明还没有从 NTP 同步
+static const time_t MIN_SYNCED_TIME = 1700000000;
+static const char* SCHEDULE_FILE = "/schedules.bin";
+static const char* SCHEDULE_TEMP_FILE = "/schedules.tmp";
+
+bool SystemScheduleClock::now(uint32_t& localSeconds) {
+    time_t utc = time(nullptr);
+    if (utc < MIN_SYNCED_TIME) {
+        return false;
+    }
+    struct tm local;
+    localtime_r(&utc, &local);
+    localSeconds = fromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                             local.tm_hour, local.tm_min, local.tm_sec);
+    return true;
+}
+
+bool LittleFSScheduleStore::load(std::vector<uint8_t>& data) {
+    if (!LittleFS.exists(SCHEDULE_FILE)) {
+        return false;
+    }
+    File file = LittleFS.open(SCHEDULE_FILE, "r");
+    if (!file) {
+        return false;
+    }
+    data.resize(file.size());
+    size_t got = file.read(data.data(), data.size());
+    file.close();
+    return got == data.size();
+}
+
+bool LittleFSScheduleStore::save(const std::vector<uint8_t>& data) {
+    File file = LittleFS.open(SCHEDULE_TEMP_FILE, "w");
+    if (!file) {
+        log_e("Failed to open %s", SCHEDULE_TEMP_FILE);
+        return false;
+    }
+    size_t put = file.write(data.data(), data.size());
+    file.close();
+    if (put != data.size()) {
+        LittleFS.remove(SCHEDULE_TEMP_FILE);
+        return false;
+    }
+    // LittleFS 的改名会原子地替换旧文件
+    return LittleFS.rename(SCHEDULE_TEMP_FILE, SCHEDULE_FILE);
+}
+#endif
+
+ACScheduler::ACScheduler(ScheduleClock& clock, ScheduleStore* store)
+    : clock(clock), store(store), entries(MAX_SCHEDULES), wheel(MAX_SCHEDULES),
+      armed(false), dirty(false), runCount(0), failureCount(0) {
+    for (size_t slot = MAX_SCHEDULES; slot > 0; slot--) {
+        entries[slot - 1].used = false;
+        entries[slot - 1].generation = 0;
+        entries[slot - 1].timer = mcp::TimerWheel::INVALID;
+        freeSlots.push_back(static_cast<uint16_t>(slot - 1));
+    }
+}
+
+void ACScheduler::setActionSink(ActionSink actionSink) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sink = std::move(actionSink);
+}
+
+bool ACScheduler::load() {
+    std::vector<uint8_t> data;
+    std::vector<ACSchedule> loaded;
+    bool ok = store && store->load(data) && decode(data, loaded);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    freeSlots.clear();
+    for (Entry& entry : entries) {
+        entry.used = false;
+        entry.timer = mcp::TimerWheel::INVALID;
+    }
+    for (const ACSchedule& schedule : loaded) {
+        Entry& entry = entries[schedule.id & 0xFF];
+        if (entry.used || !valid(schedule)) {
+            continue;
+        }
+        entry.schedule = schedule;
+        entry.used = true;
+        entry.generation = schedule.id >> 8;
+    }
+    for (size_t slot = MAX_SCHEDULES; slot > 0; slot--) {
+        if (!entries[slot - 1].used) {
+            freeSlots.push_back(static_cast<uint16_t>(slot - 1));
+        }
+    }
+    armed = false;
+    dirty = false;
+    return ok;
+}
+
+ACResultCode ACScheduler::add(ACSchedule& schedule) {
+    if (!valid(schedule)) {
+        return AC_ERR_INVALID_SCHEDULE;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeSlots.empty()) {
+        return AC_ERR_SCHEDULE_FULL;
+    }
+    size_t slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    Entry& entry = entries[slot];
+    entry.generation = (entry.generation + 1) & 0xFFFFFF;
+    if (entry.generation == 0) {
+        entry.generation = 1;
+    }
+    schedule.id = (entry.generation << 8) | static_cast<uint32_t>(slot);
+    entry.schedule = schedule;
+    entry.used = true;
+    dirty = true;
+    if (armed) {
+        arm(slot);
+    }
+    return AC_OK;
+}
+
+bool ACScheduler::remove(uint32_t id) {
+    size_t slot = id & 0xFF;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (slot >= entries.size() || !entries[slot].used || entries[slot].schedule.id != id) {
+        return false;
+    }
+    release(slot);
+    dirty = true;
+    return true;
+}
+
+std::vector<ACSchedule> ACScheduler::list(const char* device) const {
+    std::vector<ACSchedule> schedules;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        collect(schedules);
+    }
+    if (device) {
+        schedules.erase(std::remove_if(schedules.begin(), schedules.end(), [device](const ACSchedule& schedule) {
+            return strcmp(schedule.device, device) != 0;
+        }), schedules.end());
+    }
+    std::sort(schedules.begin(), schedules.end(), [](const ACSchedule& a, const ACSchedule& b) {
+        return a.minuteOfDay != b.minuteOfDay ? a.minuteOfDay < b.minuteOfDay : a.id < b.id;
+    });
+    return schedules;
+}
+
+bool ACScheduler::nextRunIn(uint32_t id, uint32_t& seconds) const {
+    size_t slot = id & 0xFF;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!armed || slot >= entries.size() || !entries[slot].used || entries[slot].schedule.id != id) {
+        return false;
+    }
+    seconds = nextOccurrence(entries[slot].schedule, wheel.now()) - wheel.now();
+    return true;
+}
+
+size_t ACScheduler::run() {
+    std::vector<ACSchedule> actions;
+    std::vector<uint8_t> file;
+    ActionSink runSink;
+    bool save = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t now;
+        if (clock.now(now)) {
+            uint32_t jump = now - wheel.now();
+            if (!armed || static_cast<int32_t>(jump) < 0 || jump > MAX_CATCH_UP_S) {
+                armAll(now);
+            }
+            wheel.advance(now, [this](mcp::TimerWheel::TimerId, uint32_t slot) {
+                fire(slot);
+            });
+        }
+        if (dirty && store) {
+            std::vector<ACSchedule> schedules;
+            collect(schedules);
+            encode(schedules, file);
+            dirty = false;
+            save = true;
+        }
+        if (!due.empty()) {
+            actions.swap(due);
+            runSink = sink;
+            runCount += actions.size();
+        }
+    }
+
+    // 锁外执行动作和写文件: 动作会加空调设备锁，而工具处理函数可能
+    // 持有设备锁再调用 add/remove
+    for (const ACSchedule& action : actions) {
+        if (runSink && runSink(action) != AC_OK) {
+            failureCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (save && !store->save(file)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        dirty = true;   // 下次 run 重试
+    }
+    return actions.size();
+}
+
+size_t ACScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return MAX_SCHEDULES - freeSlots.size();
+}
+
+uint32_t ACScheduler::runs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return runCount;
+}
+
+void ACScheduler::arm(size_t slot) {
+    Entry& entry = entries[slot];
+    entry.timer = wheel.schedule(nextOccurrence(entry.schedule, wheel.now()), static_cast<uint32_t>(slot));
+}
+
+void ACScheduler::armAll(uint32_t localSeconds) {
+    wheel.reset(localSeconds);
+    for (size_t slot = 0; slot < entries.size(); slot++) {
+        if (entries[slot].used) {
+            arm(slot);
+        }
+    }
+    armed = true;
+}
+
+void ACScheduler::release(size_t slot) {
+    Entry& entry = entries[slot];
+    wheel.cancel(entry.timer);
+    entry.timer = mcp::TimerWheel::INVALID;
+    entry.used = false;
+    freeSlots.push_back(static_cast<uint16_t>(slot));
+}
+
+// 时间轮回调: 定时器已被取出
+void ACScheduler::fire(size_t slot) {
+    Entry& entry = entries[slot];
+    if (!entry.used) {
+        return;
+    }
+    due.push_back(entry.schedule);
+    if (entry.schedule.days == 0) {
+        entry.timer = mcp::TimerWheel::INVALID;
+        release(slot);
+        dirty = true;
+    } else {
+        arm(slot);
+    }
+}
+
+void ACScheduler::collect(std::vector<ACSchedule>& out) const {
+    out.reserve(MAX_SCHEDULES - freeSlots.size());
+    for (const Entry& entry : entries) {
+        if (entry.used) {
+            out.push_back(entry.schedule);
+        }
+    }
+}
+
+bool ACScheduler::valid(const ACSchedule& schedule) {
+    if (schedule.minuteOfDay >= 24 * 60 || schedule.days > EVERY_DAY || schedule.power > AC_POWER_OFF) {
+        return false;
+    }
+    if (schedule.mode < -1 || schedule.temperature < 0 || memchr(schedule.device, '\0', sizeof(schedule.device)) == nullptr ||
+        schedule.device[0] == '\0') {
+        return false;
+    }
+    bool setsMode = schedule.mode >= 0 || schedule.temperature > 0;
+    if (schedule.power == AC_POWER_OFF && setsMode) {
+        return false;   // 关机后无法设置模式或温度
+    }
+    return schedule.power != AC_POWER_KEEP || setsMode;
+}
+
+uint32_t ACScheduler::nextOccurrence(const ACSchedule& schedule, uint32_t localSeconds) {
+    uint32_t today = localSeconds / SECONDS_PER_DAY;
+    for (uint32_t offset = 0; offset <= 7; offset++) {
+        uint32_t day = today + offset;
+        uint32_t at = day * SECONDS_PER_DAY + schedule.minuteOfDay * 60u;
+        if (at <= localSeconds) {
+            continue;
+        }
+        uint32_t weekday = (day + 4) % 7;   // 1970-01-01 是星期四
+        if (schedule.days == 0 || (schedule.days & (1u << weekday))) {
+            return at;
+        }
+    }
+    return localSeconds + 7 * SECONDS_PER_DAY;  // 掩码为空 (valid() 已排除)
+}
+
+bool ACScheduler::parseTime(const char* text, uint16_t& minuteOfDay) {
+    if (!text) {
+        return false;
+    }
+    int hour = 0;
+    int minute = 0;
+    int used = 0;
+    size_t length = strlen(text);
+    if (length < 4 || length > 5 || !isdigit(static_cast<unsigned char>(text[0])) ||
+        sscanf(text, "%2d:%2d%n", &hour, &minute, &used) != 2 || static_cast<size_t>(used) != length ||
+        text[length - 3] != ':' || hour > 23 || minute > 59 || hour < 0 || minute < 0) {
+        return false;
+    }
+    minuteOfDay = static_cast<uint16_t>(hour * 60 + minute);
+    return true;
+}
+
+void ACScheduler::formatTime(uint16_t minuteOfDay, char* out, size_t size) {
+    snprintf(out, size, "%02u:%02u", static_cast<unsigned>(minuteOfDay / 60), static_cast<unsigned>(minuteOfDay % 60));
+}
+
+bool ACScheduler::parseDays(const char* text, uint8_t& days) {
+    if (!text || strcmp(text, "daily") == 0) {
+        days = EVERY_DAY;
+        return true;
+    }
+    if (strcmp(text, "once") == 0) {
+        days = 0;
+        return true;
+    }
+    if (strcmp(text, "weekdays") == 0) {
+        days = WEEKDAYS;
+        return true;
+    }
+    if (strcmp(text, "weekends") == 0) {
+        days = WEEKENDS;
+        return true;
+    }
+    uint8_t mask = 0;
+    const char* token = text;
+    while (*token) {
+        while (*token == ' ') {
+            token++;
+        }
+        size_t length = strcspn(token, ", ");
+        int found = -1;
+        for (int day = 0; day < 7 && length == 3; day++) {
+            if (strncmp(token, DAY_NAMES[day], 3) == 0) {
+                found = day;
+            }
+        }
+        if (found < 0) {
+            return false;
+        }
+        mask |= 1u << found;
+        token += length;
+        while (*token == ' ' || *token == ',') {
+            token++;
+        }
+    }
+    if (mask == 0) {
+        return false;
+    }
+    days = mask;
+    return true;
+}
+
+void ACScheduler::formatDays(uint8_t days, char* out, size_t size) {
+    const char* name = days == EVERY_DAY ? "daily" : days == 0 ? "once" : days == WEEKDAYS ? "weekdays"
+                     : days == WEEKENDS ? "weekends" : nullptr;
+    if (name) {
+        snprintf(out, size, "%s", name);
+        return;
+    }
+    size_t used = 0;
+    out[0] = '\0';
+    for (int day = 0; day < 7; day++) {
+        if (days & (1u << day)) {
+            used += snprintf(out + used, used < size ? size - used : 0, used ? ",%s" : "%s", DAY_NAMES[day]);
+        }
+    }
+}
+
+void ACScheduler::encode(const std::vector<ACSchedule>& schedules, std::vector<uint8_t>& out) {
+    out.assign(HEADER_SIZE + schedules.size() * RECORD_SIZE + 4, 0);
+    out[0] = FILE_MAGIC_0;
+    out[1] = FILE_MAGIC_1;
+    out[2] = FILE_FORMAT;
+    putU16(&out[4], static_cast<uint16_t>(schedules.size()));
+    putU16(&out[6], static_cast<uint16_t>(RECORD_SIZE));
+
+    uint8_t* record = &out[HEADER_SIZE];
+    for (const ACSchedule& schedule : schedules) {
+        putU32(record, schedule.id);
+        putU16(record + 4, schedule.minuteOfDay);
+        record[6] = schedule.days;
+        record[7] = schedule.power;
+        record[8] = static_cast<uint8_t>(schedule.mode);
+        record[9] = static_cast<uint8_t>(schedule.temperature);
+        memcpy(record + 12, schedule.device, ACSchedule::DEVICE_ID_SIZE);
+        record += RECORD_SIZE;
+    }
+    size_t crcOffset = out.size() - 4;
+    putU32(&out[crcOffset], ACStateJournal::crc32(out.data(), crcOffset));
+}
+
+bool ACScheduler::decode(const std::vector<uint8_t>& data, std::vector<ACSchedule>& schedules) {
+    if (data.size() < HEADER_SIZE + 4 || data[0] != FILE_MAGIC_0 || data[1] != FILE_MAGIC_1 ||
+        data[2] != FILE_FORMAT || getU16(&data[6]) != RECORD_SIZE) {
+        return false;
+    }
+    size_t count = getU16(&data[4]);
+    size_t crcOffset = HEADER_SIZE + count * RECORD_SIZE;
+    if (data.size() != crcOffset + 4 || getU32(&data[crcOffset]) != ACStateJournal::crc32(data.data(), crcOffset)) {
+        return false;
+    }
+
+    schedules.clear();
+    const uint8_t* record = &data[HEADER_SIZE];
+    for (size_t i = 0; i < count; i++, record += RECORD_SIZE) {
+        ACSchedule schedule;
+        schedule.id = getU32(record);
+        schedule.minuteOfDay = getU16(record + 4);
+        schedule.days = record[6];
+        schedule.power = record[7];
+        schedule.mode = static_cast<int8_t>(record[8]);
+        schedule.temperature = static_cast<int8_t>(record[9]);
+        memcpy(schedule.device, record + 12, ACSchedule::DEVICE_ID_SIZE);
+        schedule.device[ACSchedule::DEVICE_ID_SIZE - 1] = '\0';
+        schedules.push_back(schedule);
+    }
+    return true;
+}
@@ -0,0 +1,216 @@
+#include "ACStateJournal.h"
+#include <string.h>
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#endif
+
+static const uint16_t RECORD_MAGIC = 0x5341;    // "AS"
+static const uint8_t RECORD_FORMAT = 1;
+static const size_t CRC_OFFSET = 12;
+
+static void putU32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// 序号可能回绕，按差值的符号比较
+static bool isNewer(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) > 0;
+}
+
+static std::string slotKey(const char* unitId, int slot) {
+    return std::string(unitId) + "/" + static_cast<char>('0' + slot);
+}
+
+bool MemoryJournalStore::read(const char* unitId, int slot, uint8_t* data, size_t size) {
+    auto it = slots.find(slotKey(unitId, slot));
+    if (it == slots.end() || it->second.size() < size) {
+        return false;
+    }
+    memcpy(data, it->second.data(), size);
+    return true;
+}
+
+bool MemoryJournalStore::write(const char* unitId, int slot, const uint8_t* data, size_t size) {
+    if (failWrites) {
+        return false;
+    }
+    slots[slotKey(unitId, slot)].assign(data, data + size);
+    writeCount++;
+    return true;
+}
+
+bool MemoryJournalStore::corrupt(const char* unitId, int slot, size_t offset) {
+    auto it = slots.find(slotKey(unitId, slot));
+    if (it == slots.end() || offset >= it->second.size()) {
+        return false;
+    }
+    it->second[offset] ^= 0xFF;
+    return true;
+}
+
+#ifdef ARDUINO
+static String slotPath(const char* unitId, int slot) {
+    return String("/ac_") + unitId + "_" + slot + ".bin";
+}
+
+bool LittleFSJournalStore::read(const char* unitId, int slot, uint8_t* data, size_t size) {
+    String path = slotPath(unitId, slot);
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    size_t got = file.read(data, size);
+    file.close();
+    return got == size;
+}
+
+bool LittleFSJournalStore::write(const char* unitId, int slot, const uint8_t* data, size_t size) {
+    File file = LittleFS.open(slotPath(unitId, slot), "w");
+    if (!file) {
+        log_e("Failed to open AC state journal slot %d for %s", slot, unitId);
+        return false;
+    }
+    size_t put = file.write(data, size);
+    file.close();
+    return put == size;
+}
+#endif
+
+ACStateJournal::ACStateJournal(ACJournalStore& store, const char* unitId, uint32_t debounceMs, uint32_t maxDelayMs)
+    : store(store), unit(unitId), debounceMs(debounceMs), maxDelayMs(maxDelayMs),
+      saved{false, 0, 0, 0}, hasSaved(false), lastSequence(0), seenVersion(0), dirty(false),
+      dirtySinceMs(0), lastChangeMs(0), writeCount(0), failureCount(0) {}
+
+bool ACStateJournal::restore(ACState& state) {
+    bool found = false;
+    for (int slot = 0; slot < 2; slot++) {
+        uint8_t record[RECORD_SIZE];
+        ACState candidate;
+        uint32_t sequence;
+        if (!store.read(unit.c_str(), slot, record, sizeof(record)) || !decode(record, candidate, sequence)) {
+            continue;
+        }
+        if (!found || isNewer(sequence, lastSequence)) {
+            saved = candidate;
+            lastSequence = sequence;
+            found = true;
+        }
+    }
+    hasSaved = found;
+    if (found) {
+        state = saved;
+    }
+    return found;
+}
+
+bool ACStateJournal::poll(const ACState& state, uint32_t nowMs) {
+    if (state.version != seenVersion) {
+        seenVersion = state.version;
+        lastChangeMs = nowMs;
+        if (!dirty) {
+            dirty = true;
+            dirtySinceMs = nowMs;
+        }
+    }
+    if (!dirty) {
+        return false;
+    }
+    // 改回了已保存的状态
+    if (hasSaved && sameSetting(state, saved)) {
+        dirty = false;
+        return false;
+    }
+    if (nowMs - lastChangeMs < debounceMs && nowMs - dirtySinceMs < maxDelayMs) {
+        return false;
+    }
+    if (!commit(state)) {
+        // 写入失败: 过一个防抖周期再试，避免每次循环都写闪存
+        lastChangeMs = nowMs;
+        dirtySinceMs = nowMs;
+        return false;
+    }
+    return true;
+}
+
+bool ACStateJournal::flush(const ACState& state) {
+    if (state.version != seenVersion) {
+        seenVersion = state.version;
+        dirty = true;
+    }
+    if (!dirty || (hasSaved && sameSetting(state, saved))) {
+        dirty = false;
+        return true;
+    }
+    return commit(state);
+}
+
+bool ACStateJournal::commit(const ACState& state) {
+    uint32_t sequence = lastSequence + 1;
+    uint8_t record[RECORD_SIZE];
+    encode(state, sequence, record);
+    // 覆盖较旧的槽位，最新的有效记录保持不动
+    if (!store.write(unit.c_str(), sequence & 1, record, sizeof(record))) {
+        failureCount++;
+        return false;
+    }
+    saved = state;
+    hasSaved = true;
+    lastSequence = sequence;
+    dirty = false;
+    writeCount++;
+    return true;
+}
+
+bool ACStateJournal::sameSetting(const ACState& a, const ACState& b) {
+    return a.running == b.running && a.mode == b.mode && a.temperature == b.temperature;
+}
+
+void ACStateJournal::encode(const ACState& state, uint32_t sequence, uint8_t* record) {
+    record[0] = RECORD_MAGIC & 0xFF;
+    record[1] = RECORD_MAGIC >> 8;
+    record[2] = RECORD_FORMAT;
+    record[3] = state.running ? 1 : 0;
+    putU32(record + 4, sequence);
+    record[8] = static_cast<uint8_t>(state.mode);
+    record[9] = static_cast<uint8_t>(state.temperature);
+    record[10] = 0;
+    record[11] = 0;
+    putU32(record + CRC_OFFSET, crc32(record, CRC_OFFSET));
+}
+
+bool ACStateJournal::decode(const uint8_t* record, ACState& state, uint32_t& sequence) {
+    if (record[0] != (RECORD_MAGIC & 0xFF) || record[1] != (RECORD_MAGIC >> 8) || record[2] != RECORD_FORMAT) {
+        return false;
+    }
+    if (getU32(record + CRC_OFFSET) != crc32(record, CRC_OFFSET)) {
+        return false;
+    }
+    state.running = (record[3] & 1) != 0;
+    state.mode = record[8];
+    state.temperature = record[9];
+    state.version = 0;
+    sequence = getU32(record + 4);
+    return true;
+}
+
+uint32_t ACStateJournal::crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
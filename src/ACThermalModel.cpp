@@ -0,0 +1,153 @@
+#include "ACThermalModel.h"
+
+static const uint32_t SECONDS_PER_HOUR = 3600;
+static const uint32_t SECONDS_PER_DAY = 86400;
+static const uint32_t COLDEST_SECOND = 4 * SECONDS_PER_HOUR;     // 室外最低温度的时刻
+
+ACThermalParams ACThermalParams::defaults() {
+    ACThermalParams params;
+    params.outsideMean = ACThermalModel::fromTenths(300);
+    params.outsideSwing = ACThermalModel::fromTenths(50);
+    params.initialRoom = ACThermalModel::fromTenths(300);
+    params.startSecondOfDay = 0;
+    params.insulationS = 3 * SECONDS_PER_HOUR;
+    params.capacityPerHour = ACThermalModel::fromTenths(80);
+    params.bandWidth = ACThermalModel::ONE;
+    params.integralS = 900;
+    params.rampS = 60;
+    return params;
+}
+
+ACThermalModel::ACThermalModel(const ACThermalParams& initial)
+    : params(initial), room(initial.initialRoom), duty(0), integral(0), carry(0), direction(0),
+      seconds(0), secondOfDay(initial.startSecondOfDay % SECONDS_PER_DAY), outside(0) {
+    if (params.insulationS == 0) {
+        params.insulationS = 1;
+    }
+    if (params.bandWidth <= 0) {
+        params.bandWidth = 1;
+    }
+    if (params.integralS == 0) {
+        params.integralS = 1;
+    }
+    if (params.rampS == 0) {
+        params.rampS = 1;
+    }
+    outside = outsideAt(secondOfDay);
+    published.store(ACThermalReading{room, outside, duty, seconds});
+}
+
+void ACThermalModel::step(const ACState& state) {
+    integrate(state);
+    published.store(ACThermalReading{room, outside, duty, seconds});
+}
+
+void ACThermalModel::advance(const ACState& state, uint32_t ticks) {
+    if (ticks == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < ticks; i++) {
+        integrate(state);
+    }
+    published.store(ACThermalReading{room, outside, duty, seconds});
+}
+
+int32_t ACThermalModel::fromTenths(int32_t tenths) {
+    int64_t scaled = static_cast<int64_t>(tenths) * ONE;
+    return static_cast<int32_t>((scaled + (scaled >= 0 ? 5 : -5)) / 10);
+}
+
+int32_t ACThermalModel::toTenths(int32_t fixed) {
+    int64_t scaled = static_cast<int64_t>(fixed) * 10;
+    return static_cast<int32_t>((scaled + (scaled >= 0 ? ONE / 2 : -ONE / 2)) / ONE);
+}
+
+int32_t ACThermalModel::toPercent(int32_t fixed) {
+    int64_t scaled = static_cast<int64_t>(fixed) * 100;
+    return static_cast<int32_t>((scaled + (scaled >= 0 ? ONE / 2 : -ONE / 2)) / ONE);
+}
+
+void ACThermalModel::integrate(const ACState& state) {
+    outside = outsideAt(secondOfDay);
+
+    // 压缩机负荷向目标靠拢，每步最多变化 ONE * TICK_S / rampS
+    int32_t target = targetDuty(state);
+    int32_t maxStep = static_cast<int32_t>(static_cast<int64_t>(ONE) * TICK_S / params.rampS);
+    if (maxStep < 1) {
+        maxStep = 1;
+    }
+    if (target > duty + maxStep) {
+        duty += maxStep;
+    } else if (target < duty - maxStep) {
+        duty -= maxStep;
+    } else {
+        duty = target;
+    }
+
+    // 室温变化率 (°C/h): 向室外散热 + 压缩机制冷/制热
+    int64_t ratePerHour = static_cast<int64_t>(outside - room) * SECONDS_PER_HOUR / params.insulationS;
+    ratePerHour += direction * ((static_cast<int64_t>(params.capacityPerHour) * duty) >> FRAC_BITS);
+
+    // 除不尽的部分留在 carry 中，下一步继续累加
+    carry += ratePerHour * TICK_S;
+    int64_t delta = carry / SECONDS_PER_HOUR;
+    carry -= delta * SECONDS_PER_HOUR;
+    room += static_cast<int32_t>(delta);
+
+    seconds += TICK_S;
+    secondOfDay = (secondOfDay + TICK_S) % SECONDS_PER_DAY;
+}
+
+// PI 调节: 比例项 error / bandWidth，积分项每秒累加 error / (bandWidth * integralS)
+int32_t ACThermalModel::targetDuty(const ACState& state) {
+    if (!state.running) {
+        integral = 0;
+        return 0;
+    }
+
+    int32_t setpoint = state.temperature * ONE;
+    int8_t wanted = direction;
+    switch (state.mode) {
+        case AC_MODE_COOL:
+        case AC_MODE_DEHUMIDIFY:
+            wanted = -1;
+            break;
+        case AC_MODE_HEAT:
+            wanted = 1;
+            break;
+        default:
+            if (room > setpoint + ONE / 2) {
+                wanted = -1;
+            } else if (room < setpoint - ONE / 2) {
+                wanted = 1;
+            }
+            break;
+    }
+    if (wanted != direction) {
+        // 换向时压缩机先停下，积分从零开始
+        if (duty > 0) {
+            return 0;
+        }
+        direction = wanted;
+        integral = 0;
+    }
+    if (direction == 0) {
+        return 0;
+    }
+
+    int64_t error = direction < 0 ? room - setpoint : setpoint - room;
+    int64_t next = integral + error * ONE * TICK_S / (static_cast<int64_t>(params.bandWidth) * params.integralS);
+    integral = static_cast<int32_t>(next < 0 ? 0 : next > ONE ? ONE : next);
+
+    int32_t limit = state.mode == AC_MODE_DEHUMIDIFY ? ONE / 2 : ONE;
+    int64_t output = error * ONE / params.bandWidth + integral;
+    return static_cast<int32_t>(output < 0 ? 0 : output > limit ? limit : output);
+}
+
+// 三角波: 04:00 最低 (平均 - 幅度)，16:00 最高 (平均 + 幅度)
+int32_t ACThermalModel::outsideAt(uint32_t second) const {
+    uint32_t sinceColdest = (second + SECONDS_PER_DAY - COLDEST_SECOND) % SECONDS_PER_DAY;
+    uint32_t fromColdest = sinceColdest <= SECONDS_PER_DAY / 2 ? sinceColdest : SECONDS_PER_DAY - sinceColdest;
+    int64_t rise = static_cast<int64_t>(params.outsideSwing) * 2 * fromColdest / (SECONDS_PER_DAY / 2);
+    return static_cast<int32_t>(params.outsideMean - params.outsideSwing + rise);
+}
@@ -1,105 +1,404 @@
 #include "ACTools.h"
 #include <ArduinoJson.h>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include "ACStatusCache.h"
+#include "SpanTracer.h"
+#include "ToolHandlers.h"
 
-// Helper class to simplify tool creation
-class SimpleToolHandler : public ToolHandler {
-public:
-    using HandlerFunc = std::function<JsonDocument(JsonDocument)>;
-    SimpleToolHandler(HandlerFunc func) : func_(func) {}
-    JsonDocument call(JsonDocument params) override {
-        return func_(params);
-    }
-private:
-    HandlerFunc func_;
+using mcp::SimpleToolHandler;
+using mcp::ToolDefinition;
+
+// Names of the AC tools, resolved through a compile-time perfect hash
+static constexpr const char* AC_TOOL_NAMES[] = {
+    "turnOn", "turnOff", "setMode", "setTemperature", "getStatus", "getRoomTemperature"
 };
+static constexpr mcp::StaticToolTable<6> AC_TOOL_TABLE(AC_TOOL_NAMES);
+static_assert(AC_TOOL_TABLE.valid(), "AC tool names must be unique");
+
+// Readings in °C with one decimal and duty in percent; fixed point up to here
+static void writeThermalReading(const ACThermalReading& reading, JsonObject out) {
+    out["code"] = 0;
+    out["roomTemperature"] = ACThermalModel::toTenths(reading.room) / 10.0;
+    out["outsideTemperature"] = ACThermalModel::toTenths(reading.outside) / 10.0;
+    out["compressorDuty"] = ACThermalModel::toPercent(reading.duty);
+    out["simulatedSeconds"] = reading.seconds;
+}
+
+// Helper to simplify tool creation
+static std::shared_ptr<mcp::ViewToolHandler> makeHandler(SimpleToolHandler::HandlerFunc func) {
+    return std::make_shared<SimpleToolHandler>(std::move(func));
+}
+
+using DeviceToolFunc = std::function<void(ACDevice& device, JsonVariantConst params, JsonDocument& result)>;
+
+// Runs `func` on the unit the call is for: `fixed` for namespaced tools,
+// otherwise the one named by the `device` argument. Only tools that change
+// the unit take its lock.
+static std::shared_ptr<mcp::ViewToolHandler> makeDeviceHandler(ACDeviceRegistry& devices, ACDevice* fixed,
+                                                               DeviceToolFunc func, bool readOnly = false) {
+    return makeHandler([&devices, fixed, func, readOnly](JsonVariantConst params, JsonDocument& result) {
+        ACDevice* device = fixed ? fixed : devices.resolve(params);
+        if (!device) {
+            writeErrorResult(AC_ERR_UNKNOWN_DEVICE, result.to<JsonObject>());
+            return;
+        }
+        if (readOnly) {
+            ACDeviceScope::observe(*device);
+        } else {
+            ACDeviceScope::enter(*device);
+        }
+        func(*device, params, result);
+    });
+}
+
+// The six AC tools, for one unit (`fixed`) or routed by argument
+static void addDeviceTools(mcp::ToolRegistry& registry, ACDeviceRegistry& devices, ACDevice* fixed) {
+    std::string prefix = fixed ? fixed->id + "." : std::string();
+    std::string unit = fixed ? " (unit " + fixed->id + ")" : std::string();
+    auto addDeviceParam = [fixed](ToolDefinition& tool) {
+        if (!fixed) {
+            tool.params.push_back({"device", "string", "Indoor unit id; the default unit if omitted", false});
+        }
+    };
 
-void registerACTools(MCPServer& server, AirConditioner& ac) {
     // 1. turnOn Tool
-    Tool turnOnTool;
-    turnOnTool.name = "turnOn";
-    turnOnTool.description = "Turn on the air conditioner";
-    turnOnTool.inputSchema.type = "object";
-    
-    turnOnTool.handler = std::make_shared<SimpleToolHandler>([&ac](JsonDocument params) {
-        ac.turnOn();
-        JsonDocument result;
+    ToolDefinition turnOnTool;
+    turnOnTool.name = prefix + "turnOn";
+    turnOnTool.description = "Turn on the air conditioner" + unit;
+    addDeviceParam(turnOnTool);
+
+    turnOnTool.handler = makeDeviceHandler(devices, fixed, [](ACDevice& device, JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.turnOn");
+        device.ac.turnOn();
         result["status"] = "on";
-        return result;
     });
-    server.RegisterTool(turnOnTool);
+    registry.addTool(std::move(turnOnTool));
 
     // 2. turnOff Tool
-    Tool turnOffTool;
-    turnOffTool.name = "turnOff";
-    turnOffTool.description = "Turn off the air conditioner";
-    turnOffTool.inputSchema.type = "object";
+    ToolDefinition turnOffTool;
+    turnOffTool.name = prefix + "turnOff";
+    turnOffTool.description = "Turn off the air conditioner" + unit;
+    addDeviceParam(turnOffTool);
 
-    turnOffTool.handler = std::make_shared<SimpleToolHandler>([&ac](JsonDocument params) {
-        ac.turnOff();
-        JsonDocument result;
+    turnOffTool.handler = makeDeviceHandler(devices, fixed, [](ACDevice& device, JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.turnOff");
+        device.ac.turnOff();
         result["status"] = "off";
-        return result;
     });
-    server.RegisterTool(turnOffTool);
+    registry.addTool(std::move(turnOffTool));
 
     // 3. setMode Tool
-    Tool setModeTool;
-    setModeTool.name = "setMode";
-    setModeTool.description = "Set AC mode (0: Auto, 1: Cool, 2: Heat, 3: Dehumidify)";
-    setModeTool.inputSchema.type = "object";
-    
-    Properties modeProp;
-    modeProp.type = "integer";
-    modeProp.description = "Mode value";
-    setModeTool.inputSchema.properties["mode"] = modeProp;
-    setModeTool.inputSchema.required.push_back("mode");
-
-    setModeTool.handler = std::make_shared<SimpleToolHandler>([&ac](JsonDocument params) {
+    ToolDefinition setModeTool;
+    setModeTool.name = prefix + "setMode";
+    setModeTool.description = "Set AC mode (0: Auto, 1: Cool, 2: Heat, 3: Dehumidify)" + unit;
+    setModeTool.params.push_back({"mode", "integer", "Mode value", true, true, AC_MODE_AUTO, AC_MODE_DEHUMIDIFY});
+    addDeviceParam(setModeTool);
+    setModeTool.coalesceParam = "mode";
+
+    setModeTool.handler = makeDeviceHandler(devices, fixed, [](ACDevice& device, JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.setMode");
         int mode = params["mode"];
-        String res = ac.setMode(mode);
-        JsonDocument result;
-        DeserializationError error = deserializeJson(result, res);
-        if (error) {
-            result["error"] = "Internal error parsing AC response";
-        }
-        return result;
+        writeModeResult(device.ac.setMode(mode), result.to<JsonObject>());
     });
-    server.RegisterTool(setModeTool);
+    registry.addTool(std::move(setModeTool));
 
     // 4. setTemperature Tool
-    Tool setTempTool;
-    setTempTool.name = "setTemperature";
-    setTempTool.description = "Set AC temperature (16-30)";
-    setTempTool.inputSchema.type = "object";
-    
-    Properties tempProp;
-    tempProp.type = "integer";
-    tempProp.description = "Temperature value";
-    setTempTool.inputSchema.properties["temperature"] = tempProp;
-    setTempTool.inputSchema.required.push_back("temperature");
-
-    setTempTool.handler = std::make_shared<SimpleToolHandler>([&ac](JsonDocument params) {
+    ToolDefinition setTempTool;
+    setTempTool.name = prefix + "setTemperature";
+    setTempTool.description = "Set AC temperature (16-30)" + unit;
+    setTempTool.params.push_back({"temperature", "integer", "Temperature value", true, true, MIN_TEMPERATURE, MAX_TEMPERATURE});
+    addDeviceParam(setTempTool);
+    setTempTool.coalesceParam = "temperature";
+
+    setTempTool.handler = makeDeviceHandler(devices, fixed, [](ACDevice& device, JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.setTemperature");
         int temp = params["temperature"];
-        String res = ac.setTemperature(temp);
-        JsonDocument result;
-        deserializeJson(result, res);
-        return result;
+        writeTemperatureResult(device.ac.setTemperature(temp), result.to<JsonObject>());
     });
-    server.RegisterTool(setTempTool);
+    registry.addTool(std::move(setTempTool));
 
     // 5. getStatus Tool
-    Tool getStatusTool;
-    getStatusTool.name = "getStatus";
-    getStatusTool.description = "Get AC status";
-    getStatusTool.inputSchema.type = "object";
-
-    getStatusTool.handler = std::make_shared<SimpleToolHandler>([&ac](JsonDocument params) {
-        String json = ac.getStatusJSON();
-        JsonDocument result;
-        deserializeJson(result, json);
-        return result;
+    ToolDefinition getStatusTool;
+    getStatusTool.name = prefix + "getStatus";
+    getStatusTool.description = "Get AC status" + unit;
+    getStatusTool.readOnly = true;
+    getStatusTool.params.push_back({"ifNoneMatch", "string", "etag of a previous reply; answered with notModified while unchanged", false});
+    addDeviceParam(getStatusTool);
+
+    getStatusTool.handler = makeDeviceHandler(devices, fixed, [](ACDevice& device, JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.getStatus");
+        device.statusCache.write(device.ac.getState(), params["ifNoneMatch"].as<const char*>(), result);
+    }, true);
+    registry.addTool(std::move(getStatusTool));
+
+    // 6. getRoomTemperature Tool
+    ToolDefinition roomTool;
+    roomTool.name = prefix + "getRoomTemperature";
+    roomTool.description = "Get the simulated room and outside temperature and compressor duty" + unit;
+    roomTool.readOnly = true;
+    addDeviceParam(roomTool);
+
+    roomTool.handler = makeDeviceHandler(devices, fixed, [](ACDevice& device, JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.getRoomTemperature");
+        writeThermalReading(device.thermal.reading(), result.to<JsonObject>());
+    }, true);
+    registry.addTool(std::move(roomTool));
+}
+
+void registerACTools(mcp::ToolRegistry& registry, ACDeviceRegistry& devices, bool namespacedTools) {
+    registry.setStaticTable(AC_TOOL_TABLE);
+    addDeviceTools(registry, devices, nullptr);
+
+    if (namespacedTools && devices.size() > 1) {
+        for (size_t i = 0; i < devices.size(); i++) {
+            addDeviceTools(registry, devices, &devices.at(i));
+        }
+    }
+}
+
+void registerACResources(mcp::ResourceHub& hub, ACDeviceRegistry& devices) {
+    static const char* AC_STATE_URI = "ac://state";
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        ACDevice& device = devices.at(i);
+        bool isDefault = &device == devices.defaultDevice();
+        std::string uri = "ac://" + device.id + "/state";
+
+        mcp::ResourceDefinition state;
+        state.uri = uri;
+        state.name = "AC state (" + device.id + ")";
+        state.description = "Power, mode and target temperature of unit " + device.id;
+        state.mimeType = "application/json";
+        state.read = [&device](JsonDocument& contents) {
+            writeACState(device.ac.getState(), contents.to<JsonObject>());
+        };
+        if (isDefault) {
+            mcp::ResourceDefinition alias = state;
+            alias.uri = AC_STATE_URI;
+            alias.name = "AC state";
+            alias.description = "Power, mode and target temperature of the air conditioner";
+            hub.addResource(std::move(alias));
+        }
+        hub.addResource(std::move(state));
+
+        // Runs inside the unit's lock; notifyUpdated() only bumps a revision
+        device.ac.setChangeListener([&hub, uri, isDefault]() {
+            if (isDefault) {
+                hub.notifyUpdated(AC_STATE_URI);
+            }
+            hub.notifyUpdated(uri.c_str());
+        });
+    }
+}
+
+// Schedule as returned by the schedule tools
+static void writeSchedule(const ACScheduler& scheduler, const ACSchedule& schedule, JsonObject out) {
+    char time[8];
+    char days[32];
+    ACScheduler::formatTime(schedule.minuteOfDay, time, sizeof(time));
+    ACScheduler::formatDays(schedule.days, days, sizeof(days));
+    out["id"] = schedule.id;
+    out["device"] = static_cast<const char*>(schedule.device);
+    out["time"] = static_cast<const char*>(time);
+    out["days"] = static_cast<const char*>(days);
+    if (schedule.power != AC_POWER_KEEP) {
+        out["power"] = schedule.power == AC_POWER_ON ? "on" : "off";
+    }
+    if (schedule.mode >= 0) {
+        out["mode"] = schedule.mode;
+    }
+    if (schedule.temperature > 0) {
+        out["temperature"] = schedule.temperature;
+    }
+    uint32_t seconds;
+    if (scheduler.nextRunIn(schedule.id, seconds)) {
+        out["nextRunIn"] = seconds;
+    }
+}
+
+void registerACScheduleTools(mcp::ToolRegistry& registry, ACDeviceRegistry& devices, ACScheduler& scheduler) {
+    scheduler.setActionSink([&devices](const ACSchedule& schedule) {
+        return applyACSchedule(devices, schedule);
     });
-    server.RegisterTool(getStatusTool);
+
+    // 1. addSchedule Tool
+    ToolDefinition addTool;
+    addTool.name = "addSchedule";
+    addTool.description = "Schedule an AC action at a local time, e.g. cool to 24 at 18:00 on weekdays, "
+                          "or power off at 23:00";
+    addTool.params.push_back({"time", "string", "Local time, HH:MM", true});
+    addTool.params.push_back({"days", "string", "daily (default), weekdays, weekends, once, or days like mon,wed,fri", false});
+    addTool.params.push_back({"power", "string", "on or off; without on, mode and temperature only apply if the unit is running", false});
+    addTool.params.push_back({"mode", "integer", "Mode to set (0: Auto, 1: Cool, 2: Heat, 3: Dehumidify)", false,
+                              true, AC_MODE_AUTO, AC_MODE_DEHUMIDIFY});
+    addTool.params.push_back({"temperature", "integer", "Temperature to set", false, true, MIN_TEMPERATURE, MAX_TEMPERATURE});
+    addTool.params.push_back({"device", "string", "Indoor unit id; the default unit if omitted", false});
+
+    addTool.handler = makeHandler([&devices, &scheduler](JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.addSchedule");
+        JsonObject out = result.to<JsonObject>();
+        ACDevice* device = devices.resolve(params);
+        if (!device) {
+            writeErrorResult(AC_ERR_UNKNOWN_DEVICE, out);
+            return;
+        }
+
+        ACSchedule schedule = {};
+        const char* power = params["power"];
+        bool parsed = device->id.size() < sizeof(schedule.device) &&
+                      ACScheduler::parseTime(params["time"], schedule.minuteOfDay) &&
+                      ACScheduler::parseDays(params["days"], schedule.days) &&
+                      (!power || strcmp(power, "on") == 0 || strcmp(power, "off") == 0);
+        if (!parsed) {
+            writeErrorResult(AC_ERR_INVALID_SCHEDULE, out);
+            return;
+        }
+        strcpy(schedule.device, device->id.c_str());
+        schedule.power = !power ? AC_POWER_KEEP : strcmp(power, "on") == 0 ? AC_POWER_ON : AC_POWER_OFF;
+        schedule.mode = params["mode"] | -1;
+        schedule.temperature = params["temperature"] | 0;
+
+        ACResultCode error = scheduler.add(schedule);
+        if (error != AC_OK) {
+            writeErrorResult(error, out);
+            return;
+        }
+        out["code"] = 0;
+        writeSchedule(scheduler, schedule, out["schedule"].to<JsonObject>());
+    });
+    registry.addTool(std::move(addTool));
+
+    // 2. listSchedules Tool
+    ToolDefinition listTool;
+    listTool.name = "listSchedules";
+    listTool.description = "List scheduled AC actions, in order of time of day";
+    listTool.readOnly = true;
+    listTool.params.push_back({"device", "string", "Only this indoor unit's schedules; all units if omitted", false});
+
+    listTool.handler = makeHandler([&devices, &scheduler](JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.listSchedules");
+        JsonObject out = result.to<JsonObject>();
+        const char* device = params["device"];
+        if (device && !devices.find(device)) {
+            writeErrorResult(AC_ERR_UNKNOWN_DEVICE, out);
+            return;
+        }
+        out["code"] = 0;
+        JsonArray schedules = out["schedules"].to<JsonArray>();
+        for (const ACSchedule& schedule : scheduler.list(device)) {
+            writeSchedule(scheduler, schedule, schedules.add<JsonObject>());
+        }
+    });
+    registry.addTool(std::move(listTool));
+
+    // 3. removeSchedule Tool
+    ToolDefinition removeTool;
+    removeTool.name = "removeSchedule";
+    removeTool.description = "Remove a scheduled AC action";
+    removeTool.params.push_back({"id", "integer", "Schedule id from addSchedule or listSchedules", true});
+
+    removeTool.handler = makeHandler([&scheduler](JsonVariantConst params, JsonDocument& result) {
+        TRACE_SPAN("tool.removeSchedule");
+        JsonObject out = result.to<JsonObject>();
+        if (!scheduler.remove(params["id"].as<uint32_t>())) {
+            writeErrorResult(AC_ERR_UNKNOWN_SCHEDULE, out);
+            return;
+        }
+        out["code"] = 0;
+    });
+    registry.addTool(std::move(removeTool));
+}
+
+ACResultCode applyACSchedule(ACDeviceRegistry& devices, const ACSchedule& schedule) {
+    ACDevice* device = devices.find(schedule.device);
+    if (!device) {
+        log_w("Schedule %u: unknown unit %s", static_cast<unsigned>(schedule.id), schedule.device);
+        return AC_ERR_UNKNOWN_DEVICE;
+    }
+    TRACE_SPAN("schedule.apply");
+    AirConditioner& ac = device->ac;
+    ACResultCode error = AC_OK;
+    ac.beginBatch();
+    if (schedule.power == AC_POWER_ON) {
+        ac.turnOn();
+    }
+    if (schedule.mode >= 0) {
+        error = ac.setMode(schedule.mode).error;
+    }
+    if (schedule.temperature > 0) {
+        ACResultCode result = ac.setTemperature(schedule.temperature).error;
+        error = error != AC_OK ? error : result;
+    }
+    if (schedule.power == AC_POWER_OFF) {
+        ac.turnOff();
+    }
+    ac.endBatch();
+    if (error != AC_OK) {
+        // Typically a setpoint-only schedule firing while the unit is off
+        log_w("Schedule %u on %s failed: %s", static_cast<unsigned>(schedule.id), schedule.device,
+              acErrorMessage(error));
+    }
+    return error;
+}
+
+// Unit whose lock this task holds, and whether it is inside a dispatch
+static thread_local ACDevice* heldDevice = nullptr;
+static thread_local bool inScope = false;
+
+ACDeviceScope::ACDeviceScope()
+    : toolCalls(0), requests(0), maxBatch(0), publishedCalls(0), publishedRequests(0) {}
+
+void ACDeviceScope::beginCalls() {
+    inScope = true;
+}
+
+void ACDeviceScope::endCalls(size_t calls) {
+    release();
+    inScope = false;
+
+    toolCalls.fetch_add(static_cast<uint32_t>(calls), std::memory_order_relaxed);
+    requests.fetch_add(1, std::memory_order_relaxed);
+    uint32_t seen = maxBatch.load(std::memory_order_relaxed);
+    while (calls > seen && !maxBatch.compare_exchange_weak(seen, static_cast<uint32_t>(calls), std::memory_order_relaxed)) {
+    }
+}
+
+void ACDeviceScope::publish(const mcp::SystemProfiler::GaugeSink& sink) {
+    uint32_t calls = toolCalls.load(std::memory_order_relaxed);
+    uint32_t batches = requests.load(std::memory_order_relaxed);
+    uint32_t windowBatches = batches - publishedRequests;
+    sink("mcp.tool_calls", calls);
+    sink("mcp.batch_size_avg", windowBatches ? static_cast<double>(calls - publishedCalls) / windowBatches : 0.0);
+    sink("mcp.batch_size_max", maxBatch.exchange(0, std::memory_order_relaxed));
+    publishedCalls = calls;
+    publishedRequests = batches;
+}
+
+void ACDeviceScope::enter(ACDevice& device) {
+    device.toolCalls.fetch_add(1, std::memory_order_relaxed);
+    if (!inScope) {
+        return;
+    }
+    if (heldDevice != &device) {
+        release();
+        uint32_t start = micros();
+        device.ac.beginBatch();
+        uint32_t waitUs = micros() - start;
+        device.recordLockWait(waitUs);
+        heldDevice = &device;
+    }
+}
+
+void ACDeviceScope::observe(ACDevice& device) {
+    device.toolCalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ACDeviceScope::release() {
+    if (!heldDevice) {
+        return;
+    }
+    heldDevice->ac.endBatch();
+    heldDevice = nullptr;
 }
@@ -1,5 +1,94 @@
 #pragma once
-#include "MCPServer.h"
+#include "ACDevices.h"
+#include "ACScheduler.h"
+#include "McpDispatcher.h"
+#include "ResourceHub.h"
+#include "ToolRegistry.h"
 #include "ac.h"
 
-void registerACTools(MCPServer& server, AirConditioner& ac);
+/**
+ * Register the AC tools. Each takes an optional `device` argument naming
+ * the unit (the default unit if omitted). With more than one unit, every
+ * unit also gets namespaced copies without that argument, e.g.
+ * "bedroom.setMode"; those grow tools/list by six tools per unit.
+ */
+void registerACTools(mcp::ToolRegistry& registry, ACDeviceRegistry& devices, bool namespacedTools = true);
+
+/**
+ * Expose each unit's state as the resource ac://<id>/state, and the
+ * default unit's also as ac://state; every state change is announced to
+ * its subscribers
+ */
+void registerACResources(mcp::ResourceHub& hub, ACDeviceRegistry& devices);
+
+/**
+ * Register addSchedule, listSchedules and removeSchedule, and have
+ * `scheduler` apply due schedules to the units. Schedules name their unit
+ * by id; one whose unit no longer exists is skipped when it comes due.
+ * Applies that fail are counted in ACScheduler::failures().
+ */
+void registerACScheduleTools(mcp::ToolRegistry& registry, ACDeviceRegistry& devices, ACScheduler& scheduler);
+
+/**
+ * Apply a due schedule to its unit: power on, then mode and temperature,
+ * or power off; the LCD is refreshed once. A failure is logged.
+ * @return AC_OK, AC_ERR_UNKNOWN_DEVICE, or the first error of setting the
+ *         mode or temperature, e.g. AC_ERR_NOT_RUNNING when a schedule
+ *         without power on fires while the unit is off
+ */
+ACResultCode applyACSchedule(ACDeviceRegistry& devices, const ACSchedule& schedule);
+
+/**
+ * Holds the lock of the unit being called across the tool calls of one
+ * MCP request or batch. The LCD is refreshed once per unit when its lock
+ * is released. Calls and lock waits are only counted in atomics (the
+ * unit's and this scope's) and published by the profiler.
+ *
+ * The lock is taken by the first call that touches a unit, not up front,
+ * so requests for different units run in parallel. A request that moves
+ * on to another unit releases the previous one first: no task ever holds
+ * two unit locks, so batches spanning units cannot deadlock.
+ *
+ * Atomicity is therefore per unit and per run of consecutive calls: a
+ * batch's calls to one unit are applied without other requests in between
+ * only while they are contiguous. A batch spanning units is not atomic as
+ * a whole; another request may change unit A after the batch has moved on
+ * to unit B, and a batch that returns to A (A, B, A) takes A's lock again.
+ * Clients that need a multi-step change applied as one should keep those
+ * calls together, per unit.
+ */
+class ACDeviceScope : public mcp::DispatchObserver {
+public:
+    ACDeviceScope();
+
+    void beginCalls() override;
+    void endCalls(size_t calls) override;
+
+    /**
+     * Publish mcp.tool_calls, and mcp.batch_size_avg and mcp.batch_size_max
+     * over the requests since the previous publish. Call from one task.
+     */
+    void publish(const mcp::SystemProfiler::GaugeSink& sink);
+
+    /**
+     * Called by a tool before it touches `device`. Outside a dispatch
+     * (no beginCalls on this task) only the call is counted.
+     */
+    static void enter(ACDevice& device);
+
+    /**
+     * Called by a tool that only reads `device`. Reads come from the unit's
+     * lock-free state snapshot, so this only bumps device.toolCalls: no
+     * lock is taken or released and nothing is formatted.
+     */
+    static void observe(ACDevice& device);
+
+private:
+    static void release();
+
+    std::atomic<uint32_t> toolCalls;
+    std::atomic<uint32_t> requests;
+    std::atomic<uint32_t> maxBatch;     // Reset by publish()
+    uint32_t publishedCalls;            // Totals at the previous publish
+    uint32_t publishedRequests;
+};
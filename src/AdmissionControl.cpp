@@ -0,0 +1,82 @@
+#include "AdmissionControl.h"
+#include <algorithm>
+
+using namespace mcp;
+
+static const uint32_t MILLI = 1000;
+
+AdmissionControl::AdmissionControl(uint32_t ratePerSecond, uint32_t burst)
+    : rate(0), capacity(0), buckets(), admittedCount(0), throttledCount(0), evictionCount(0) {
+    configure(ratePerSecond, burst);
+}
+
+void AdmissionControl::configure(uint32_t ratePerSecond, uint32_t burst) {
+    std::lock_guard<std::mutex> lock(mutex);
+    rate = ratePerSecond;
+    capacity = std::max<uint32_t>(burst, 1) * MILLI;
+    for (Bucket& bucket : buckets) {
+        bucket.tokens = capacity;
+    }
+}
+
+AdmissionControl::Decision AdmissionControl::admit(uint32_t client, uint32_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (rate == 0) {
+        admittedCount.fetch_add(1, std::memory_order_relaxed);
+        return Decision{true, 0};
+    }
+
+    Bucket& bucket = bucketLocked(client, nowMs);
+    // `rate` tokens per second is `rate` thousandths per millisecond
+    uint64_t refilled = bucket.tokens + uint64_t(nowMs - bucket.lastMs) * rate;
+    bucket.tokens = static_cast<uint32_t>(std::min<uint64_t>(refilled, capacity));
+    bucket.lastMs = nowMs;
+
+    if (bucket.tokens >= MILLI) {
+        bucket.tokens -= MILLI;
+        admittedCount.fetch_add(1, std::memory_order_relaxed);
+        return Decision{true, 0};
+    }
+    throttledCount.fetch_add(1, std::memory_order_relaxed);
+    return Decision{false, (MILLI - bucket.tokens + rate - 1) / rate};
+}
+
+AdmissionControl::Stats AdmissionControl::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats{admittedCount.load(std::memory_order_relaxed), throttledCount.load(std::memory_order_relaxed),
+                evictionCount, 0};
+    for (const Bucket& bucket : buckets) {
+        stats.clients += bucket.used ? 1 : 0;
+    }
+    return stats;
+}
+
+void AdmissionControl::publish(const SystemProfiler::GaugeSink& gauges) const {
+    // Lock-free: admit() only pays for a relaxed increment
+    gauges("mcp.admitted", static_cast<double>(admittedCount.load(std::memory_order_relaxed)));
+    gauges("mcp.throttled", static_cast<double>(throttledCount.load(std::memory_order_relaxed)));
+}
+
+AdmissionControl::Bucket& AdmissionControl::bucketLocked(uint32_t client, uint32_t nowMs) {
+    Bucket* empty = nullptr;
+    Bucket* oldest = &buckets[0];
+    for (Bucket& bucket : buckets) {
+        if (bucket.used && bucket.client == client) {
+            return bucket;
+        }
+        if (!bucket.used) {
+            empty = empty ? empty : &bucket;
+        } else if (nowMs - bucket.lastMs > nowMs - oldest->lastMs) {
+            oldest = &bucket;
+        }
+    }
+
+    Bucket* bucket = empty;
+    if (!bucket) {
+        // The least recently seen client starts over with a full bucket if it returns
+        bucket = oldest;
+        evictionCount++;
+    }
+    *bucket = Bucket{client, capacity, nowMs, true};
+    return *bucket;
+}
@@ -0,0 +1,213 @@
+#include "AllocTracker.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <mutex>
+#include <set>
+#include "MetricsSystem.h"
+#endif
+
+using namespace mcp;
+
+static const char* UNTAGGED = "untagged";
+
+// Per-thread state; plain TLS so the hooks never allocate
+static thread_local const char* currentTag = nullptr;
+static thread_local uint32_t allocationCount = 0;
+static thread_local uint32_t allocationBytes = 0;
+static thread_local bool inHook = false;
+
+AllocTracker::AllocTracker() : reporter(nullptr) {
+    for (auto& slot : slots) {
+        slot.tag.store(nullptr, std::memory_order_relaxed);
+        slot.allocations.store(0, std::memory_order_relaxed);
+        slot.bytes.store(0, std::memory_order_relaxed);
+    }
+}
+
+AllocTracker::Slot* AllocTracker::findSlot(const char* tag, bool create) {
+    for (auto& slot : slots) {
+        const char* existing = slot.tag.load(std::memory_order_acquire);
+        if (existing == nullptr) {
+            if (!create) {
+                return nullptr;
+            }
+            // Claim the empty slot; if another thread won, check what it stored
+            if (slot.tag.compare_exchange_strong(existing, tag, std::memory_order_acq_rel)) {
+                return &slot;
+            }
+        }
+        if (existing == tag || strcmp(existing, tag) == 0) {
+            return &slot;
+        }
+    }
+    return nullptr; // Table full: allocation is counted per thread only
+}
+
+void AllocTracker::onAllocate(size_t size) {
+    if (inHook) {
+        return;
+    }
+    inHook = true;
+
+    allocationCount++;
+    allocationBytes += static_cast<uint32_t>(size);
+
+    Slot* slot = getInstance().findSlot(currentTag ? currentTag : UNTAGGED, true);
+    if (slot) {
+        slot->allocations.fetch_add(1, std::memory_order_relaxed);
+        slot->bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    inHook = false;
+}
+
+uint32_t AllocTracker::threadAllocations() {
+    return allocationCount;
+}
+
+uint32_t AllocTracker::threadBytes() {
+    return allocationBytes;
+}
+
+AllocTracker::TagStats AllocTracker::getTagStats(const char* tag) const {
+    TagStats stats = {tag, 0, 0};
+    Slot* slot = const_cast<AllocTracker*>(this)->findSlot(tag, false);
+    if (slot) {
+        stats.allocations = slot->allocations.load(std::memory_order_relaxed);
+        stats.bytes = slot->bytes.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+size_t AllocTracker::getStats(TagStats* out, size_t max) const {
+    size_t count = 0;
+    for (const auto& slot : slots) {
+        const char* tag = slot.tag.load(std::memory_order_acquire);
+        if (tag == nullptr || count >= max) {
+            break;
+        }
+        out[count++] = {tag,
+                        slot.allocations.load(std::memory_order_relaxed),
+                        slot.bytes.load(std::memory_order_relaxed)};
+    }
+    return count;
+}
+
+void AllocTracker::reset() {
+    for (auto& slot : slots) {
+        slot.allocations.store(0, std::memory_order_relaxed);
+        slot.bytes.store(0, std::memory_order_relaxed);
+    }
+}
+
+#ifdef ARDUINO
+void AllocTracker::metricsReporter(const char* tag, uint32_t allocations, uint32_t bytes) {
+    static std::mutex registeredMutex;
+    static std::set<String> registered;
+
+    MetricsSystem& metrics = MetricsSystem::getInstance();
+    String countName = String("alloc.") + tag + ".count";
+    String bytesName = String("alloc.") + tag + ".bytes";
+    {
+        // registerHistogram resets the metric, so only register once
+        std::lock_guard<std::mutex> lock(registeredMutex);
+        if (registered.insert(countName).second) {
+            metrics.registerHistogram(countName, "Allocations per scope", "allocs", "alloc");
+            metrics.registerHistogram(bytesName, "Bytes allocated per scope", "bytes", "alloc");
+        }
+    }
+    metrics.recordHistogram(countName, allocations);
+    metrics.recordHistogram(bytesName, bytes);
+}
+#endif
+
+AllocScope::AllocScope(const char* scopeTag, bool reportOnExit)
+    : tag(scopeTag)
+    , previousTag(currentTag)
+    , startAllocations(allocationCount)
+    , startBytes(allocationBytes)
+    , report(reportOnExit) {
+    currentTag = scopeTag;
+}
+
+AllocScope::~AllocScope() {
+    currentTag = previousTag;
+    if (report) {
+        AllocTracker::Reporter reporter = AllocTracker::getInstance().getReporter();
+        if (reporter) {
+            reporter(tag, allocations(), bytes());
+        }
+    }
+}
+
+uint32_t AllocScope::allocations() const {
+    return allocationCount - startAllocations;
+}
+
+uint32_t AllocScope::bytes() const {
+    return allocationBytes - startBytes;
+}
+
+// ===== Allocation hooks =====
+//
+// malloc/calloc/realloc are intercepted with the linker's --wrap option so
+// Arduino String, ArduinoJson and C code are covered. On the host, operator
+// new is replaced as well because libstdc++ calls the unwrapped malloc.
+
+#ifdef MCP_ALLOC_TRACKING
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    AllocTracker::onAllocate(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    AllocTracker::onAllocate(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    AllocTracker::onAllocate(size);
+    return __real_realloc(ptr, size);
+}
+}
+
+#ifndef ARDUINO
+void* operator new(size_t size) {
+    AllocTracker::onAllocate(size);
+    void* ptr = __real_malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+#endif
+#endif
@@ -0,0 +1,168 @@
+#include "JsonArena.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace mcp;
+
+void* HeapJsonAllocator::allocate(size_t size) {
+    return malloc(size);
+}
+
+void HeapJsonAllocator::deallocate(void* ptr) {
+    free(ptr);
+}
+
+void* HeapJsonAllocator::reallocate(void* ptr, size_t newSize) {
+    return realloc(ptr, newSize);
+}
+
+JsonArena::JsonArena(uint8_t* arenaBuffer, size_t capacity, ArduinoJson::Allocator* fallbackAllocator)
+    : buffer(arenaBuffer),
+      bufferCapacity(capacity),
+      fallback(fallbackAllocator),
+      offset(0),
+      lastBlock(nullptr),
+      peak(0),
+      overflowCount(0) {}
+
+void* JsonArena::allocate(size_t size) {
+    size_t needed = sizeof(BlockHeader) + align(size);
+    if (needed > bufferCapacity - offset) {
+        overflowCount++;
+        return fallback->allocate(size);
+    }
+
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(buffer + offset);
+    header->size = static_cast<uint32_t>(size);
+    lastBlock = buffer + offset;
+    offset += needed;
+    if (offset > peak) {
+        peak = offset;
+    }
+    return header + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (!owns(ptr)) {
+        fallback->deallocate(ptr);
+        return;
+    }
+
+    // Only the newest block can be handed back; the rest waits for reset()
+    if (reinterpret_cast<uint8_t*>(headerOf(ptr)) == lastBlock) {
+        offset = lastBlock - buffer;
+        lastBlock = nullptr;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) {
+        return allocate(newSize);
+    }
+    if (!owns(ptr)) {
+        return fallback->reallocate(ptr, newSize);
+    }
+
+    BlockHeader* header = headerOf(ptr);
+    uint8_t* block = reinterpret_cast<uint8_t*>(header);
+    size_t start = block - buffer;
+
+    // Grow or shrink the newest block in place
+    if (block == lastBlock && sizeof(BlockHeader) + align(newSize) <= bufferCapacity - start) {
+        header->size = static_cast<uint32_t>(newSize);
+        offset = start + sizeof(BlockHeader) + align(newSize);
+        if (offset > peak) {
+            peak = offset;
+        }
+        return ptr;
+    }
+    if (newSize <= header->size) {
+        header->size = static_cast<uint32_t>(newSize);
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved) {
+        memcpy(moved, ptr, header->size);
+        deallocate(ptr);
+    }
+    return moved;
+}
+
+void JsonArena::reset() {
+    offset = 0;
+    lastBlock = nullptr;
+    peak = 0;
+    overflowCount = 0;
+}
+
+JsonArenaPool::Lease& JsonArenaPool::Lease::operator=(Lease&& other) {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        arena = other.arena;
+        other.arena = nullptr;
+    }
+    return *this;
+}
+
+void JsonArenaPool::Lease::release() {
+    if (arena) {
+        pool->release(arena);
+        arena = nullptr;
+    }
+}
+
+JsonArenaPool::JsonArenaPool(size_t arenaCount, size_t arenaSize)
+    : storage(nullptr), acquired(0), exhausted(0), overflows(0), highWater(0) {
+    size_t size = (arenaSize + JsonArena::ALIGNMENT - 1) & ~(JsonArena::ALIGNMENT - 1);
+
+    // One allocation for all arenas, made once, so the pool itself does
+    // not fragment the heap either
+    storage = static_cast<uint8_t*>(malloc(arenaCount * size));
+    if (!storage) {
+        return;
+    }
+    arenas.reserve(arenaCount);
+    freeArenas.reserve(arenaCount);
+    for (size_t i = 0; i < arenaCount; i++) {
+        arenas.emplace_back(storage + i * size, size);
+    }
+    for (auto& arena : arenas) {
+        freeArenas.push_back(&arena);
+    }
+}
+
+JsonArenaPool::~JsonArenaPool() {
+    free(storage);
+}
+
+JsonArenaPool::Lease JsonArenaPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeArenas.empty()) {
+        exhausted++;
+        return Lease();
+    }
+    JsonArena* arena = freeArenas.back();
+    freeArenas.pop_back();
+    acquired++;
+    return Lease(this, arena);
+}
+
+void JsonArenaPool::release(JsonArena* arena) {
+    std::lock_guard<std::mutex> lock(mutex);
+    overflows += arena->overflows();
+    if (arena->highWater() > highWater) {
+        highWater = arena->highWater();
+    }
+    arena->reset();
+    freeArenas.push_back(arena);
+}
+
+JsonArenaPool::Stats JsonArenaPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return Stats{acquired, exhausted, overflows, highWater, freeArenas.size()};
+}
@@ -0,0 +1,361 @@
+#include "McpDispatcher.h"
+#include <cstdio>
+#include <cstring>
+#include "SpanTracer.h"
+
+using namespace mcp;
+
+const char* McpDispatcher::PROTOCOL_VERSION = "2024-11-05";
+
+static bool isToolsCall(JsonVariantConst message) {
+    const char* method = message["method"];
+    return method && strcmp(method, "tools/call") == 0;
+}
+
+static bool isResourcesMethod(const char* method) {
+    return strcmp(method, "resources/list") == 0 || strcmp(method, "resources/read") == 0 ||
+           strcmp(method, "resources/subscribe") == 0 || strcmp(method, "resources/unsubscribe") == 0;
+}
+
+McpDispatcher::McpDispatcher(ToolRegistry& toolRegistry, const char* serverName, const char* serverVersion)
+    : registry(toolRegistry),
+      observer(nullptr),
+      resources(nullptr),
+      arenaPool(nullptr),
+      streaming(false),
+      name(serverName),
+      version(serverVersion) {}
+
+size_t McpResponse::read(uint8_t* buffer, size_t maxLen, size_t index) const {
+    if (stream) {
+        return stream->read(buffer, maxLen, index);
+    }
+    if (index >= body.size()) {
+        return 0;
+    }
+    size_t length = body.size() - index < maxLen ? body.size() - index : maxLen;
+    memcpy(buffer, body.data() + index, length);
+    return length;
+}
+
+McpResponse McpDispatcher::handle(const char* body, size_t length, uint32_t session) {
+    // Declared before the documents so they are gone when the arena is reset
+    JsonArenaPool::Lease arena = acquireArena();
+    JsonDocument request(arena.allocator());
+    DeserializationError error = deserializeJson(request, body, length);
+    if (error) {
+        return parseError();
+    }
+    return dispatch(request, session, arena.allocator());
+}
+
+McpResponse McpDispatcher::handle(JsonDocument& request, const JsonArenaPool::Lease& arena, uint32_t session) {
+    return dispatch(request, session, arena.allocator());
+}
+
+McpResponse McpDispatcher::dispatch(JsonDocument& request, uint32_t session, Allocator* allocator) {
+    TRACE_SPAN("mcp.dispatch");
+    if (request.is<JsonArray>()) {
+        return handleBatch(request.as<JsonArrayConst>(), session, allocator);
+    }
+
+    size_t calls = 0;
+    bool scoped = observer && isToolsCall(request.as<JsonVariantConst>());
+    if (scoped) {
+        observer->beginCalls();
+    }
+    McpResponse response = handleMessage(request.as<JsonVariantConst>(), session, calls, allocator, streaming);
+    if (scoped) {
+        observer->endCalls(calls);
+    }
+    return response;
+}
+
+bool McpDispatcher::hasToolCalls(const JsonDocument& request) {
+    if (!request.is<JsonArray>()) {
+        return isToolsCall(request.as<JsonVariantConst>());
+    }
+    for (JsonVariantConst message : request.as<JsonArrayConst>()) {
+        if (isToolsCall(message)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool McpDispatcher::readsOnly(const JsonDocument& request) const {
+    auto readOnlyCall = [this](JsonVariantConst message) {
+        return !isToolsCall(message) || registry.isReadOnly(message["params"]["name"]);
+    };
+    if (!request.is<JsonArray>()) {
+        return readOnlyCall(request.as<JsonVariantConst>());
+    }
+    for (JsonVariantConst message : request.as<JsonArrayConst>()) {
+        if (!readOnlyCall(message)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string McpDispatcher::coalesceKey(const JsonDocument& request) const {
+    JsonVariantConst message = request.as<JsonVariantConst>();
+    if (request.is<JsonArray>() || !isToolsCall(message) || message["id"].isNull()) {
+        return std::string();
+    }
+    return registry.coalesceKey(message["params"]["name"], message["params"]["arguments"]);
+}
+
+McpResponse McpDispatcher::withId(const McpResponse& response, const std::string& idJson) {
+    McpResponse copy{response.status, std::string(), response.etag};
+    if (!response.hasBody()) {
+        return copy;
+    }
+    JsonDocument reply;
+    if (deserializeJson(reply, response.text()) || !reply.is<JsonObject>()) {
+        copy.body = response.text();
+        return copy;
+    }
+    reply["id"] = serialized(idJson);
+    serializeJson(reply, copy.body);
+    return copy;
+}
+
+McpResponse McpDispatcher::parseError() {
+    McpResponse response = errorResponse(JsonVariantConst(), PARSE_ERROR, "Parse error");
+    response.status = 400;
+    return response;
+}
+
+McpResponse McpDispatcher::handleBatch(JsonArrayConst batch, uint32_t session, Allocator* allocator) {
+    TRACE_SPAN("mcp.batch");
+    if (batch.size() == 0 || batch.size() > MAX_BATCH_SIZE) {
+        McpResponse response = errorResponse(JsonVariantConst(), INVALID_REQUEST,
+                                             batch.size() ? "Batch too large" : "Invalid Request", allocator);
+        response.status = 400;
+        return response;
+    }
+
+    // One device scope for the whole batch: calls run back to back, in order,
+    // and deferred work (LCD refresh, metrics) is flushed once at the end
+    bool scoped = false;
+    for (JsonVariantConst message : batch) {
+        scoped = scoped || isToolsCall(message);
+    }
+    scoped = scoped && observer;
+    if (scoped) {
+        observer->beginCalls();
+    }
+
+    McpResponse response{200, std::string(), std::string()};
+    size_t calls = 0;
+    for (JsonVariantConst message : batch) {
+        McpResponse reply = handleMessage(message, session, calls, allocator, false);
+        if (reply.body.empty()) {
+            continue;   // Notification
+        }
+        response.body += response.body.empty() ? '[' : ',';
+        response.body += reply.body;
+    }
+
+    if (scoped) {
+        observer->endCalls(calls);
+    }
+
+    if (response.body.empty()) {
+        response.status = 202;   // Only notifications
+    } else {
+        response.body += ']';
+    }
+    return response;
+}
+
+McpResponse McpDispatcher::handleMessage(JsonVariantConst message, uint32_t session, size_t& calls,
+                                         Allocator* allocator, bool stream) {
+    JsonVariantConst id = message["id"];
+    const char* method = message["method"];
+    if (!message.is<JsonObjectConst>() || !method) {
+        McpResponse response = errorResponse(id, INVALID_REQUEST, "Invalid Request", allocator);
+        response.status = 400;
+        return response;
+    }
+
+    bool notification = id.isNull();
+    if (strcmp(method, "tools/list") == 0 && !notification) {
+        return toolsList(id, stream);
+    }
+    if (stream && !notification && strcmp(method, "tools/call") == 0) {
+        calls++;
+        return streamToolsCall(id, message["params"], allocator);
+    }
+
+    JsonDocument reply(allocator);
+    reply["jsonrpc"] = "2.0";
+    reply["id"] = id;
+    JsonObject result = reply["result"].to<JsonObject>();
+    McpResponse response{200, std::string(), std::string()};
+
+    if (strcmp(method, "initialize") == 0) {
+        handleInitialize(result);
+    } else if (strcmp(method, "ping") == 0 || strncmp(method, "notifications/", 14) == 0) {
+        // Empty result
+    } else if (strcmp(method, "tools/call") == 0) {
+        calls++;
+        std::string error;
+        if (!handleToolsCall(message["params"], result, error, allocator)) {
+            response = errorResponse(id, INVALID_PARAMS, error.c_str(), allocator);
+        }
+    } else if (resources && isResourcesMethod(method)) {
+        std::string error;
+        if (!handleResources(method, message["params"], session, result, error, allocator)) {
+            response = errorResponse(id, INVALID_PARAMS, error.c_str(), allocator);
+        }
+    } else {
+        response = errorResponse(id, METHOD_NOT_FOUND, "Method not found", allocator);
+    }
+
+    // Notifications are executed but get no response body
+    if (notification) {
+        return McpResponse{202, std::string(), std::string()};
+    }
+    if (response.body.empty()) {
+        serializeJson(reply, response.body);
+    }
+    return response;
+}
+
+void McpDispatcher::handleInitialize(JsonObject result) {
+    result["protocolVersion"] = PROTOCOL_VERSION;
+    JsonObject capabilities = result["capabilities"].to<JsonObject>();
+    capabilities["tools"]["listChanged"] = false;
+    if (resources) {
+        capabilities["resources"]["subscribe"] = true;
+        capabilities["resources"]["listChanged"] = false;
+    }
+    JsonObject serverInfo = result["serverInfo"].to<JsonObject>();
+    serverInfo["name"] = name.c_str();
+    serverInfo["version"] = version.c_str();
+}
+
+bool McpDispatcher::handleResources(const char* method, JsonVariantConst params, uint32_t session,
+                                    JsonObject result, std::string& error, Allocator* allocator) {
+    if (strcmp(method, "resources/list") == 0) {
+        resources->list(result);
+        return true;
+    }
+
+    bool subscribe = strcmp(method, "resources/subscribe") == 0;
+    bool unsubscribe = strcmp(method, "resources/unsubscribe") == 0;
+    const char* uri = params["uri"];
+    if (!uri) {
+        error = "Missing resource uri";
+        return false;
+    }
+    if (!subscribe && !unsubscribe) {
+        if (!resources->read(uri, result, allocator)) {
+            error = std::string("Unknown resource: ") + uri;
+            return false;
+        }
+        return true;
+    }
+
+    // Updates are pushed on the client's event stream (GET /mcp/events)
+    if (session == 0) {
+        error = "Subscriptions need an event stream session";
+        return false;
+    }
+    bool done = subscribe ? resources->subscribe(session, uri) : resources->unsubscribe(session, uri);
+    if (!done) {
+        error = std::string("Unknown resource or session: ") + uri;
+        return false;
+    }
+    return true;
+}
+
+bool McpDispatcher::handleToolsCall(JsonVariantConst params, JsonObject result, std::string& error,
+                                    Allocator* allocator) {
+    const char* toolName = params["name"];
+    if (!toolName) {
+        error = "Missing tool name";
+        return false;
+    }
+
+    JsonDocument output(allocator);
+    ToolRejection rejection;
+    if (!registry.callTool(toolName, params["arguments"], output, &rejection)) {
+        error = rejection.message ? rejection.message : std::string("Unknown tool: ") + toolName;
+        return false;
+    }
+
+    // MCP wraps tool output in a text content block
+    JsonObject content = result["content"].to<JsonArray>().add<JsonObject>();
+    content["type"] = "text";
+    std::string text;
+    serializeJson(output, text);
+    content["text"] = text;
+    result["isError"] = false;
+    return true;
+}
+
+McpResponse McpDispatcher::streamToolsCall(JsonVariantConst id, JsonVariantConst params, Allocator* allocator) {
+    const char* toolName = params["name"];
+    if (!toolName) {
+        return errorResponse(id, INVALID_PARAMS, "Missing tool name", allocator);
+    }
+
+    // The output document lives in the body, in its own arena, until the
+    // transport has sent the last chunk
+    auto body = std::make_shared<ToolCallBody>(acquireArena(), serializeId(id));
+    ToolRejection rejection;
+    if (!registry.callTool(toolName, params["arguments"], body->output(), &rejection)) {
+        if (rejection.message) {
+            return errorResponse(id, INVALID_PARAMS, rejection.message, allocator);
+        }
+        char message[96];
+        snprintf(message, sizeof(message), "Unknown tool: %s", toolName);
+        return errorResponse(id, INVALID_PARAMS, message, allocator);
+    }
+
+    McpResponse response{200, std::string(), std::string()};
+    response.stream = std::move(body);
+    return response;
+}
+
+McpResponse McpDispatcher::toolsList(JsonVariantConst id, bool stream) {
+    std::shared_ptr<const ToolsListCache> list = registry.toolsList();
+    if (stream) {
+        McpResponse response{200, std::string(), list->etag};
+        response.stream = std::make_shared<ToolsListBody>(serializeId(id), std::move(list));
+        return response;
+    }
+
+    // Splice the cached result into the envelope instead of re-serializing it
+    McpResponse response{200, std::string(), list->etag};
+    std::string idJson = serializeId(id);
+    response.body.reserve(list->body.size() + idJson.size() + 36);
+    response.body += "{\"jsonrpc\":\"2.0\",\"id\":";
+    response.body += idJson;
+    response.body += ",\"result\":";
+    response.body += list->body;
+    response.body += '}';
+    return response;
+}
+
+McpResponse McpDispatcher::errorResponse(JsonVariantConst id, int code, const char* message,
+                                         Allocator* allocator) {
+    JsonDocument reply(allocator);
+    reply["jsonrpc"] = "2.0";
+    reply["id"] = id;
+    reply["error"]["code"] = code;
+    reply["error"]["message"] = message;
+
+    McpResponse response{200, std::string(), std::string()};
+    serializeJson(reply, response.body);
+    return response;
+}
+
+std::string McpDispatcher::serializeId(JsonVariantConst id) {
+    std::string out;
+    serializeJson(id, out);
+    return out;
+}
@@ -0,0 +1,308 @@
+#include "McpEndpoint.h"
+#include <WebResponseImpl.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+using namespace mcp;
+
+namespace {
+
+// Constant so throttling costs no serialization; code is McpDispatcher::RATE_LIMITED
+const char* THROTTLED_BODY =
+    "{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"code\":-32029,\"message\":\"Rate limited\"}}";
+
+// What handleBody leaves in _tempObject for handleRequest: the admission
+// decision, followed by the body unless the client was throttled. Freed by
+// the server together with the request.
+struct PostBody {
+    bool throttled;
+    uint32_t retryAfterMs;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+};
+
+// Response shared between the worker, which fills it, and the chunked
+// response callback, which streams it once it is ready
+struct PendingReply {
+    std::atomic<bool> ready{false};
+    McpResponse response;
+};
+
+/**
+ * Chunked response that commits nothing until the worker is done, so the
+ * status line can carry the reply's status (503 from a stopped worker, 202
+ * for a batch of notifications) instead of a 200 sent up front.
+ *
+ * The worker only sets the ready flag. The response checks it when it is
+ * handed to the server, which catches calls that finish while the request is
+ * still being queued, and again on every ACK and AsyncTCP poll of the
+ * connection, all on the async_tcp task.
+ */
+class PendingResponse : public AsyncChunkedResponse {
+public:
+    explicit PendingResponse(std::shared_ptr<PendingReply> reply)
+        : AsyncChunkedResponse("application/json",
+              [reply](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                  return reply->response.read(buffer, maxLen, index);
+              }),
+          pending(std::move(reply)), started(false) {}
+
+    void _respond(AsyncWebServerRequest* request) override {
+        startIfReady(request);
+    }
+
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override {
+        if (!started) {
+            startIfReady(request);
+            return 0;
+        }
+        return AsyncChunkedResponse::_ack(request, len, time);
+    }
+
+    bool _finished() const override { return started && AsyncChunkedResponse::_finished(); }
+
+private:
+    void startIfReady(AsyncWebServerRequest* request) {
+        if (!pending->ready.load(std::memory_order_acquire)) {
+            return;
+        }
+        started = true;
+        setCode(pending->response.status);
+        AsyncChunkedResponse::_respond(request);
+    }
+
+    std::shared_ptr<PendingReply> pending;
+    bool started;   // Only touched on the async_tcp task
+};
+
+}
+
+McpEndpoint::McpEndpoint(uint16_t port, ToolRegistry& toolRegistry, const char* serverName, const char* serverVersion)
+    : server(port), registry(toolRegistry), dispatcher(toolRegistry, serverName, serverVersion), worker(nullptr), resources(nullptr), admission(nullptr) {
+    // Responses are read chunk by chunk into AsyncTCP's send buffer
+    dispatcher.setStreaming(true);
+}
+
+void McpEndpoint::setResources(ResourceHub* hub) {
+    resources = hub;
+    dispatcher.setResources(hub);
+}
+
+void McpEndpoint::begin() {
+    // The body handler only collects the request; the response is sent once
+    // the whole request has arrived
+    server.on("/mcp", HTTP_POST,
+        [this](AsyncWebServerRequest* request) {
+            handleRequest(request);
+        },
+        nullptr,
+        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            handleBody(request, data, len, index, total);
+        });
+
+    server.on("/mcp/tools", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleToolsGet(request);
+    });
+
+    server.on("/mcp/events", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        handleEventsGet(request);
+    });
+
+    server.begin();
+}
+
+void McpEndpoint::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (total > MAX_BODY_SIZE) {
+        return;
+    }
+    if (index == 0) {
+        // A throttled client's body is dropped unbuffered; only the
+        // decision is kept for handleRequest
+        AdmissionControl::Decision decision = admit(request);
+        PostBody* post = static_cast<PostBody*>(malloc(sizeof(PostBody) + (decision.admitted ? total + 1 : 0)));
+        if (post) {
+            post->throttled = !decision.admitted;
+            post->retryAfterMs = decision.retryAfterMs;
+        }
+        request->_tempObject = post;
+    }
+    PostBody* post = static_cast<PostBody*>(request->_tempObject);
+    if (!post || post->throttled) {
+        return;
+    }
+    memcpy(post->data() + index, data, len);
+    if (index + len == total) {
+        post->data()[total] = '\0';
+    }
+}
+
+AdmissionControl::Decision McpEndpoint::admit(AsyncWebServerRequest* request) {
+    if (!admission) {
+        return AdmissionControl::Decision{true, 0};
+    }
+    return admission->admit(request->client()->remoteIP(), millis());
+}
+
+void McpEndpoint::sendThrottled(AsyncWebServerRequest* request, uint32_t retryAfterMs) {
+    AsyncWebServerResponse* response = request->beginResponse(429, "application/json", THROTTLED_BODY);
+    char retryAfter[12];
+    snprintf(retryAfter, sizeof(retryAfter), "%u", static_cast<unsigned>(std::max<uint32_t>((retryAfterMs + 999) / 1000, 1)));
+    response->addHeader("Retry-After", retryAfter);
+    request->send(response);
+}
+
+void McpEndpoint::handleRequest(AsyncWebServerRequest* request) {
+    size_t length = request->contentLength();
+    PostBody* post = static_cast<PostBody*>(request->_tempObject);
+    if (post && post->throttled) {
+        sendThrottled(request, post->retryAfterMs);
+        return;
+    }
+    // handleBody took the token for any body it could buffer; empty and
+    // oversized bodies are admitted here
+    if (length == 0 || length > MAX_BODY_SIZE) {
+        AdmissionControl::Decision decision = admit(request);
+        if (!decision.admitted) {
+            sendThrottled(request, decision.retryAfterMs);
+            return;
+        }
+    }
+    if (length > MAX_BODY_SIZE) {
+        request->send(413, "application/json", "{\"error\":\"Request too large\"}");
+        return;
+    }
+    if (length == 0) {
+        request->send(400, "application/json", "{\"error\":\"Empty request\"}");
+        return;
+    }
+    if (!post) {
+        request->send(503, "application/json", "{\"error\":\"Server busy\"}");   // Out of memory
+        return;
+    }
+
+    const char* body = post->data();
+    uint32_t session = sessionId(request);
+    if (!worker) {
+        send(request, dispatcher.handle(body, request->contentLength(), session));
+        return;
+    }
+
+    JsonArenaPool::Lease arena = dispatcher.acquireArena();
+    JsonDocument parsed(arena.allocator());
+    if (deserializeJson(parsed, body, request->contentLength())) {
+        send(request, McpDispatcher::parseError());
+        return;
+    }
+    if (!McpDispatcher::hasToolCalls(parsed)) {
+        send(request, dispatcher.handle(parsed, arena, session));
+        return;
+    }
+    dispatchToWorker(request, std::move(parsed), std::move(arena), session);
+}
+
+void McpEndpoint::dispatchToWorker(AsyncWebServerRequest* request, JsonDocument&& parsed,
+                                   JsonArenaPool::Lease&& arena, uint32_t session) {
+    // The worker never touches the connection; the response picks the
+    // reply up on the async_tcp task
+    auto pending = std::make_shared<PendingReply>();
+    bool queued = worker->submit(std::move(parsed), [pending](McpResponse&& response) {
+        pending->response = std::move(response);
+        pending->ready.store(true, std::memory_order_release);
+    }, std::move(arena), session);
+    if (!queued) {
+        request->send(503, "application/json", "{\"error\":\"Server busy\"}");
+        return;
+    }
+    request->send(new PendingResponse(pending));
+}
+
+void McpEndpoint::handleToolsGet(AsyncWebServerRequest* request) {
+    AdmissionControl::Decision decision = admit(request);
+    if (!decision.admitted) {
+        sendThrottled(request, decision.retryAfterMs);
+        return;
+    }
+    std::shared_ptr<const ToolsListCache> list = registry.toolsList();
+    const char* etag = ifNoneMatch(request);
+    AsyncWebServerResponse* response;
+    if (etag && list->etag == etag) {
+        response = request->beginResponse(304);
+    } else {
+        // Read straight from the cached payload instead of copying it into the response
+        response = request->beginResponse("application/json", list->body.size(),
+            [list](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                size_t length = std::min(maxLen, list->body.size() - index);
+                memcpy(buffer, list->body.data() + index, length);
+                return length;
+            });
+    }
+    response->addHeader("ETag", list->etag.c_str());
+    request->send(response);
+}
+
+void McpEndpoint::handleEventsGet(AsyncWebServerRequest* request) {
+    if (!resources) {
+        request->send(404);
+        return;
+    }
+    std::shared_ptr<EventSession> session = resources->openSession();
+    if (!session) {
+        request->send(503, "application/json", "{\"error\":\"Too many event streams\"}");
+        return;
+    }
+
+    // AsyncTCP asks for data on every ACK and poll, and gets
+    // RESPONSE_TRY_AGAIN while nothing is pending. The first read is always
+    // the endpoint event, so the headers go out right away; after that a
+    // subscribed resource change goes out on the connection's next poll.
+    // The response owns the session, so it ends with the connection.
+    AsyncWebServerResponse* response = request->beginChunkedResponse("text/event-stream",
+        [session](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t length = session->read(buffer, maxLen, millis());
+            return length ? length : RESPONSE_TRY_AGAIN;
+        });
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+void McpEndpoint::send(AsyncWebServerRequest* request, McpResponse&& response) {
+    if (!response.hasBody()) {
+        AsyncWebServerResponse* reply = request->beginResponse(response.status);
+        if (!response.etag.empty()) {
+            reply->addHeader("ETag", response.etag.c_str());
+        }
+        request->send(reply);
+        return;
+    }
+
+    // The callback reads the body in place, one send buffer at a time; a
+    // streamed body is produced as it is read, so its length is unknown
+    auto shared = std::make_shared<McpResponse>(std::move(response));
+    AwsResponseFiller filler = [shared](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        return shared->read(buffer, maxLen, index);
+    };
+    AsyncWebServerResponse* reply = shared->stream
+        ? request->beginChunkedResponse("application/json", filler)
+        : request->beginResponse("application/json", shared->body.size(), filler);
+    reply->setCode(shared->status);
+    if (!shared->etag.empty()) {
+        reply->addHeader("ETag", shared->etag.c_str());
+    }
+    request->send(reply);
+}
+
+const char* McpEndpoint::ifNoneMatch(AsyncWebServerRequest* request) {
+    if (!request->hasHeader("If-None-Match")) {
+        return nullptr;
+    }
+    return request->getHeader("If-None-Match")->value().c_str();
+}
+
+uint32_t McpEndpoint::sessionId(AsyncWebServerRequest* request) {
+    if (!request->hasParam("sessionId")) {
+        return 0;
+    }
+    return strtoul(request->getParam("sessionId")->value().c_str(), nullptr, 10);
+}
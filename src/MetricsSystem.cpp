@@ -3,6 +3,7 @@
 #include <mutex>
 #include <ArduinoJson.h>
 #include <esp_timer.h>
+#include "AllocTracker.h"
 
 using namespace mcp;
 
@@ -10,14 +11,15 @@ using namespace mcp;
 static const char* BOOT_METRICS_FILE = "/boot_metrics.bin";
 static const char* CONFIG_FILE = "/metrics_config.json";
 static const uint32_t SAVE_INTERVAL = 60000; // 1 minute
-static const size_t MAX_METRICS = 50;
+static const size_t MAX_METRICS = 128;
 
 // Static members initialization
-std::mutex MetricsSystem::metricsMutex;
+std::recursive_mutex MetricsSystem::metricsMutex;
 
 MetricsSystem::MetricsSystem() 
     : lastSaveTime(0)
-    , initialized(false) {
+    , initialized(false)
+    , lastFlushTime(0) {
 }
 
 MetricsSystem::~MetricsSystem() {
@@ -25,7 +27,7 @@ MetricsSystem::~MetricsSystem() {
 }
 
 bool MetricsSystem::begin() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
     
     if (initialized) {
         return true;
@@ -52,12 +54,14 @@ bool MetricsSystem::begin() {
 
     initialized = true;
     lastSaveTime = millis();
+    lastFlushTime = lastSaveTime;
     return true;
 }
 
 void MetricsSystem::end() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
     if (initialized) {
+        flush();
         saveBootMetrics();
         logger.end();
         initialized = false;
@@ -66,7 +70,7 @@ void MetricsSystem::end() {
 
 void MetricsSystem::registerMetric(const String& name, MetricType type, const String& description,
                                    const String& unit, const String& category) {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
 
     if (metrics.size() >= MAX_METRICS) {
         log_w("Max metrics limit reached, ignoring: %s", name.c_str());
@@ -105,8 +109,180 @@ void MetricsSystem::registerHistogram(const String& name, const String& descript
                                       const String& unit, const String& category) {
     registerMetric(name, MetricType::HISTOGRAM, description, unit, category);
 }
+void MetricsSystem::initializeSystemMetrics() {
+    registerGauge("system.wifi.signal", "WiFi signal strength", "dBm", "system");
+    registerGauge("system.heap.free", "Free heap", "bytes", "system");
+    registerGauge("system.heap.min", "Minimum free heap since boot", "bytes", "system");
+    registerGauge("system.uptime", "Uptime", "ms", "system");
+}
+
+void MetricsSystem::incrementCounter(const String& name, int64_t value) {
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+
+    auto it = metrics.find(name);
+    if (it == metrics.end() || it->second.type != MetricType::COUNTER) {
+        return;
+    }
+
+    MetricValue& current = bootMetrics[name];
+    current.timestamp = millis();
+    current.counter += value;
+
+    PendingValue& delta = pending[name];
+    if (!delta.dirty) {
+        delta.dirty = true;
+        delta.value.counter = 0;
+    }
+    delta.value.timestamp = current.timestamp;
+    delta.value.counter += value;
+}
+
+void MetricsSystem::setGauge(const String& name, double value) {
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+
+    auto it = metrics.find(name);
+    if (it == metrics.end() || it->second.type != MetricType::GAUGE) {
+        return;
+    }
+
+    MetricValue& current = bootMetrics[name];
+    current.timestamp = millis();
+    current.gauge = value;
+
+    PendingValue& last = pending[name];
+    last.dirty = true;
+    last.value = current;
+}
+
+void MetricsSystem::recordHistogram(const String& name, double value) {
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+
+    auto it = metrics.find(name);
+    if (it == metrics.end() || it->second.type != MetricType::HISTOGRAM) {
+        return;
+    }
+
+    MetricValue& current = bootMetrics[name];
+    auto& hist = current.histogram;
+    current.timestamp = millis();
+    if (hist.count == 0) {
+        hist.min = value;
+        hist.max = value;
+    } else {
+        hist.min = std::min(hist.min, value);
+        hist.max = std::max(hist.max, value);
+    }
+    hist.sum += value;
+    hist.count++;
+    hist.value = hist.sum / hist.count;
+
+    PendingValue& window = pending[name];
+    auto& summary = window.value.histogram;
+    if (!window.dirty) {
+        window.dirty = true;
+        summary = {value, value, value, 0.0, 0};
+    }
+    window.value.timestamp = current.timestamp;
+    summary.min = std::min(summary.min, value);
+    summary.max = std::max(summary.max, value);
+    summary.sum += value;
+    summary.count++;
+    summary.value = summary.sum / summary.count;
+}
+
+size_t MetricsSystem::flush() {
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+    ALLOC_SCOPE("metrics.flush");
+
+    std::vector<uLogger::Record> records;
+    for (auto& pair : pending) {
+        PendingValue& entry = pair.second;
+        auto info = metrics.find(pair.first);
+        if (!entry.dirty || info == metrics.end()) {
+            continue;
+        }
+        uLogger::Record record;
+        record.timestamp = entry.value.timestamp;
+        strncpy(record.name, pair.first.c_str(), uLogger::MAX_NAME_LENGTH - 1);
+        switch (info->second.type) {
+            case MetricType::COUNTER:
+                record.dataSize = sizeof(entry.value.counter);
+                memcpy(record.data, &entry.value.counter, record.dataSize);
+                break;
+            case MetricType::GAUGE:
+                record.dataSize = sizeof(entry.value.gauge);
+                memcpy(record.data, &entry.value.gauge, record.dataSize);
+                break;
+            case MetricType::HISTOGRAM:
+                record.dataSize = sizeof(entry.value.histogram);
+                memcpy(record.data, &entry.value.histogram, record.dataSize);
+                break;
+        }
+        records.push_back(record);
+        entry.dirty = false;
+    }
+
+    lastFlushTime = millis();
+    if (!records.empty() && !logger.logMetrics(records)) {
+        log_w("Failed to flush %u metric records", static_cast<unsigned>(records.size()));
+    }
+    return records.size();
+}
+
+std::vector<MetricValue> MetricsSystem::getMetricHistory(const String& name, uint32_t seconds) {
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+
+    std::vector<MetricValue> history;
+    auto it = metrics.find(name);
+    if (it == metrics.end()) {
+        return history;
+    }
+    flush();
+
+    uint64_t now = millis();
+    uint64_t window = static_cast<uint64_t>(seconds) * 1000;
+    uint64_t startTime = (seconds == 0 || window > now) ? 0 : now - window;
+
+    std::vector<uLogger::Record> records;
+    logger.queryMetrics(name.c_str(), startTime, records);
+
+    history.reserve(records.size());
+    for (const auto& record : records) {
+        MetricValue value = {record.timestamp, {}};
+        switch (it->second.type) {
+            case MetricType::COUNTER:
+                memcpy(&value.counter, record.data, sizeof(value.counter));
+                break;
+            case MetricType::GAUGE:
+                memcpy(&value.gauge, record.data, sizeof(value.gauge));
+                break;
+            case MetricType::HISTOGRAM:
+                memcpy(&value.histogram, record.data, sizeof(value.histogram));
+                break;
+        }
+        history.push_back(value);
+    }
+    return history;
+}
+
+std::map<String, MetricsSystem::MetricInfo> MetricsSystem::getMetrics(const String& category) {
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+
+    if (category.isEmpty()) {
+        return metrics;
+    }
+
+    std::map<String, MetricInfo> filtered;
+    for (const auto& pair : metrics) {
+        if (pair.second.category == category) {
+            filtered.insert(pair);
+        }
+    }
+    return filtered;
+}
+
 MetricValue MetricsSystem::getMetric(const String& name, bool fromBoot) {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
 
     auto it = metrics.find(name);
     if (it == metrics.end()) {
@@ -117,6 +293,7 @@ MetricValue MetricsSystem::getMetric(const String& name, bool fromBoot) {
         return bootMetrics[name];
     }
 
+    flush();
     std::vector<uLogger::Record> records;
     logger.queryMetrics(name.c_str(), 0, records); // Fetch records
 
@@ -159,16 +336,21 @@ MetricValue MetricsSystem::calculateHistogram(const std::vector<MetricValue>& va
         return result;
     }
 
+    // Each record summarizes one flush window
     auto& hist = result.histogram;
-    hist.min = values[0].histogram.value;
-    hist.max = values[0].histogram.value;
+    hist.min = values[0].histogram.min;
+    hist.max = values[0].histogram.max;
     hist.sum = 0;
-    hist.count = values.size();
+    hist.count = 0;
 
     for (const auto& v : values) {
-        hist.min = std::min(hist.min, v.histogram.value);
-        hist.max = std::max(hist.max, v.histogram.value);
-        hist.sum += v.histogram.value;
+        hist.min = std::min(hist.min, v.histogram.min);
+        hist.max = std::max(hist.max, v.histogram.max);
+        hist.sum += v.histogram.sum;
+        hist.count += v.histogram.count;
+    }
+    if (hist.count == 0) {
+        return result;
     }
 
     hist.value = hist.sum / hist.count;
@@ -176,7 +358,7 @@ MetricValue MetricsSystem::calculateHistogram(const std::vector<MetricValue>& va
 }
 
 void MetricsSystem::updateSystemMetrics() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
     
     // Update WiFi signal strength if connected
     if (WiFi.status() == WL_CONNECTED) {
@@ -188,15 +370,21 @@ void MetricsSystem::updateSystemMetrics() {
     setGauge("system.heap.min", ESP.getMinFreeHeap());
     setGauge("system.uptime", millis());
 
-    // Check if it's time to save boot metrics
+    // Samples reach the log in one append per flush interval
     uint32_t now = millis();
+    if (now - lastFlushTime >= FLUSH_INTERVAL_MS) {
+        flush();
+    }
+
+    // Check if it's time to save boot metrics
     if (now - lastSaveTime >= SAVE_INTERVAL) {
         saveBootMetrics();
         lastSaveTime = now;
     }
 }
 bool MetricsSystem::saveBootMetrics() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
+    ALLOC_SCOPE("metrics.save");
 
     File file = LittleFS.open(BOOT_METRICS_FILE, "w");
     if (!file) {
@@ -227,7 +415,7 @@ bool MetricsSystem::saveBootMetrics() {
 }
 
 bool MetricsSystem::loadBootMetrics() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
     
     File file = LittleFS.open(BOOT_METRICS_FILE, "r");
     if (!file) {
@@ -265,7 +453,7 @@ bool MetricsSystem::loadBootMetrics() {
 }
 
 void MetricsSystem::resetBootMetrics() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
     
     bootMetrics.clear();
     for (const auto& pair : metrics) {
@@ -292,7 +480,8 @@ bool MetricsSystem::isInitialized() const {
 }
 
 void MetricsSystem::clearHistory() {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    std::lock_guard<std::recursive_mutex> lock(metricsMutex);
     logger.clear();
+    pending.clear();
     resetBootMetrics();
 }
\ No newline at end of file
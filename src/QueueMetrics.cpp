@@ -0,0 +1,57 @@
+#include "QueueMetrics.h"
+
+using namespace mcp;
+
+static void storeMax(std::atomic<uint32_t>& target, uint32_t value) {
+    uint32_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+MetricsQueueObserver::MetricsQueueObserver(const std::string& queueName, const std::vector<std::string>& laneNames) {
+    lanes.reserve(laneNames.size());
+    for (const auto& laneName : laneNames) {
+        std::string prefix = "queue." + queueName + "." + laneName;
+        std::unique_ptr<LaneMetrics> lane(new LaneMetrics());
+        lane->rejectedName = prefix + ".rejected";
+        lane->highWaterName = prefix + ".high_water";
+        lane->waitAvgName = prefix + ".wait_avg_ms";
+        lane->waitMaxName = prefix + ".wait_max_ms";
+        lanes.push_back(std::move(lane));
+    }
+}
+
+void MetricsQueueObserver::onRejected(size_t lane) {
+    if (lane < lanes.size()) {
+        lanes[lane]->rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MetricsQueueObserver::onHighWater(size_t lane, size_t depth) {
+    if (lane < lanes.size()) {
+        storeMax(lanes[lane]->highWater, static_cast<uint32_t>(depth));
+    }
+}
+
+void MetricsQueueObserver::onDequeued(size_t lane, uint32_t waitUs) {
+    if (lane < lanes.size()) {
+        LaneMetrics& metrics = *lanes[lane];
+        metrics.waitTotalUs.fetch_add(waitUs, std::memory_order_relaxed);
+        metrics.waitCount.fetch_add(1, std::memory_order_relaxed);
+        storeMax(metrics.waitMaxUs, waitUs);
+    }
+}
+
+void MetricsQueueObserver::publish(const SystemProfiler::GaugeSink& sink) {
+    for (auto& lane : lanes) {
+        // A dequeue between the exchanges lands in this window or the next
+        uint32_t count = lane->waitCount.exchange(0, std::memory_order_relaxed);
+        uint64_t totalUs = lane->waitTotalUs.exchange(0, std::memory_order_relaxed);
+        uint32_t maxUs = lane->waitMaxUs.exchange(0, std::memory_order_relaxed);
+
+        sink(lane->rejectedName.c_str(), lane->rejected.load(std::memory_order_relaxed));
+        sink(lane->highWaterName.c_str(), lane->highWater.load(std::memory_order_relaxed));
+        sink(lane->waitAvgName.c_str(), count ? totalUs / 1000.0 / count : 0.0);
+        sink(lane->waitMaxName.c_str(), maxUs / 1000.0);
+    }
+}
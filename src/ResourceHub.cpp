@@ -0,0 +1,252 @@
+#include "ResourceHub.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+using namespace mcp;
+
+namespace {
+
+// Default id source; openSession calls it under the session lock
+uint32_t randomSessionId() {
+    static std::random_device device;
+    return device();
+}
+
+}
+
+EventSession::EventSession(ResourceHub& resourceHub, uint32_t id, size_t streamSlot, void* streamHandle)
+    : hub(resourceHub), sessionId(id), slot(streamSlot), stream(streamHandle), sent(0), greeted(false),
+      lastSendMs(0), events(0) {}
+
+EventSession::~EventSession() {
+    // Leave the slot alone if a newer session already took it over
+    void* expected = stream;
+    hub.streams[slot].handle.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+}
+
+size_t EventSession::read(uint8_t* buffer, size_t maxLen, uint32_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sent == outbox.size()) {
+        outbox.clear();
+        sent = 0;
+        collectLocked(nowMs);
+    }
+
+    size_t length = std::min(maxLen, outbox.size() - sent);
+    memcpy(buffer, outbox.data() + sent, length);
+    sent += length;
+    if (length > 0) {
+        lastSendMs = nowMs;
+    }
+    return length;
+}
+
+uint32_t EventSession::eventCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return events;
+}
+
+void EventSession::collectLocked(uint32_t nowMs) {
+    if (!greeted) {
+        // Same first event as the MCP SSE transport: where to post requests
+        outbox = "event: endpoint\ndata: /mcp?sessionId=" + std::to_string(sessionId) + "\n\n";
+        greeted = true;
+        lastSendMs = nowMs;
+        return;
+    }
+
+    for (Subscription& subscription : subscriptions) {
+        const ResourceHub::Entry& entry = hub.resources[subscription.resource];
+        uint32_t revision = entry.revision.load(std::memory_order_acquire);
+        if (revision == subscription.announced) {
+            continue;
+        }
+        subscription.announced = revision;
+
+        JsonDocument notification;
+        notification["jsonrpc"] = "2.0";
+        notification["method"] = "notifications/resources/updated";
+        notification["params"]["uri"] = entry.definition.uri.c_str();
+        outbox += "event: message\ndata: ";
+        std::string data;
+        serializeJson(notification, data);
+        outbox += data;
+        outbox += "\n\n";
+        events++;
+    }
+
+    // Comment line, so dead connections are noticed and proxies keep it open
+    if (outbox.empty() && nowMs - lastSendMs >= KEEPALIVE_MS) {
+        outbox = ": keepalive\n\n";
+    }
+}
+
+ResourceHub::ResourceHub(IdSource sessionIds)
+    : idSource(sessionIds ? std::move(sessionIds) : IdSource(randomSessionId)) {}
+
+void ResourceHub::addResource(ResourceDefinition resource) {
+    int existing = find(resource.uri.c_str());
+    if (existing >= 0) {
+        resources[existing].definition = std::move(resource);
+        resources[existing].revision.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    resources.emplace_back(std::move(resource));
+}
+
+bool ResourceHub::notifyUpdated(const char* uri) {
+    int index = find(uri);
+    if (index < 0) {
+        return false;
+    }
+    resources[index].revision.fetch_add(1, std::memory_order_release);
+    if (streamWaker) {
+        uint32_t bit = interestBit(static_cast<size_t>(index));
+        for (Stream& stream : streams) {
+            void* handle = stream.handle.load(std::memory_order_acquire);
+            if (handle && (stream.interest.load(std::memory_order_relaxed) & bit)) {
+                streamWaker(handle);
+            }
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<EventSession> ResourceHub::openSession(void* stream) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    for (size_t slot = 0; slot < MAX_SESSIONS; slot++) {
+        if (!streams[slot].session.expired()) {
+            continue;
+        }
+        uint32_t id;
+        do {
+            id = idSource();
+        } while (id == 0 || idInUseLocked(id));
+
+        auto session = std::make_shared<EventSession>(*this, id, slot, stream);
+        streams[slot].session = session;
+        streams[slot].interest.store(0, std::memory_order_relaxed);
+        streams[slot].handle.store(stream, std::memory_order_release);
+        return session;
+    }
+    return nullptr;
+}
+
+bool ResourceHub::subscribe(uint32_t sessionId, const char* uri) {
+    int index = find(uri);
+    std::shared_ptr<EventSession> session = findSession(sessionId);
+    if (index < 0 || !session) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    for (const EventSession::Subscription& subscription : session->subscriptions) {
+        if (subscription.resource == static_cast<size_t>(index)) {
+            return true;
+        }
+    }
+    // Announce changes from now on, not the ones before subscribing
+    uint32_t revision = resources[index].revision.load(std::memory_order_acquire);
+    session->subscriptions.push_back(EventSession::Subscription{static_cast<size_t>(index), revision});
+    streams[session->slot].interest.fetch_or(interestBit(static_cast<size_t>(index)), std::memory_order_relaxed);
+    return true;
+}
+
+bool ResourceHub::unsubscribe(uint32_t sessionId, const char* uri) {
+    int index = find(uri);
+    std::shared_ptr<EventSession> session = findSession(sessionId);
+    if (index < 0 || !session) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(session->mutex);
+    std::vector<EventSession::Subscription>& subscriptions = session->subscriptions;
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                       [index](const EventSession::Subscription& subscription) {
+                                           return subscription.resource == static_cast<size_t>(index);
+                                       }),
+                        subscriptions.end());
+    uint32_t interest = 0;
+    for (const EventSession::Subscription& subscription : subscriptions) {
+        interest |= interestBit(subscription.resource);
+    }
+    streams[session->slot].interest.store(interest, std::memory_order_relaxed);
+    return true;
+}
+
+void ResourceHub::list(JsonObject result) const {
+    JsonArray array = result["resources"].to<JsonArray>();
+    for (const Entry& entry : resources) {
+        JsonObject resource = array.add<JsonObject>();
+        resource["uri"] = entry.definition.uri.c_str();
+        resource["name"] = entry.definition.name.c_str();
+        resource["description"] = entry.definition.description.c_str();
+        resource["mimeType"] = entry.definition.mimeType.c_str();
+    }
+}
+
+bool ResourceHub::read(const char* uri, JsonObject result, Allocator* allocator) const {
+    int index = find(uri);
+    if (index < 0) {
+        return false;
+    }
+    const ResourceDefinition& definition = resources[index].definition;
+
+    JsonDocument contents(allocator);
+    definition.read(contents);
+    std::string text;
+    serializeJson(contents, text);
+
+    JsonObject content = result["contents"].to<JsonArray>().add<JsonObject>();
+    content["uri"] = definition.uri.c_str();
+    content["mimeType"] = definition.mimeType.c_str();
+    content["text"] = text;
+    return true;
+}
+
+size_t ResourceHub::sessionCount() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    size_t open = 0;
+    for (const Stream& stream : streams) {
+        open += stream.session.expired() ? 0 : 1;
+    }
+    return open;
+}
+
+bool ResourceHub::hasSession(uint32_t sessionId) {
+    return findSession(sessionId) != nullptr;
+}
+
+int ResourceHub::find(const char* uri) const {
+    if (!uri) {
+        return -1;
+    }
+    for (size_t i = 0; i < resources.size(); i++) {
+        if (resources[i].definition.uri == uri) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::shared_ptr<EventSession> ResourceHub::findSession(uint32_t sessionId) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    for (const Stream& stream : streams) {
+        std::shared_ptr<EventSession> session = stream.session.lock();
+        if (session && session->id() == sessionId) {
+            return session;
+        }
+    }
+    return nullptr;
+}
+
+bool ResourceHub::idInUseLocked(uint32_t sessionId) const {
+    for (const Stream& stream : streams) {
+        std::shared_ptr<EventSession> session = stream.session.lock();
+        if (session && session->id() == sessionId) {
+            return true;
+        }
+    }
+    return false;
+}
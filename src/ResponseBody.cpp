@@ -0,0 +1,89 @@
+#include "ResponseBody.h"
+#include <cstring>
+
+using namespace mcp;
+
+static const char TOOLS_CALL_SUFFIX[] = "\"}],\"isError\":false}}";
+
+size_t ChunkWindow::write(const uint8_t* data, size_t length) {
+    size_t start = seen;
+    seen += length;
+    if (seen <= offset || copied == capacity) {
+        return length;   // Before the window, or the window is full
+    }
+
+    size_t skip = offset > start ? offset - start : 0;
+    size_t count = length - skip;
+    if (count > capacity - copied) {
+        count = capacity - copied;
+    }
+    memcpy(buffer + copied, data + skip, count);
+    copied += count;
+    return length;
+}
+
+std::string ResponseBody::toString() {
+    std::string out;
+    uint8_t chunk[256];
+    size_t read;
+    while ((read = this->read(chunk, sizeof(chunk), out.size())) > 0) {
+        out.append(reinterpret_cast<const char*>(chunk), read);
+    }
+    return out;
+}
+
+ToolsListBody::ToolsListBody(const std::string& idJson, std::shared_ptr<const ToolsListCache> toolsList)
+    : prefix("{\"jsonrpc\":\"2.0\",\"id\":" + idJson + ",\"result\":"), list(std::move(toolsList)) {}
+
+size_t ToolsListBody::read(uint8_t* buffer, size_t maxLen, size_t index) {
+    ChunkWindow window(buffer, maxLen, index);
+    window.write(prefix.c_str());
+    window.write(reinterpret_cast<const uint8_t*>(list->body.data()), list->body.size());
+    window.write("}");
+    return window.filled();
+}
+
+ToolCallBody::ToolCallBody(JsonArenaPool::Lease&& outputArena, const std::string& idJson)
+    : arena(std::move(outputArena)),
+      document(arena.allocator()),
+      prefix("{\"jsonrpc\":\"2.0\",\"id\":" + idJson + ",\"result\":{\"content\":[{\"type\":\"text\",\"text\":\""),
+      cacheStart(0),
+      cacheLength(0),
+      refillCount(0) {}
+
+size_t ToolCallBody::read(uint8_t* buffer, size_t maxLen, size_t index) {
+    if (maxLen >= READ_AHEAD) {
+        return serializeWindow(buffer, maxLen, index);
+    }
+
+    // A short refill means the cache holds the end of the body
+    bool cached = index >= cacheStart && index - cacheStart < cacheLength;
+    bool pastEnd = refillCount > 0 && cacheLength < READ_AHEAD && index >= cacheStart + cacheLength;
+    if (pastEnd) {
+        return 0;
+    }
+    if (!cached) {
+        if (!cache) {
+            cache.reset(new uint8_t[READ_AHEAD]);
+        }
+        cacheStart = index;
+        cacheLength = serializeWindow(cache.get(), READ_AHEAD, index);
+    }
+
+    size_t available = cacheStart + cacheLength - index;
+    size_t length = available < maxLen ? available : maxLen;
+    memcpy(buffer, cache.get() + (index - cacheStart), length);
+    return length;
+}
+
+size_t ToolCallBody::serializeWindow(uint8_t* buffer, size_t maxLen, size_t index) {
+    refillCount++;
+    ChunkWindow window(buffer, maxLen, index);
+    window.write(prefix.c_str());
+    if (!window.full()) {
+        EscapingWriter<ChunkWindow> text(window);
+        serializeJson(document, text);
+    }
+    window.write(TOOLS_CALL_SUFFIX);
+    return window.filled();
+}
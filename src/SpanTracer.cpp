@@ -0,0 +1,179 @@
+#include "SpanTracer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <thread>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#endif
+
+using namespace mcp;
+
+// Nesting depth of open spans on the current thread
+static thread_local uint16_t spanDepth = 0;
+
+uint64_t mcp::traceNowMicros() {
+#ifdef ARDUINO
+    return static_cast<uint64_t>(esp_timer_get_time());
+#else
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint32_t mcp::traceThreadId() {
+#ifdef ARDUINO
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle()));
+#else
+    static thread_local uint32_t id =
+        static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return id;
+#endif
+}
+
+uint8_t mcp::traceCoreId() {
+#ifdef ARDUINO
+    return static_cast<uint8_t>(xPortGetCoreID());
+#elif defined(__linux__)
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : static_cast<uint8_t>(cpu);
+#else
+    return 0;
+#endif
+}
+
+SpanTracer::SpanTracer() : head(0), enabled(true) {
+    for (auto& slot : slots) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+void SpanTracer::record(const char* name, uint64_t start, uint64_t end, uint16_t depth) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    uint32_t ticket = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[ticket & (CAPACITY - 1)];
+
+    // Mark the slot as being written so readers skip it
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SpanRecord& rec = slot.record;
+    rec.start = start;
+    rec.duration = static_cast<uint32_t>(end - start);
+    rec.threadId = traceThreadId();
+    rec.depth = depth;
+    rec.core = traceCoreId();
+    strncpy(rec.name, name ? name : "", SpanRecord::MAX_NAME_LENGTH - 1);
+    rec.name[SpanRecord::MAX_NAME_LENGTH - 1] = '\0';
+
+    slot.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+size_t SpanTracer::snapshot(std::vector<SpanRecord>& out) const {
+    out.clear();
+    out.reserve(CAPACITY);
+
+    std::vector<uint32_t> tickets;
+    tickets.reserve(CAPACITY);
+
+    for (const auto& slot : slots) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            continue;
+        }
+        SpanRecord copy = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            continue; // Overwritten while copying
+        }
+        out.push_back(copy);
+        tickets.push_back(before);
+    }
+
+    // Order by ticket so the oldest span comes first
+    std::vector<size_t> order(out.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&tickets](size_t a, size_t b) {
+        return tickets[a] < tickets[b];
+    });
+    std::vector<SpanRecord> sorted;
+    sorted.reserve(out.size());
+    for (size_t i : order) {
+        sorted.push_back(out[i]);
+    }
+    out.swap(sorted);
+    return out.size();
+}
+
+size_t SpanTracer::exportChromeTrace(const Writer& write) const {
+    std::vector<SpanRecord> spans;
+    snapshot(spans);
+
+    static const char HEADER[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    static const char FOOTER[] = "]}";
+    write(HEADER, sizeof(HEADER) - 1);
+
+    char line[192];
+    char escaped[SpanRecord::MAX_NAME_LENGTH * 2];
+    for (size_t i = 0; i < spans.size(); i++) {
+        const SpanRecord& rec = spans[i];
+
+        // Span names are identifiers, but escape JSON specials to be safe
+        size_t n = 0;
+        for (const char* p = rec.name; *p && n < sizeof(escaped) - 2; p++) {
+            if (*p == '"' || *p == '\\') {
+                escaped[n++] = '\\';
+            }
+            escaped[n++] = (static_cast<unsigned char>(*p) < 0x20) ? ' ' : *p;
+        }
+        escaped[n] = '\0';
+
+        int len = snprintf(line, sizeof(line),
+                           "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%lu,"
+                           "\"pid\":0,\"tid\":%lu,\"args\":{\"core\":%u,\"depth\":%u}}",
+                           i == 0 ? "" : ",", escaped,
+                           static_cast<unsigned long long>(rec.start),
+                           static_cast<unsigned long>(rec.duration),
+                           static_cast<unsigned long>(rec.threadId),
+                           static_cast<unsigned>(rec.core),
+                           static_cast<unsigned>(rec.depth));
+        if (len > 0) {
+            write(line, std::min(static_cast<size_t>(len), sizeof(line) - 1));
+        }
+    }
+
+    write(FOOTER, sizeof(FOOTER) - 1);
+    return spans.size();
+}
+
+void SpanTracer::clear() {
+    for (auto& slot : slots) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+    head.store(0, std::memory_order_release);
+}
+
+TraceSpan::TraceSpan(const char* spanName)
+    : name(spanName)
+    , start(traceNowMicros())
+    , depth(spanDepth++) {
+}
+
+TraceSpan::~TraceSpan() {
+    spanDepth--;
+    SpanTracer::getInstance().record(name, start, traceNowMicros(), depth);
+}
@@ -0,0 +1,312 @@
+#include "SystemProfiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <memory>
+#include <set>
+#include "MetricsSystem.h"
+#endif
+
+using namespace mcp;
+
+static const size_t GAUGE_NAME_LENGTH = 48;
+
+// ===== Host stand-in =====
+
+void HostStatsSource::setTask(uint32_t id, const char* name, uint32_t runtime, uint32_t stackHighWater) {
+    for (auto& task : tasks) {
+        if (task.id == id) {
+            task.runtime = runtime;
+            task.stackHighWater = stackHighWater;
+            return;
+        }
+    }
+
+    TaskSample task = {};
+    task.id = id;
+    strncpy(task.name, name, TaskSample::MAX_NAME_LENGTH - 1);
+    task.runtime = runtime;
+    task.stackHighWater = stackHighWater;
+    tasks.push_back(task);
+}
+
+bool HostStatsSource::sampleTasks(std::vector<TaskSample>& out, uint32_t& total) {
+    out = tasks;
+    total = totalRuntime;
+    return totalRuntime != 0;
+}
+
+// ===== Device source =====
+
+#ifdef ARDUINO
+bool EspStatsSource::sampleTasks(std::vector<TaskSample>& tasks, uint32_t& totalRuntime) {
+    tasks.clear();
+    totalRuntime = 0;
+
+    // Leave headroom for tasks created between the two calls
+    std::vector<TaskStatus_t> status(uxTaskGetNumberOfTasks() + 4);
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status.data(), status.size(), &total);
+
+    tasks.reserve(count);
+    for (UBaseType_t i = 0; i < count; i++) {
+        TaskSample sample = {};
+        sample.id = status[i].xTaskNumber;
+        strncpy(sample.name, status[i].pcTaskName, TaskSample::MAX_NAME_LENGTH - 1);
+#if configGENERATE_RUN_TIME_STATS
+        sample.runtime = status[i].ulRunTimeCounter;
+#endif
+        sample.stackHighWater = status[i].usStackHighWaterMark; // Bytes on ESP-IDF
+        tasks.push_back(sample);
+    }
+
+    totalRuntime = total;
+    return total != 0;
+}
+
+HeapSample EspStatsSource::sampleHeap() {
+    HeapSample sample;
+    sample.freeBytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    sample.minFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    sample.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    sample.psramTotal = ESP.getPsramSize();
+    sample.psramFree = ESP.getFreePsram();
+    return sample;
+}
+#endif
+
+// ===== Collector =====
+
+SystemProfiler::SystemProfiler(SystemStatsSource& statsSource, GaugeSink gaugeSink)
+    : source(statsSource)
+    , sink(gaugeSink)
+    , interval(DEFAULT_INTERVAL_MS)
+    , lastSampleTime(0)
+    , sampled(false)
+    , lastTotalRuntime(0)
+    , fragmentation(0.0)
+    , collectors(std::make_shared<const std::vector<Collector>>())
+    , loopSum(0)
+    , loopCount(0)
+    , loopMax(0)
+#ifdef ARDUINO
+    , taskHandle(nullptr)
+    , stopping(false)
+    , stopped(false)
+#endif
+{
+}
+
+SystemProfiler::~SystemProfiler() {
+#ifdef ARDUINO
+    stop();
+#endif
+}
+
+bool SystemProfiler::tick(uint64_t nowMs) {
+    if (sampled && nowMs - lastSampleTime < interval) {
+        return false;
+    }
+    lastSampleTime = nowMs;
+    sampled = true;
+    sample();
+    return true;
+}
+
+void SystemProfiler::sample() {
+    // Take the loop window and the collector list, then publish unlocked
+    uint64_t sum;
+    uint32_t count;
+    uint32_t max;
+    std::shared_ptr<const std::vector<Collector>> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sum = loopSum;
+        count = loopCount;
+        max = loopMax;
+        loopSum = 0;
+        loopCount = 0;
+        loopMax = 0;
+        current = collectors;
+    }
+    publishTasks();
+    publishHeap();
+    publishLoop(sum, count, max);
+    for (const Collector& collector : *current) {
+        collector(sink);
+    }
+}
+
+void SystemProfiler::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto next = std::make_shared<std::vector<Collector>>(*collectors);
+    next->push_back(std::move(collector));
+    collectors = std::move(next);
+}
+
+void SystemProfiler::recordLoopIteration(uint32_t micros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    loopSum += micros;
+    loopCount++;
+    loopMax = std::max(loopMax, micros);
+}
+
+std::vector<SystemProfiler::TaskUsage> SystemProfiler::getTaskUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return taskUsage;
+}
+
+double SystemProfiler::getFragmentation() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fragmentation;
+}
+
+void SystemProfiler::publishTasks() {
+    uint32_t totalRuntime = 0;
+    bool haveRuntime = source.sampleTasks(taskBuffer, totalRuntime);
+
+    // Counters are 32-bit and may wrap; unsigned subtraction handles one wrap
+    uint32_t totalDelta = totalRuntime - lastTotalRuntime;
+    bool haveDelta = haveRuntime && lastTotalRuntime != 0 && totalDelta != 0;
+
+    usageBuffer.clear();
+    std::map<uint32_t, uint32_t> runtimes;
+    for (const auto& task : taskBuffer) {
+        TaskUsage usage = {};
+        memcpy(usage.name, task.name, sizeof(usage.name));
+        usage.stackHighWater = task.stackHighWater;
+
+        auto previous = lastRuntime.find(task.id);
+        if (haveDelta && previous != lastRuntime.end()) {
+            usage.cpuPercent = 100.0 * static_cast<uint32_t>(task.runtime - previous->second) / totalDelta;
+        }
+        runtimes[task.id] = task.runtime;
+        usageBuffer.push_back(usage);
+    }
+    lastRuntime.swap(runtimes);
+    lastTotalRuntime = haveRuntime ? totalRuntime : 0;
+
+    std::stable_sort(usageBuffer.begin(), usageBuffer.end(), [](const TaskUsage& a, const TaskUsage& b) {
+        return a.cpuPercent > b.cpuPercent;
+    });
+
+    char name[GAUGE_NAME_LENGTH];
+    size_t published = std::min(usageBuffer.size(), MAX_TRACKED_TASKS);
+    for (size_t i = 0; i < published; i++) {
+        const TaskUsage& usage = usageBuffer[i];
+        if (haveDelta) {
+            snprintf(name, sizeof(name), "system.task.%s.cpu", usage.name);
+            sink(name, usage.cpuPercent);
+        }
+        snprintf(name, sizeof(name), "system.task.%s.stack", usage.name);
+        sink(name, usage.stackHighWater);
+    }
+
+    // The previous sample's vector is reused next time
+    std::lock_guard<std::mutex> lock(mutex);
+    taskUsage.swap(usageBuffer);
+}
+
+void SystemProfiler::publishHeap() {
+    HeapSample heap = source.sampleHeap();
+
+    double heapFragmentation = heap.freeBytes == 0
+        ? 0.0
+        : 1.0 - static_cast<double>(heap.largestFreeBlock) / heap.freeBytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fragmentation = heapFragmentation;
+    }
+
+    sink("system.heap.largest_block", heap.largestFreeBlock);
+    sink("system.heap.fragmentation", heapFragmentation);
+
+    if (heap.psramTotal > 0) {
+        sink("system.psram.free", heap.psramFree);
+        sink("system.psram.used", heap.psramTotal - heap.psramFree);
+    }
+}
+
+void SystemProfiler::publishLoop(uint64_t sum, uint32_t count, uint32_t max) {
+    if (count == 0) {
+        return;
+    }
+    sink("system.loop.latency.avg", static_cast<double>(sum) / count);
+    sink("system.loop.latency.max", max);
+}
+
+#ifdef ARDUINO
+bool SystemProfiler::start(uint8_t core) {
+    if (taskHandle) {
+        return true;
+    }
+    stopping.store(false);
+    stopped.store(false);
+    TaskHandle_t handle = nullptr;
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "sysprof", 4096, this, 1, &handle, core);
+    taskHandle = handle;
+    return created == pdPASS;
+}
+
+void SystemProfiler::stop() {
+    if (!taskHandle) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    xTaskNotifyGive(static_cast<TaskHandle_t>(taskHandle));
+    while (!stopped.load(std::memory_order_acquire)) {
+        vTaskDelay(1);
+    }
+    taskHandle = nullptr;
+}
+
+void SystemProfiler::taskEntry(void* arg) {
+    SystemProfiler* profiler = static_cast<SystemProfiler*>(arg);
+    TickType_t nextWake = xTaskGetTickCount();
+
+    for (;;) {
+        // Sleep until the next sample is due, or until stop() notifies
+        TickType_t period = pdMS_TO_TICKS(profiler->interval);
+        nextWake += period;
+        TickType_t remaining = nextWake - xTaskGetTickCount();
+        if (remaining > period) {
+            // Running late: sample now and restart the cadence from here
+            remaining = 0;
+            nextWake = xTaskGetTickCount();
+        }
+        ulTaskNotifyTake(pdTRUE, remaining);
+        if (profiler->stopping.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        MetricsSystem& metrics = MetricsSystem::getInstance();
+        if (metrics.isInitialized()) {
+            metrics.updateSystemMetrics();
+        }
+        profiler->sample();
+    }
+
+    // Past this point the task no longer touches the profiler
+    profiler->stopped.store(true, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+SystemProfiler::GaugeSink SystemProfiler::metricsSink() {
+    // Gauges are registered the first time they are published
+    auto registered = std::make_shared<std::set<String>>();
+    return [registered](const char* name, double value) {
+        MetricsSystem& metrics = MetricsSystem::getInstance();
+        String key(name);
+        if (registered->insert(key).second) {
+            metrics.registerGauge(key, key, "", "system");
+        }
+        metrics.setGauge(key, value);
+    };
+}
+#endif
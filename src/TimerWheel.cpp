@@ -0,0 +1,202 @@
+#include "TimerWheel.h"
+
+namespace mcp {
+
+static const uint32_t SLOT_MASK = TimerWheel::SLOTS - 1;
+
+TimerWheel::TimerWheel(size_t capacity, uint32_t startTick)
+    : nodes(capacity > 0xFFFF ? 0xFFFF : capacity), freeList(-1), active(0), current(startTick) {
+    for (Node& node : nodes) {
+        node.bucket = -1;
+        node.generation = 0;
+    }
+    reset(startTick);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(uint32_t expiry, uint32_t payload) {
+    if (freeList < 0) {
+        return INVALID;
+    }
+    int32_t index = freeList;
+    freeList = nodes[index].next;
+    nodes[index].expiry = expiry;
+    nodes[index].payload = payload;
+    place(index);
+    active++;
+    return idOf(index);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    int32_t index = indexOf(id);
+    if (index < 0) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimerWheel::pending(TimerId id) const {
+    return indexOf(id) >= 0;
+}
+
+size_t TimerWheel::advance(uint32_t tick, const FireFunc& fire) {
+    size_t fired = 0;
+    if (heads[DUE] >= 0) {
+        fired += fireBucket(DUE, fire);
+    }
+    while (static_cast<int32_t>(tick - current) > 0) {
+        if (active == 0) {
+            current = tick;
+            break;
+        }
+        current++;
+        if ((current & SLOT_MASK) == 0) {
+            cascade(1);
+        }
+        fired += fireBucket(current & SLOT_MASK, fire);
+        if (heads[DUE] >= 0) {
+            fired += fireBucket(DUE, fire);
+        }
+    }
+    return fired;
+}
+
+void TimerWheel::reset(uint32_t tick) {
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        heads[bucket] = -1;
+        tails[bucket] = -1;
+    }
+    freeList = -1;
+    for (int32_t index = static_cast<int32_t>(nodes.size()) - 1; index >= 0; index--) {
+        if (nodes[index].bucket >= 0) {
+            nodes[index].generation++;
+        }
+        nodes[index].bucket = -1;
+        nodes[index].next = freeList;
+        freeList = index;
+    }
+    active = 0;
+    current = tick;
+}
+
+// Slot in the lowest level whose span covers the delay
+void TimerWheel::place(int32_t index) {
+    uint32_t expiry = nodes[index].expiry;
+    uint32_t delay = expiry - current;
+    if (static_cast<int32_t>(delay) <= 0) {
+        link(index, DUE);
+        return;
+    }
+    if (delay > MAX_DELAY) {
+        expiry = current + MAX_DELAY;
+        delay = MAX_DELAY;
+    }
+    uint32_t level = 0;
+    while (level + 1 < LEVELS && delay >= (1u << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    link(index, level * SLOTS + ((expiry >> (SLOT_BITS * level)) & SLOT_MASK));
+}
+
+void TimerWheel::link(int32_t index, int bucket) {
+    Node& node = nodes[index];
+    node.bucket = static_cast<int16_t>(bucket);
+    node.next = -1;
+    node.prev = tails[bucket];
+    if (tails[bucket] >= 0) {
+        nodes[tails[bucket]].next = index;
+    } else {
+        heads[bucket] = index;
+    }
+    tails[bucket] = index;
+}
+
+void TimerWheel::unlink(int32_t index) {
+    Node& node = nodes[index];
+    if (node.prev >= 0) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[node.bucket] = node.next;
+    }
+    if (node.next >= 0) {
+        nodes[node.next].prev = node.prev;
+    } else {
+        tails[node.bucket] = node.prev;
+    }
+}
+
+void TimerWheel::release(int32_t index) {
+    Node& node = nodes[index];
+    node.bucket = -1;
+    node.generation++;
+    node.next = freeList;
+    freeList = index;
+    active--;
+}
+
+// Entering a new block of `level`: move its timers down to where they now
+// belong, and cascade the level above when this level wraps
+void TimerWheel::cascade(uint32_t level) {
+    uint32_t slot = (current >> (SLOT_BITS * level)) & SLOT_MASK;
+    int bucket = level * SLOTS + slot;
+    int32_t index = heads[bucket];
+    heads[bucket] = -1;
+    tails[bucket] = -1;
+    while (index >= 0) {
+        int32_t next = nodes[index].next;
+        place(index);
+        index = next;
+    }
+    if (slot == 0 && level + 1 < LEVELS) {
+        cascade(level + 1);
+    }
+}
+
+size_t TimerWheel::fireBucket(int bucket, const FireFunc& fire) {
+    // Due timers move to their own list first, so ones made due by the
+    // callbacks wait for the next tick instead of firing in this loop.
+    // A wheel slot needs no such step: new timers never land in the slot
+    // being fired.
+    if (bucket == DUE) {
+        for (int32_t index = heads[DUE]; index >= 0; index = nodes[index].next) {
+            nodes[index].bucket = FIRING;
+        }
+        heads[FIRING] = heads[DUE];
+        tails[FIRING] = tails[DUE];
+        heads[DUE] = -1;
+        tails[DUE] = -1;
+        bucket = FIRING;
+    }
+    size_t fired = 0;
+    while (heads[bucket] >= 0) {
+        int32_t index = heads[bucket];
+        TimerId id = idOf(index);
+        uint32_t payload = nodes[index].payload;
+        unlink(index);
+        release(index);
+        fired++;
+        if (fire) {
+            fire(id, payload);
+        }
+    }
+    return fired;
+}
+
+TimerWheel::TimerId TimerWheel::idOf(int32_t index) const {
+    return (static_cast<uint32_t>(nodes[index].generation) << 16) | static_cast<uint32_t>(index + 1);
+}
+
+int32_t TimerWheel::indexOf(TimerId id) const {
+    int32_t index = static_cast<int32_t>(id & 0xFFFF) - 1;
+    if (index < 0 || index >= static_cast<int32_t>(nodes.size())) {
+        return -1;
+    }
+    const Node& node = nodes[index];
+    if (node.bucket < 0 || node.generation != (id >> 16)) {
+        return -1;
+    }
+    return index;
+}
+
+} // namespace mcp
@@ -0,0 +1,230 @@
+#include "ToolRegistry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace mcp;
+
+// FNV-1a, enough to tell two renderings apart
+static uint32_t hashBody(const std::string& body) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : body) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+ToolRegistry::ToolRegistry()
+    : staticTable(nullptr), staticFind(nullptr), currentRevision(0) {}
+
+void ToolRegistry::addTool(ToolDefinition tool) {
+    tool.validator = std::make_shared<const ToolValidator>(
+        ToolValidator::compile(tool.params, "Invalid arguments for " + tool.name + ": "));
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& existing : tools) {
+        if (existing.name == tool.name) {
+            existing = std::move(tool);
+            currentRevision++;
+            cache.reset();
+            return;
+        }
+    }
+    tools.push_back(std::move(tool));
+    currentRevision++;
+    cache.reset();
+    rebuildIndexLocked();
+}
+
+bool ToolRegistry::removeTool(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = tools.begin(); it != tools.end(); ++it) {
+        if (it->name == name) {
+            tools.erase(it);
+            currentRevision++;
+            cache.reset();
+            rebuildIndexLocked();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ToolRegistry::hasTool(const char* name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return findLocked(name) != nullptr;
+}
+
+bool ToolRegistry::isReadOnly(const char* name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const ToolDefinition* tool = findLocked(name);
+    return tool && tool->readOnly;
+}
+
+std::string ToolRegistry::coalesceKey(const char* name, JsonVariantConst arguments) const {
+    std::string param;
+    std::shared_ptr<const ToolValidator> validator;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const ToolDefinition* tool = findLocked(name);
+        if (!tool || tool->coalesceParam.empty()) {
+            return std::string();
+        }
+        param = tool->coalesceParam;
+        validator = tool->validator;
+    }
+    if (validator && validator->validate(arguments)) {
+        return std::string();
+    }
+
+    JsonDocument rest;
+    JsonObject others = rest.to<JsonObject>();
+    for (JsonPairConst member : arguments.as<JsonObjectConst>()) {
+        if (param != member.key().c_str()) {
+            others[member.key()] = member.value();
+        }
+    }
+    std::string key = name;
+    key += ':';
+    serializeJson(rest, key);
+    return key;
+}
+
+size_t ToolRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tools.size();
+}
+
+uint32_t ToolRegistry::revision() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentRevision;
+}
+
+std::shared_ptr<const ToolsListCache> ToolRegistry::toolsList() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!cache) {
+        cache = renderLocked();
+    }
+    return cache;
+}
+
+bool ToolRegistry::callTool(const char* name, JsonVariantConst arguments, JsonDocument& result,
+                            ToolRejection* rejection) {
+    std::shared_ptr<ViewToolHandler> handler;
+    std::shared_ptr<const ToolValidator> validator;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const ToolDefinition* tool = findLocked(name);
+        if (!tool) {
+            return false;
+        }
+        handler = tool->handler;
+        validator = tool->validator;
+    }
+
+    const char* message = validator ? validator->validate(arguments) : nullptr;
+    if (message) {
+        if (rejection) {
+            rejection->message = message;
+            rejection->validator = std::move(validator);
+        }
+        return false;
+    }
+    if (handler) {
+        handler->invoke(arguments, result);
+    }
+    return true;
+}
+
+void ToolRegistry::writeTool(const ToolDefinition& tool, JsonObject out) {
+    out["name"] = tool.name.c_str();
+    out["description"] = tool.description.c_str();
+
+    JsonObject schema = out["inputSchema"].to<JsonObject>();
+    schema["type"] = "object";
+    JsonObject properties = schema["properties"].to<JsonObject>();
+    bool anyRequired = false;
+    for (const auto& param : tool.params) {
+        JsonObject property = properties[param.name.c_str()].to<JsonObject>();
+        property["type"] = param.type.c_str();
+        property["description"] = param.description.c_str();
+        if (param.bounded) {
+            property["minimum"] = param.minimum;
+            property["maximum"] = param.maximum;
+        }
+        anyRequired = anyRequired || param.required;
+    }
+    if (anyRequired) {
+        JsonArray required = schema["required"].to<JsonArray>();
+        for (const auto& param : tool.params) {
+            if (param.required) {
+                required.add(param.name.c_str());
+            }
+        }
+    }
+    if (tool.readOnly) {
+        out["annotations"]["readOnlyHint"] = true;
+    }
+}
+
+const ToolDefinition* ToolRegistry::findLocked(const char* name) const {
+    if (!name) {
+        return nullptr;
+    }
+    if (staticFind) {
+        int id = staticFind(staticTable, name);
+        if (id >= 0) {
+            int index = staticToTool[id];
+            return index >= 0 ? &tools[index] : nullptr;
+        }
+    }
+    if (dynamicIndex.empty()) {
+        return nullptr;
+    }
+    size_t mask = dynamicIndex.size() - 1;
+    for (size_t slot = toolNameHash(name) & mask;; slot = (slot + 1) & mask) {
+        int index = dynamicIndex[slot];
+        if (index < 0) {
+            return nullptr;
+        }
+        if (tools[index].name == name) {
+            return &tools[index];
+        }
+    }
+}
+
+void ToolRegistry::rebuildIndexLocked() {
+    std::fill(staticToTool.begin(), staticToTool.end(), -1);
+    dynamicIndex.assign(toolTableSize(tools.size() * 2 + 1), -1);
+    size_t mask = dynamicIndex.size() - 1;
+
+    for (size_t i = 0; i < tools.size(); i++) {
+        const char* name = tools[i].name.c_str();
+        int id = staticFind ? staticFind(staticTable, name) : -1;
+        if (id >= 0) {
+            staticToTool[id] = static_cast<int>(i);
+            continue;
+        }
+        size_t slot = toolNameHash(name) & mask;
+        while (dynamicIndex[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        dynamicIndex[slot] = static_cast<int>(i);
+    }
+}
+
+std::shared_ptr<const ToolsListCache> ToolRegistry::renderLocked() const {
+    JsonDocument doc;
+    JsonArray list = doc["tools"].to<JsonArray>();
+    for (const auto& tool : tools) {
+        writeTool(tool, list.add<JsonObject>());
+    }
+
+    auto rendered = std::make_shared<ToolsListCache>();
+    serializeJson(doc, rendered->body);
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%08x\"", static_cast<unsigned>(hashBody(rendered->body)));
+    rendered->etag = etag;
+    rendered->revision = currentRevision;
+    return rendered;
+}
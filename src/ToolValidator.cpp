@@ -0,0 +1,135 @@
+#include "ToolValidator.h"
+#include "ToolRegistry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace mcp;
+
+ToolValidator ToolValidator::compile(const std::vector<ToolParam>& params, const std::string& messagePrefix) {
+    ToolValidator validator;
+    validator.fields.reserve(params.size());
+    validator.errors.reserve(params.size());
+    validator.requiredMask = 0;
+    for (const ToolParam& param : params) {
+        FieldType type = parseType(param.type);
+        size_t index = validator.fields.size();
+        validator.fields.push_back(FieldCheck{param.name, type, param.required,
+                                              param.bounded, param.minimum, param.maximum});
+        if (param.required && index < MASK_FIELDS) {
+            validator.requiredMask |= uint64_t(1) << index;
+        }
+
+        FieldErrors errors;
+        errors.missing = messagePrefix + "missing required argument '" + param.name + "'";
+        errors.wrongType = messagePrefix + "argument '" + param.name + "' must be " + typeName(type);
+        if (param.bounded) {
+            char range[64];
+            snprintf(range, sizeof(range), " must be between %g and %g", param.minimum, param.maximum);
+            errors.outOfRange = messagePrefix + "argument '" + param.name + "'" + range;
+        }
+        validator.errors.push_back(std::move(errors));
+        validator.byName.push_back(static_cast<uint16_t>(index));
+    }
+    std::sort(validator.byName.begin(), validator.byName.end(), [&validator](uint16_t a, uint16_t b) {
+        return validator.fields[a].name < validator.fields[b].name;
+    });
+    validator.notObject = messagePrefix + "arguments must be an object";
+    return validator;
+}
+
+const char* ToolValidator::validate(JsonVariantConst arguments) const {
+    JsonObjectConst object = arguments.as<JsonObjectConst>();
+    if (!arguments.isNull() && object.isNull()) {
+        return notObject.c_str();
+    }
+
+    uint64_t seen = 0;
+    for (JsonPairConst member : object) {
+        int index = find(member.key().c_str());
+        JsonVariantConst value = member.value();
+        // Undeclared arguments are left to the handler; null counts as absent
+        if (index < 0 || value.isNull()) {
+            continue;
+        }
+        const FieldCheck& field = fields[index];
+        if (!matches(field.type, value)) {
+            return errors[index].wrongType.c_str();
+        }
+        if (field.bounded) {
+            double number = value.as<double>();
+            if (number < field.minimum || number > field.maximum) {
+                return errors[index].outOfRange.c_str();
+            }
+        }
+        if (static_cast<size_t>(index) < MASK_FIELDS) {
+            seen |= uint64_t(1) << index;
+        }
+    }
+
+    if ((seen & requiredMask) == requiredMask && fields.size() <= MASK_FIELDS) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (!fields[i].required) {
+            continue;
+        }
+        bool present = i < MASK_FIELDS ? ((seen >> i) & 1) != 0 : !object[fields[i].name.c_str()].isNull();
+        if (!present) {
+            return errors[i].missing.c_str();
+        }
+    }
+    return nullptr;
+}
+
+int ToolValidator::find(const char* name) const {
+    size_t low = 0;
+    size_t high = byName.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        int order = strcmp(fields[byName[middle]].name.c_str(), name);
+        if (order == 0) {
+            return byName[middle];
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return -1;
+}
+
+ToolValidator::FieldType ToolValidator::parseType(const std::string& type) {
+    if (type == "integer") return FieldType::Integer;
+    if (type == "number") return FieldType::Number;
+    if (type == "string") return FieldType::String;
+    if (type == "boolean") return FieldType::Boolean;
+    if (type == "object") return FieldType::Object;
+    if (type == "array") return FieldType::Array;
+    return FieldType::Any;
+}
+
+const char* ToolValidator::typeName(FieldType type) {
+    switch (type) {
+        case FieldType::Integer: return "an integer";
+        case FieldType::Number: return "a number";
+        case FieldType::String: return "a string";
+        case FieldType::Boolean: return "a boolean";
+        case FieldType::Object: return "an object";
+        case FieldType::Array: return "an array";
+        default: return "present";
+    }
+}
+
+bool ToolValidator::matches(FieldType type, JsonVariantConst value) {
+    switch (type) {
+        case FieldType::Integer: return value.is<long long>() || value.is<unsigned long long>();
+        case FieldType::Number: return value.is<double>();
+        case FieldType::String: return value.is<const char*>();
+        case FieldType::Boolean: return value.is<bool>();
+        case FieldType::Object: return value.is<JsonObjectConst>();
+        case FieldType::Array: return value.is<JsonArrayConst>();
+        default: return true;
+    }
+}
@@ -0,0 +1,180 @@
+#include "ToolWorker.h"
+#include <chrono>
+#include "SpanTracer.h"
+
+#ifdef ARDUINO
+#include <esp_pthread.h>
+#endif
+
+using namespace mcp;
+
+// How often an idle worker checks whether it was stopped
+static const std::chrono::milliseconds IDLE_POLL(50);
+
+ToolWorker::ToolWorker(McpDispatcher& mcpDispatcher, size_t queueSize, QueueObserver* queueObserver)
+    : dispatcher(mcpDispatcher),
+      queue({{QueueLaneConfig{queueSize, CONTROL_WEIGHT}, QueueLaneConfig{queueSize, STATUS_WEIGHT}}}, queueObserver),
+      running(false),
+      coalescing(true),
+      executed(0),
+      execTotalUs(0),
+      execMaxUs(0) {}
+
+ToolWorker::~ToolWorker() {
+    stop();
+}
+
+bool ToolWorker::start(uint8_t core) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (running.load()) {
+        return true;
+    }
+    running.store(true);
+
+#ifdef ARDUINO
+    // std::thread maps to a pthread; the config applies to threads created
+    // by this task until it is reset
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.thread_name = "mcpworker";
+    cfg.stack_size = STACK_SIZE;
+    cfg.prio = 2;
+    cfg.pin_to_core = core;
+    esp_pthread_set_cfg(&cfg);
+#else
+    (void)core;
+#endif
+
+    thread = std::thread(&ToolWorker::run, this);
+
+#ifdef ARDUINO
+    cfg = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&cfg);
+#endif
+    return true;
+}
+
+void ToolWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(lifecycleMutex);
+        running.store(false);
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    // Nothing can be queued any more; do not leave connections hanging
+    Job job;
+    while (queue.try_pop(job)) {
+        for (Superseded& waiter : job.superseded) {
+            waiter.done(unavailable());
+        }
+        job.superseded.clear();
+        job.done(unavailable());
+        job.request.clear();
+        job.arena = JsonArenaPool::Lease();
+    }
+}
+
+bool ToolWorker::submit(JsonDocument&& request, Completion done, JsonArenaPool::Lease&& arena, uint32_t session) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (!running.load()) {
+        return false;
+    }
+    Lane lane = dispatcher.readsOnly(request) ? STATUS_LANE : CONTROL_LANE;
+    Job job{std::move(arena), std::move(request), std::move(done), session};
+    if (lane == CONTROL_LANE && coalescing.load()) {
+        job.coalesceKey = dispatcher.coalesceKey(job.request);
+    }
+    return push(std::move(job), lane);
+}
+
+bool ToolWorker::push(Job&& job, Lane lane) {
+    if (job.coalesceKey.empty()) {
+        return queue.push(std::move(job), lane);
+    }
+    auto relation = [](const Job& waiting, const Job& incoming) {
+        if (waiting.coalesceKey.empty()) {
+            return QueueCoalesce::Stop;
+        }
+        return waiting.coalesceKey == incoming.coalesceKey ? QueueCoalesce::Replace : QueueCoalesce::Pass;
+    };
+    auto absorb = [](Job& incoming, Job&& waiting) {
+        for (Superseded& earlier : waiting.superseded) {
+            incoming.superseded.push_back(std::move(earlier));
+        }
+        incoming.superseded.push_back(
+            Superseded{McpDispatcher::serializeId(waiting.request["id"]), std::move(waiting.done)});
+    };
+    return queue.pushCoalescing(std::move(job), lane, relation, absorb);
+}
+
+ToolWorker::Stats ToolWorker::getStats() const {
+    Stats stats = {};
+    for (size_t i = 0; i < LANE_COUNT; i++) {
+        QueueLaneStats lane = queue.stats(i);
+        stats.submitted += lane.pushed;
+        stats.rejected += lane.rejected;
+        stats.depth += lane.depth;
+        stats.highWater += lane.highWater;
+        stats.waitTotalUs += lane.waitTotalUs;
+        if (lane.waitMaxUs > stats.waitMaxUs) {
+            stats.waitMaxUs = lane.waitMaxUs;
+        }
+        stats.coalesced += lane.superseded;
+    }
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.executed = executed;
+    stats.execTotalUs = execTotalUs;
+    stats.execMaxUs = execMaxUs;
+    return stats;
+}
+
+void ToolWorker::run() {
+    Job job;
+    while (running.load()) {
+        if (queue.pop_wait(job, IDLE_POLL)) {
+            execute(job);
+        }
+    }
+}
+
+void ToolWorker::execute(Job& job) {
+    uint64_t start = traceNowMicros();
+    McpResponse response = dispatcher.handle(job.request, job.arena, job.session);
+    uint32_t elapsed = static_cast<uint32_t>(traceNowMicros() - start);
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        executed++;
+        execTotalUs += elapsed;
+        if (elapsed > execMaxUs) {
+            execMaxUs = elapsed;
+        }
+    }
+    if (sink) {
+        sink(elapsed, queue.size());
+    }
+
+    // Replaced callers came first; each gets the reply under its own id
+    for (Superseded& waiter : job.superseded) {
+        waiter.done(McpDispatcher::withId(response, waiter.idJson));
+    }
+    job.superseded.clear();
+    job.done(std::move(response));
+    // Release the document, then its arena, before waiting for the next job
+    job.request.clear();
+    job.arena = JsonArenaPool::Lease();
+}
+
+McpResponse ToolWorker::unavailable() {
+    return McpResponse{503, std::string(), std::string()};
+}
+
+void ToolWorker::publish(const SystemProfiler::GaugeSink& gauges) const {
+    Stats stats = getStats();
+    gauges("mcp.worker.executed", static_cast<double>(stats.executed));
+    gauges("mcp.worker.coalesced", static_cast<double>(stats.coalesced));
+    gauges("mcp.worker.exec_avg_ms", stats.executed ? stats.execTotalUs / 1000.0 / stats.executed : 0.0);
+    gauges("mcp.worker.exec_max_ms", stats.execMaxUs / 1000.0);
+    gauges("mcp.worker.queue_depth", static_cast<double>(stats.depth));
+}
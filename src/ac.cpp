@@ -6,14 +6,20 @@
 #include "uart.h"
 #include "xl9555.h"
 #include "spilcd.h"
+#include "SpanTracer.h"
+#include "AllocTracker.h"
 
 // 构造函数
 AirConditioner::AirConditioner() {
     mode = AC_MODE_AUTO; // 默认模式为自动
     temperature = 25;
     isRunning = false;
+    stateVersion = 0;
     lcdEnabled = false;
     lastUpdate = 0;
+    batchDepth = 0;
+    lcdPending = false;
+    published.store({isRunning, mode, temperature, stateVersion});
     Serial.println("空调系统初始化完成");
 }
 
@@ -21,7 +27,13 @@ String AirConditioner::description() {
     return "{\"device_type\":\"空调\",\"brand\":\"美的\",\"model\":\"KFR-35GW/N8XHA1\",\"description\":\"这是一个美的空调\",\"alias\":\"次卧空调\"}";
 }
 
-String AirConditioner::listTools() {
+const String& AirConditioner::listTools() {
+    // 工具定义启动后不会变化，只序列化一次
+    static String cached;
+    if (!cached.isEmpty()) {
+        return cached;
+    }
+
     JsonDocument doc;
     JsonObject result = doc.to<JsonObject>();
     JsonArray tools = result["tools"].to<JsonArray>();
@@ -46,9 +58,8 @@ String AirConditioner::listTools() {
     turnOffInputSchema["properties"].to<JsonObject>();
     
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+    serializeJson(doc, cached);
+    return cached;
 }
 
 /*
@@ -56,22 +67,26 @@ String AirConditioner::listTools() {
     说明：
         如果空调没有处于开机模式，需要先开机 
     参数：
-        mode: 空调工作模式，0表示自动，1表示制冷，2表示制热，4表示抽湿
+        mode: 空调工作模式，0表示自动，1表示制冷，2表示制热，3表示抽湿
     返回：
-        code: 状态码，0表示成功，1表示失败
-        msg: 若不成功展示错误信息
+        error: AC_OK 表示成功，否则为失败原因
+        state: 设置后的空调状态
 */
-String AirConditioner::setMode(int newMode) {
+ACResult AirConditioner::setMode(int newMode) {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
     if (newMode < AC_MODE_AUTO || newMode > AC_MODE_DEHUMIDIFY) {
-        return "{\"code\":1,\"msg\":\"无效的空调模式\"}";
+        return {AC_ERR_INVALID_MODE, getState()};
     }
     if (!isRunning) {
-        return "{\"code\":1,\"msg\":\"空调未开启，请先开启空调\"}";
+        return {AC_ERR_NOT_RUNNING, getState()};
+    }
+    if (mode != newMode) {
+        mode = newMode;
+        markChanged();
     }
-    mode = newMode;
-    Serial.printf("空调模式已设置为: %s\n", getModeString().c_str());
+    Serial.printf("空调模式已设置为: %s\n", acModeName(mode));
     forceLCDUpdate(); // 立即更新LCD显示
-    return "{\"code\":0,\"msg\":\"空调模式已设置为: " + getModeString() + "\"}";
+    return {AC_OK, getState()};
 }
 
 /*
@@ -82,23 +97,12 @@ String AirConditioner::setMode(int newMode) {
         data: 空调工作模式，0表示自动，1表示制冷，2表示制热，4表示抽湿
 */
 int AirConditioner::getMode() const {
-    return mode;
+    return getState().mode;
 }
 
 // 获取工作模式字符串
 String AirConditioner::getModeString() const {
-    switch (mode) {
-        case AC_MODE_AUTO:
-            return "auto";
-        case AC_MODE_COOL:
-            return "cool";
-        case AC_MODE_HEAT:
-            return "heat";
-        case AC_MODE_DEHUMIDIFY:
-            return "humdify";
-        default:
-            return "unknown";
-    }
+    return acModeName(getState().mode);
 }
 
 /*
@@ -106,37 +110,43 @@ String AirConditioner::getModeString() const {
     说明：
         如果空调没有处于开机模式，需要先开机
 */
-String AirConditioner::setTemperature(int temp) {
+ACResult AirConditioner::setTemperature(int temp) {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
     if (temp < MIN_TEMPERATURE || temp > MAX_TEMPERATURE) {
         Serial.printf("温度超出范围: %d (范围: %d-%d)\n", temp, MIN_TEMPERATURE, MAX_TEMPERATURE);
-        return "{\"code\":1,\"msg\":\"温度超出范围\"}";
+        return {AC_ERR_TEMPERATURE_RANGE, getState()};
     }
     if (!isRunning) {
         Serial.println("空调未开启，请先开启空调");
-        return "{\"code\":1,\"msg\":\"空调未开启，请先开启空调\"}";
+        return {AC_ERR_NOT_RUNNING, getState()};
+    }
+    if (temperature != temp) {
+        temperature = temp;
+        markChanged();
     }
-    temperature = temp;
     Serial.printf("空调温度已设置为: %d°C\n", temperature);
     forceLCDUpdate(); // 立即更新LCD显示
-    return "{\"code\":0,\"msg\":\"空调温度已设置为: " + String(temperature) + "°C\"}";
+    return {AC_OK, getState()};
 }
 
 // 获取温度
 int AirConditioner::getTemperature() const {
-    return temperature;
+    return getState().temperature;
 }
 
 /*
     开启空调
 */
 bool AirConditioner::turnOn() {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
     if (isRunning) {
         Serial.println("空调已经在运行中");
         return true;
     }
     
     isRunning = true;
-    Serial.printf("空调已开启 - 模式: %s, 温度: %d°C\n", getModeString().c_str(), temperature);
+    markChanged();
+    Serial.printf("空调已开启 - 模式: %s, 温度: %d°C\n", acModeName(mode), temperature);
     forceLCDUpdate(); // 立即更新LCD显示
     return true;
 }
@@ -146,13 +156,17 @@ bool AirConditioner::turnOn() {
 
 */
 bool AirConditioner::turnOff() {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
     if (!isRunning) {
         Serial.println("空调已经关闭");
         return true;
     }
     
     isRunning = false;
-    clearLCD();
+    markChanged();
+    if (lcdEnabled) {
+        clearLCD(); // 只有显示在LCD上的设备才清屏 (网关上其他设备共用同一块屏)
+    }
     Serial.println("空调已关闭");
     forceLCDUpdate(); // 立即更新LCD显示
     return true;
@@ -160,31 +174,92 @@ bool AirConditioner::turnOff() {
 
 // 获取工作状态
 bool AirConditioner::getRunningStatus() const {
-    return isRunning;
+    return getState().running;
 }
 
 // 获取状态字符串
 String AirConditioner::getStatusString() const {
-    return isRunning ? "运行中" : "已关闭";
+    return getState().running ? "运行中" : "已关闭";
+}
+
+// 获取状态快照
+ACState AirConditioner::getState() const {
+    ACState state;
+    if (published.tryLoad(state, mcp::SeqLock<ACState>::SPIN_ATTEMPTS)) {
+        return state;
+    }
+    // 一直与写入重叠: 写者可能在本核心上被抢占，改为等待状态锁 (锁内没有写入在进行)
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
+    return published.load();
+}
+
+// 获取状态版本号
+uint32_t AirConditioner::getStateVersion() const {
+    return getState().version;
+}
+
+// 设置状态变化监听者
+void AirConditioner::setChangeListener(std::function<void()> listener) {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
+    changeListener = std::move(listener);
+}
+
+// 状态已变化，递增版本号使缓存的状态输出失效，并通知监听者
+void AirConditioner::markChanged() {
+    stateVersion++;
+    published.store({isRunning, mode, temperature, stateVersion});
+    if (changeListener) {
+        changeListener();
+    }
 }
 
 // 获取完整状态信息
 String AirConditioner::getFullStatus() const {
+    ACState state = getState();
     String status = "空调状态:\n";
-    status += "  工作状态: " + getStatusString() + "\n";
-    status += "  工作模式: " + getModeString() + "\n";
-    status += "  设定温度: " + String(temperature) + "°C\n";
+    status += String("  工作状态: ") + (state.running ? "运行中" : "已关闭") + "\n";
+    status += String("  工作模式: ") + acModeName(state.mode) + "\n";
+    status += "  设定温度: " + String(state.temperature) + "°C\n";
     return status;
 }
 
 // 重置为默认设置
 void AirConditioner::reset() {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
     mode = AC_MODE_AUTO;
     temperature = 25;
     isRunning = false;
+    markChanged();
     Serial.println("空调已重置为默认设置");
 }
 
+/*
+    恢复保存的状态
+    说明：
+        启动时由状态日志调用，直接设置运行状态、模式和温度，
+        不要求先开机；保存的值超出范围时不做任何修改
+    返回：
+        error: AC_OK 表示成功，否则为失败原因
+        state: 恢复后的空调状态
+*/
+ACResult AirConditioner::restoreState(const ACState& saved) {
+    std::lock_guard<std::recursive_mutex> lock(stateMutex);
+    if (saved.mode < AC_MODE_AUTO || saved.mode > AC_MODE_DEHUMIDIFY) {
+        return {AC_ERR_INVALID_MODE, getState()};
+    }
+    if (saved.temperature < MIN_TEMPERATURE || saved.temperature > MAX_TEMPERATURE) {
+        return {AC_ERR_TEMPERATURE_RANGE, getState()};
+    }
+    isRunning = saved.running;
+    mode = saved.mode;
+    temperature = saved.temperature;
+    markChanged();
+    Serial.printf("空调状态已恢复 - %s, 模式: %s, 温度: %d°C\n",
+                  isRunning ? "运行中" : "已关闭", acModeName(mode), temperature);
+    forceLCDUpdate();
+    return {AC_OK, getState()};
+}
+
 /*
     获取空调状态JSON
     返回：
@@ -193,12 +268,10 @@ void AirConditioner::reset() {
         temerature: 表示空调目标温度
 */
 String AirConditioner::getStatusJSON() const {
-    String json = "{";
-    json += "\"running\":" + String(isRunning ? "true" : "false") + ",";
-    json += "\"mode\":" + String(mode) + ",";
-    json += "\"modeString\":\"" + getModeString() + "\",";
-    json += "\"temperature\":" + String(temperature);
-    json += "}";
+    JsonDocument doc;
+    writeACState(getState(), doc.to<JsonObject>());
+    String json;
+    serializeJson(doc, json);
     return json;
 }
 
@@ -239,19 +312,34 @@ bool AirConditioner::initLCD() {
 }
 
 void AirConditioner::clearLCD() {
-        lcd_clear(WHITE);
+    std::lock_guard<std::mutex> lock(lcdMutex);
+    lcd_clear(WHITE);
 }
 
-// 更新LCD显示
+// 更新LCD显示 (距上次刷新不足 UPDATE_INTERVAL 时跳过)
 void AirConditioner::updateLCDDisplay() {
+    refreshLCD(false);
+}
+
+// 按状态快照绘制LCD，不持有状态锁，主循环刷新时不阻塞状态写入
+void AirConditioner::refreshLCD(bool force) {
     if (!lcdEnabled) {
         return;
     }
     
+    std::lock_guard<std::mutex> lock(lcdMutex);
     unsigned long currentTime = millis();
-    if (currentTime - lastUpdate < UPDATE_INTERVAL) {
+    if (!force && currentTime - lastUpdate < UPDATE_INTERVAL) {
         return; // 还未到更新时间
     }
+    // 不在此处等待状态锁 (写者持有状态锁时会来获取LCD锁)；
+    // 与写入重叠时跳过本次刷新，写者写完后会自己强制刷新
+    ACState state;
+    if (!published.tryLoad(state, mcp::SeqLock<ACState>::SPIN_ATTEMPTS)) {
+        return;
+    }
+    TRACE_SPAN("lcd.refresh");
+    ALLOC_SCOPE("lcd.render");
     
     // 清屏
     // 显示标题
@@ -259,8 +347,8 @@ void AirConditioner::updateLCDDisplay() {
     
     // 显示状态和模式
     char statusStr[128];
-    if (isRunning) {
-        sprintf(statusStr, "Status: ON Mode: %s", getModeString().c_str());
+    if (state.running) {
+        sprintf(statusStr, "Status: ON Mode: %s", acModeName(state.mode));
     } else {
         sprintf(statusStr, "Status: OFF");
     }
@@ -268,11 +356,11 @@ void AirConditioner::updateLCDDisplay() {
     
     // 显示温度
     char tempStr[32];
-    sprintf(tempStr, "Temperature: %d C", temperature);
+    sprintf(tempStr, "Temperature: %d C", state.temperature);
     lcd_show_string(10, 56, 200, 24, LCD_FONT_24, tempStr, BLACK);
     
     // 显示运行指示器
-    if (isRunning) {
+    if (state.running) {
         static int animFrame = 0;
         const char* anim = "|/-\\";
         char animStr[16];
@@ -299,6 +387,7 @@ void AirConditioner::enableLCD(bool enable) {
         Serial.println("LCD显示已启用");
         forceLCDUpdate();
     } else {
+        std::lock_guard<std::mutex> lock(lcdMutex);
         lcd_clear(BLACK);
         Serial.println("LCD显示已禁用");
     }
@@ -315,6 +404,27 @@ void AirConditioner::forceLCDUpdate() {
         return;
     }
     
-    lastUpdate = 0; // 重置更新时间，强制更新
-    updateLCDDisplay();
+    {
+        std::lock_guard<std::recursive_mutex> lock(stateMutex);
+        if (batchDepth > 0) {
+            lcdPending = true; // 批量操作结束时统一刷新
+            return;
+        }
+    }
+    refreshLCD(true);
+}
+
+// 开始批量操作
+void AirConditioner::beginBatch() {
+    stateMutex.lock();
+    batchDepth++;
+}
+
+// 结束批量操作，合并执行推迟的LCD刷新
+void AirConditioner::endBatch() {
+    if (--batchDepth == 0 && lcdPending) {
+        lcdPending = false;
+        forceLCDUpdate();
+    }
+    stateMutex.unlock();
 }
\ No newline at end of file
@@ -2,21 +2,61 @@
 #include <LittleFS.h>
 #include <esp_task_wdt.h>
 #include "NetworkManager.h"
-#include "MCPServer.h"
 #include "ACTools.h"
+#include "ToolRegistry.h"
+#include "McpEndpoint.h"
+#include "ToolWorker.h"
+#include "JsonArena.h"
+#include "ResourceHub.h"
+#include "AdmissionControl.h"
+#include "QueueMetrics.h"
+#include "MetricsSystem.h"
+#include "SystemProfiler.h"
+#include "AllocTracker.h"
 
 // Global instances
 
 // MCP Server 监听的端口
 int MCP_HTTP_PORT = 9000;
 
-AirConditioner airConditioner;
-MCPServer* mcpServer = nullptr;
+// 每个客户端的请求速率限制 (每秒请求数, 突发上限)
+const uint32_t MCP_RATE_PER_SECOND = 10;
+const uint32_t MCP_RATE_BURST = 20;
+
+// 工具调用队列每条通道 (控制/查询) 的长度
+const size_t MCP_TOOL_QUEUE_SIZE = 4;
+
+// 请求 JSON 文档使用的内存区大小；超出的部分回落到堆上并计入 overflows
+const size_t MCP_JSON_ARENA_SIZE = 2048;
+
+// 定时任务使用的本地时区 (POSIX TZ 格式)
+const char* AC_TIMEZONE = "CST-8";
+
+// Indoor units behind this gateway; the first is the default unit and is shown on the LCD
+const char* AC_UNIT_IDS[] = {"main"};
+
+ACDeviceRegistry acDevices;
+AirConditioner* airConditioner = nullptr;   // Default unit
+LittleFSJournalStore acJournalStore;        // Unit state saved across reboots
+SystemScheduleClock scheduleClock;
+LittleFSScheduleStore scheduleStore;
+ACScheduler acScheduler(scheduleClock, &scheduleStore);
+mcp::ToolRegistry toolRegistry;
+mcp::McpEndpoint* mcpEndpoint = nullptr;
+ACDeviceScope* acDeviceScope = nullptr;
+mcp::ToolWorker* toolWorker = nullptr;
+mcp::MetricsQueueObserver* toolQueueMetrics = nullptr;
+mcp::JsonArenaPool* jsonArenas = nullptr;
+mcp::ResourceHub resourceHub(esp_random);  // Session ids from the hardware RNG
+mcp::AdmissionControl admissionControl(MCP_RATE_PER_SECOND, MCP_RATE_BURST);
 NetworkManager networkManager;
+mcp::EspStatsSource statsSource;
+mcp::SystemProfiler* systemProfiler = nullptr;
 
 // Helper function to repeat characters
 String repeatChar(const char* ch, int count) {
-    String result = "";
+    String result;
+    result.reserve(count * strlen(ch)); // 一次分配，避免逐字符扩容
     for (int i = 0; i < count; i++) {
         result += ch;
     }
@@ -25,6 +65,24 @@ String repeatChar(const char* ch, int count) {
 
 void setup() {
     Serial.begin(115200);
+
+    // Bring the units back to their saved state first, before anything
+    // slow (WiFi, mDNS, the MCP server) gets to run
+    uint32_t restoreStart = millis();
+    if (!LittleFS.begin(true)) {
+        Serial.println("❌ LittleFS mount failed, AC state will not be saved");
+    }
+    for (const char* id : AC_UNIT_IDS) {
+        if (!acDevices.add(id)) {
+            Serial.printf("❌ Invalid or duplicate AC unit id: %s\n", id);
+        }
+    }
+    airConditioner = &acDevices.defaultDevice()->ac;
+    size_t restored = acDevices.restoreStates(acJournalStore);
+    Serial.printf("Restored %u of %u AC units in %u ms\n", static_cast<unsigned>(restored),
+                  static_cast<unsigned>(acDevices.size()), static_cast<unsigned>(millis() - restoreStart));
+    acScheduler.load();
+
     Serial.println("\n" + repeatChar("*", 60));
     Serial.println("                ESP32 MCP SERVER STARTING");
     Serial.println(repeatChar("*", 60));
@@ -33,36 +91,80 @@ void setup() {
     // Start network manager (it will initialize LittleFS)
     networkManager.begin();
 
+    // Schedules run on local time; they stay idle until NTP has synced
+    configTzTime(AC_TIMEZONE, "pool.ntp.org", "ntp.aliyun.com");
+
     // Wait for network connection or AP mode
     Serial.println("Waiting for network initialization...");
     uint32_t startTime = millis();
 
-    // Initialize Air Conditioner with LCD
+    // Initialize Air Conditioner LCD (units were created and restored above)
     Serial.println("Initializing Air Conditioner...");
-    
+
     // 验证空调系统基本状态
     Serial.printf("✅ Air Conditioner basic system initialized - Mode: %s, Temp: %d°C, Status: %s\n", 
-                  airConditioner.getModeString().c_str(), 
-                  airConditioner.getTemperature(), 
-                  airConditioner.getStatusString().c_str());
+                  airConditioner->getModeString().c_str(), 
+                  airConditioner->getTemperature(), 
+                  airConditioner->getStatusString().c_str());
     
     // 初始化LCD屏幕
-    if (!airConditioner.initLCD()) {
+    if (!airConditioner->initLCD()) {
         Serial.println("❌ LCD initialization failed. Air Conditioner will not display.");
     } else {
         Serial.println("✅ Air Conditioner initialized with LCD.");
     }
 
+    // Start metrics and the periodic system profiler
+    if (!mcp::MetricsSystem::getInstance().begin()) {
+        Serial.println("❌ Metrics system initialization failed");
+    }
+#ifdef MCP_ALLOC_TRACKING
+    mcp::AllocTracker::getInstance().setReporter(mcp::AllocTracker::metricsReporter);
+#endif
+    systemProfiler = new mcp::SystemProfiler(statsSource, mcp::SystemProfiler::metricsSink());
+    if (!systemProfiler->start(1)) {
+        Serial.println("❌ Failed to start system profiler task");
+    }
+
     // Register MCP Tools
     Serial.println("Registering MCP tools...");
-    mcpServer = new MCPServer(MCP_HTTP_PORT, "ESP32-AC-MCP-Server", "1.0.0");
-    registerACTools(*mcpServer, airConditioner);
+    registerACTools(toolRegistry, acDevices);
+    registerACResources(resourceHub, acDevices);
+    registerACScheduleTools(toolRegistry, acDevices, acScheduler);
 
     // Start MCP Server
     Serial.println("Starting MCP server...");
+    mcpEndpoint = new mcp::McpEndpoint(MCP_HTTP_PORT, toolRegistry, "ESP32-AC-MCP-Server", "1.0.0");
+    acDeviceScope = new ACDeviceScope();
+    mcpEndpoint->getDispatcher().setObserver(acDeviceScope);
+    mcpEndpoint->setResources(&resourceHub);
+    mcpEndpoint->setAdmission(&admissionControl);
 
-    // Create MCP task
+    // Request documents live in these arenas instead of the general heap,
+    // enough for every request the tool queue can hold
+    jsonArenas = new mcp::JsonArenaPool(mcp::ToolWorker::arenasFor(MCP_TOOL_QUEUE_SIZE), MCP_JSON_ARENA_SIZE);
+    mcpEndpoint->getDispatcher().setArenaPool(jsonArenas);
+
+    // Tool calls run on core 1 so the AsyncTCP task on core 0 stays responsive
     Serial.println("Creating MCP task on core 1...");
+    // Lanes in ToolWorker::Lane order
+    toolQueueMetrics = new mcp::MetricsQueueObserver("mcp", {"control", "status"});
+    toolWorker = new mcp::ToolWorker(mcpEndpoint->getDispatcher(), MCP_TOOL_QUEUE_SIZE, toolQueueMetrics);
+    systemProfiler->addCollector([](const mcp::SystemProfiler::GaugeSink& sink) {
+        toolQueueMetrics->publish(sink);
+        toolWorker->publish(sink);
+        acDeviceScope->publish(sink);
+        admissionControl.publish(sink);
+        acDevices.publish(sink);
+        sink("ac.schedule_runs", acScheduler.runs());
+        sink("ac.schedule_failures", acScheduler.failures());
+    });
+    if (toolWorker->start(1)) {
+        mcpEndpoint->setWorker(toolWorker);
+    } else {
+        Serial.println("❌ Failed to start tool worker, tool calls run on the network task");
+    }
+    mcpEndpoint->begin();
 
     Serial.println(repeatChar("*", 60));
     Serial.println("              SYSTEM INITIALIZATION COMPLETE");
@@ -74,12 +176,27 @@ void loop() {
     static unsigned long lastLCDUpdate = 0;
     static unsigned long lastHeartbeat = 0;
     unsigned long currentTime = millis();
+    uint32_t iterationStart = micros();
     
     // 定期更新LCD显示
     if (currentTime - lastLCDUpdate >= 1000) {  // 每秒更新一次LCD
-        airConditioner.updateLCDDisplay();
+        airConditioner->updateLCDDisplay();
         lastLCDUpdate = currentTime;
     }
+
+    // 状态稳定后写入状态日志 (防抖，只在变化时写)
+    acDevices.persistStates(currentTime);
+
+    // 执行到期的定时任务 (只推进时间轮，不逐个检查任务)
+    acScheduler.run();
+
+    // 房间热模拟按整秒推进；读数由 systemProfiler 的采集周期发布
+    acDevices.simulate(currentTime);
+
+    // 记录本次循环耗时（不含下面的延时）
+    if (systemProfiler) {
+        systemProfiler->recordLoopIteration(micros() - iterationStart);
+    }
     // 短暂延时，避免CPU占用过高
     delay(100);
 }
\ No newline at end of file
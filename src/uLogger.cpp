@@ -63,6 +63,32 @@ bool uLogger::logMetric(const char* name, const void* data, size_t dataSize) {
     return success;
 }
 
+bool uLogger::logMetrics(const std::vector<Record>& records) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!initialized) {
+        return false;
+    }
+    if (records.empty()) {
+        return true;
+    }
+    if (!openLog("a+")) {
+        return false;
+    }
+
+    bool success = true;
+    for (const auto& record : records) {
+        success = writeRecord(record) && success;
+    }
+
+    if (logFile.size() >= MAX_FILE_SIZE) {
+        rotateLog();
+    }
+
+    closeLog();
+    return success;
+}
+
 size_t uLogger::queryMetrics(const char* name, uint64_t startTime, std::vector<Record>& records) {
     std::lock_guard<std::mutex> lock(mutex);
     
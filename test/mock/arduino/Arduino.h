@@ -0,0 +1,102 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core that ac.cpp and
+// ACTools.cpp use, so the device code can be linked into native tests.
+// Serial output is counted and discarded; time comes from steady_clock.
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+class String {
+public:
+    String() {}
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    explicit String(int number) : value(std::to_string(number)) {}
+    explicit String(unsigned long number) : value(std::to_string(number)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(value.size()); }
+    bool isEmpty() const { return value.empty(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* other) { value += other; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+    bool operator==(const char* other) const { return value == other; }
+
+    // ArduinoJson writer interface, so serializeJson() can target a String
+    size_t write(uint8_t c) { value += static_cast<char>(c); return 1; }
+    size_t write(const uint8_t* data, size_t length) {
+        value.append(reinterpret_cast<const char*>(data), length);
+        return length;
+    }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+    friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+
+private:
+    std::string value;
+};
+
+class MockSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const char* text) { return count(strlen(text)); }
+    size_t print(const String& text) { return count(text.length()); }
+    size_t println(const char* text = "") { return count(strlen(text) + 1); }
+    size_t println(const String& text) { return count(text.length() + 1); }
+    size_t printf(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(nullptr, 0, format, args);
+        va_end(args);
+        return count(length > 0 ? static_cast<size_t>(length) : 0);
+    }
+
+    size_t bytesWritten() const { return written.load(); }
+
+private:
+    // Atomic: the UART driver serializes writes from several tasks
+    size_t count(size_t length) { written += length; return length; }
+    std::atomic<size_t> written{0};
+};
+
+static MockSerial Serial;
+
+// esp32-hal-log: counted with the Serial output
+#define log_e(format, ...) Serial.printf(format "\n", ##__VA_ARGS__)
+#define log_w(format, ...) Serial.printf(format "\n", ##__VA_ARGS__)
+
+// Time since the host booted, so millis() is large like on a device that has been up a while
+inline unsigned long millis() {
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline unsigned long micros() {
+    return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline uint32_t esp_random() {
+    static std::mt19937 generator(std::random_device{}());
+    return generator();
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return 0; }
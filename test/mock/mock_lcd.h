@@ -0,0 +1,73 @@
+#pragma once
+
+// Simulated SPI LCD for host builds of ac.cpp: the lcd_* calls the
+// AirConditioner makes take as long as pushing their pixels over the SPI
+// bus would on the device, so LCD refreshes cost realistic time under load.
+// Include from exactly one translation unit.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include "spilcd.h"
+#include "uart.h"
+#include "xl9555.h"
+
+class MockLcd {
+public:
+    static const uint16_t WIDTH = 320;
+    static const uint16_t HEIGHT = 240;
+
+    static std::atomic<uint32_t> spiClockHz;   // 0 makes drawing free
+    static std::atomic<uint64_t> bytesSent;
+    static std::atomic<uint32_t> draws;
+
+    static void reset() {
+        bytesSent = 0;
+        draws = 0;
+    }
+
+    // RGB565 pixels over the bus, busy-waiting like a blocking SPI transfer
+    static void transfer(uint32_t pixels) {
+        uint64_t bytes = static_cast<uint64_t>(pixels) * 2;
+        bytesSent += bytes;
+        draws++;
+        uint32_t clock = spiClockHz.load();
+        if (clock == 0) {
+            return;
+        }
+        auto busyUntil = std::chrono::steady_clock::now() +
+                         std::chrono::nanoseconds(bytes * 8 * 1000000000ULL / clock);
+        while (std::chrono::steady_clock::now() < busyUntil) {
+        }
+    }
+
+    static uint16_t fontHeight(lcd_font_t font) {
+        switch (font) {
+            case LCD_FONT_12: return 12;
+            case LCD_FONT_16: return 16;
+            case LCD_FONT_24: return 24;
+            default: return 32;
+        }
+    }
+};
+
+std::atomic<uint32_t> MockLcd::spiClockHz(80000000);   // SPICLK in spilcd.cpp
+std::atomic<uint64_t> MockLcd::bytesSent(0);
+std::atomic<uint32_t> MockLcd::draws(0);
+
+void uart_init(uint8_t, uint32_t) {}
+void xl9555_init(void) {}
+void lcd_init(void) {}
+
+void lcd_clear(uint16_t) {
+    MockLcd::transfer(static_cast<uint32_t>(MockLcd::WIDTH) * MockLcd::HEIGHT);
+}
+
+// Glyphs are font-height x half-width cells, drawn one by one
+void lcd_show_string(uint16_t, uint16_t, uint16_t width, uint16_t, lcd_font_t font, char* str, uint16_t) {
+    uint16_t height = MockLcd::fontHeight(font);
+    size_t glyphs = strlen(str);
+    size_t fit = width / (height / 2);
+    MockLcd::transfer(static_cast<uint32_t>((glyphs < fit ? glyphs : fit) * height * (height / 2)));
+}
@@ -0,0 +1,145 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "ACResult.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// What AirConditioner returned before ACResult: a hand-built JSON string
+static std::string legacySetTemperature(const ACResult& result) {
+    if (result.error == AC_ERR_TEMPERATURE_RANGE) {
+        return "{\"code\":1,\"msg\":\"温度超出范围\"}";
+    }
+    if (result.error == AC_ERR_NOT_RUNNING) {
+        return "{\"code\":1,\"msg\":\"空调未开启，请先开启空调\"}";
+    }
+    return "{\"code\":0,\"msg\":\"空调温度已设置为: " + std::to_string(result.state.temperature) + "°C\"}";
+}
+
+static std::string legacyStatus(const ACState& state) {
+    std::string json = "{";
+    json += "\"running\":" + std::string(state.running ? "true" : "false") + ",";
+    json += "\"mode\":" + std::to_string(state.mode) + ",";
+    json += "\"modeString\":\"" + std::string(acModeName(state.mode)) + "\",";
+    json += "\"temperature\":" + std::to_string(state.temperature);
+    json += "}";
+    return json;
+}
+
+static std::string serialize(const JsonDocument& doc) {
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_mode_result_matches_legacy_format() {
+    JsonDocument doc;
+    writeModeResult({AC_OK, {true, 1, 24}}, doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_STRING("{\"code\":0,\"msg\":\"空调模式已设置为: cool\"}", serialize(doc).c_str());
+
+    writeModeResult({AC_ERR_INVALID_MODE, {true, 1, 24}}, doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_STRING("{\"code\":1,\"msg\":\"无效的空调模式\"}", serialize(doc).c_str());
+
+    writeModeResult({AC_ERR_NOT_RUNNING, {false, 0, 25}}, doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_STRING("{\"code\":1,\"msg\":\"空调未开启，请先开启空调\"}", serialize(doc).c_str());
+}
+
+void test_temperature_result_matches_legacy_format() {
+    const ACResult results[] = {
+        {AC_OK, {true, 0, 21}},
+        {AC_ERR_TEMPERATURE_RANGE, {true, 0, 25}},
+        {AC_ERR_NOT_RUNNING, {false, 0, 25}},
+    };
+    for (const ACResult& result : results) {
+        JsonDocument doc;
+        writeTemperatureResult(result, doc.to<JsonObject>());
+        TEST_ASSERT_EQUAL_STRING(legacySetTemperature(result).c_str(), serialize(doc).c_str());
+    }
+}
+
+void test_state_matches_legacy_format() {
+    const ACState state = {true, 2, 28};
+    JsonDocument doc;
+    writeACState(state, doc.to<JsonObject>());
+    TEST_ASSERT_EQUAL_STRING(legacyStatus(state).c_str(), serialize(doc).c_str());
+    TEST_ASSERT_EQUAL_STRING("heat", doc["modeString"].as<const char*>());
+}
+
+void test_result_codes() {
+    ACResult ok = {AC_OK, {true, 0, 25}};
+    ACResult failed = {AC_ERR_NOT_RUNNING, {false, 0, 25}};
+    TEST_ASSERT_TRUE(ok.ok());
+    TEST_ASSERT_EQUAL(0, ok.code());
+    TEST_ASSERT_FALSE(failed.ok());
+    TEST_ASSERT_EQUAL(1, failed.code());
+    TEST_ASSERT_EQUAL_STRING("unknown", acModeName(7));
+}
+
+// Tool-call latency of setTemperature/getStatus: string + deserializeJson vs direct write
+void test_tool_result_benchmark() {
+    const int ITERATIONS = 50000;
+    using Clock = std::chrono::steady_clock;
+    ACResult result = {AC_OK, {true, 1, 22}};
+    size_t sink = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        result.state.temperature = 16 + i % 15;
+        JsonDocument doc;
+        deserializeJson(doc, legacySetTemperature(result));
+        JsonDocument status;
+        deserializeJson(status, legacyStatus(result.state));
+        sink += doc.size() + status.size();
+    }
+    double legacyNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        result.state.temperature = 16 + i % 15;
+        JsonDocument doc;
+        writeTemperatureResult(result, doc.to<JsonObject>());
+        JsonDocument status;
+        writeACState(result.state, status.to<JsonObject>());
+        sink += doc.size() + status.size();
+    }
+    double directNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "String + deserializeJson: %.0f ns/call, direct write: %.0f ns/call (%.1fx)",
+             legacyNs, directNs, legacyNs / directNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(ITERATIONS * 2 * 6, sink);
+    TEST_ASSERT_LESS_THAN(legacyNs, directNs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_mode_result_matches_legacy_format);
+    RUN_TEST(test_temperature_result_matches_legacy_format);
+    RUN_TEST(test_state_matches_legacy_format);
+    RUN_TEST(test_result_codes);
+    RUN_TEST(test_tool_result_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
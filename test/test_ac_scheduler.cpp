@@ -0,0 +1,388 @@
+#include <unity.h>
+#include "ACScheduler.h"
+#include <chrono>
+#include <cstdio>
+#include <string.h>
+#include <vector>
+
+// Monday 2024-06-03 00:00 local time
+static const uint32_t MONDAY = ScheduleClock::fromCivil(2024, 6, 3, 0, 0, 0);
+static const uint32_t HOUR = 3600;
+static const uint32_t DAY = 86400;
+
+static ACSchedule makeSchedule(const char* device, const char* time, const char* days, uint8_t power,
+                               int8_t mode = -1, int8_t temperature = 0) {
+    ACSchedule schedule;
+    memset(&schedule, 0, sizeof(schedule));
+    strncpy(schedule.device, device, ACSchedule::DEVICE_ID_SIZE - 1);
+    ACScheduler::parseTime(time, schedule.minuteOfDay);
+    ACScheduler::parseDays(days, schedule.days);
+    schedule.power = power;
+    schedule.mode = mode;
+    schedule.temperature = temperature;
+    return schedule;
+}
+
+static bool sameSchedule(const ACSchedule& a, const ACSchedule& b) {
+    return a.id == b.id && strcmp(a.device, b.device) == 0 && a.minuteOfDay == b.minuteOfDay && a.days == b.days &&
+           a.power == b.power && a.mode == b.mode && a.temperature == b.temperature;
+}
+
+struct Fired {
+    uint32_t at;
+    ACSchedule schedule;
+};
+
+// Runs the scheduler the way loop() does, one call per `step` seconds
+static void runUntil(ACScheduler& scheduler, VirtualClock& clock, uint32_t until, uint32_t step = 1) {
+    uint32_t now;
+    while (clock.now(now) && now < until) {
+        clock.advance(step);
+        scheduler.run();
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_parse_and_format() {
+    uint16_t minute = 0;
+    TEST_ASSERT_TRUE(ACScheduler::parseTime("18:00", minute));
+    TEST_ASSERT_EQUAL(18 * 60, minute);
+    TEST_ASSERT_TRUE(ACScheduler::parseTime("7:05", minute));
+    TEST_ASSERT_EQUAL(7 * 60 + 5, minute);
+    const char* badTimes[] = {"24:00", "12:60", "1200", "12:5", "-1:00", "12:00pm", "", " 1:00"};
+    for (const char* text : badTimes) {
+        TEST_ASSERT_FALSE(ACScheduler::parseTime(text, minute));
+    }
+    TEST_ASSERT_FALSE(ACScheduler::parseTime(nullptr, minute));
+
+    char text[32];
+    ACScheduler::formatTime(7 * 60 + 5, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("07:05", text);
+
+    uint8_t days = 0;
+    TEST_ASSERT_TRUE(ACScheduler::parseDays(nullptr, days));
+    TEST_ASSERT_EQUAL(0x7F, days);
+    TEST_ASSERT_TRUE(ACScheduler::parseDays("weekdays", days));
+    TEST_ASSERT_EQUAL(0x3E, days);
+    TEST_ASSERT_TRUE(ACScheduler::parseDays("mon, wed,fri", days));
+    TEST_ASSERT_EQUAL(0x2A, days);
+    ACScheduler::formatDays(days, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("mon,wed,fri", text);
+    ACScheduler::formatDays(0x41, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("weekends", text);
+    TEST_ASSERT_FALSE(ACScheduler::parseDays("monday", days));
+    TEST_ASSERT_FALSE(ACScheduler::parseDays("", days));
+}
+
+void test_next_occurrence() {
+    ACSchedule daily = makeSchedule("main", "18:00", "daily", AC_POWER_ON);
+    TEST_ASSERT_EQUAL_UINT32(MONDAY + 18 * HOUR, ACScheduler::nextOccurrence(daily, MONDAY));
+    // Strictly after now: at 18:00 sharp the next one is tomorrow
+    TEST_ASSERT_EQUAL_UINT32(MONDAY + DAY + 18 * HOUR, ACScheduler::nextOccurrence(daily, MONDAY + 18 * HOUR));
+
+    // Friday evening to Monday for a weekday schedule
+    ACSchedule weekdays = makeSchedule("main", "07:30", "weekdays", AC_POWER_ON);
+    uint32_t friday = MONDAY + 4 * DAY + 20 * HOUR;
+    TEST_ASSERT_EQUAL_UINT32(MONDAY + 7 * DAY + 7 * HOUR + 1800, ACScheduler::nextOccurrence(weekdays, friday));
+
+    ACSchedule sunday = makeSchedule("main", "09:00", "sun", AC_POWER_ON);
+    TEST_ASSERT_EQUAL_UINT32(MONDAY + 6 * DAY + 9 * HOUR, ACScheduler::nextOccurrence(sunday, MONDAY));
+}
+
+void test_validation() {
+    MemoryScheduleStore store;
+    VirtualClock clock;
+    ACScheduler scheduler(clock, &store);
+
+    ACSchedule noAction = makeSchedule("main", "18:00", "daily", AC_POWER_KEEP);
+    TEST_ASSERT_EQUAL(AC_ERR_INVALID_SCHEDULE, scheduler.add(noAction));
+    ACSchedule offAndCool = makeSchedule("main", "18:00", "daily", AC_POWER_OFF, 1);
+    TEST_ASSERT_EQUAL(AC_ERR_INVALID_SCHEDULE, scheduler.add(offAndCool));
+    ACSchedule noDevice = makeSchedule("", "18:00", "daily", AC_POWER_ON);
+    TEST_ASSERT_EQUAL(AC_ERR_INVALID_SCHEDULE, scheduler.add(noDevice));
+    ACSchedule badMinute = makeSchedule("main", "18:00", "daily", AC_POWER_ON);
+    badMinute.minuteOfDay = 24 * 60;
+    TEST_ASSERT_EQUAL(AC_ERR_INVALID_SCHEDULE, scheduler.add(badMinute));
+
+    ACSchedule setpointOnly = makeSchedule("main", "18:00", "daily", AC_POWER_KEEP, -1, 24);
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(setpointOnly));
+    TEST_ASSERT_EQUAL(1, scheduler.size());
+}
+
+// "cool to 24 at 18:00 and off at 23:00" on weekdays, over a simulated week
+void test_fires_at_local_times_over_a_week() {
+    VirtualClock clock;
+    ACScheduler scheduler(clock);
+    std::vector<Fired> fired;
+    scheduler.setActionSink([&](const ACSchedule& schedule) {
+        uint32_t now;
+        clock.now(now);
+        fired.push_back({now, schedule});
+        return AC_OK;
+    });
+
+    ACSchedule cool = makeSchedule("main", "18:00", "weekdays", AC_POWER_ON, 1, 24);
+    ACSchedule off = makeSchedule("main", "23:00", "weekdays", AC_POWER_OFF);
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(cool));
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(off));
+
+    clock.set(MONDAY);
+    scheduler.run();
+    uint32_t wait = 0;
+    TEST_ASSERT_TRUE(scheduler.nextRunIn(cool.id, wait));
+    TEST_ASSERT_EQUAL_UINT32(18 * HOUR, wait);
+
+    runUntil(scheduler, clock, MONDAY + 7 * DAY);
+    TEST_ASSERT_EQUAL(10, fired.size());
+    for (size_t i = 0; i < fired.size(); i++) {
+        uint32_t day = i / 2;
+        bool isCool = i % 2 == 0;
+        TEST_ASSERT_EQUAL_UINT32(MONDAY + day * DAY + (isCool ? 18 : 23) * HOUR, fired[i].at);
+        TEST_ASSERT_EQUAL_UINT32(isCool ? cool.id : off.id, fired[i].schedule.id);
+    }
+    TEST_ASSERT_EQUAL(24, fired[0].schedule.temperature);
+    TEST_ASSERT_EQUAL(10, scheduler.runs());
+    TEST_ASSERT_EQUAL(0, scheduler.failures());
+    TEST_ASSERT_EQUAL(2, scheduler.size());
+}
+
+// Actions that fail are still runs, and are counted as failures
+void test_failed_actions_counted() {
+    VirtualClock clock;
+    ACScheduler scheduler(clock);
+    scheduler.setActionSink([](const ACSchedule& schedule) {
+        return schedule.power == AC_POWER_KEEP ? AC_ERR_NOT_RUNNING : AC_OK;
+    });
+    ACSchedule setpointOnly = makeSchedule("main", "18:00", "daily", AC_POWER_KEEP, -1, 24);
+    ACSchedule on = makeSchedule("main", "17:00", "daily", AC_POWER_ON);
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(setpointOnly));
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(on));
+
+    clock.set(MONDAY);
+    runUntil(scheduler, clock, MONDAY + 2 * DAY, 60);
+    TEST_ASSERT_EQUAL(4, scheduler.runs());
+    TEST_ASSERT_EQUAL(2, scheduler.failures());
+}
+
+void test_once_remove_and_ids() {
+    VirtualClock clock;
+    ACScheduler scheduler(clock);
+    size_t fired = 0;
+    scheduler.setActionSink([&](const ACSchedule&) {
+        fired++;
+        return AC_OK;
+    });
+    clock.set(MONDAY + 12 * HOUR);
+
+    ACSchedule once = makeSchedule("main", "12:30", "once", AC_POWER_ON);
+    ACSchedule removed = makeSchedule("main", "12:10", "daily", AC_POWER_ON);
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(once));
+    TEST_ASSERT_EQUAL(AC_OK, scheduler.add(removed));
+    scheduler.run();
+    TEST_ASSERT_TRUE(scheduler.remove(removed.id));
+    TEST_ASSERT_FALSE(scheduler.remove(removed.id));
+
+    runUntil(scheduler, clock, MONDAY + 3 * DAY, 60);
+    TEST_ASSERT_EQUAL(1, fired);
+    TEST_ASSERT_EQUAL(0, scheduler.size());
+    TEST_ASSERT_FALSE(scheduler.remove(once.id));
+
+    // A slot reused later gets a new id, so a stale id cannot remove it
+    ACSchedule again = makeSchedule("main", "08:00", "daily", AC_POWER_ON);
+    scheduler.add(again);
+    TEST_ASSERT_TRUE(again.id != once.id && again.id != removed.id);
+    TEST_ASSERT_FALSE(scheduler.remove(once.id));
+    TEST_ASSERT_FALSE(scheduler.remove(removed.id));
+    TEST_ASSERT_EQUAL(1, scheduler.size());
+}
+
+void test_persistence() {
+    MemoryScheduleStore store;
+    VirtualClock clock;
+    std::vector<ACSchedule> added;
+    {
+        ACScheduler scheduler(clock, &store);
+        const char* units[] = {"main", "bedroom", "study"};
+        for (int i = 0; i < 30; i++) {
+            ACSchedule schedule = makeSchedule(units[i % 3], "06:00", i % 2 ? "weekends" : "mon,thu", AC_POWER_ON,
+                                               i % 4, 16 + i % 15);
+            schedule.minuteOfDay = static_cast<uint16_t>(i * 37 % 1440);
+            TEST_ASSERT_EQUAL(AC_OK, scheduler.add(schedule));
+            added.push_back(schedule);
+        }
+        TEST_ASSERT_TRUE(scheduler.remove(added[4].id));
+        added.erase(added.begin() + 4);
+
+        // Saved by run(), in the main loop; even without a synced clock
+        TEST_ASSERT_EQUAL(0, store.saves());
+        scheduler.run();
+        TEST_ASSERT_EQUAL(1, store.saves());
+        scheduler.run();
+        TEST_ASSERT_EQUAL(1, store.saves());
+        TEST_ASSERT_EQUAL(ACScheduler::HEADER_SIZE + added.size() * ACScheduler::RECORD_SIZE + 4,
+                          store.contents().size());
+    }
+
+    ACScheduler rebooted(clock, &store);
+    TEST_ASSERT_TRUE(rebooted.load());
+    std::vector<ACSchedule> listed = rebooted.list();
+    TEST_ASSERT_EQUAL(added.size(), listed.size());
+    size_t matched = 0;
+    for (const ACSchedule& want : added) {
+        for (const ACSchedule& got : listed) {
+            matched += sameSchedule(want, got) ? 1 : 0;
+        }
+    }
+    TEST_ASSERT_EQUAL(added.size(), matched);
+    TEST_ASSERT_EQUAL(10, rebooted.list("study").size());
+
+    // Loaded ids stay removable, and new ids do not collide with them
+    TEST_ASSERT_TRUE(rebooted.remove(added[0].id));
+    ACSchedule fresh = makeSchedule("main", "10:00", "daily", AC_POWER_ON);
+    rebooted.add(fresh);
+    for (const ACSchedule& schedule : added) {
+        TEST_ASSERT_TRUE(schedule.id != fresh.id);
+    }
+
+    // A damaged file is ignored instead of restoring garbage
+    store.contents()[ACScheduler::HEADER_SIZE + 5] ^= 0x10;
+    ACScheduler damaged(clock, &store);
+    TEST_ASSERT_FALSE(damaged.load());
+    TEST_ASSERT_EQUAL(0, damaged.size());
+}
+
+void test_clock_sync_and_jumps() {
+    VirtualClock clock;
+    ACScheduler scheduler(clock);
+    std::vector<uint32_t> fired;
+    scheduler.setActionSink([&](const ACSchedule&) {
+        uint32_t now;
+        clock.now(now);
+        fired.push_back(now);
+        return AC_OK;
+    });
+    ACSchedule hourly[24];
+    for (int hour = 0; hour < 24; hour++) {
+        char time[6];
+        snprintf(time, sizeof(time), "%02d:00", hour);
+        hourly[hour] = makeSchedule("main", time, "daily", AC_POWER_ON);
+        scheduler.add(hourly[hour]);
+    }
+
+    // Not synced yet: nothing runs, nothing has a next run
+    uint32_t wait;
+    scheduler.run();
+    TEST_ASSERT_FALSE(scheduler.nextRunIn(hourly[0].id, wait));
+
+    clock.set(MONDAY + 10 * HOUR + 30 * 60);
+    scheduler.run();
+    TEST_ASSERT_EQUAL(0, fired.size());
+    runUntil(scheduler, clock, MONDAY + 12 * HOUR + 30 * 60, 60);
+    TEST_ASSERT_EQUAL(2, fired.size());
+
+    // One hour forward (daylight saving): the skipped hour still runs
+    clock.advance(HOUR);
+    scheduler.run();
+    TEST_ASSERT_EQUAL(3, fired.size());
+
+    // A correction of days forward or any step back re-arms without
+    // replaying what was missed
+    clock.advance(3 * DAY);
+    scheduler.run();
+    TEST_ASSERT_EQUAL(3, fired.size());
+    clock.set(MONDAY);
+    scheduler.run();
+    TEST_ASSERT_EQUAL(3, fired.size());
+    runUntil(scheduler, clock, MONDAY + 2 * HOUR + 30 * 60, 60);
+    TEST_ASSERT_EQUAL(5, fired.size());
+    TEST_ASSERT_EQUAL_UINT32(MONDAY + 2 * HOUR, fired.back());
+}
+
+void test_capacity() {
+    VirtualClock clock;
+    ACScheduler scheduler(clock);
+    for (size_t i = 0; i < ACScheduler::MAX_SCHEDULES; i++) {
+        ACSchedule schedule = makeSchedule("main", "18:00", "daily", AC_POWER_ON);
+        TEST_ASSERT_EQUAL(AC_OK, scheduler.add(schedule));
+    }
+    ACSchedule extra = makeSchedule("main", "18:00", "daily", AC_POWER_ON);
+    TEST_ASSERT_EQUAL(AC_ERR_SCHEDULE_FULL, scheduler.add(extra));
+}
+
+// Per-loop cost of run() with 1 and with MAX_SCHEDULES schedules: the same,
+// since run() does not visit schedules that are not due
+void test_scheduler_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int LOOPS = 200000;
+    char msg[200];
+
+    for (size_t count : {static_cast<size_t>(1), ACScheduler::MAX_SCHEDULES}) {
+        VirtualClock clock;
+        ACScheduler scheduler(clock);
+        for (size_t i = 0; i < count; i++) {
+            ACSchedule schedule = makeSchedule("main", "00:00", "daily", AC_POWER_ON);
+            schedule.minuteOfDay = static_cast<uint16_t>(i * 5 % 1440);
+            scheduler.add(schedule);
+        }
+        clock.set(MONDAY + 60);
+        scheduler.run();
+
+        // loop() runs every 100 ms: the clock moves one second every tenth call
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < LOOPS; i++) {
+            if (i % 10 == 0) {
+                clock.advance(1);
+            }
+            scheduler.run();
+        }
+        double runNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / LOOPS;
+
+        ACSchedule churn = makeSchedule("main", "12:00", "daily", AC_POWER_ON);
+        start = Clock::now();
+        for (int i = 0; i < LOOPS / 10; i++) {
+            scheduler.add(churn);
+            scheduler.remove(churn.id);
+        }
+        double addRemoveNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (LOOPS / 10);
+
+        snprintf(msg, sizeof(msg), "%u schedules: run() %.0f ns per loop, add+remove %.0f ns",
+                 static_cast<unsigned>(count), runNs, addRemoveNs);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_and_format);
+    RUN_TEST(test_next_occurrence);
+    RUN_TEST(test_validation);
+    RUN_TEST(test_fires_at_local_times_over_a_week);
+    RUN_TEST(test_failed_actions_counted);
+    RUN_TEST(test_once_remove_and_ids);
+    RUN_TEST(test_persistence);
+    RUN_TEST(test_clock_sync_and_jumps);
+    RUN_TEST(test_capacity);
+    RUN_TEST(test_scheduler_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
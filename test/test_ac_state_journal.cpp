@@ -0,0 +1,269 @@
+#include <unity.h>
+#include "ACStateJournal.h"
+#include <chrono>
+#include <cstdio>
+#include <string.h>
+
+static const ACState COOL_22 = {true, 1, 22, 0};
+static const ACState HEAT_28 = {true, 2, 28, 0};
+
+// State as AirConditioner publishes it: each change gets a new version
+static ACState changed(ACState state, uint32_t& version) {
+    state.version = ++version;
+    return state;
+}
+
+static bool sameSetting(const ACState& a, const ACState& b) {
+    return a.running == b.running && a.mode == b.mode && a.temperature == b.temperature;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_record_round_trip() {
+    uint8_t record[ACStateJournal::RECORD_SIZE];
+    ACStateJournal::encode(HEAT_28, 0xDEADBEEF, record);
+
+    ACState state;
+    uint32_t sequence = 0;
+    TEST_ASSERT_TRUE(ACStateJournal::decode(record, state, sequence));
+    TEST_ASSERT_TRUE(sameSetting(HEAT_28, state));
+    TEST_ASSERT_EQUAL_UINT32(0xDEADBEEF, sequence);
+
+    // Any flipped bit is caught
+    for (size_t bit = 0; bit < sizeof(record) * 8; bit++) {
+        record[bit / 8] ^= 1 << (bit % 8);
+        TEST_ASSERT_FALSE(ACStateJournal::decode(record, state, sequence));
+        record[bit / 8] ^= 1 << (bit % 8);
+    }
+    TEST_ASSERT_TRUE(ACStateJournal::decode(record, state, sequence));
+
+    // Standard CRC-32 check value
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, ACStateJournal::crc32(reinterpret_cast<const uint8_t*>("123456789"), 9));
+}
+
+void test_first_boot_writes_nothing_until_changed() {
+    MemoryJournalStore store;
+    ACStateJournal journal(store, "main", 100, 1000);
+    ACState state;
+    TEST_ASSERT_FALSE(journal.restore(state));
+
+    ACState defaults = {false, 0, 25, 0};
+    for (uint32_t now = 0; now < 5000; now += 100) {
+        TEST_ASSERT_FALSE(journal.poll(defaults, now));
+    }
+    TEST_ASSERT_EQUAL(0, store.writes());
+}
+
+void test_slots_alternate_and_restore_newest() {
+    MemoryJournalStore store;
+    uint32_t version = 0;
+    {
+        ACStateJournal journal(store, "main", 0, 0);
+        TEST_ASSERT_TRUE(journal.poll(changed(COOL_22, version), 10));
+        TEST_ASSERT_TRUE(journal.poll(changed(HEAT_28, version), 20));
+        TEST_ASSERT_EQUAL(2, journal.sequence());
+    }
+
+    ACStateJournal rebooted(store, "main");
+    ACState state;
+    TEST_ASSERT_TRUE(rebooted.restore(state));
+    TEST_ASSERT_TRUE(sameSetting(HEAT_28, state));
+    TEST_ASSERT_EQUAL(2, rebooted.sequence());
+
+    // Power lost while writing slot 0: the previous record in slot 1 still holds
+    TEST_ASSERT_TRUE(store.corrupt("main", 0, 9));
+    ACStateJournal afterTornWrite(store, "main");
+    TEST_ASSERT_TRUE(afterTornWrite.restore(state));
+    TEST_ASSERT_TRUE(sameSetting(COOL_22, state));
+    TEST_ASSERT_EQUAL(1, afterTornWrite.sequence());
+
+    // Units are journaled apart
+    ACStateJournal other(store, "bedroom");
+    TEST_ASSERT_FALSE(other.restore(state));
+}
+
+void test_next_write_never_overwrites_newest() {
+    MemoryJournalStore store;
+    uint32_t version = 0;
+    ACStateJournal journal(store, "main", 0, 0);
+    journal.poll(changed(COOL_22, version), 0);
+    journal.poll(changed(HEAT_28, version), 0);
+
+    ACStateJournal rebooted(store, "main", 0, 0);
+    ACState state;
+    rebooted.restore(state);
+    // The next record goes to slot 1, the older one; if that write tears,
+    // slot 0 (HEAT_28) is still the newest valid record
+    ACState dry = {true, 3, 24, 0};
+    TEST_ASSERT_TRUE(rebooted.poll(changed(dry, version), 0));
+    TEST_ASSERT_TRUE(store.corrupt("main", 1, 4));
+    ACStateJournal again(store, "main");
+    TEST_ASSERT_TRUE(again.restore(state));
+    TEST_ASSERT_TRUE(sameSetting(HEAT_28, state));
+}
+
+void test_sequence_wraparound() {
+    MemoryJournalStore store;
+    uint8_t record[ACStateJournal::RECORD_SIZE];
+    ACStateJournal::encode(COOL_22, 0xFFFFFFFF, record);
+    store.write("main", 1, record, sizeof(record));
+    ACStateJournal::encode(HEAT_28, 0, record);
+    store.write("main", 0, record, sizeof(record));
+
+    ACStateJournal journal(store, "main");
+    ACState state;
+    TEST_ASSERT_TRUE(journal.restore(state));
+    TEST_ASSERT_TRUE(sameSetting(HEAT_28, state));
+    TEST_ASSERT_EQUAL(0, journal.sequence());
+}
+
+void test_debounce_coalesces_bursts() {
+    MemoryJournalStore store;
+    ACStateJournal journal(store, "main", 2000, 10000);
+    uint32_t version = 0;
+    ACState state = COOL_22;
+
+    // A user holding the temperature button: 40 changes 50 ms apart
+    uint32_t now = 0;
+    for (int i = 0; i < 40; i++, now += 50) {
+        state.temperature = 16 + i % 15;
+        state = changed(state, version);
+        TEST_ASSERT_FALSE(journal.poll(state, now));
+    }
+    TEST_ASSERT_FALSE(journal.poll(state, now + 1000));
+    TEST_ASSERT_TRUE(journal.poll(state, now + 2000));
+    TEST_ASSERT_EQUAL(1, store.writes());
+    TEST_ASSERT_FALSE(journal.poll(state, now + 60000));
+
+    // Changed and changed back before it settled: nothing to write
+    ACState saved = state;
+    state.temperature = saved.temperature == 30 ? 29 : 30;
+    journal.poll(changed(state, version), now + 61000);
+    saved = changed(saved, version);
+    journal.poll(saved, now + 61500);
+    journal.poll(saved, now + 70000);
+    TEST_ASSERT_EQUAL(1, store.writes());
+}
+
+void test_max_delay_bounds_unsaved_changes() {
+    MemoryJournalStore store;
+    ACStateJournal journal(store, "main", 2000, 10000);
+    uint32_t version = 0;
+    ACState state = COOL_22;
+
+    // Never settles: a change every second still gets saved every 10 s
+    for (uint32_t now = 1000; now <= 35000; now += 1000) {
+        state.temperature = 16 + (now / 1000) % 15;
+        journal.poll(changed(state, version), now);
+    }
+    TEST_ASSERT_EQUAL(3, store.writes());
+}
+
+void test_write_failure_backs_off_and_retries() {
+    MemoryJournalStore store;
+    ACStateJournal journal(store, "main", 100, 1000);
+    uint32_t version = 0;
+    store.setFailWrites(true);
+
+    ACState state = changed(COOL_22, version);
+    journal.poll(state, 0);
+    TEST_ASSERT_FALSE(journal.poll(state, 100));
+    TEST_ASSERT_EQUAL(1, journal.failures());
+    // Not retried on every loop iteration
+    TEST_ASSERT_FALSE(journal.poll(state, 150));
+    TEST_ASSERT_EQUAL(1, journal.failures());
+
+    store.setFailWrites(false);
+    TEST_ASSERT_TRUE(journal.poll(state, 200));
+    TEST_ASSERT_EQUAL(1, journal.writes());
+}
+
+void test_flush_writes_pending_change() {
+    MemoryJournalStore store;
+    ACStateJournal journal(store, "main");
+    uint32_t version = 0;
+    TEST_ASSERT_TRUE(journal.flush(COOL_22));
+    TEST_ASSERT_EQUAL(0, store.writes());
+
+    ACState state = changed(HEAT_28, version);
+    journal.poll(state, 0);
+    TEST_ASSERT_TRUE(journal.flush(state));
+    TEST_ASSERT_EQUAL(1, store.writes());
+    TEST_ASSERT_TRUE(journal.flush(state));
+    TEST_ASSERT_EQUAL(1, store.writes());
+}
+
+// Boot-time cost of reading both slots, and the per-loop cost of polling
+// an unchanged state
+void test_journal_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int RESTORES = 100000;
+    const int POLLS = 1000000;
+
+    MemoryJournalStore store;
+    uint32_t version = 0;
+    {
+        ACStateJournal journal(store, "main", 0, 0);
+        journal.poll(changed(COOL_22, version), 0);
+        journal.poll(changed(HEAT_28, version), 0);
+    }
+
+    ACState state;
+    uint32_t found = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < RESTORES; i++) {
+        ACStateJournal journal(store, "main");
+        found += journal.restore(state) ? 1 : 0;
+    }
+    double restoreNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / RESTORES;
+
+    ACStateJournal journal(store, "main");
+    journal.restore(state);
+    start = Clock::now();
+    for (int i = 0; i < POLLS; i++) {
+        journal.poll(state, static_cast<uint32_t>(i));
+    }
+    double pollNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / POLLS;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "journal: restore %.0f ns (2 slots, %u bytes each), idle poll %.1f ns",
+             restoreNs, static_cast<unsigned>(ACStateJournal::RECORD_SIZE), pollNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(RESTORES, found);
+    TEST_ASSERT_EQUAL(2, store.writes());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_record_round_trip);
+    RUN_TEST(test_first_boot_writes_nothing_until_changed);
+    RUN_TEST(test_slots_alternate_and_restore_newest);
+    RUN_TEST(test_next_write_never_overwrites_newest);
+    RUN_TEST(test_sequence_wraparound);
+    RUN_TEST(test_debounce_coalesces_bursts);
+    RUN_TEST(test_max_delay_bounds_unsaved_changes);
+    RUN_TEST(test_write_failure_backs_off_and_retries);
+    RUN_TEST(test_flush_writes_pending_change);
+    RUN_TEST(test_journal_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
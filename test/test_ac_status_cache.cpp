@@ -0,0 +1,218 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "ACStatusCache.h"
+#include "McpDispatcher.h"
+#include "ToolHandlers.h"
+#include "ToolRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace mcp;
+
+static std::string serialize(const JsonDocument& doc) {
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+// Register getStatus the way ACTools does, over a plain state
+static void addGetStatus(ToolRegistry& registry, const ACState& state, std::shared_ptr<ACStatusCache> cache) {
+    ToolDefinition tool;
+    tool.name = "getStatus";
+    tool.description = "Get AC status";
+    tool.params.push_back(ToolParam{"ifNoneMatch", "string", "etag of a previous reply", false});
+    tool.handler = std::make_shared<SimpleToolHandler>([&state, cache](JsonVariantConst params, JsonDocument& result) {
+        cache->write(state, params["ifNoneMatch"].as<const char*>(), result);
+    });
+    registry.addTool(std::move(tool));
+}
+
+static std::string poll(McpDispatcher& dispatcher, const std::string& etag) {
+    std::string body = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"getStatus\"";
+    if (!etag.empty()) {
+        JsonDocument arguments;
+        arguments["ifNoneMatch"] = etag;
+        body += ",\"arguments\":" + serialize(arguments);
+    }
+    body += "}}";
+    return dispatcher.handle(body.c_str(), body.size()).text();
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_payload_is_state_plus_etag() {
+    ACStatusCache cache(0x1234abcd);
+    ACState state = {true, 1, 22, 7};
+
+    JsonDocument result;
+    TEST_ASSERT_FALSE(cache.write(state, nullptr, result));
+
+    JsonDocument parsed;
+    deserializeJson(parsed, serialize(result));
+    TEST_ASSERT_TRUE(parsed["running"].as<bool>());
+    TEST_ASSERT_EQUAL(1, parsed["mode"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("cool", parsed["modeString"].as<const char*>());
+    TEST_ASSERT_EQUAL(22, parsed["temperature"].as<int>());
+    TEST_ASSERT_EQUAL(7, parsed["version"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("\"1234abcd-7\"", parsed["etag"].as<const char*>());
+}
+
+void test_matching_etag_not_modified() {
+    ACStatusCache cache(1);
+    ACState state = {true, 0, 25, 3};
+
+    JsonDocument first;
+    cache.write(state, nullptr, first);
+    JsonDocument parsed;
+    deserializeJson(parsed, serialize(first));
+    std::string etag = parsed["etag"].as<std::string>();
+
+    JsonDocument again;
+    TEST_ASSERT_TRUE(cache.write(state, etag.c_str(), again));
+    TEST_ASSERT_EQUAL_STRING(("{\"notModified\":true,\"etag\":\"\\\"00000001-3\\\"\"}"), serialize(again).c_str());
+
+    // Stale or foreign etags get the full status
+    JsonDocument stale;
+    TEST_ASSERT_FALSE(cache.write(state, "\"00000001-2\"", stale));
+    TEST_ASSERT_EQUAL_STRING(serialize(first).c_str(), serialize(stale).c_str());
+
+    state.version++;
+    JsonDocument changed;
+    TEST_ASSERT_FALSE(cache.write(state, etag.c_str(), changed));
+}
+
+void test_rebuilt_once_per_version() {
+    ACStatusCache cache(1);
+    ACState state = {false, 0, 25, 0};
+    for (int i = 0; i < 10; i++) {
+        JsonDocument result;
+        cache.write(state, nullptr, result);
+    }
+    TEST_ASSERT_EQUAL(1, cache.rebuilds());
+
+    state.running = true;
+    state.version++;
+    JsonDocument result;
+    cache.write(state, nullptr, result);
+    TEST_ASSERT_EQUAL(2, cache.rebuilds());
+    TEST_ASSERT_TRUE(serialize(result).find("\"running\":true") != std::string::npos);
+}
+
+void test_etags_differ_across_boots() {
+    // After a reboot the version restarts; the boot id keeps old etags from matching
+    ACState state = {true, 2, 28, 1};
+    ACStatusCache before(0xaaaa0001);
+    ACStatusCache after(0xbbbb0002);
+
+    JsonDocument old;
+    before.write(state, nullptr, old);
+    JsonDocument parsed;
+    deserializeJson(parsed, serialize(old));
+
+    JsonDocument result;
+    TEST_ASSERT_FALSE(after.write(state, parsed["etag"].as<const char*>(), result));
+}
+
+void test_tools_call_reply() {
+    ACState state = {true, 1, 24, 5};
+    ToolRegistry registry;
+    addGetStatus(registry, state, std::make_shared<ACStatusCache>(9));
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    JsonDocument reply;
+    deserializeJson(reply, poll(dispatcher, ""));
+    JsonDocument status;
+    deserializeJson(status, reply["result"]["content"][0]["text"].as<std::string>());
+    TEST_ASSERT_EQUAL(24, status["temperature"].as<int>());
+    std::string etag = status["etag"].as<std::string>();
+
+    deserializeJson(reply, poll(dispatcher, etag));
+    deserializeJson(status, reply["result"]["content"][0]["text"].as<std::string>());
+    TEST_ASSERT_TRUE(status["notModified"].as<bool>());
+    TEST_ASSERT_TRUE(status["running"].isNull());
+}
+
+// A bridge polling an unchanged device: rebuilt status vs cached status vs notModified
+void test_poll_benchmark() {
+    const int ITERATIONS = 20000;
+    using Clock = std::chrono::steady_clock;
+    ACState state = {true, 1, 22, 1};
+    size_t sink = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        JsonDocument result;
+        writeACState(state, result.to<JsonObject>());
+        sink += serialize(result).size();
+    }
+    double rebuildNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+
+    ACStatusCache cache(1);
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        JsonDocument result;
+        cache.write(state, nullptr, result);
+        sink += serialize(result).size();
+    }
+    double cachedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+
+    JsonDocument first;
+    cache.write(state, nullptr, first);
+    JsonDocument parsed;
+    deserializeJson(parsed, serialize(first));
+    std::string etag = parsed["etag"].as<std::string>();
+    size_t fullSize = serialize(first).size();
+    size_t notModifiedSize = 0;
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        JsonDocument result;
+        cache.write(state, etag.c_str(), result);
+        notModifiedSize = serialize(result).size();
+        sink += notModifiedSize;
+    }
+    double notModifiedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ITERATIONS;
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "getStatus poll: rebuilt %.0f ns, cached %.0f ns (%u bytes), notModified %.0f ns (%u bytes)",
+             rebuildNs, cachedNs, static_cast<unsigned>(fullSize), notModifiedNs,
+             static_cast<unsigned>(notModifiedSize));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(0, sink);
+    TEST_ASSERT_EQUAL(1, cache.rebuilds());
+    TEST_ASSERT_LESS_THAN(fullSize, notModifiedSize);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_payload_is_state_plus_etag);
+    RUN_TEST(test_matching_etag_not_modified);
+    RUN_TEST(test_rebuilt_once_per_version);
+    RUN_TEST(test_etags_differ_across_boots);
+    RUN_TEST(test_tools_call_reply);
+    RUN_TEST(test_poll_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
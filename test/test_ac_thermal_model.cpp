@@ -0,0 +1,251 @@
+#include <unity.h>
+#include "ACThermalModel.h"
+#include <chrono>
+#include <cstdio>
+
+static const uint32_t DAY_S = 86400;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static ACState acState(bool running, int mode, int temperature) {
+    ACState state = {};
+    state.running = running;
+    state.mode = mode;
+    state.temperature = temperature;
+    return state;
+}
+
+// Room temperature over one simulated day, one sample per tick
+struct DayStats {
+    int32_t minRoom;
+    int32_t maxRoom;
+    int64_t roomSum;
+    int32_t maxDuty;
+    int64_t dutySum;
+    uint32_t samples;
+
+    int32_t meanRoomTenths() const {
+        return ACThermalModel::toTenths(static_cast<int32_t>(roomSum / samples));
+    }
+    int32_t meanDutyPercent() const {
+        return static_cast<int32_t>(dutySum * 100 / samples / ACThermalModel::ONE);
+    }
+};
+
+static DayStats runDay(ACThermalModel& model, const ACState& state) {
+    DayStats stats = {INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+    for (uint32_t i = 0; i < DAY_S; i += ACThermalModel::TICK_S) {
+        model.step(state);
+        ACThermalReading reading = model.reading();
+        stats.minRoom = reading.room < stats.minRoom ? reading.room : stats.minRoom;
+        stats.maxRoom = reading.room > stats.maxRoom ? reading.room : stats.maxRoom;
+        stats.maxDuty = reading.duty > stats.maxDuty ? reading.duty : stats.maxDuty;
+        stats.roomSum += reading.room;
+        stats.dutySum += reading.duty;
+        stats.samples++;
+    }
+    return stats;
+}
+
+void test_fixed_point_conversions() {
+    TEST_ASSERT_EQUAL_INT32(ACThermalModel::ONE, ACThermalModel::fromTenths(10));
+    TEST_ASSERT_EQUAL_INT32(-ACThermalModel::ONE / 2, ACThermalModel::fromTenths(-5));
+    for (int32_t tenths = -400; tenths <= 600; tenths++) {
+        TEST_ASSERT_EQUAL_INT32(tenths, ACThermalModel::toTenths(ACThermalModel::fromTenths(tenths)));
+    }
+    // 24.04 rounds down, 24.06 up, -0.06 to -0.1
+    TEST_ASSERT_EQUAL_INT32(240, ACThermalModel::toTenths(24 * ACThermalModel::ONE + ACThermalModel::ONE * 4 / 100));
+    TEST_ASSERT_EQUAL_INT32(241, ACThermalModel::toTenths(24 * ACThermalModel::ONE + ACThermalModel::ONE * 6 / 100));
+    TEST_ASSERT_EQUAL_INT32(-1, ACThermalModel::toTenths(-ACThermalModel::ONE * 6 / 100));
+    TEST_ASSERT_EQUAL_INT32(100, ACThermalModel::toPercent(ACThermalModel::ONE));
+    TEST_ASSERT_EQUAL_INT32(50, ACThermalModel::toPercent(ACThermalModel::ONE / 2));
+    TEST_ASSERT_EQUAL_INT32(25, ACThermalModel::toPercent(ACThermalModel::ONE * 254 / 1000));
+    TEST_ASSERT_EQUAL_INT32(26, ACThermalModel::toPercent(ACThermalModel::ONE * 256 / 1000));
+}
+
+// With the AC off and a constant outside temperature, the room approaches
+// it exponentially: after one time constant about e^-1 of the gap is left
+void test_room_drifts_to_outside() {
+    ACThermalParams params = ACThermalParams::defaults();
+    params.outsideMean = ACThermalModel::fromTenths(350);
+    params.outsideSwing = 0;
+    params.initialRoom = ACThermalModel::fromTenths(250);
+    ACThermalModel model(params);
+
+    ACState off = acState(false, AC_MODE_COOL, 24);
+    model.advance(off, params.insulationS);
+    ACThermalReading reading = model.reading();
+    TEST_ASSERT_EQUAL_UINT32(params.insulationS, reading.seconds);
+    TEST_ASSERT_EQUAL_INT32(0, reading.duty);
+    // 35 - 10 * e^-1 = 31.32
+    TEST_ASSERT_INT32_WITHIN(1, 313, ACThermalModel::toTenths(reading.room));
+
+    model.advance(off, 5 * DAY_S);
+    TEST_ASSERT_EQUAL_INT32(350, ACThermalModel::toTenths(model.reading().room));
+}
+
+void test_outside_follows_daily_cycle() {
+    ACThermalModel model;       // 30 ± 5, starting at midnight
+    ACState off = acState(false, AC_MODE_COOL, 24);
+    model.advance(off, 4 * 3600);
+    TEST_ASSERT_EQUAL_INT32(250, ACThermalModel::toTenths(model.reading().outside));
+    model.advance(off, 6 * 3600);
+    TEST_ASSERT_EQUAL_INT32(300, ACThermalModel::toTenths(model.reading().outside));
+    model.advance(off, 6 * 3600);
+    TEST_ASSERT_EQUAL_INT32(350, ACThermalModel::toTenths(model.reading().outside));
+
+    // The room lags the outside swing but stays within it
+    DayStats day = runDay(model, off);
+    TEST_ASSERT_TRUE(day.minRoom > ACThermalModel::fromTenths(250));
+    TEST_ASSERT_TRUE(day.maxRoom < ACThermalModel::fromTenths(350));
+    TEST_ASSERT_INT32_WITHIN(3, 300, day.meanRoomTenths());
+}
+
+// Cooling holds the setpoint through a hot day; the duty follows the load
+void test_cooling_holds_setpoint() {
+    ACThermalModel model;
+    ACState cool = acState(true, AC_MODE_COOL, 24);
+    runDay(model, cool);        // Pull-down from 30°C and settling
+
+    DayStats day = runDay(model, cool);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "cool 24 in 30±5: room %.2f..%.2f, mean duty %d%%",
+             day.minRoom / 65536.0, day.maxRoom / 65536.0, static_cast<int>(day.meanDutyPercent()));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(day.minRoom > ACThermalModel::fromTenths(237));
+    TEST_ASSERT_TRUE(day.maxRoom < ACThermalModel::fromTenths(243));
+    TEST_ASSERT_TRUE(day.maxDuty < ACThermalModel::ONE);
+    // Load is (30 - 24) / 3 h = 2°C/h of the 8°C/h capacity
+    TEST_ASSERT_INT32_WITHIN(3, 25, day.meanDutyPercent());
+}
+
+void test_heating_holds_setpoint() {
+    ACThermalParams winter = ACThermalParams::defaults();
+    winter.outsideMean = ACThermalModel::fromTenths(50);
+    winter.outsideSwing = ACThermalModel::fromTenths(30);
+    winter.initialRoom = ACThermalModel::fromTenths(120);
+    ACThermalModel model(winter);
+    ACState heat = acState(true, AC_MODE_HEAT, 22);
+    runDay(model, heat);
+
+    DayStats day = runDay(model, heat);
+    TEST_ASSERT_TRUE(day.minRoom > ACThermalModel::fromTenths(217));
+    TEST_ASSERT_TRUE(day.maxRoom < ACThermalModel::fromTenths(223));
+    TEST_ASSERT_INT32_WITHIN(3, 71, day.meanDutyPercent());
+}
+
+// Auto mode cools in the afternoon and heats at night around a mild mean
+void test_auto_mode_switches_direction() {
+    ACThermalParams spring = ACThermalParams::defaults();
+    spring.outsideMean = ACThermalModel::fromTenths(220);
+    spring.outsideSwing = ACThermalModel::fromTenths(100);
+    spring.initialRoom = ACThermalModel::fromTenths(220);
+    ACThermalModel model(spring);
+    ACState autoMode = acState(true, AC_MODE_AUTO, 22);
+    runDay(model, autoMode);
+
+    DayStats day = runDay(model, autoMode);
+    TEST_ASSERT_TRUE(day.minRoom > ACThermalModel::fromTenths(210));
+    TEST_ASSERT_TRUE(day.maxRoom < ACThermalModel::fromTenths(230));
+    TEST_ASSERT_TRUE(day.maxDuty > 0);
+
+    // Off, the same day swings with the outside
+    ACThermalModel idle(spring);
+    runDay(idle, acState(false, AC_MODE_AUTO, 22));
+    DayStats idleDay = runDay(idle, acState(false, AC_MODE_AUTO, 22));
+    TEST_ASSERT_TRUE(idleDay.maxRoom - idleDay.minRoom > 3 * (day.maxRoom - day.minRoom));
+}
+
+void test_dehumidify_and_power_off() {
+    ACThermalModel model;
+    ACState dry = acState(true, AC_MODE_DEHUMIDIFY, 16);
+    DayStats day = runDay(model, dry);
+    TEST_ASSERT_EQUAL_INT32(ACThermalModel::ONE / 2, day.maxDuty);
+
+    // Off: the compressor ramps down within rampS and the room warms up
+    ACState off = acState(false, AC_MODE_DEHUMIDIFY, 16);
+    int32_t before = model.reading().room;
+    model.step(off);
+    TEST_ASSERT_TRUE(model.reading().duty > 0);
+    model.advance(off, ACThermalParams::defaults().rampS);
+    TEST_ASSERT_EQUAL_INT32(0, model.reading().duty);
+    model.advance(off, 3600);
+    TEST_ASSERT_TRUE(model.reading().room > before + ACThermalModel::ONE);
+}
+
+// advance() is step() without the per-tick publish: both give the same
+// state after a month, bit for bit
+void test_advance_matches_steps() {
+    ACThermalModel stepped;
+    ACThermalModel advanced;
+    ACState states[] = {acState(true, AC_MODE_COOL, 24), acState(false, AC_MODE_COOL, 24),
+                        acState(true, AC_MODE_AUTO, 27), acState(true, AC_MODE_HEAT, 30)};
+    for (int day = 0; day < 30; day++) {
+        const ACState& state = states[day % 4];
+        for (uint32_t i = 0; i < DAY_S; i++) {
+            stepped.step(state);
+        }
+        advanced.advance(state, DAY_S);
+    }
+    ACThermalReading a = stepped.reading();
+    ACThermalReading b = advanced.reading();
+    TEST_ASSERT_EQUAL_INT32(a.room, b.room);
+    TEST_ASSERT_EQUAL_INT32(a.outside, b.outside);
+    TEST_ASSERT_EQUAL_INT32(a.duty, b.duty);
+    TEST_ASSERT_EQUAL_UINT32(30 * DAY_S, b.seconds);
+}
+
+// Simulated time per wall-clock second: a year of one-second ticks
+void test_thermal_model_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const uint32_t DAYS = 365;
+    ACThermalModel model;
+    ACState cool = acState(true, AC_MODE_COOL, 25);
+
+    Clock::time_point start = Clock::now();
+    for (uint32_t day = 0; day < DAYS; day++) {
+        model.advance(cool, DAY_S);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u simulated days in %.3f s: %.1f ns per tick, %.0f days per second",
+             static_cast<unsigned>(DAYS), seconds, seconds * 1e9 / (DAYS * DAY_S), DAYS / seconds);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(DAYS * DAY_S, model.reading().seconds);
+    TEST_ASSERT_INT32_WITHIN(3, 250, ACThermalModel::toTenths(model.reading().room));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fixed_point_conversions);
+    RUN_TEST(test_room_drifts_to_outside);
+    RUN_TEST(test_outside_follows_daily_cycle);
+    RUN_TEST(test_cooling_holds_setpoint);
+    RUN_TEST(test_heating_holds_setpoint);
+    RUN_TEST(test_auto_mode_switches_direction);
+    RUN_TEST(test_dehumidify_and_power_off);
+    RUN_TEST(test_advance_matches_steps);
+    RUN_TEST(test_thermal_model_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
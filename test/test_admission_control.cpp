@@ -0,0 +1,178 @@
+#include <unity.h>
+#include "AdmissionControl.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+static const uint32_t CLIENT_A = 0x0A00000B;
+static const uint32_t CLIENT_B = 0x0A00000C;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_burst_then_throttle() {
+    AdmissionControl control(10, 5);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(control.admit(CLIENT_A, 1000).admitted);
+    }
+    AdmissionControl::Decision refused = control.admit(CLIENT_A, 1000);
+    TEST_ASSERT_FALSE(refused.admitted);
+    TEST_ASSERT_EQUAL(100, refused.retryAfterMs);
+
+    // 10 per second: one token every 100 ms
+    TEST_ASSERT_FALSE(control.admit(CLIENT_A, 1099).admitted);
+    TEST_ASSERT_TRUE(control.admit(CLIENT_A, 1100).admitted);
+    TEST_ASSERT_FALSE(control.admit(CLIENT_A, 1100).admitted);
+
+    // Idle time refills up to the burst, not beyond
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(control.admit(CLIENT_A, 60000).admitted);
+    }
+    TEST_ASSERT_FALSE(control.admit(CLIENT_A, 60000).admitted);
+
+    AdmissionControl::Stats stats = control.getStats();
+    TEST_ASSERT_EQUAL(11, stats.admitted);
+    TEST_ASSERT_EQUAL(4, stats.throttled);
+}
+
+void test_clients_are_independent() {
+    AdmissionControl control(1, 2);
+    TEST_ASSERT_TRUE(control.admit(CLIENT_A, 0).admitted);
+    TEST_ASSERT_TRUE(control.admit(CLIENT_A, 0).admitted);
+    TEST_ASSERT_FALSE(control.admit(CLIENT_A, 0).admitted);
+    TEST_ASSERT_TRUE(control.admit(CLIENT_B, 0).admitted);
+}
+
+void test_least_recent_client_evicted() {
+    AdmissionControl control(1, 1);
+    for (uint32_t ip = 1; ip <= AdmissionControl::MAX_CLIENTS; ip++) {
+        TEST_ASSERT_TRUE(control.admit(ip, ip).admitted);
+    }
+    TEST_ASSERT_EQUAL(AdmissionControl::MAX_CLIENTS, control.getStats().clients);
+    TEST_ASSERT_FALSE(control.admit(5, 100).admitted);
+
+    // A new client takes the slot of client 1, seen longest ago
+    TEST_ASSERT_TRUE(control.admit(1000, 200).admitted);
+    TEST_ASSERT_EQUAL(1, control.getStats().evictions);
+    TEST_ASSERT_FALSE(control.admit(5, 200).admitted);
+    TEST_ASSERT_TRUE(control.admit(1, 200).admitted);
+    TEST_ASSERT_EQUAL(2, control.getStats().evictions);
+}
+
+void test_clock_wraparound() {
+    AdmissionControl control(10, 1);
+    uint32_t now = 0xFFFFFFF0u;
+    TEST_ASSERT_TRUE(control.admit(CLIENT_A, now).admitted);
+    TEST_ASSERT_FALSE(control.admit(CLIENT_A, now).admitted);
+    TEST_ASSERT_TRUE(control.admit(CLIENT_A, now + 100).admitted);
+}
+
+void test_disabled_and_reconfigured() {
+    AdmissionControl control(0, 1);
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(control.admit(CLIENT_A, 0).admitted);
+    }
+    control.configure(1, 3);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(control.admit(CLIENT_A, 0).admitted);
+    }
+    TEST_ASSERT_FALSE(control.admit(CLIENT_A, 0).admitted);
+}
+
+void test_published_counts() {
+    AdmissionControl control(1, 2);
+    for (int i = 0; i < 5; i++) {
+        control.admit(CLIENT_A, 0);
+    }
+    std::map<std::string, double> gauges;
+    control.publish([&gauges](const char* name, double value) { gauges[name] = value; });
+    TEST_ASSERT_EQUAL(2, static_cast<int>(gauges["mcp.admitted"]));
+    TEST_ASSERT_EQUAL(3, static_cast<int>(gauges["mcp.throttled"]));
+}
+
+void test_concurrent_admits_respect_burst() {
+    const uint32_t BURST = 100;
+    AdmissionControl control(1, BURST);
+    std::atomic<uint32_t> admitted(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; i++) {
+                admitted += control.admit(CLIENT_A, 0).admitted ? 1 : 0;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    TEST_ASSERT_EQUAL(BURST, admitted.load());
+    TEST_ASSERT_EQUAL(4000 - BURST, control.getStats().throttled);
+}
+
+// Limiter cost per request with a full client table, admitted and throttled
+void test_admission_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int CALLS = 200000;
+
+    AdmissionControl control(1000000, 1000000);
+    for (uint32_t ip = 1; ip <= AdmissionControl::MAX_CLIENTS; ip++) {
+        control.admit(ip, 0);
+    }
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        control.admit(1 + i % AdmissionControl::MAX_CLIENTS, static_cast<uint32_t>(i));
+    }
+    double admitNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / CALLS;
+
+    AdmissionControl strict(1, 1);
+    strict.admit(CLIENT_A, 0);
+    start = Clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        strict.admit(CLIENT_A, 0);
+    }
+    double throttleNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / CALLS;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "admit: %.0f ns admitted (%u clients), %.0f ns throttled",
+             admitNs, static_cast<unsigned>(AdmissionControl::MAX_CLIENTS), throttleNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(CALLS, strict.getStats().throttled);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_burst_then_throttle);
+    RUN_TEST(test_clients_are_independent);
+    RUN_TEST(test_least_recent_client_evicted);
+    RUN_TEST(test_clock_wraparound);
+    RUN_TEST(test_disabled_and_reconfigured);
+    RUN_TEST(test_published_counts);
+    RUN_TEST(test_concurrent_admits_respect_burst);
+    RUN_TEST(test_admission_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,178 @@
+#include <unity.h>
+#include "AllocTracker.h"
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+static const char* lastReportTag = nullptr;
+static uint32_t lastReportAllocations = 0;
+static uint32_t lastReportBytes = 0;
+
+static void recordReport(const char* tag, uint32_t allocations, uint32_t bytes) {
+    lastReportTag = tag;
+    lastReportAllocations = allocations;
+    lastReportBytes = bytes;
+}
+
+// Keep the optimizer from removing allocations under test
+static void* volatile sink;
+
+void setUp(void) {
+    AllocTracker::getInstance().reset();
+    AllocTracker::getInstance().setReporter(recordReport);
+    lastReportTag = nullptr;
+    lastReportAllocations = 0;
+    lastReportBytes = 0;
+}
+
+void tearDown(void) {
+    AllocTracker::getInstance().setReporter(nullptr);
+}
+
+void test_alloc_scope_counts() {
+    TEST_ASSERT_TRUE(AllocTracker::isCompiledIn());
+
+    AllocScope scope("test.scope");
+    for (int i = 0; i < 3; i++) {
+        void* ptr = malloc(100);
+        sink = ptr;
+        free(ptr);
+    }
+    int* value = new int(7);
+    sink = value;
+    delete value;
+
+    TEST_ASSERT_EQUAL(4, scope.allocations());
+    TEST_ASSERT_EQUAL(300 + sizeof(int), scope.bytes());
+
+    AllocTracker::TagStats stats = AllocTracker::getInstance().getTagStats("test.scope");
+    TEST_ASSERT_EQUAL(4, stats.allocations);
+    TEST_ASSERT_EQUAL(300 + sizeof(int), stats.bytes);
+}
+
+void test_alloc_scope_nesting() {
+    {
+        AllocScope outer("test.outer");
+        sink = malloc(10);
+        free(sink);
+        {
+            AllocScope inner("test.inner");
+            sink = malloc(20);
+            free(sink);
+        }
+        sink = malloc(30);
+        free(sink);
+
+        // Outer scope sees everything its thread allocated, inner included
+        TEST_ASSERT_EQUAL(3, outer.allocations());
+    }
+
+    // Attribution goes to the innermost tag only
+    TEST_ASSERT_EQUAL(2, AllocTracker::getInstance().getTagStats("test.outer").allocations);
+    TEST_ASSERT_EQUAL(40, AllocTracker::getInstance().getTagStats("test.outer").bytes);
+    TEST_ASSERT_EQUAL(1, AllocTracker::getInstance().getTagStats("test.inner").allocations);
+    TEST_ASSERT_EQUAL(20, AllocTracker::getInstance().getTagStats("test.inner").bytes);
+}
+
+void test_alloc_scopes_in_one_scope() {
+    {
+        ALLOC_SCOPE_REPORT("test.request");
+        ALLOC_SCOPE("test.render");
+        sink = malloc(16);
+        free(sink);
+    }
+    TEST_ASSERT_EQUAL(1, AllocTracker::getInstance().getTagStats("test.render").allocations);
+    TEST_ASSERT_EQUAL_STRING("test.request", lastReportTag);
+    TEST_ASSERT_EQUAL(1, lastReportAllocations);
+}
+
+void test_alloc_scope_report() {
+    {
+        AllocScope request("mcp.request", true);
+        std::string text(64, 'x');
+        sink = &text[0];
+    }
+    TEST_ASSERT_EQUAL_STRING("mcp.request", lastReportTag);
+    TEST_ASSERT_EQUAL(1, lastReportAllocations);
+    TEST_ASSERT_GREATER_OR_EQUAL(64, lastReportBytes);
+}
+
+void test_alloc_free_path() {
+    // A path that does not touch the heap reports zero allocations
+    {
+        AllocScope request("mcp.request", true);
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "{\"code\":0,\"temperature\":%d}", 24);
+        sink = buffer;
+    }
+    TEST_ASSERT_EQUAL_STRING("mcp.request", lastReportTag);
+    TEST_ASSERT_EQUAL(0, lastReportAllocations);
+}
+
+void test_alloc_threads_are_separate() {
+    std::thread worker([]() {
+        AllocScope workerScope("test.worker");
+        for (int i = 0; i < 5; i++) {
+            sink = malloc(8);
+            free(sink);
+        }
+    });
+    {
+        AllocScope scope("test.main");
+        worker.join();
+    }
+
+    // The worker's allocations never land in this thread's scope
+    TEST_ASSERT_EQUAL(5, AllocTracker::getInstance().getTagStats("test.worker").allocations);
+    TEST_ASSERT_EQUAL(0, AllocTracker::getInstance().getTagStats("test.main").allocations);
+}
+
+void test_alloc_stats_listing() {
+    {
+        AllocScope scope("test.listing");
+        sink = malloc(1);
+        free(sink);
+    }
+
+    AllocTracker::TagStats stats[AllocTracker::MAX_TAGS];
+    size_t count = AllocTracker::getInstance().getStats(stats, AllocTracker::MAX_TAGS);
+    bool found = false;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(stats[i].tag, "test.listing") == 0) {
+            found = true;
+            TEST_ASSERT_EQUAL(1, stats[i].allocations);
+        }
+    }
+    TEST_ASSERT_TRUE(found);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_alloc_scope_counts);
+    RUN_TEST(test_alloc_scope_nesting);
+    RUN_TEST(test_alloc_scopes_in_one_scope);
+    RUN_TEST(test_alloc_scope_report);
+    RUN_TEST(test_alloc_free_path);
+    RUN_TEST(test_alloc_threads_are_separate);
+    RUN_TEST(test_alloc_stats_listing);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,262 @@
+#include <unity.h>
+#include "BoundedRequestQueue.h"
+#include "RequestQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_spsc_fifo_and_capacity() {
+    BoundedRequestQueue<int, 4, QueueConcurrency::SPSC> queue;
+    TEST_ASSERT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(99));   // Full
+    TEST_ASSERT_EQUAL(4, queue.size());
+
+    int value = -1;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.try_pop(value));
+        TEST_ASSERT_EQUAL(i, value);
+    }
+    TEST_ASSERT_FALSE(queue.try_pop(value));
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_mpmc_fifo_and_capacity() {
+    BoundedRequestQueue<int, 4> queue;
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(99));
+
+    int value = -1;
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL(0, value);
+    TEST_ASSERT_TRUE(queue.push(4));   // Slot freed by the pop is reusable
+
+    for (int i = 1; i <= 4; i++) {
+        TEST_ASSERT_TRUE(queue.try_pop(value));
+        TEST_ASSERT_EQUAL(i, value);
+    }
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_move_only_items() {
+    BoundedRequestQueue<std::unique_ptr<std::string>, 8> mpmc;
+    BoundedRequestQueue<std::unique_ptr<std::string>, 8, QueueConcurrency::SPSC> spsc;
+    RequestQueue<std::unique_ptr<std::string>> locked;
+
+    TEST_ASSERT_TRUE(mpmc.push(std::unique_ptr<std::string>(new std::string("mpmc"))));
+    TEST_ASSERT_TRUE(spsc.push(std::unique_ptr<std::string>(new std::string("spsc"))));
+    TEST_ASSERT_TRUE(locked.push(std::unique_ptr<std::string>(new std::string("locked"))));
+
+    std::unique_ptr<std::string> item;
+    TEST_ASSERT_TRUE(mpmc.try_pop(item));
+    TEST_ASSERT_EQUAL_STRING("mpmc", item->c_str());
+    TEST_ASSERT_TRUE(spsc.try_pop(item));
+    TEST_ASSERT_EQUAL_STRING("spsc", item->c_str());
+    TEST_ASSERT_TRUE(locked.try_pop(item));
+    TEST_ASSERT_EQUAL_STRING("locked", item->c_str());
+}
+
+void test_clear_destroys_items() {
+    auto tracked = std::make_shared<int>(0);
+    {
+        BoundedRequestQueue<std::shared_ptr<int>, 8> queue;
+        queue.push(tracked);
+        queue.push(tracked);
+        TEST_ASSERT_EQUAL(3, tracked.use_count());
+        queue.clear();
+        TEST_ASSERT_EQUAL(1, tracked.use_count());
+        queue.push(tracked);
+    }
+    // Destructor releases what is still queued
+    TEST_ASSERT_EQUAL(1, tracked.use_count());
+}
+
+void test_mpmc_concurrent_producers_consumers() {
+    const int PRODUCERS = 4;
+    const int CONSUMERS = 4;
+    const int ITEMS_PER_PRODUCER = 50000;
+
+    BoundedRequestQueue<int, 256> queue;
+    std::atomic<long long> sum(0);
+    std::atomic<int> consumed(0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                int value = p * ITEMS_PER_PRODUCER + i;
+                while (!queue.push(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&]() {
+            int value;
+            while (consumed.load() < PRODUCERS * ITEMS_PER_PRODUCER) {
+                if (queue.try_pop(value)) {
+                    sum += value;
+                    consumed++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    long long total = static_cast<long long>(PRODUCERS) * ITEMS_PER_PRODUCER;
+    TEST_ASSERT_EQUAL(total, consumed.load());
+    TEST_ASSERT_EQUAL(total * (total - 1) / 2, sum.load());
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_spsc_concurrent_order() {
+    const int ITEMS = 200000;
+    BoundedRequestQueue<int, 128, QueueConcurrency::SPSC> queue;
+    bool ordered = true;
+
+    std::thread consumer([&]() {
+        int expected = 0;
+        int value;
+        while (expected < ITEMS) {
+            if (queue.try_pop(value)) {
+                ordered = ordered && (value == expected);
+                expected++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (int i = 0; i < ITEMS; i++) {
+        while (!queue.push(i)) {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+}
+
+// ===== Benchmark: one producer, one consumer =====
+
+struct BenchResult {
+    double itemsPerSecond;
+    double p50Ns;
+    double p99Ns;
+};
+
+template<typename Queue>
+static BenchResult runBenchmark(Queue& queue, int items) {
+    // Each item carries its enqueue timestamp so the consumer can measure latency
+    std::vector<double> latencies;
+    latencies.reserve(items);
+
+    auto begin = Clock::now();
+    std::thread consumer([&]() {
+        Clock::rep stamp;
+        int received = 0;
+        while (received < items) {
+            if (queue.pop(stamp)) {
+                latencies.push_back(static_cast<double>(Clock::now().time_since_epoch().count() - stamp));
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (int i = 0; i < items; i++) {
+        Clock::rep stamp = Clock::now().time_since_epoch().count();
+        while (!queue.push(stamp)) {
+            std::this_thread::yield();
+            stamp = Clock::now().time_since_epoch().count();
+        }
+    }
+    consumer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    double nsPerTick = 1e9 * Clock::period::num / Clock::period::den;
+    return {items / seconds,
+            latencies[latencies.size() / 2] * nsPerTick,
+            latencies[latencies.size() * 99 / 100] * nsPerTick};
+}
+
+static void report(const char* name, const BenchResult& result) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%-14s %10.0f items/s  p50 %8.0f ns  p99 %8.0f ns",
+             name, result.itemsPerSecond, result.p50Ns, result.p99Ns);
+    TEST_MESSAGE(msg);
+}
+
+void test_queue_benchmark() {
+    const int ITEMS = 200000;
+    const size_t CAPACITY = 1024;
+
+    RequestQueue<Clock::rep> locked(CAPACITY);
+    BoundedRequestQueue<Clock::rep, CAPACITY, QueueConcurrency::SPSC> spsc;
+    BoundedRequestQueue<Clock::rep, CAPACITY, QueueConcurrency::MPMC> mpmc;
+
+    BenchResult lockedResult = runBenchmark(locked, ITEMS);
+    BenchResult spscResult = runBenchmark(spsc, ITEMS);
+    BenchResult mpmcResult = runBenchmark(mpmc, ITEMS);
+
+    report("RequestQueue", lockedResult);
+    report("Bounded SPSC", spscResult);
+    report("Bounded MPMC", mpmcResult);
+
+    // Every item must have arrived; relative speed is reported, not asserted
+    TEST_ASSERT_TRUE(lockedResult.itemsPerSecond > 0);
+    TEST_ASSERT_TRUE(spsc.empty());
+    TEST_ASSERT_TRUE(mpmc.empty());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_spsc_fifo_and_capacity);
+    RUN_TEST(test_mpmc_fifo_and_capacity);
+    RUN_TEST(test_move_only_items);
+    RUN_TEST(test_clear_destroys_items);
+    RUN_TEST(test_mpmc_concurrent_producers_consumers);
+    RUN_TEST(test_spsc_concurrent_order);
+    RUN_TEST(test_queue_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,474 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mcp;
+
+/**
+ * Model of the device heap: a fixed region managed with good-fit and
+ * coalescing, roughly what ESP-IDF's TLSF allocator does. Host malloc hides
+ * fragmentation behind mmap, so the simulation measures it here instead.
+ */
+class SimulatedHeap : public ArduinoJson::Allocator {
+public:
+    static const size_t GRANULE = 8;
+    static const size_t OVERHEAD = 8;   // Block header, like multi_heap
+
+    explicit SimulatedHeap(size_t size) : region(size), calls(0), failures(0) {
+        addFree(0, size);
+    }
+
+    void* allocate(size_t size) override {
+        calls++;
+        size_t needed = round(size + OVERHEAD);
+        auto fit = bySize.lower_bound(needed);
+        if (fit == bySize.end()) {
+            failures++;
+            return nullptr;
+        }
+        size_t offset = fit->second;
+        size_t available = fit->first;
+        removeFree(offset, available);
+        if (available > needed) {
+            addFree(offset + needed, available - needed);
+        }
+        used[offset] = needed;
+        return region.data() + offset + OVERHEAD;
+    }
+
+    void deallocate(void* ptr) override {
+        if (!ptr) {
+            return;
+        }
+        size_t offset = static_cast<uint8_t*>(ptr) - region.data() - OVERHEAD;
+        auto block = used.find(offset);
+        size_t size = block->second;
+        used.erase(block);
+
+        // Merge with free neighbours
+        auto next = byAddress.find(offset + size);
+        if (next != byAddress.end()) {
+            size += next->second;
+            removeFree(next->first, next->second);
+        }
+        auto prev = byAddress.lower_bound(offset);
+        if (prev != byAddress.begin()) {
+            --prev;
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                removeFree(prev->first, prev->second);
+            }
+        }
+        addFree(offset, size);
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (!ptr) {
+            return allocate(newSize);
+        }
+        calls++;
+        size_t offset = static_cast<uint8_t*>(ptr) - region.data() - OVERHEAD;
+        size_t& blockSize = used[offset];
+        size_t oldSize = blockSize - OVERHEAD;
+        size_t needed = round(newSize + OVERHEAD);
+
+        // Shrink in place, or grow into a free neighbour, like TLSF
+        auto next = byAddress.find(offset + blockSize);
+        size_t adjacent = next != byAddress.end() ? next->second : 0;
+        if (needed <= blockSize + adjacent) {
+            size_t total = blockSize + adjacent;
+            if (adjacent) {
+                removeFree(next->first, next->second);
+            }
+            blockSize = needed;
+            if (total > needed) {
+                addFree(offset + needed, total - needed);
+            }
+            return ptr;
+        }
+
+        void* moved = allocate(newSize);
+        if (moved) {
+            memcpy(moved, ptr, oldSize < newSize ? oldSize : newSize);
+            deallocate(ptr);
+        }
+        return moved;
+    }
+
+    size_t freeBytes() const {
+        size_t total = 0;
+        for (const auto& block : byAddress) {
+            total += block.second;
+        }
+        return total;
+    }
+
+    size_t largestFreeBlock() const {
+        return bySize.empty() ? 0 : bySize.rbegin()->first;
+    }
+
+    // Same definition as SystemProfiler: 1 - largest free block / free bytes
+    double fragmentation() const {
+        size_t total = freeBytes();
+        return total ? 1.0 - static_cast<double>(largestFreeBlock()) / total : 0.0;
+    }
+
+    size_t freeBlocks() const { return byAddress.size(); }
+    uint64_t failedAllocations() const { return failures; }
+    uint64_t allocationCalls() const { return calls; }   // allocate + reallocate
+
+private:
+    static size_t round(size_t size) { return (size + GRANULE - 1) & ~(GRANULE - 1); }
+
+    void addFree(size_t offset, size_t size) {
+        byAddress[offset] = size;
+        bySize.emplace(size, offset);
+    }
+
+    void removeFree(size_t offset, size_t size) {
+        byAddress.erase(offset);
+        auto range = bySize.equal_range(size);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == offset) {
+                bySize.erase(it);
+                break;
+            }
+        }
+    }
+
+    std::vector<uint8_t> region;
+    std::map<size_t, size_t> byAddress;        // Free blocks: offset -> size
+    std::multimap<size_t, size_t> bySize;      // Free blocks: size -> offset
+    std::unordered_map<size_t, size_t> used;   // Allocated blocks: offset -> size
+    uint64_t calls;
+    uint64_t failures;
+};
+
+/**
+ * Replays the allocation pattern of the request path. Two requests are in
+ * flight at a time, as with the network task parsing the next request while
+ * the worker finishes the previous one. Each request has:
+ *  - four documents (request, reply, tool output, error/aux), each with a
+ *    slot pool page and a few strings grown by reallocate and then shrunk,
+ *    as ArduinoJson does while deserializing
+ *  - the response body std::string, which always lives on the heap
+ * Between requests, unrelated long-lived allocations (logs, metrics, TCP
+ * buffers) come and go with random lifetimes.
+ */
+class RequestSimulator {
+public:
+    struct InFlight {
+        ArduinoJson::Allocator* json;
+        std::vector<void*> blocks;
+        void* body;
+    };
+
+    RequestSimulator(SimulatedHeap& simulatedHeap, uint32_t seed) : heap(simulatedHeap), rng(seed), tick(0) {}
+
+    ~RequestSimulator() {
+        for (auto& entry : background) {
+            heap.deallocate(entry.second);
+        }
+    }
+
+    void begin(ArduinoJson::Allocator& json, InFlight& request) {
+        request.json = &json;
+        request.blocks.clear();
+        for (int doc = 0; doc < 4; doc++) {
+            request.blocks.push_back(json.allocate(pick(96, 256)));
+            int strings = pick(1, 5);
+            for (int s = 0; s < strings; s++) {
+                size_t length = pick(4, 120);
+                size_t capacity = 31;
+                void* str = json.allocate(capacity);
+                while (capacity < length) {
+                    capacity = capacity * 2 + 1;
+                    str = json.reallocate(str, capacity);
+                }
+                request.blocks.push_back(json.reallocate(str, length + 1));
+            }
+        }
+        request.body = heap.allocate(pick(80, 400));
+
+        if (pick(0, 99) < 10) {
+            background.emplace(tick + pick(1, 1000), heap.allocate(pick(24, 512)));
+        }
+        while (!background.empty() && background.begin()->first <= tick) {
+            heap.deallocate(background.begin()->second);
+            background.erase(background.begin());
+        }
+        tick++;
+    }
+
+    void finish(InFlight& request) {
+        heap.deallocate(request.body);
+        for (auto it = request.blocks.rbegin(); it != request.blocks.rend(); ++it) {
+            request.json->deallocate(*it);
+        }
+        request.blocks.clear();
+    }
+
+private:
+    size_t pick(size_t low, size_t high) {
+        return std::uniform_int_distribution<size_t>(low, high)(rng);
+    }
+
+    SimulatedHeap& heap;
+    std::mt19937 rng;
+    uint64_t tick;
+    std::multimap<uint64_t, void*> background;   // Expiry tick -> allocation
+};
+
+/**
+ * Fragmentation sampled over a run
+ */
+struct FragmentationSamples {
+    double sum = 0;
+    double worst = 0;
+    size_t smallestLargestBlock = SIZE_MAX;
+    uint32_t count = 0;
+
+    void add(const SimulatedHeap& heap) {
+        double fragmentation = heap.fragmentation();
+        sum += fragmentation;
+        worst = fragmentation > worst ? fragmentation : worst;
+        size_t largest = heap.largestFreeBlock();
+        smallestLargestBlock = largest < smallestLargestBlock ? largest : smallestLargestBlock;
+        count++;
+    }
+
+    double mean() const { return count ? sum / count : 0; }
+};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_arena_bump_and_reset() {
+    alignas(8) uint8_t buffer[256];
+    JsonArena arena(buffer, sizeof(buffer));
+
+    void* a = arena.allocate(10);
+    void* b = arena.allocate(3);
+    TEST_ASSERT_TRUE(arena.owns(a));
+    TEST_ASSERT_TRUE(arena.owns(b));
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(a) % JsonArena::ALIGNMENT);
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(b) % JsonArena::ALIGNMENT);
+    TEST_ASSERT_TRUE(static_cast<uint8_t*>(b) >= static_cast<uint8_t*>(a) + 10);
+
+    // Freeing an older block does nothing; freeing the newest rolls back
+    size_t used = arena.used();
+    arena.deallocate(a);
+    TEST_ASSERT_EQUAL(used, arena.used());
+    arena.deallocate(b);
+    TEST_ASSERT_LESS_THAN(used, arena.used());
+
+    arena.reset();
+    TEST_ASSERT_EQUAL(0, arena.used());
+    TEST_ASSERT_EQUAL(a, arena.allocate(10));
+}
+
+void test_arena_reallocate_in_place() {
+    alignas(8) uint8_t buffer[512];
+    JsonArena arena(buffer, sizeof(buffer));
+
+    void* keep = arena.allocate(16);
+    char* str = static_cast<char*>(arena.allocate(31));
+    strcpy(str, "hello");
+
+    // The newest block grows and shrinks without moving
+    TEST_ASSERT_EQUAL(str, arena.reallocate(str, 63));
+    TEST_ASSERT_EQUAL(str, arena.reallocate(str, 6));
+    TEST_ASSERT_EQUAL_STRING("hello", str);
+    size_t used = arena.used();
+
+    // An older block is copied when it grows
+    char* grown = static_cast<char*>(arena.reallocate(keep, 100));
+    TEST_ASSERT_NOT_EQUAL(keep, grown);
+    TEST_ASSERT_GREATER_THAN(used, arena.used());
+    TEST_ASSERT_EQUAL_STRING("hello", str);
+    TEST_ASSERT_EQUAL(0, arena.overflows());
+}
+
+void test_arena_overflows_to_fallback() {
+    alignas(8) uint8_t buffer[64];
+    SimulatedHeap heap(4096);
+    size_t heapFree = heap.freeBytes();
+    JsonArena arena(buffer, sizeof(buffer), &heap);
+
+    void* inside = arena.allocate(16);
+    void* outside = arena.allocate(200);
+    TEST_ASSERT_TRUE(arena.owns(inside));
+    TEST_ASSERT_FALSE(arena.owns(outside));
+    TEST_ASSERT_EQUAL(1, arena.overflows());
+    TEST_ASSERT_LESS_THAN(heapFree, heap.freeBytes());
+
+    // Growing an arena block that no longer fits moves it to the fallback
+    memset(inside, 'x', 16);
+    void* moved = arena.reallocate(inside, 300);
+    TEST_ASSERT_FALSE(arena.owns(moved));
+    TEST_ASSERT_EQUAL('x', static_cast<char*>(moved)[15]);
+
+    arena.deallocate(outside);
+    arena.deallocate(moved);
+    TEST_ASSERT_EQUAL(heapFree, heap.freeBytes());
+}
+
+void test_pool_leases() {
+    JsonArenaPool pool(2, 1000);
+    {
+        JsonArenaPool::Lease first = pool.acquire();
+        JsonArenaPool::Lease second = pool.acquire();
+        JsonArenaPool::Lease third = pool.acquire();
+        TEST_ASSERT_TRUE(first.pooled());
+        TEST_ASSERT_TRUE(second.pooled());
+        TEST_ASSERT_FALSE(third.pooled());   // Exhausted: heap
+        TEST_ASSERT_TRUE(third.allocator() == HeapJsonAllocator::instance());
+        TEST_ASSERT_TRUE(first.allocator() != second.allocator());
+        TEST_ASSERT_EQUAL(0, pool.getStats().available);
+
+        first.allocator()->allocate(100);
+        JsonArenaPool::Lease moved = std::move(first);
+        TEST_ASSERT_FALSE(first.pooled());
+        TEST_ASSERT_TRUE(moved.pooled());
+    }
+
+    JsonArenaPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL(2, stats.available);
+    TEST_ASSERT_EQUAL(2, stats.acquired);
+    TEST_ASSERT_EQUAL(1, stats.exhausted);
+    TEST_ASSERT_GREATER_OR_EQUAL(100, stats.highWater);
+
+    // Released arenas come back empty
+    JsonArenaPool::Lease again = pool.acquire();
+    void* p = again.allocator()->allocate(8);
+    void* q = pool.acquire().allocator()->allocate(8);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_NOT_NULL(q);
+}
+
+void test_document_in_arena() {
+    JsonArenaPool pool(1, 4096);
+    std::string out;
+    {
+        JsonArenaPool::Lease arena = pool.acquire();
+        JsonDocument doc(arena.allocator());
+        const char* json = "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"tools/call\","
+                           "\"params\":{\"name\":\"setTemperature\",\"arguments\":{\"temperature\":22}}}";
+        TEST_ASSERT_FALSE(deserializeJson(doc, json));
+        TEST_ASSERT_EQUAL_STRING("setTemperature", doc["params"]["name"].as<const char*>());
+        doc["result"]["msg"] = "ok";
+        serializeJson(doc, out);
+    }
+    TEST_ASSERT_TRUE(out.find("\"msg\":\"ok\"") != std::string::npos);
+    TEST_ASSERT_EQUAL(1, pool.getStats().available);
+}
+
+static void report(const char* label, const FragmentationSamples& samples, const SimulatedHeap& heap,
+                   uint32_t requests) {
+    char message[200];
+    snprintf(message, sizeof(message),
+             "%s fragmentation mean %.3f, worst %.3f; smallest largest-free-block %u bytes; "
+             "%.1f heap calls/request",
+             label, samples.mean(), samples.worst, static_cast<unsigned>(samples.smallestLargestBlock),
+             static_cast<double>(heap.allocationCalls()) / requests);
+    TEST_MESSAGE(message);
+}
+
+// One million requests against a 96 KB heap, with request documents on the
+// heap vs in two 4 KB arenas carved out before the run. Fragmentation is
+// sampled every 1000 requests, at a point where a request is in flight.
+void test_fragmentation_after_one_million_requests() {
+    const uint32_t REQUESTS = 1000000;
+    const uint32_t SAMPLE_EVERY = 1000;
+    const size_t HEAP_SIZE = 96 * 1024;
+    const size_t ARENA_SIZE = 4096;
+
+    SimulatedHeap heapOnly(HEAP_SIZE);
+    FragmentationSamples heapSamples;
+    {
+        RequestSimulator simulator(heapOnly, 42);
+        RequestSimulator::InFlight requests[2];
+        for (uint32_t i = 0; i < REQUESTS; i++) {
+            simulator.begin(heapOnly, requests[i % 2]);
+            if (i > 0) {
+                simulator.finish(requests[(i + 1) % 2]);
+            }
+            if (i % SAMPLE_EVERY == 0) {
+                heapSamples.add(heapOnly);
+            }
+        }
+        simulator.finish(requests[(REQUESTS - 1) % 2]);
+    }
+    report("heap documents: ", heapSamples, heapOnly, REQUESTS);
+
+    SimulatedHeap withArenas(HEAP_SIZE);
+    FragmentationSamples arenaSamples;
+    uint32_t overflows = 0;
+    {
+        uint8_t* storage = static_cast<uint8_t*>(withArenas.allocate(2 * ARENA_SIZE));
+        JsonArena arenas[2] = {JsonArena(storage, ARENA_SIZE, &withArenas),
+                               JsonArena(storage + ARENA_SIZE, ARENA_SIZE, &withArenas)};
+        RequestSimulator simulator(withArenas, 42);
+        RequestSimulator::InFlight requests[2];
+        for (uint32_t i = 0; i < REQUESTS; i++) {
+            simulator.begin(arenas[i % 2], requests[i % 2]);
+            if (i > 0) {
+                JsonArena& previous = arenas[(i + 1) % 2];
+                simulator.finish(requests[(i + 1) % 2]);
+                overflows += previous.overflows();
+                previous.reset();
+            }
+            if (i % SAMPLE_EVERY == 0) {
+                arenaSamples.add(withArenas);
+            }
+        }
+        simulator.finish(requests[(REQUESTS - 1) % 2]);
+        withArenas.deallocate(storage);
+    }
+    report("arena documents:", arenaSamples, withArenas, REQUESTS);
+
+    TEST_ASSERT_EQUAL(0, overflows);
+    TEST_ASSERT_EQUAL(0, heapOnly.failedAllocations());
+    TEST_ASSERT_EQUAL(0, withArenas.failedAllocations());
+    TEST_ASSERT_LESS_THAN(heapSamples.mean(), arenaSamples.mean());
+    TEST_ASSERT_LESS_THAN(heapOnly.allocationCalls() / 10, withArenas.allocationCalls());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_arena_bump_and_reset);
+    RUN_TEST(test_arena_reallocate_in_place);
+    RUN_TEST(test_arena_overflows_to_fallback);
+    RUN_TEST(test_pool_leases);
+    RUN_TEST(test_document_in_arena);
+    RUN_TEST(test_fragmentation_after_one_million_requests);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
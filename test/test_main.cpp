@@ -3,7 +3,6 @@
 // Declare test functions from other test files
 void test_request_queue();
 void test_network_manager();
-void test_mcp_server();
 
 void setUp(void) {
     // Global setup
@@ -19,7 +18,6 @@ int main(int argc, char **argv) {
     // Run all test groups
     test_request_queue();
     test_network_manager();
-    test_mcp_server();
     
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "McpDispatcher.h"
+#include "ToolRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+// Device stand-in following AirConditioner's batch rules: every change
+// refreshes the LCD, unless a batch is open, in which case one refresh
+// happens when the batch ends
+struct FakeDevice {
+    std::recursive_mutex mutex;
+    int batchDepth = 0;
+    bool pending = false;
+    bool running = false;
+    int mode = 0;
+    int temperature = 25;
+    int refreshes = 0;
+    std::vector<std::string> log;
+    std::chrono::microseconds refreshCost{0};
+
+    void changed() {
+        if (batchDepth > 0) {
+            pending = true;
+            return;
+        }
+        refresh();
+    }
+
+    void refresh() {
+        refreshes++;
+        if (refreshCost.count() > 0) {
+            std::this_thread::sleep_for(refreshCost);
+        }
+    }
+};
+
+class FakeScope : public DispatchObserver {
+public:
+    explicit FakeScope(FakeDevice& d) : device(d) {}
+
+    void beginCalls() override {
+        device.mutex.lock();
+        device.batchDepth++;
+        scopes++;
+    }
+
+    void endCalls(size_t calls) override {
+        if (--device.batchDepth == 0 && device.pending) {
+            device.pending = false;
+            device.refresh();
+        }
+        device.mutex.unlock();
+        lastCalls = calls;
+    }
+
+    int scopes = 0;
+    size_t lastCalls = 0;
+
+private:
+    FakeDevice& device;
+};
+
+static void registerTools(ToolRegistry& registry, FakeDevice& device) {
+    auto add = [&registry](const char* name, SimpleToolHandler::HandlerFunc func) {
+        ToolDefinition tool;
+        tool.name = name;
+        tool.description = name;
+        tool.handler = std::make_shared<SimpleToolHandler>(std::move(func));
+        registry.addTool(std::move(tool));
+    };
+    add("turnOn", [&device](JsonVariantConst, JsonDocument& result) {
+        std::lock_guard<std::recursive_mutex> lock(device.mutex);
+        device.running = true;
+        device.log.push_back("turnOn");
+        device.changed();
+        result["status"] = "on";
+    });
+    add("setMode", [&device](JsonVariantConst params, JsonDocument& result) {
+        std::lock_guard<std::recursive_mutex> lock(device.mutex);
+        device.mode = params["mode"];
+        device.log.push_back("setMode");
+        device.changed();
+        result["code"] = device.running ? 0 : 1;
+    });
+    add("setTemperature", [&device](JsonVariantConst params, JsonDocument& result) {
+        std::lock_guard<std::recursive_mutex> lock(device.mutex);
+        device.temperature = params["temperature"];
+        device.log.push_back("setTemperature");
+        device.changed();
+        result["code"] = device.running ? 0 : 1;
+    });
+}
+
+static std::string call(int id, const char* tool, const char* arguments) {
+    return std::string("{\"jsonrpc\":\"2.0\",\"id\":") + std::to_string(id) +
+           ",\"method\":\"tools/call\",\"params\":{\"name\":\"" + tool + "\",\"arguments\":" + arguments + "}}";
+}
+
+static const std::string COOL_TO_22[] = {
+    call(1, "turnOn", "{}"),
+    call(2, "setMode", "{\"mode\":1}"),
+    call(3, "setTemperature", "{\"temperature\":22}"),
+};
+
+static std::string batchOf(const std::vector<std::string>& messages) {
+    std::string body = "[";
+    for (size_t i = 0; i < messages.size(); i++) {
+        body += (i ? "," : "") + messages[i];
+    }
+    return body + "]";
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_batch_runs_in_order_with_one_refresh() {
+    FakeDevice device;
+    FakeScope scope(device);
+    ToolRegistry registry;
+    registerTools(registry, device);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+    dispatcher.setObserver(&scope);
+
+    std::string body = batchOf({COOL_TO_22[0], COOL_TO_22[1], COOL_TO_22[2]});
+    McpResponse response = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(200, response.status);
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, response.body));
+    TEST_ASSERT_EQUAL(3, doc.size());
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(i + 1, doc[i]["id"].as<int>());
+    }
+    TEST_ASSERT_EQUAL_STRING("{\"code\":0}", doc[2]["result"]["content"][0]["text"].as<const char*>());
+
+    TEST_ASSERT_EQUAL(3, device.log.size());
+    TEST_ASSERT_TRUE(device.log[0] == "turnOn" && device.log[2] == "setTemperature");
+    TEST_ASSERT_EQUAL(1, device.refreshes);
+    TEST_ASSERT_EQUAL(1, scope.scopes);
+    TEST_ASSERT_EQUAL(3, scope.lastCalls);
+}
+
+void test_batch_mixed_results_and_notifications() {
+    FakeDevice device;
+    ToolRegistry registry;
+    registerTools(registry, device);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    std::string body = batchOf({
+        "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}",
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"ping\"}",
+        "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"nope\"}}",
+        "{\"foo\":1}",
+        "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"params\":{\"name\":\"turnOn\"}}",
+    });
+    McpResponse response = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(200, response.status);
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, response.body));
+    TEST_ASSERT_EQUAL(3, doc.size());   // Notifications get no entry
+    TEST_ASSERT_TRUE(doc[0]["result"].is<JsonObject>());
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_PARAMS, doc[1]["error"]["code"].as<int>());
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_REQUEST, doc[2]["error"]["code"].as<int>());
+    TEST_ASSERT_TRUE(doc[2]["id"].isNull());
+
+    // The notification-style tools/call still ran
+    TEST_ASSERT_TRUE(device.running);
+}
+
+void test_batch_edge_cases() {
+    FakeDevice device;
+    ToolRegistry registry;
+    registerTools(registry, device);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    McpResponse empty = dispatcher.handle("[]", 2);
+    TEST_ASSERT_EQUAL(400, empty.status);
+
+    std::vector<std::string> tooMany(McpDispatcher::MAX_BATCH_SIZE + 1, COOL_TO_22[0]);
+    std::string body = batchOf(tooMany);
+    TEST_ASSERT_EQUAL(400, dispatcher.handle(body.c_str(), body.size()).status);
+    TEST_ASSERT_FALSE(device.running);
+
+    body = batchOf({"{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}"});
+    McpResponse onlyNotifications = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(202, onlyNotifications.status);
+    TEST_ASSERT_TRUE(onlyNotifications.body.empty());
+}
+
+void test_single_call_takes_scope() {
+    FakeDevice device;
+    FakeScope scope(device);
+    ToolRegistry registry;
+    registerTools(registry, device);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+    dispatcher.setObserver(&scope);
+
+    dispatcher.handle(COOL_TO_22[0].c_str(), COOL_TO_22[0].size());
+    TEST_ASSERT_EQUAL(1, scope.scopes);
+    TEST_ASSERT_EQUAL(1, device.refreshes);
+
+    // Requests without tool calls do not touch the device
+    std::string list = "{\"jsonrpc\":\"2.0\",\"id\":9,\"method\":\"tools/list\"}";
+    dispatcher.handle(list.c_str(), list.size());
+    TEST_ASSERT_EQUAL(1, scope.scopes);
+}
+
+// turnOn -> setMode -> setTemperature as three requests vs one batch
+void test_batch_latency_benchmark() {
+    const int ROUNDS = 20;
+    using Clock = std::chrono::steady_clock;
+
+    FakeDevice device;
+    device.refreshCost = std::chrono::microseconds(2000);   // LCD redraw over SPI
+    FakeScope scope(device);
+    ToolRegistry registry;
+    registerTools(registry, device);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+    dispatcher.setObserver(&scope);
+
+    auto start = Clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (const std::string& message : COOL_TO_22) {
+            dispatcher.handle(message.c_str(), message.size());
+        }
+    }
+    double separateMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / ROUNDS;
+    int separateRefreshes = device.refreshes;
+
+    device.refreshes = 0;
+    std::string body = batchOf({COOL_TO_22[0], COOL_TO_22[1], COOL_TO_22[2]});
+    start = Clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        dispatcher.handle(body.c_str(), body.size());
+    }
+    double batchMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / ROUNDS;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "3 requests: %.2f ms / %d refreshes, 1 batch: %.2f ms / %d refreshes (device side only)",
+             separateMs, separateRefreshes / ROUNDS, batchMs, device.refreshes / ROUNDS);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(3 * ROUNDS, separateRefreshes);
+    TEST_ASSERT_EQUAL(ROUNDS, device.refreshes);
+    TEST_ASSERT_LESS_THAN(separateMs * 0.6, batchMs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_batch_runs_in_order_with_one_refresh);
+    RUN_TEST(test_batch_mixed_results_and_notifications);
+    RUN_TEST(test_batch_edge_cases);
+    RUN_TEST(test_single_call_takes_scope);
+    RUN_TEST(test_batch_latency_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
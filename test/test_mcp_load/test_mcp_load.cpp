@@ -0,0 +1,970 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "ACDevices.h"
+#include "ACTools.h"
+#include "AllocTracker.h"
+#include "JsonArena.h"
+#include "McpDispatcher.h"
+#include "ResourceHub.h"
+#include "ToolRegistry.h"
+#include "ToolWorker.h"
+#include "ac.h"
+#include "../mock/mock_lcd.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load generator for the MCP request path on the host.
+//
+// The real registerACTools/registerACResources run against real
+// AirConditioner units; the default unit's LCD is simulated with the SPI
+// transfer time of each draw (mock/mock_lcd.h). Client threads play the
+// role of HTTP connections:
+// each request goes through the same steps as McpEndpoint::handleRequest
+// (arena lease, parse, inline or ToolWorker, chunked read of the reply), and
+// latency is measured from the request body to the last byte read.
+//
+// Environment:
+//   MCP_LOAD_CLIENTS   concurrent clients (default 4)
+//   MCP_LOAD_REQUESTS  requests per client and scenario (default 250)
+//   MCP_LOAD_TRACE     file with one recorded JSON-RPC body per line,
+//                      replayed instead of the built-in trace
+
+using namespace mcp;
+using Clock = std::chrono::steady_clock;
+
+// Typical AsyncTCP send buffer: one TCP segment
+static const size_t CHUNK_SIZE = 1436;
+
+// A home-automation bridge's session: handshake, then polling with the odd change
+static const char* RECORDED_TRACE[] = {
+    "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{\"protocolVersion\":\"2024-11-05\"}}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}",
+    "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/list\"}",
+    "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"tools/call\",\"params\":{\"name\":\"getStatus\",\"arguments\":{}}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"tools/call\",\"params\":{\"name\":\"getStatus\",\"arguments\":{}}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"tools/call\",\"params\":{\"name\":\"turnOn\",\"arguments\":{}}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"tools/call\",\"params\":{\"name\":\"setTemperature\",\"arguments\":{\"temperature\":23}}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"tools/call\",\"params\":{\"name\":\"getStatus\",\"arguments\":{}}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":8,\"method\":\"ping\"}",
+    "{\"jsonrpc\":\"2.0\",\"id\":9,\"method\":\"tools/call\",\"params\":{\"name\":\"getStatus\",\"arguments\":{}}}",
+    "{\"jsonrpc\":\"2.0\",\"id\":10,\"method\":\"resources/read\",\"params\":{\"uri\":\"ac://state\"}}",
+    "[{\"jsonrpc\":\"2.0\",\"id\":11,\"method\":\"tools/call\",\"params\":{\"name\":\"setMode\",\"arguments\":{\"mode\":1}}},"
+    "{\"jsonrpc\":\"2.0\",\"id\":12,\"method\":\"tools/call\",\"params\":{\"name\":\"setTemperature\",\"arguments\":{\"temperature\":21}}}]",
+    "{\"jsonrpc\":\"2.0\",\"id\":13,\"method\":\"tools/call\",\"params\":{\"name\":\"getStatus\",\"arguments\":{}}}",
+};
+
+static int envInt(const char* name, int fallback) {
+    const char* value = getenv(name);
+    return value && atoi(value) > 0 ? atoi(value) : fallback;
+}
+
+static std::string toolCall(int id, const char* tool, const char* arguments) {
+    return std::string("{\"jsonrpc\":\"2.0\",\"id\":") + std::to_string(id) +
+           ",\"method\":\"tools/call\",\"params\":{\"name\":\"" + tool + "\",\"arguments\":" + arguments + "}}";
+}
+
+/**
+ * Synthetic mix, weighted like an agent plus pollers: mostly getStatus,
+ * some changes, discovery and the occasional batch
+ */
+static std::vector<std::string> syntheticMix(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<std::string> bodies;
+    bodies.reserve(count);
+    char arguments[48];
+    for (size_t i = 0; i < count; i++) {
+        int id = static_cast<int>(i) + 1;
+        uint32_t pick = random() % 100;
+        if (pick < 50) {
+            bodies.push_back(toolCall(id, "getStatus", "{}"));
+        } else if (pick < 65) {
+            snprintf(arguments, sizeof(arguments), "{\"temperature\":%u}", static_cast<unsigned>(16 + random() % 15));
+            bodies.push_back(toolCall(id, "setTemperature", arguments));
+        } else if (pick < 75) {
+            snprintf(arguments, sizeof(arguments), "{\"mode\":%u}", static_cast<unsigned>(random() % 4));
+            bodies.push_back(toolCall(id, "setMode", arguments));
+        } else if (pick < 80) {
+            bodies.push_back(toolCall(id, "turnOn", "{}"));
+        } else if (pick < 82) {
+            bodies.push_back(toolCall(id, "turnOff", "{}"));
+        } else if (pick < 90) {
+            bodies.push_back("{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"method\":\"tools/list\"}");
+        } else if (pick < 95) {
+            bodies.push_back("{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"method\":\"ping\"}");
+        } else {
+            bodies.push_back("[" + toolCall(id, "turnOn", "{}") + "," + toolCall(id + 1, "setMode", "{\"mode\":1}") +
+                             "," + toolCall(id + 2, "setTemperature", "{\"temperature\":22}") + "]");
+        }
+    }
+    return bodies;
+}
+
+static std::string unitId(size_t index) {
+    return index == 0 ? std::string("main") : "unit" + std::to_string(index);
+}
+
+/**
+ * Gateway mix over `units` indoor units: polling and changes addressed by
+ * `device` argument or by namespaced tool name, plus batches that touch
+ * one unit or move between two
+ * @param toolCalls Incremented by the tools/call messages generated
+ */
+static std::vector<std::string> multiDeviceMix(size_t count, uint32_t seed, size_t units, size_t& toolCalls) {
+    std::mt19937 random(seed);
+    std::vector<std::string> bodies;
+    bodies.reserve(count);
+    char arguments[96];
+    for (size_t i = 0; i < count; i++) {
+        int id = static_cast<int>(i) + 1;
+        std::string unit = unitId(random() % units);
+        uint32_t pick = random() % 100;
+        unsigned temperature = 16 + random() % 15;
+        if (pick < 30) {
+            snprintf(arguments, sizeof(arguments), "{\"device\":\"%s\"}", unit.c_str());
+            bodies.push_back(toolCall(id, "getStatus", arguments));
+            toolCalls += 1;
+        } else if (pick < 55) {
+            bodies.push_back(toolCall(id, (unit + ".getStatus").c_str(), "{}"));
+            toolCalls += 1;
+        } else if (pick < 70) {
+            snprintf(arguments, sizeof(arguments), "{\"device\":\"%s\",\"temperature\":%u}", unit.c_str(), temperature);
+            bodies.push_back(toolCall(id, "setTemperature", arguments));
+            toolCalls += 1;
+        } else if (pick < 80) {
+            snprintf(arguments, sizeof(arguments), "{\"mode\":%u}", static_cast<unsigned>(random() % 4));
+            bodies.push_back(toolCall(id, (unit + ".setMode").c_str(), arguments));
+            toolCalls += 1;
+        } else if (pick < 92) {
+            snprintf(arguments, sizeof(arguments), "{\"temperature\":%u}", temperature);
+            bodies.push_back("[" + toolCall(id, (unit + ".setMode").c_str(), "{\"mode\":1}") + "," +
+                             toolCall(id + 1, (unit + ".setTemperature").c_str(), arguments) + "]");
+            toolCalls += 2;
+        } else {
+            std::string other = unitId(random() % units);
+            bodies.push_back("[" + toolCall(id, (unit + ".getStatus").c_str(), "{}") + "," +
+                             toolCall(id + 1, (other + ".getStatus").c_str(), "{}") + "]");
+            toolCalls += 2;
+        }
+    }
+    return bodies;
+}
+
+/**
+ * Recorded trace, replayed in order and repeated up to `count` requests
+ */
+static std::vector<std::string> recordedTrace(size_t count) {
+    std::vector<std::string> lines;
+    const char* path = getenv("MCP_LOAD_TRACE");
+    if (path) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
+        }
+    }
+    if (lines.empty()) {
+        lines.assign(std::begin(RECORDED_TRACE), std::end(RECORDED_TRACE));
+    }
+
+    std::vector<std::string> bodies;
+    bodies.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        bodies.push_back(lines[i % lines.size()]);
+    }
+    return bodies;
+}
+
+/**
+ * The device's request path, minus the sockets
+ */
+class LoadTarget {
+public:
+    /**
+     * @param units Indoor units; the first one ("main") drives the LCD
+     * @param inlineCalls Run tool calls on the client threads instead of
+     *        the single ToolWorker, as several worker tasks would
+     */
+    explicit LoadTarget(size_t units = 1, bool inlineCalls = false)
+        : arenas(ToolWorker::arenasFor(ToolWorker::DEFAULT_QUEUE_SIZE)),
+          dispatcher(registry, "ESP32-AC-MCP-Server", "1.0.0"),
+          worker(dispatcher),
+          inlineToolCalls(inlineCalls) {
+        addUnits(devices, units);
+        registerACTools(registry, devices);
+        registerACResources(resources, devices);
+        dispatcher.setObserver(&scope);
+        dispatcher.setResources(&resources);
+        dispatcher.setArenaPool(&arenas);
+        dispatcher.setStreaming(true);
+        ac().enableLCD(true);
+        worker.start(1);
+    }
+
+    ~LoadTarget() {
+        worker.stop();
+    }
+
+    /**
+     * Handle one body like McpEndpoint::handleRequest and read the reply
+     * in send-buffer chunks
+     * @return HTTP status
+     */
+    int request(const std::string& body, std::string& reply) {
+        McpResponse response = dispatch(body);
+        reply.clear();
+        uint8_t chunk[CHUNK_SIZE];
+        size_t read;
+        while ((read = response.read(chunk, sizeof(chunk), reply.size())) > 0) {
+            reply.append(reinterpret_cast<const char*>(chunk), read);
+        }
+        return response.status;
+    }
+
+    void setCoalescing(bool enabled) { worker.setCoalescing(enabled); }
+
+    // Adds the schedule tools, applying due schedules to these units
+    void addScheduler(ACScheduler& scheduler) { registerACScheduleTools(registry, devices, scheduler); }
+
+    ToolWorker::Stats workerStats() const { return worker.getStats(); }
+    JsonArenaPool::Stats arenaStats() const { return arenas.getStats(); }
+
+    // Gauges as the profiler would collect them
+    std::map<std::string, double> publish() {
+        std::map<std::string, double> gauges;
+        auto sink = [&gauges](const char* name, double value) { gauges[name] = value; };
+        scope.publish(sink);
+        devices.publish(sink);
+        return gauges;
+    }
+    ACDeviceRegistry& units() { return devices; }
+    AirConditioner& ac() { return devices.defaultDevice()->ac; }
+
+private:
+    static void addUnits(ACDeviceRegistry& registry, size_t units) {
+        for (size_t i = 0; i < units; i++) {
+            registry.add(unitId(i).c_str());
+        }
+    }
+
+    McpResponse dispatch(const std::string& body) {
+        JsonArenaPool::Lease arena = dispatcher.acquireArena();
+        JsonDocument parsed(arena.allocator());
+        if (deserializeJson(parsed, body.c_str(), body.size())) {
+            return McpDispatcher::parseError();
+        }
+        if (inlineToolCalls || !McpDispatcher::hasToolCalls(parsed)) {
+            return dispatcher.handle(parsed, arena);
+        }
+
+        auto reply = std::make_shared<std::promise<McpResponse>>();
+        std::future<McpResponse> done = reply->get_future();
+        bool queued = worker.submit(std::move(parsed), [reply](McpResponse&& response) {
+            reply->set_value(std::move(response));
+        }, std::move(arena));
+        if (!queued) {
+            return McpResponse{503, std::string(), std::string()};
+        }
+        return done.get();
+    }
+
+    ACDeviceRegistry devices;
+    ToolRegistry registry;
+    ResourceHub resources;
+    JsonArenaPool arenas;
+    McpDispatcher dispatcher;
+    ACDeviceScope scope;
+    ToolWorker worker;
+    bool inlineToolCalls;
+};
+
+struct LoadReport {
+    size_t requests;
+    size_t failures;     // Non-2xx status, unparsable reply or JSON-RPC error
+    double seconds;
+    double throughput;   // Requests per second
+    double p50Us;
+    double p95Us;
+    double p99Us;
+    double maxUs;
+    double allocationsPerCall;   // -1 without MCP_ALLOC_TRACKING
+    uint64_t lcdBytes;
+};
+
+static double percentile(const std::vector<double>& sorted, double q) {
+    size_t index = static_cast<size_t>(q * sorted.size());
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static uint64_t totalAllocations() {
+    AllocTracker::TagStats stats[AllocTracker::MAX_TAGS];
+    size_t count = AllocTracker::getInstance().getStats(stats, AllocTracker::MAX_TAGS);
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += stats[i].allocations;
+    }
+    return total;
+}
+
+static bool isFailure(int status, const std::string& reply) {
+    if (status == 202) {
+        return false;
+    }
+    if (status != 200) {
+        return true;
+    }
+    JsonDocument parsed;
+    if (deserializeJson(parsed, reply)) {
+        return true;
+    }
+    if (parsed.is<JsonArray>()) {
+        for (JsonVariantConst message : parsed.as<JsonArrayConst>()) {
+            if (!message["error"].isNull()) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return !parsed["error"].isNull();
+}
+
+/**
+ * Run `workloads[i]` on client i, all clients at once
+ */
+static LoadReport runLoad(LoadTarget& target, const std::vector<std::vector<std::string>>& workloads) {
+    std::vector<std::vector<double>> latencies(workloads.size());
+    std::vector<size_t> failures(workloads.size(), 0);
+    for (size_t i = 0; i < workloads.size(); i++) {
+        latencies[i].reserve(workloads[i].size());
+    }
+
+    MockLcd::reset();
+    AllocTracker::getInstance().reset();
+    std::atomic<bool> go(false);
+    std::vector<std::thread> clients;
+    for (size_t i = 0; i < workloads.size(); i++) {
+        clients.emplace_back([&, i] {
+            std::string reply;
+            reply.reserve(8192);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            for (const std::string& body : workloads[i]) {
+                Clock::time_point start = Clock::now();
+                int status = target.request(body, reply);
+                latencies[i].push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+                failures[i] += isFailure(status, reply) ? 1 : 0;
+            }
+        });
+    }
+
+    Clock::time_point start = Clock::now();
+    go.store(true);
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t allocations = totalAllocations();
+
+    std::vector<double> all;
+    size_t failed = 0;
+    for (size_t i = 0; i < workloads.size(); i++) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        failed += failures[i];
+    }
+    std::sort(all.begin(), all.end());
+
+    LoadReport report;
+    report.requests = all.size();
+    report.failures = failed;
+    report.seconds = seconds;
+    report.throughput = all.size() / seconds;
+    report.p50Us = percentile(all, 0.50);
+    report.p95Us = percentile(all, 0.95);
+    report.p99Us = percentile(all, 0.99);
+    report.maxUs = all.back();
+    report.allocationsPerCall = AllocTracker::isCompiledIn() ? static_cast<double>(allocations) / all.size() : -1;
+    report.lcdBytes = MockLcd::bytesSent.load();
+    return report;
+}
+
+static void printReport(const char* scenario, size_t clients, const LoadReport& report) {
+    char allocations[24];
+    if (report.allocationsPerCall < 0) {
+        snprintf(allocations, sizeof(allocations), "n/a");
+    } else {
+        snprintf(allocations, sizeof(allocations), "%.1f", report.allocationsPerCall);
+    }
+    char msg[320];
+    snprintf(msg, sizeof(msg),
+             "%s: %u clients, %u requests in %.2f s = %.0f req/s; latency p50 %.0f us, p95 %.0f us, "
+             "p99 %.0f us, max %.0f us; %s allocations/call; %u failures; LCD %.1f KB over SPI",
+             scenario, static_cast<unsigned>(clients), static_cast<unsigned>(report.requests), report.seconds,
+             report.throughput, report.p50Us, report.p95Us, report.p99Us, report.maxUs, allocations,
+             static_cast<unsigned>(report.failures), report.lcdBytes / 1024.0);
+    TEST_MESSAGE(msg);
+}
+
+static size_t clientCount() {
+    return static_cast<size_t>(envInt("MCP_LOAD_CLIENTS", 4));
+}
+
+static size_t requestsPerClient() {
+    return static_cast<size_t>(envInt("MCP_LOAD_REQUESTS", 250));
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_request_path_replies() {
+    LoadTarget target;
+    std::string reply;
+
+    TEST_ASSERT_EQUAL(200, target.request(RECORDED_TRACE[0], reply));
+    TEST_ASSERT_TRUE(reply.find("\"protocolVersion\"") != std::string::npos);
+    TEST_ASSERT_EQUAL(202, target.request(RECORDED_TRACE[1], reply));
+
+    TEST_ASSERT_EQUAL(200, target.request(toolCall(1, "turnOn", "{}"), reply));
+    TEST_ASSERT_EQUAL(200, target.request(toolCall(2, "setTemperature", "{\"temperature\":19}"), reply));
+    TEST_ASSERT_FALSE(isFailure(200, reply));
+    TEST_ASSERT_EQUAL(19, target.ac().getTemperature());
+    TEST_ASSERT_GREATER_THAN(0, MockLcd::draws.load());
+
+    TEST_ASSERT_EQUAL(200, target.request(toolCall(3, "missing", "{}"), reply));
+    TEST_ASSERT_TRUE(isFailure(200, reply));
+    TEST_ASSERT_EQUAL(400, target.request("{\"jsonrpc\":", reply));
+    TEST_ASSERT_EQUAL(3, target.workerStats().executed);
+}
+
+void test_synthetic_mix_load() {
+    LoadTarget target;
+    std::vector<std::vector<std::string>> workloads;
+    for (size_t i = 0; i < clientCount(); i++) {
+        workloads.push_back(syntheticMix(requestsPerClient(), static_cast<uint32_t>(i + 1)));
+    }
+    // Start from a running AC so setMode/setTemperature are not rejected
+    target.ac().turnOn();
+
+    LoadReport report = runLoad(target, workloads);
+    printReport("synthetic mix", workloads.size(), report);
+
+    TEST_ASSERT_EQUAL(workloads.size() * requestsPerClient(), report.requests);
+    TEST_ASSERT_LESS_OR_EQUAL(report.p95Us, report.p50Us);
+    TEST_ASSERT_LESS_OR_EQUAL(report.p99Us, report.p95Us);
+    TEST_ASSERT_GREATER_THAN(0, report.lcdBytes);
+    // turnOff makes later setMode/setTemperature fail with code 1, which is
+    // a tool-level result, not a protocol failure
+    TEST_ASSERT_EQUAL(0, report.failures);
+
+    // The pool is sized for the worker's queue: no request left the arenas
+    JsonArenaPool::Stats arenas = target.arenaStats();
+    char msg[160];
+    snprintf(msg, sizeof(msg), "JSON arenas: %u leased, %u from the heap, high water %u bytes, %u overflows",
+             static_cast<unsigned>(arenas.acquired), static_cast<unsigned>(arenas.exhausted),
+             static_cast<unsigned>(arenas.highWater), static_cast<unsigned>(arenas.overflows));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(0, arenas.exhausted);
+}
+
+void test_recorded_trace_load() {
+    LoadTarget target;
+    std::vector<std::vector<std::string>> workloads(clientCount(), recordedTrace(requestsPerClient()));
+
+    LoadReport report = runLoad(target, workloads);
+    printReport("recorded trace", workloads.size(), report);
+
+    TEST_ASSERT_EQUAL(workloads.size() * requestsPerClient(), report.requests);
+    TEST_ASSERT_EQUAL(0, report.failures);
+}
+
+// Same mix on one client vs several: how far the server scales with
+// concurrent connections when tool calls serialize on the worker
+void test_concurrency_scaling() {
+    LoadTarget target;
+    target.ac().turnOn();
+    size_t total = clientCount() * requestsPerClient();
+
+    std::vector<std::vector<std::string>> single(1, syntheticMix(total, 7));
+    LoadReport serial = runLoad(target, single);
+    printReport("1 client", 1, serial);
+
+    std::vector<std::vector<std::string>> spread;
+    for (size_t i = 0; i < clientCount(); i++) {
+        spread.push_back(std::vector<std::string>(single[0].begin() + i * requestsPerClient(),
+                                                  single[0].begin() + (i + 1) * requestsPerClient()));
+    }
+    LoadReport concurrent = runLoad(target, spread);
+    printReport("concurrent", spread.size(), concurrent);
+
+    TEST_ASSERT_EQUAL(serial.requests, concurrent.requests);
+    TEST_ASSERT_EQUAL(0, serial.failures + concurrent.failures);
+}
+
+/**
+ * An agent sweeping the main unit over several connections: each client
+ * steps the temperature and now and then the mode, waiting for every reply
+ * before the next call, so calls pile up behind the LCD refresh of the one
+ * running
+ */
+static std::vector<std::vector<std::string>> sweepBursts(size_t clients, size_t steps) {
+    std::vector<std::vector<std::string>> workloads(clients);
+    char arguments[32];
+    for (size_t c = 0; c < clients; c++) {
+        for (size_t i = 0; i < steps; i++) {
+            int id = static_cast<int>(c * steps + i) + 1;
+            if (i % 5 == 4) {
+                snprintf(arguments, sizeof(arguments), "{\"mode\":%u}", static_cast<unsigned>((c + i) % 4));
+                workloads[c].push_back(toolCall(id, "setMode", arguments));
+            } else {
+                snprintf(arguments, sizeof(arguments), "{\"temperature\":%u}",
+                         static_cast<unsigned>(MIN_TEMPERATURE + (c + i) % 15));
+                workloads[c].push_back(toolCall(id, "setTemperature", arguments));
+            }
+        }
+    }
+    return workloads;
+}
+
+// Handler runs and LCD refreshes a bursty sweep costs with and without
+// coalescing in the worker
+void test_bursty_sweep_coalescing() {
+    const size_t CLIENTS = 8;   // One control lane's worth of waiting calls
+    const size_t STEPS = 40;
+
+    struct Sweep {
+        LoadReport report;
+        uint64_t handlerRuns;
+        uint64_t coalesced;
+        double lcdFlushes;
+    };
+    auto sweep = [&](bool coalescing) {
+        LoadTarget target;
+        target.setCoalescing(coalescing);
+        std::string reply;
+        TEST_ASSERT_EQUAL(200, target.request(toolCall(1, "turnOn", "{}"), reply));
+
+        // One setTemperature is one full LCD refresh
+        MockLcd::reset();
+        TEST_ASSERT_EQUAL(200, target.request(toolCall(2, "setTemperature", "{\"temperature\":16}"), reply));
+        uint32_t drawsPerFlush = MockLcd::draws.load();
+        TEST_ASSERT_GREATER_THAN(0, drawsPerFlush);
+
+        ToolWorker::Stats before = target.workerStats();
+        Sweep result;
+        result.report = runLoad(target, sweepBursts(CLIENTS, STEPS));
+        ToolWorker::Stats after = target.workerStats();
+        result.handlerRuns = after.executed - before.executed;
+        result.coalesced = after.coalesced - before.coalesced;
+        result.lcdFlushes = static_cast<double>(MockLcd::draws.load()) / drawsPerFlush;
+        return result;
+    };
+    Sweep fifo = sweep(false);
+    Sweep coalesced = sweep(true);
+
+    char msg[200];
+    snprintf(msg, sizeof(msg), "%u-call sweep, FIFO: %u handler runs, %.0f LCD flushes, p95 %.0f us",
+             static_cast<unsigned>(fifo.report.requests), static_cast<unsigned>(fifo.handlerRuns),
+             fifo.lcdFlushes, fifo.report.p95Us);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg),
+             "%u-call sweep, coalescing: %u handler runs, %.0f LCD flushes, p95 %.0f us (%u calls answered "
+             "from a newer one)",
+             static_cast<unsigned>(coalesced.report.requests), static_cast<unsigned>(coalesced.handlerRuns),
+             coalesced.lcdFlushes, coalesced.report.p95Us, static_cast<unsigned>(coalesced.coalesced));
+    TEST_MESSAGE(msg);
+
+    // Every call is answered without error either way
+    TEST_ASSERT_EQUAL(CLIENTS * STEPS, fifo.report.requests);
+    TEST_ASSERT_EQUAL(CLIENTS * STEPS, coalesced.report.requests);
+    TEST_ASSERT_EQUAL(0, fifo.report.failures + coalesced.report.failures);
+    TEST_ASSERT_EQUAL(CLIENTS * STEPS, fifo.handlerRuns);
+    TEST_ASSERT_EQUAL(CLIENTS * STEPS, coalesced.handlerRuns + coalesced.coalesced);
+    TEST_ASSERT_LESS_THAN(fifo.handlerRuns, coalesced.handlerRuns);
+    TEST_ASSERT_LESS_THAN(fifo.lcdFlushes, coalesced.lcdFlushes);
+}
+
+void test_device_routing() {
+    LoadTarget target(3);
+    ACDeviceRegistry& units = target.units();
+    std::string reply;
+
+    TEST_ASSERT_TRUE(units.add("a.b") == nullptr);
+    TEST_ASSERT_TRUE(units.add("unit1") == nullptr);
+    TEST_ASSERT_TRUE(units.find("unit2") == &units.at(2));
+
+    // By namespaced name, by argument, and the default unit without either
+    target.request(toolCall(1, "unit1.turnOn", "{}"), reply);
+    target.request(toolCall(2, "turnOn", "{\"device\":\"unit2\"}"), reply);
+    target.request(toolCall(3, "unit1.setTemperature", "{\"temperature\":18}"), reply);
+    target.request(toolCall(4, "setTemperature", "{\"device\":\"unit2\",\"temperature\":27}"), reply);
+    TEST_ASSERT_TRUE(units.at(1).ac.getRunningStatus() && units.at(2).ac.getRunningStatus());
+    TEST_ASSERT_FALSE(target.ac().getRunningStatus());
+    TEST_ASSERT_EQUAL(18, units.at(1).ac.getTemperature());
+    TEST_ASSERT_EQUAL(27, units.at(2).ac.getTemperature());
+    TEST_ASSERT_EQUAL(25, target.ac().getTemperature());
+
+    TEST_ASSERT_EQUAL(200, target.request(toolCall(5, "getStatus", "{\"device\":\"attic\"}"), reply));
+    TEST_ASSERT_FALSE(isFailure(200, reply));
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":1") != std::string::npos);
+
+    // A batch moving between units applies to each of them
+    target.request("[" + toolCall(6, "unit1.setTemperature", "{\"temperature\":20}") + "," +
+                   toolCall(7, "unit2.setTemperature", "{\"temperature\":21}") + "," +
+                   toolCall(8, "unit1.setMode", "{\"mode\":2}") + "]", reply);
+    TEST_ASSERT_FALSE(isFailure(200, reply));
+    TEST_ASSERT_EQUAL(20, units.at(1).ac.getTemperature());
+    TEST_ASSERT_EQUAL(21, units.at(2).ac.getTemperature());
+    TEST_ASSERT_EQUAL(AC_MODE_HEAT, units.at(1).ac.getMode());
+    TEST_ASSERT_EQUAL(4, units.at(1).toolCalls.load());
+
+    // Counted in RAM, published once per profiler sample
+    std::map<std::string, double> gauges = target.publish();
+    TEST_ASSERT_EQUAL(4, static_cast<int>(gauges["ac.unit1.tool_calls"]));
+    TEST_ASSERT_EQUAL(8, static_cast<int>(gauges["mcp.tool_calls"]));
+    TEST_ASSERT_EQUAL(3, static_cast<int>(gauges["mcp.batch_size_max"]));
+    TEST_ASSERT_TRUE(gauges.count("ac.unit2.lock_wait_avg_us") && gauges.count("ac.main.lock_wait_max_us"));
+    // A lock-free read is counted on the unit the same way
+    target.request(toolCall(11, "unit1.getStatus", "{}"), reply);
+    gauges = target.publish();
+    TEST_ASSERT_EQUAL(5, static_cast<int>(gauges["ac.unit1.tool_calls"]));
+    TEST_ASSERT_EQUAL(1, static_cast<int>(gauges["mcp.batch_size_max"]));
+    TEST_ASSERT_EQUAL(0, static_cast<int>(gauges["ac.unit1.lock_wait_max_us"]));
+
+    TEST_ASSERT_EQUAL(200, target.request("{\"jsonrpc\":\"2.0\",\"id\":9,\"method\":\"resources/read\","
+                                          "\"params\":{\"uri\":\"ac://unit2/state\"}}", reply));
+    TEST_ASSERT_TRUE(reply.find("\\\"temperature\\\":21") != std::string::npos);
+    target.request("{\"jsonrpc\":\"2.0\",\"id\":10,\"method\":\"tools/list\"}", reply);
+    TEST_ASSERT_TRUE(reply.find("\"unit2.getStatus\"") != std::string::npos);
+    TEST_ASSERT_TRUE(reply.find("\"device\"") != std::string::npos);
+}
+
+// One gateway fronting 64 units: clients address random units, tool calls
+// run on the client threads, and each unit only serializes its own calls
+void test_multi_device_scale() {
+    const size_t UNITS = 64;
+    LoadTarget target(UNITS, true);
+    ACDeviceRegistry& units = target.units();
+    for (size_t i = 0; i < UNITS; i++) {
+        units.at(i).ac.turnOn();
+    }
+    size_t clients = clientCount() * 2;
+
+    size_t toolCalls = 0;
+    std::vector<std::vector<std::string>> workloads;
+    for (size_t i = 0; i < clients; i++) {
+        workloads.push_back(multiDeviceMix(requestsPerClient(), static_cast<uint32_t>(i + 100), UNITS, toolCalls));
+    }
+    std::vector<uint32_t> before(UNITS);
+    for (size_t i = 0; i < UNITS; i++) {
+        before[i] = units.at(i).toolCalls.load();
+    }
+
+    LoadReport report = runLoad(target, workloads);
+    printReport("64 units", clients, report);
+
+    size_t executed = 0;
+    size_t idle = 0;
+    uint64_t waitUs = 0;
+    uint32_t maxWaitUs = 0;
+    for (size_t i = 0; i < UNITS; i++) {
+        uint32_t calls = units.at(i).toolCalls.load() - before[i];
+        executed += calls;
+        idle += calls == 0 ? 1 : 0;
+        waitUs += units.at(i).lockWaitUs.load();
+        maxWaitUs = std::max(maxWaitUs, units.at(i).maxLockWaitUs.load());
+    }
+    char msg[160];
+    snprintf(msg, sizeof(msg), "64 units: %u tool calls, unit lock wait avg %.1f us, max %u us; %u idle units",
+             static_cast<unsigned>(executed), static_cast<double>(waitUs) / executed,
+             static_cast<unsigned>(maxWaitUs), static_cast<unsigned>(idle));
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL(clients * requestsPerClient(), report.requests);
+    TEST_ASSERT_EQUAL(0, report.failures);
+    TEST_ASSERT_EQUAL(toolCalls, executed);
+}
+
+// Writers on several tasks, lock-free readers on others: every snapshot a
+// reader gets must be one that was published whole, and a version always
+// names the same state
+void test_state_reads_during_writes() {
+    LoadTarget target(2);
+    AirConditioner& ac = target.units().at(1).ac;
+    ac.turnOn();
+    const int WRITES = 20000;
+    const int READERS = 3;
+
+    std::atomic<bool> done(false);
+    std::vector<std::map<uint32_t, ACState>> seen(READERS);
+    std::atomic<uint32_t> invalid(0);
+    std::atomic<int> reading(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&, r] {
+            uint32_t last = 0;
+            reading++;
+            while (!done.load()) {
+                ACState state = ac.getState();
+                bool valid = state.version >= last && state.mode >= AC_MODE_AUTO && state.mode <= AC_MODE_DEHUMIDIFY &&
+                             state.temperature >= MIN_TEMPERATURE && state.temperature <= MAX_TEMPERATURE;
+                invalid += valid ? 0 : 1;
+                last = state.version;
+                seen[r].emplace(state.version, state);
+                std::this_thread::yield();
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; w++) {
+        writers.emplace_back([&, w] {
+            while (reading.load() < READERS) {
+                std::this_thread::yield();
+            }
+            std::mt19937 random(w + 1);
+            for (int i = 0; i < WRITES; i++) {
+                uint32_t pick = random() % 10;
+                if (pick == 0) {
+                    ac.turnOff();
+                    ac.turnOn();
+                } else if (pick < 4) {
+                    ac.setMode(random() % 4);
+                } else {
+                    ac.setTemperature(MIN_TEMPERATURE + random() % 15);
+                }
+                // Hand the core over now and then, so single-core hosts interleave too
+                if (i % 8 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    size_t versions = 0;
+    uint32_t conflicts = 0;
+    for (const auto& entry : seen[0]) {
+        for (int r = 1; r < READERS; r++) {
+            auto other = seen[r].find(entry.first);
+            if (other != seen[r].end()) {
+                const ACState& a = entry.second;
+                const ACState& b = other->second;
+                conflicts += a.running == b.running && a.mode == b.mode && a.temperature == b.temperature ? 0 : 1;
+            }
+        }
+        versions++;
+    }
+    char msg[160];
+    snprintf(msg, sizeof(msg), "state snapshots: %u versions published, %u seen by reader 0, %u invalid, %u conflicting",
+             static_cast<unsigned>(ac.getStateVersion()), static_cast<unsigned>(versions),
+             static_cast<unsigned>(invalid.load()), static_cast<unsigned>(conflicts));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(0, invalid.load());
+    TEST_ASSERT_EQUAL(0, conflicts);
+    TEST_ASSERT_GREATER_THAN(1, versions);
+}
+
+// Units come back in their saved state after a reboot, before any request
+void test_state_restored_after_reboot() {
+    MemoryJournalStore store;
+    {
+        ACDeviceRegistry units;
+        units.add("main");
+        units.add("bedroom");
+        TEST_ASSERT_EQUAL(0, units.restoreStates(store));
+
+        AirConditioner& bedroom = units.find("bedroom")->ac;
+        bedroom.turnOn();
+        bedroom.setMode(AC_MODE_HEAT);
+        bedroom.setTemperature(27);
+        TEST_ASSERT_EQUAL(0, units.persistStates(1000));
+        TEST_ASSERT_EQUAL(0, units.persistStates(1000 + ACStateJournal::DEBOUNCE_MS / 2));
+        TEST_ASSERT_EQUAL(1, units.persistStates(1000 + ACStateJournal::DEBOUNCE_MS));
+        TEST_ASSERT_EQUAL(0, units.persistStates(60000));
+    }
+
+    ACDeviceRegistry rebooted;
+    rebooted.add("main");
+    rebooted.add("bedroom");
+    TEST_ASSERT_EQUAL(1, rebooted.restoreStates(store));
+    ACState bedroom = rebooted.find("bedroom")->ac.getState();
+    TEST_ASSERT_TRUE(bedroom.running);
+    TEST_ASSERT_EQUAL(AC_MODE_HEAT, bedroom.mode);
+    TEST_ASSERT_EQUAL(27, bedroom.temperature);
+    TEST_ASSERT_FALSE(rebooted.find("main")->ac.getRunningStatus());
+
+    // Restoring is not itself a change to save
+    TEST_ASSERT_EQUAL(0, rebooted.persistStates(0));
+    TEST_ASSERT_EQUAL(0, rebooted.persistStates(60000));
+    TEST_ASSERT_EQUAL(1, store.writes());
+}
+
+// Schedules added over MCP fire on the virtual clock's local time and
+// drive the unit they name; list and remove see the same schedules
+void test_schedules_through_tools() {
+    LoadTarget target(2);
+    VirtualClock clock;
+    MemoryScheduleStore store;
+    ACScheduler scheduler(clock, &store);
+    target.addScheduler(scheduler);
+    AirConditioner& unit1 = target.units().find("unit1")->ac;
+    std::string reply;
+
+    // Monday 2024-01-01 17:59:30
+    clock.set(ScheduleClock::fromCivil(2024, 1, 1, 17, 59, 30));
+    target.request(toolCall(1, "addSchedule", "{\"device\":\"unit1\",\"time\":\"18:00\",\"days\":\"weekdays\","
+                                              "\"power\":\"on\",\"mode\":1,\"temperature\":24}"), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":0") != std::string::npos);
+    TEST_ASSERT_TRUE(reply.find("\\\"days\\\":\\\"weekdays\\\"") != std::string::npos);
+    target.request(toolCall(2, "addSchedule", "{\"device\":\"unit1\",\"time\":\"23:00\",\"power\":\"off\"}"), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":0") != std::string::npos);
+
+    // Rejected: bad time, unknown unit
+    target.request(toolCall(3, "addSchedule", "{\"time\":\"25:00\",\"power\":\"on\"}"), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":0") == std::string::npos);
+    target.request(toolCall(4, "addSchedule", "{\"device\":\"attic\",\"time\":\"08:00\",\"power\":\"on\"}"), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":1") != std::string::npos);
+    TEST_ASSERT_EQUAL(2, scheduler.size());
+
+    TEST_ASSERT_EQUAL(0, scheduler.run());
+    TEST_ASSERT_EQUAL(1, store.saves());
+    clock.advance(29);
+    TEST_ASSERT_EQUAL(0, scheduler.run());
+    clock.advance(1);
+    TEST_ASSERT_EQUAL(1, scheduler.run());
+    TEST_ASSERT_TRUE(unit1.getRunningStatus());
+    TEST_ASSERT_EQUAL(AC_MODE_COOL, unit1.getMode());
+    TEST_ASSERT_EQUAL(24, unit1.getTemperature());
+    TEST_ASSERT_FALSE(target.ac().getRunningStatus());
+
+    // Hour by hour: a single jump past MAX_CATCH_UP_S would re-arm instead
+    size_t ran = 0;
+    for (int hour = 0; hour < 5; hour++) {
+        clock.advance(3600);
+        ran += scheduler.run();
+    }
+    TEST_ASSERT_EQUAL(1, ran);
+    TEST_ASSERT_FALSE(unit1.getRunningStatus());
+    TEST_ASSERT_EQUAL(0, scheduler.failures());
+
+    // Cooling without power on fails while the unit is off, and is counted
+    ACSchedule coolOnly = {};
+    strcpy(coolOnly.device, "unit1");
+    coolOnly.mode = AC_MODE_COOL;
+    coolOnly.temperature = 24;
+    TEST_ASSERT_EQUAL(AC_ERR_NOT_RUNNING, applyACSchedule(target.units(), coolOnly));
+    strcpy(coolOnly.device, "attic");
+    TEST_ASSERT_EQUAL(AC_ERR_UNKNOWN_DEVICE, applyACSchedule(target.units(), coolOnly));
+    coolOnly.power = AC_POWER_ON;
+    strcpy(coolOnly.device, "unit1");
+    TEST_ASSERT_EQUAL(AC_OK, applyACSchedule(target.units(), coolOnly));
+    TEST_ASSERT_TRUE(unit1.getRunningStatus());
+    unit1.turnOff();
+
+    target.request(toolCall(5, "listSchedules", "{\"device\":\"unit1\"}"), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"time\\\":\\\"18:00\\\"") != std::string::npos);
+    TEST_ASSERT_TRUE(reply.find("23:00") != std::string::npos);
+    TEST_ASSERT_TRUE(reply.find("\\\"nextRunIn\\\"") != std::string::npos);
+
+    uint32_t id = scheduler.list()[0].id;
+    std::string arguments = "{\"id\":" + std::to_string(id) + "}";
+    target.request(toolCall(6, "removeSchedule", arguments.c_str()), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":0") != std::string::npos);
+    target.request(toolCall(7, "removeSchedule", arguments.c_str()), reply);
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":0") == std::string::npos);
+    TEST_ASSERT_EQUAL(1, scheduler.size());
+}
+
+// The room model behind getRoomTemperature: a day of main-loop ticks,
+// with a stall in the middle that is skipped rather than replayed
+void test_room_temperature_simulation() {
+    LoadTarget target(2);
+    ACDeviceRegistry& units = target.units();
+    AirConditioner& unit1 = units.find("unit1")->ac;
+    unit1.turnOn();
+    unit1.setMode(AC_MODE_COOL);
+    unit1.setTemperature(22);
+
+    uint32_t nowMs = 5000;
+    TEST_ASSERT_EQUAL_UINT32(0, units.simulate(nowMs));
+    uint32_t ticks = 0;
+    for (int i = 0; i < 24 * 3600 * 10; i++) {
+        nowMs += 100;
+        ticks += units.simulate(nowMs);
+    }
+    TEST_ASSERT_EQUAL_UINT32(24 * 3600, ticks);
+    nowMs += 600000;
+    TEST_ASSERT_EQUAL_UINT32(ACDeviceRegistry::MAX_SIMULATION_TICKS, units.simulate(nowMs));
+    TEST_ASSERT_EQUAL_UINT32(0, units.simulate(nowMs + 999));
+
+    std::string reply;
+    TEST_ASSERT_EQUAL(200, target.request(toolCall(1, "unit1.getRoomTemperature", "{}"), reply));
+    TEST_ASSERT_TRUE(reply.find("\\\"roomTemperature\\\":22") != std::string::npos);
+    TEST_ASSERT_TRUE(reply.find("\\\"compressorDuty\\\"") != std::string::npos);
+    TEST_ASSERT_TRUE(reply.find("\\\"simulatedSeconds\\\":86460") != std::string::npos);
+
+    // The profiler sample reports the same reading
+    std::map<std::string, double> gauges = target.publish();
+    TEST_ASSERT_EQUAL(220, static_cast<int>(gauges["ac.unit1.room_temperature"] * 10 + 0.5));
+    TEST_ASSERT_TRUE(gauges.count("ac.main.outside_temperature") && gauges.count("ac.unit1.compressor_duty"));
+
+    // The unit left off drifts with the outside temperature instead
+    ACThermalReading idle = units.defaultDevice()->thermal.reading();
+    TEST_ASSERT_EQUAL_INT32(0, idle.duty);
+    TEST_ASSERT_TRUE(idle.room > ACThermalModel::fromTenths(250));
+    TEST_ASSERT_EQUAL(200, target.request(toolCall(2, "getRoomTemperature", "{\"device\":\"attic\"}"), reply));
+    TEST_ASSERT_TRUE(reply.find("\\\"code\\\":1") != std::string::npos);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_request_path_replies);
+    RUN_TEST(test_synthetic_mix_load);
+    RUN_TEST(test_recorded_trace_load);
+    RUN_TEST(test_concurrency_scaling);
+    RUN_TEST(test_bursty_sweep_coalescing);
+    RUN_TEST(test_device_routing);
+    RUN_TEST(test_multi_device_scale);
+    RUN_TEST(test_state_reads_during_writes);
+    RUN_TEST(test_state_restored_after_reboot);
+    RUN_TEST(test_schedules_through_tools);
+    RUN_TEST(test_room_temperature_simulation);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,229 @@
+#include <unity.h>
+#include "PriorityRequestQueue.h"
+#include "QueueMetrics.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum Lane {
+    LANE_CONTROL = 0,   // turnOn/turnOff/setMode...
+    LANE_STATUS = 1     // getStatus polls
+};
+
+class RecordingObserver : public QueueObserver {
+public:
+    std::vector<size_t> rejected;
+    std::vector<size_t> highWater;
+    std::vector<uint32_t> waits;
+
+    void onRejected(size_t lane) override { rejected.push_back(lane); }
+    void onHighWater(size_t, size_t depth) override { highWater.push_back(depth); }
+    void onDequeued(size_t, uint32_t waitUs) override { waits.push_back(waitUs); }
+};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_priority_weighted_fair_order() {
+    PriorityRequestQueue<int, 2> queue(PriorityRequestQueue<int, 2>::Config{{{16, 3}, {16, 1}}});
+
+    for (int i = 0; i < 8; i++) {
+        queue.push(100 + i, LANE_CONTROL);
+        queue.push(200 + i, LANE_STATUS);
+    }
+
+    // 3:1 weights: three control items for every status item
+    std::string pattern;
+    int value;
+    size_t lane;
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(queue.pop(value, &lane));
+        pattern += lane == LANE_CONTROL ? 'C' : 'S';
+    }
+    TEST_ASSERT_EQUAL_STRING("CCSCCCSC", pattern.c_str());
+
+    // Status lane is never starved and FIFO order holds within a lane
+    std::vector<int> rest;
+    while (queue.pop(value)) {
+        rest.push_back(value);
+    }
+    TEST_ASSERT_EQUAL(8, rest.size());
+    TEST_ASSERT_EQUAL(207, rest.back());
+}
+
+void test_priority_control_jumps_status_burst() {
+    PriorityRequestQueue<std::string, 2> queue(PriorityRequestQueue<std::string, 2>::Config{{{8, 8}, {64, 1}}});
+
+    for (int i = 0; i < 50; i++) {
+        queue.push("getStatus", LANE_STATUS);
+    }
+    queue.push("turnOff", LANE_CONTROL);
+
+    std::string next;
+    TEST_ASSERT_TRUE(queue.pop(next));
+    TEST_ASSERT_EQUAL_STRING("turnOff", next.c_str());
+}
+
+void test_priority_per_lane_capacity() {
+    RecordingObserver observer;
+    PriorityRequestQueue<int, 2> queue(PriorityRequestQueue<int, 2>::Config{{{4, 1}, {2, 1}}}, &observer);
+
+    TEST_ASSERT_TRUE(queue.push(1, LANE_STATUS));
+    TEST_ASSERT_TRUE(queue.push(2, LANE_STATUS));
+    TEST_ASSERT_FALSE(queue.push(3, LANE_STATUS));   // Status lane full
+    TEST_ASSERT_TRUE(queue.push(4, LANE_CONTROL));   // Control lane still accepts
+
+    QueueLaneStats status = queue.stats(LANE_STATUS);
+    TEST_ASSERT_EQUAL(2, status.pushed);
+    TEST_ASSERT_EQUAL(1, status.rejected);
+    TEST_ASSERT_EQUAL(2, status.highWater);
+    TEST_ASSERT_EQUAL(1, observer.rejected.size());
+    TEST_ASSERT_EQUAL(LANE_STATUS, observer.rejected[0]);
+}
+
+// Values are key * 100 + version; a newer version of a key replaces a
+// waiting one, odd keys must keep their place
+void test_priority_push_coalescing() {
+    PriorityRequestQueue<int, 2> queue(PriorityRequestQueue<int, 2>::Config{{{4, 1}, {4, 1}}});
+    std::vector<int> absorbed;
+    auto relation = [](const int& waiting, const int& item) {
+        if ((waiting / 100) % 2) {
+            return QueueCoalesce::Stop;
+        }
+        return waiting / 100 == item / 100 ? QueueCoalesce::Replace : QueueCoalesce::Pass;
+    };
+    auto absorb = [&absorbed](int&, int&& waiting) { absorbed.push_back(waiting); };
+
+    TEST_ASSERT_TRUE(queue.pushCoalescing(201, LANE_CONTROL, relation, absorb));
+    TEST_ASSERT_TRUE(queue.push(301, LANE_CONTROL));
+    TEST_ASSERT_TRUE(queue.pushCoalescing(202, LANE_CONTROL, relation, absorb));
+    TEST_ASSERT_TRUE(queue.pushCoalescing(401, LANE_CONTROL, relation, absorb));
+    TEST_ASSERT_FALSE(queue.push(501, LANE_CONTROL));   // Full
+    TEST_ASSERT_TRUE(queue.pushCoalescing(203, LANE_CONTROL, relation, absorb));   // Frees 202's slot
+
+    // 201 stays ahead of 301; 202 is replaced and 203 moves past 401
+    TEST_ASSERT_EQUAL(1, absorbed.size());
+    TEST_ASSERT_EQUAL(202, absorbed[0]);
+    int expected[] = {201, 301, 401, 203};
+    int value;
+    for (int want : expected) {
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL(want, value);
+    }
+    TEST_ASSERT_TRUE(queue.empty());
+
+    QueueLaneStats stats = queue.stats(LANE_CONTROL);
+    TEST_ASSERT_EQUAL(5, stats.pushed);
+    TEST_ASSERT_EQUAL(1, stats.superseded);
+    TEST_ASSERT_EQUAL(4, stats.dequeued);
+}
+
+void test_priority_high_water_and_wait() {
+    RecordingObserver observer;
+    PriorityRequestQueue<int, 2> queue(PriorityRequestQueue<int, 2>::Config{{{8, 1}, {8, 1}}}, &observer);
+
+    queue.push(1, LANE_CONTROL);
+    queue.push(2, LANE_CONTROL);
+    int value;
+    queue.pop(value);
+    queue.push(3, LANE_CONTROL);   // Depth back to 2: no new high-water event
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    queue.pop(value);
+    queue.pop(value);
+
+    QueueLaneStats control = queue.stats(LANE_CONTROL);
+    TEST_ASSERT_EQUAL(2, control.highWater);
+    TEST_ASSERT_EQUAL(0, control.depth);
+    TEST_ASSERT_EQUAL(3, control.dequeued);
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, control.waitMaxUs);
+    TEST_ASSERT_GREATER_OR_EQUAL(control.waitMaxUs, control.waitTotalUs);
+
+    TEST_ASSERT_EQUAL(2, observer.highWater.size());
+    TEST_ASSERT_EQUAL(3, observer.waits.size());
+}
+
+void test_priority_pop_wait() {
+    PriorityRequestQueue<int, 2> queue(PriorityRequestQueue<int, 2>::Config{{{4, 1}, {4, 1}}});
+    int value = 0;
+    size_t lane = 0;
+
+    TEST_ASSERT_FALSE(queue.pop_wait(value, std::chrono::milliseconds(10)));
+
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.push(42, LANE_STATUS);
+    });
+    TEST_ASSERT_TRUE(queue.pop_wait(value, std::chrono::seconds(5), &lane));
+    producer.join();
+
+    TEST_ASSERT_EQUAL(42, value);
+    TEST_ASSERT_EQUAL(LANE_STATUS, lane);
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+// Events only touch counters; publish() reports them and starts a new wait window
+void test_queue_metrics_published_in_batches() {
+    mcp::MetricsQueueObserver metrics("mcp", {"control", "status"});
+    PriorityRequestQueue<int, 2> queue(PriorityRequestQueue<int, 2>::Config{{{2, 1}, {2, 1}}}, &metrics);
+
+    queue.push(1, LANE_CONTROL);
+    queue.push(2, LANE_CONTROL);
+    TEST_ASSERT_FALSE(queue.push(3, LANE_CONTROL));
+    queue.push(4, LANE_STATUS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    int value;
+    while (queue.pop(value)) {
+    }
+
+    std::map<std::string, double> gauges;
+    auto sink = [&gauges](const char* name, double gaugeValue) { gauges[name] = gaugeValue; };
+    metrics.publish(sink);
+    TEST_ASSERT_EQUAL(8, gauges.size());
+    TEST_ASSERT_EQUAL(1, gauges["queue.mcp.control.rejected"]);
+    TEST_ASSERT_EQUAL(2, gauges["queue.mcp.control.high_water"]);
+    TEST_ASSERT_EQUAL(0, gauges["queue.mcp.status.rejected"]);
+    TEST_ASSERT_EQUAL(1, gauges["queue.mcp.status.high_water"]);
+    TEST_ASSERT_TRUE(gauges["queue.mcp.control.wait_max_ms"] >= 5);
+    TEST_ASSERT_TRUE(gauges["queue.mcp.control.wait_avg_ms"] >= 5);
+    TEST_ASSERT_TRUE(gauges["queue.mcp.control.wait_avg_ms"] <= gauges["queue.mcp.control.wait_max_ms"]);
+
+    // Nothing dequeued since: the wait window is empty, the totals stay
+    metrics.publish(sink);
+    TEST_ASSERT_EQUAL(1, gauges["queue.mcp.control.rejected"]);
+    TEST_ASSERT_EQUAL(0, gauges["queue.mcp.control.wait_max_ms"]);
+    TEST_ASSERT_EQUAL(0, gauges["queue.mcp.control.wait_avg_ms"]);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_priority_weighted_fair_order);
+    RUN_TEST(test_priority_control_jumps_status_burst);
+    RUN_TEST(test_priority_per_lane_capacity);
+    RUN_TEST(test_priority_push_coalescing);
+    RUN_TEST(test_priority_high_water_and_wait);
+    RUN_TEST(test_priority_pop_wait);
+    RUN_TEST(test_queue_metrics_published_in_batches);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
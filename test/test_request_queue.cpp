@@ -2,6 +2,11 @@
 #include "RequestQueue.h"
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <vector>
+#include <iterator>
+#include <cstdio>
+#include <ctime>
 
 void setUp(void) {
     // Set up any test prerequisites
@@ -74,12 +79,164 @@ void test_request_queue_thread_safety() {
     consumer.join();
 }
 
+void test_request_queue_pop_wait_timeout() {
+    RequestQueue<int> queue;
+    int value = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_FALSE(queue.pop_wait(value, std::chrono::milliseconds(20)));
+    auto waited = std::chrono::steady_clock::now() - start;
+    TEST_ASSERT_GREATER_OR_EQUAL(20, std::chrono::duration_cast<std::chrono::milliseconds>(waited).count());
+}
+
+void test_request_queue_pop_wait_wakeup() {
+    RequestQueue<int> queue;
+    int value = 0;
+
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.push(7);
+    });
+
+    // Woken by the push long before the timeout
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(queue.pop_wait(value, std::chrono::seconds(5)));
+    auto waited = std::chrono::steady_clock::now() - start;
+    producer.join();
+
+    TEST_ASSERT_EQUAL(7, value);
+    TEST_ASSERT_LESS_THAN(1000, std::chrono::duration_cast<std::chrono::milliseconds>(waited).count());
+}
+
+void test_request_queue_drain() {
+    RequestQueue<int> queue;
+    for (int i = 0; i < 10; i++) {
+        queue.push(i);
+    }
+
+    std::vector<int> batch;
+    TEST_ASSERT_EQUAL(4, queue.drain(std::back_inserter(batch), 4));
+    TEST_ASSERT_EQUAL(6, queue.size());
+    TEST_ASSERT_EQUAL(10, queue.drain(std::back_inserter(batch), 100) + 4);
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(i, batch[i]);
+    }
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+#ifdef __linux__
+static double threadCpuMs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// CPU burned by a consumer while the queue stays idle for 200 ms
+void test_request_queue_idle_cpu_benchmark() {
+    const auto IDLE = std::chrono::milliseconds(200);
+    RequestQueue<int> queue;
+    double pollCpu = 0;
+    double waitCpu = 0;
+
+    std::thread poller([&]() {
+        double start = threadCpuMs();
+        auto deadline = std::chrono::steady_clock::now() + IDLE;
+        int value;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (!queue.pop(value)) {
+                std::this_thread::yield();
+            }
+        }
+        pollCpu = threadCpuMs() - start;
+    });
+    poller.join();
+
+    std::thread waiter([&]() {
+        double start = threadCpuMs();
+        int value;
+        queue.pop_wait(value, IDLE);
+        waitCpu = threadCpuMs() - start;
+    });
+    waiter.join();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "idle 200 ms: polling %.1f ms CPU, pop_wait %.3f ms CPU", pollCpu, waitCpu);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(pollCpu, waitCpu);
+}
+#endif
+
+// Bursts of 32 items: loop()-style polling with delay() versus pop_wait + drain
+void test_request_queue_burst_benchmark() {
+    const int BURSTS = 20;
+    const int BURST_SIZE = 32;
+    const int TOTAL = BURSTS * BURST_SIZE;
+
+    auto runProducer = [](RequestQueue<int>& queue) {
+        for (int b = 0; b < BURSTS; b++) {
+            for (int i = 0; i < BURST_SIZE; i++) {
+                queue.push(i);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    };
+
+    RequestQueue<int> polled(TOTAL);
+    auto start = std::chrono::steady_clock::now();
+    std::thread pollProducer([&]() { runProducer(polled); });
+    int received = 0;
+    while (received < TOTAL) {
+        int value;
+        if (polled.pop(value)) {
+            received++;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    pollProducer.join();
+    double pollMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    RequestQueue<int> batched(TOTAL);
+    int wakeups = 0;
+    start = std::chrono::steady_clock::now();
+    std::thread batchProducer([&]() { runProducer(batched); });
+    received = 0;
+    std::vector<int> batch;
+    batch.reserve(BURST_SIZE);
+    while (received < TOTAL) {
+        int first;
+        if (!batched.pop_wait(first, std::chrono::milliseconds(100))) {
+            continue;
+        }
+        wakeups++;
+        batch.clear();
+        batched.drain(std::back_inserter(batch), BURST_SIZE);
+        received += 1 + static_cast<int>(batch.size());
+    }
+    batchProducer.join();
+    double batchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%d items in bursts: polling %.1f ms (%.0f items/s), pop_wait+drain %.1f ms (%.0f items/s, %d wakeups)",
+             TOTAL, pollMs, TOTAL * 1000.0 / pollMs, batchMs, TOTAL * 1000.0 / batchMs, wakeups);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(pollMs, batchMs);
+    TEST_ASSERT_LESS_THAN(TOTAL, wakeups);
+}
+
 int runUnityTests() {
     UNITY_BEGIN();
     
     RUN_TEST(test_request_queue_push_pop);
     RUN_TEST(test_request_queue_multiple_items);
     RUN_TEST(test_request_queue_thread_safety);
+    RUN_TEST(test_request_queue_pop_wait_timeout);
+    RUN_TEST(test_request_queue_pop_wait_wakeup);
+    RUN_TEST(test_request_queue_drain);
+#ifdef __linux__
+    RUN_TEST(test_request_queue_idle_cpu_benchmark);
+#endif
+    RUN_TEST(test_request_queue_burst_benchmark);
     
     return UNITY_END();
 }
@@ -0,0 +1,325 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "McpDispatcher.h"
+#include "ResourceHub.h"
+#include "ToolRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+static const char* STATE_URI = "ac://state";
+
+static int temperature = 25;
+
+static void addState(ResourceHub& hub) {
+    ResourceDefinition state;
+    state.uri = STATE_URI;
+    state.name = "AC state";
+    state.description = "AC state";
+    state.mimeType = "application/json";
+    state.read = [](JsonDocument& contents) {
+        contents["temperature"] = temperature;
+    };
+    hub.addResource(std::move(state));
+}
+
+// Everything the transport would send right now
+static std::string drain(EventSession& session, uint32_t nowMs = 0) {
+    std::string out;
+    uint8_t buffer[64];
+    size_t read;
+    while ((read = session.read(buffer, sizeof(buffer), nowMs)) > 0) {
+        out.append(reinterpret_cast<const char*>(buffer), read);
+    }
+    return out;
+}
+
+static size_t count(const std::string& text, const char* needle) {
+    size_t found = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        found++;
+    }
+    return found;
+}
+
+static std::string request(McpDispatcher& dispatcher, const char* method, const char* uri, uint32_t session) {
+    std::string body = std::string("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"") + method + "\"";
+    if (uri) {
+        body += std::string(",\"params\":{\"uri\":\"") + uri + "\"}";
+    }
+    body += "}";
+    return dispatcher.handle(body.c_str(), body.size(), session).text();
+}
+
+void setUp(void) {
+    temperature = 25;
+}
+
+void tearDown(void) {
+}
+
+void test_first_event_names_endpoint() {
+    ResourceHub hub;
+    std::shared_ptr<EventSession> session = hub.openSession();
+    std::string expected = "event: endpoint\ndata: /mcp?sessionId=" + std::to_string(session->id()) + "\n\n";
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), drain(*session).c_str());
+    TEST_ASSERT_EQUAL_STRING("", drain(*session).c_str());
+}
+
+void test_subscriber_notified_once_per_read() {
+    ResourceHub hub;
+    addState(hub);
+    std::shared_ptr<EventSession> subscriber = hub.openSession();
+    std::shared_ptr<EventSession> bystander = hub.openSession();
+    drain(*subscriber);
+    drain(*bystander);
+
+    // Changes before subscribing are not announced
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_TRUE(hub.subscribe(subscriber->id(), STATE_URI));
+    TEST_ASSERT_EQUAL_STRING("", drain(*subscriber).c_str());
+
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL_STRING(
+        "event: message\ndata: {\"jsonrpc\":\"2.0\",\"method\":\"notifications/resources/updated\","
+        "\"params\":{\"uri\":\"ac://state\"}}\n\n",
+        drain(*subscriber).c_str());
+    TEST_ASSERT_EQUAL_STRING("", drain(*bystander).c_str());
+
+    // Changes between two reads collapse into one event
+    for (int i = 0; i < 5; i++) {
+        hub.notifyUpdated(STATE_URI);
+    }
+    TEST_ASSERT_EQUAL(1, count(drain(*subscriber), "resources/updated"));
+    TEST_ASSERT_EQUAL(2, subscriber->eventCount());
+
+    TEST_ASSERT_TRUE(hub.unsubscribe(subscriber->id(), STATE_URI));
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL_STRING("", drain(*subscriber).c_str());
+
+    TEST_ASSERT_FALSE(hub.notifyUpdated("ac://missing"));
+    TEST_ASSERT_FALSE(hub.subscribe(subscriber->id(), "ac://missing"));
+    TEST_ASSERT_FALSE(hub.subscribe(999, STATE_URI));
+}
+
+void test_keepalive_when_idle() {
+    ResourceHub hub;
+    std::shared_ptr<EventSession> session = hub.openSession();
+    drain(*session, 1000);
+    TEST_ASSERT_EQUAL_STRING("", drain(*session, 1000 + EventSession::KEEPALIVE_MS - 1).c_str());
+    TEST_ASSERT_EQUAL_STRING(": keepalive\n\n", drain(*session, 1000 + EventSession::KEEPALIVE_MS).c_str());
+    TEST_ASSERT_EQUAL(0, session->eventCount());
+}
+
+void test_sessions_end_with_transport() {
+    ResourceHub hub;
+    addState(hub);
+    std::vector<std::shared_ptr<EventSession>> open;
+    for (size_t i = 0; i < ResourceHub::MAX_SESSIONS; i++) {
+        open.push_back(hub.openSession());
+    }
+    TEST_ASSERT_TRUE(hub.openSession() == nullptr);
+
+    uint32_t closed = open.back()->id();
+    open.pop_back();
+    TEST_ASSERT_EQUAL(ResourceHub::MAX_SESSIONS - 1, hub.sessionCount());
+    TEST_ASSERT_FALSE(hub.subscribe(closed, STATE_URI));
+    TEST_ASSERT_TRUE(hub.openSession() != nullptr);
+}
+
+// Ids come from the source, skipping 0 and ids of open sessions
+void test_session_ids_from_source() {
+    std::vector<uint32_t> ids = {0, 7, 7, 0xdeadbeef};
+    size_t next = 0;
+    ResourceHub hub([&ids, &next] { return ids[next++ % ids.size()]; });
+    std::shared_ptr<EventSession> first = hub.openSession();
+    std::shared_ptr<EventSession> second = hub.openSession();
+    TEST_ASSERT_EQUAL_UINT32(7, first->id());
+    TEST_ASSERT_EQUAL_UINT32(0xdeadbeef, second->id());
+    TEST_ASSERT_TRUE(hub.hasSession(0xdeadbeef));
+    TEST_ASSERT_FALSE(hub.hasSession(8));
+
+    // Default source: random, not a counter
+    ResourceHub random;
+    std::shared_ptr<EventSession> a = random.openSession();
+    std::shared_ptr<EventSession> b = random.openSession();
+    TEST_ASSERT_TRUE(a->id() != 0 && b->id() != 0 && a->id() != b->id());
+}
+
+// A change wakes the streams subscribed to it, once per change, and only
+// while they are open
+void test_changes_wake_subscribed_streams() {
+    ResourceHub hub;
+    addState(hub);
+    std::vector<void*> woken;
+    hub.setStreamWaker([&woken](void* stream) { woken.push_back(stream); });
+
+    int subscriberStream = 0;
+    int bystanderStream = 0;
+    std::shared_ptr<EventSession> subscriber = hub.openSession(&subscriberStream);
+    std::shared_ptr<EventSession> bystander = hub.openSession(&bystanderStream);
+    std::shared_ptr<EventSession> headless = hub.openSession();
+    hub.subscribe(subscriber->id(), STATE_URI);
+    hub.subscribe(headless->id(), STATE_URI);
+
+    hub.notifyUpdated(STATE_URI);
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL(2, woken.size());
+    TEST_ASSERT_TRUE(woken[0] == &subscriberStream && woken[1] == &subscriberStream);
+
+    woken.clear();
+    hub.unsubscribe(subscriber->id(), STATE_URI);
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL(0, woken.size());
+
+    // A closed stream is not woken, and its slot starts with no subscriptions
+    hub.subscribe(subscriber->id(), STATE_URI);
+    subscriber.reset();
+    int nextStream = 0;
+    std::shared_ptr<EventSession> next = hub.openSession(&nextStream);
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL(0, woken.size());
+    hub.subscribe(next->id(), STATE_URI);
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL(1, woken.size());
+    TEST_ASSERT_TRUE(woken[0] == &nextStream);
+}
+
+void test_dispatcher_resources() {
+    ToolRegistry registry;
+    ResourceHub hub;
+    addState(hub);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    // Without a hub resources are not offered
+    TEST_ASSERT_TRUE(request(dispatcher, "initialize", nullptr, 0).find("\"resources\"") == std::string::npos);
+    TEST_ASSERT_TRUE(request(dispatcher, "resources/list", nullptr, 0).find("-32601") != std::string::npos);
+
+    dispatcher.setResources(&hub);
+    TEST_ASSERT_TRUE(request(dispatcher, "initialize", nullptr, 0).find("\"subscribe\":true") != std::string::npos);
+
+    JsonDocument reply;
+    deserializeJson(reply, request(dispatcher, "resources/list", nullptr, 0));
+    TEST_ASSERT_EQUAL_STRING(STATE_URI, reply["result"]["resources"][0]["uri"].as<const char*>());
+
+    temperature = 19;
+    deserializeJson(reply, request(dispatcher, "resources/read", STATE_URI, 0));
+    TEST_ASSERT_EQUAL_STRING("{\"temperature\":19}", reply["result"]["contents"][0]["text"].as<const char*>());
+    deserializeJson(reply, request(dispatcher, "resources/read", "ac://missing", 0));
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_PARAMS, reply["error"]["code"].as<int>());
+
+    // Subscribing needs the session of an open event stream
+    deserializeJson(reply, request(dispatcher, "resources/subscribe", STATE_URI, 0));
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_PARAMS, reply["error"]["code"].as<int>());
+
+    std::shared_ptr<EventSession> session = hub.openSession();
+    drain(*session);
+    deserializeJson(reply, request(dispatcher, "resources/subscribe", STATE_URI, session->id()));
+    TEST_ASSERT_TRUE(reply["error"].isNull());
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL(1, count(drain(*session), "resources/updated"));
+
+    deserializeJson(reply, request(dispatcher, "resources/unsubscribe", STATE_URI, session->id()));
+    TEST_ASSERT_TRUE(reply["error"].isNull());
+    hub.notifyUpdated(STATE_URI);
+    TEST_ASSERT_EQUAL_STRING("", drain(*session).c_str());
+}
+
+void test_notify_while_reading() {
+    ResourceHub hub;
+    addState(hub);
+    std::shared_ptr<EventSession> session = hub.openSession();
+    drain(*session);
+    hub.subscribe(session->id(), STATE_URI);
+
+    const int CHANGES = 20000;
+    std::thread device([&hub] {
+        for (int i = 0; i < CHANGES; i++) {
+            hub.notifyUpdated(STATE_URI);
+        }
+    });
+    size_t events = 0;
+    for (int i = 0; i < 1000; i++) {
+        events += count(drain(*session), "resources/updated");
+    }
+    device.join();
+    events += count(drain(*session), "resources/updated");
+
+    // At least one event after the last change, never more than one per change
+    TEST_ASSERT_GREATER_OR_EQUAL(1, events);
+    TEST_ASSERT_LESS_OR_EQUAL(CHANGES, events);
+    TEST_ASSERT_EQUAL_STRING("", drain(*session).c_str());
+}
+
+// Cost of one state change for the mutating call, with every session
+// subscribed: the fan-out is left to the readers
+void test_notify_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int CHANGES = 100000;
+
+    ResourceHub hub;
+    addState(hub);
+    std::vector<std::shared_ptr<EventSession>> sessions;
+    for (size_t i = 0; i < ResourceHub::MAX_SESSIONS; i++) {
+        sessions.push_back(hub.openSession());
+        drain(*sessions.back());
+        hub.subscribe(sessions.back()->id(), STATE_URI);
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < CHANGES; i++) {
+        hub.notifyUpdated(STATE_URI);
+    }
+    double notifyNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / CHANGES;
+
+    size_t bytes = 0;
+    start = Clock::now();
+    for (const std::shared_ptr<EventSession>& session : sessions) {
+        bytes += drain(*session).size();
+    }
+    double fanOutUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "notifyUpdated: %.0f ns per change with %u subscribers; fan-out on read: %.1f us, %u bytes",
+             notifyNs, static_cast<unsigned>(sessions.size()), fanOutUs, static_cast<unsigned>(bytes));
+    TEST_MESSAGE(msg);
+    for (const std::shared_ptr<EventSession>& session : sessions) {
+        TEST_ASSERT_EQUAL(1, session->eventCount());
+    }
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_event_names_endpoint);
+    RUN_TEST(test_subscriber_notified_once_per_read);
+    RUN_TEST(test_keepalive_when_idle);
+    RUN_TEST(test_sessions_end_with_transport);
+    RUN_TEST(test_session_ids_from_source);
+    RUN_TEST(test_changes_wake_subscribed_streams);
+    RUN_TEST(test_dispatcher_resources);
+    RUN_TEST(test_notify_while_reading);
+    RUN_TEST(test_notify_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,257 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "AllocTracker.h"
+#include "McpDispatcher.h"
+#include "ResponseBody.h"
+#include "ToolRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace mcp;
+
+// Typical AsyncTCP send buffer: one TCP segment
+static const size_t CHUNK_SIZE = 1436;
+
+static std::string readAll(const McpResponse& response, size_t chunkSize, size_t* chunks = nullptr) {
+    std::string out;
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[chunkSize]);
+    size_t read;
+    size_t count = 0;
+    while ((read = response.read(buffer.get(), chunkSize, out.size())) > 0) {
+        TEST_ASSERT_LESS_OR_EQUAL(chunkSize, read);
+        out.append(reinterpret_cast<const char*>(buffer.get()), read);
+        count++;
+    }
+    if (chunks) {
+        *chunks = count;
+    }
+    return out;
+}
+
+static void addTool(ToolRegistry& registry, const char* name, SimpleToolHandler::HandlerFunc func) {
+    ToolDefinition tool;
+    tool.name = name;
+    tool.description = name;
+    tool.params.push_back(ToolParam{"count", "number", "Number of samples", false});
+    tool.handler = std::make_shared<SimpleToolHandler>(std::move(func));
+    registry.addTool(std::move(tool));
+}
+
+// A metric history: the kind of result that gets large
+static void writeHistory(JsonVariantConst params, JsonDocument& result) {
+    int count = params["count"] | 10;
+    result["metric"] = "system.heap.free";
+    result["note"] = "quoted \"text\", a back\\slash and a\nnewline";
+    JsonArray samples = result["samples"].to<JsonArray>();
+    for (int i = 0; i < count; i++) {
+        JsonObject sample = samples.add<JsonObject>();
+        sample["t"] = 1700000000 + i * 5;
+        sample["v"] = 180000 - (i * 37) % 5000;
+    }
+}
+
+static std::string call(int id, const char* tool, int count) {
+    return std::string("{\"jsonrpc\":\"2.0\",\"id\":") + std::to_string(id) +
+           ",\"method\":\"tools/call\",\"params\":{\"name\":\"" + tool +
+           "\",\"arguments\":{\"count\":" + std::to_string(count) + "}}}";
+}
+
+void setUp(void) {
+    AllocTracker::getInstance().reset();
+}
+
+void tearDown(void) {
+}
+
+void test_window_matches_serialize() {
+    JsonDocument doc;
+    writeHistory(JsonVariantConst(), doc);
+    std::string expected;
+    serializeJson(doc, expected);
+
+    for (size_t size : {1, 7, 64, 1000}) {
+        std::string out;
+        uint8_t buffer[1000];
+        for (;;) {
+            ChunkWindow window(buffer, size, out.size());
+            serializeJson(doc, window);
+            if (window.filled() == 0) {
+                break;
+            }
+            out.append(reinterpret_cast<const char*>(buffer), window.filled());
+        }
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), out.c_str());
+    }
+}
+
+void test_escaping_matches_string_value() {
+    JsonDocument doc;
+    writeHistory(JsonVariantConst(), doc);
+    doc["control"] = std::string("tab\there, bell\x07");
+    std::string text;
+    serializeJson(doc, text);
+
+    // serializeJson's escaping of the text as a string value...
+    JsonDocument wrapper;
+    wrapper.set(text);
+    std::string expected;
+    serializeJson(wrapper, expected);
+
+    // ...matches escaping it on the fly
+    std::string escaped = "\"";
+    struct StringWriter {
+        std::string& out;
+        size_t write(uint8_t c) { out += static_cast<char>(c); return 1; }
+        size_t write(const uint8_t* data, size_t length) { out.append(reinterpret_cast<const char*>(data), length); return length; }
+    } sink{escaped};
+    EscapingWriter<StringWriter> writer(sink);
+    serializeJson(doc, writer);
+    escaped += '"';
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), escaped.c_str());
+}
+
+void test_streamed_replies_match_serialized() {
+    ToolRegistry registry;
+    addTool(registry, "history", writeHistory);
+    McpDispatcher serialized(registry, "test", "1.0");
+    McpDispatcher streamed(registry, "test", "1.0");
+    streamed.setStreaming(true);
+
+    const std::string bodies[] = {
+        call(1, "history", 3),
+        call(2, "history", 200),
+        call(3, "missing", 1),
+        "{\"jsonrpc\":\"2.0\",\"id\":\"list\",\"method\":\"tools/list\"}",
+        "{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"ping\"}",
+        "[" + call(5, "history", 2) + "," + call(6, "history", 1) + "]",
+    };
+    for (const std::string& body : bodies) {
+        McpResponse expected = serialized.handle(body.c_str(), body.size());
+        McpResponse actual = streamed.handle(body.c_str(), body.size());
+        TEST_ASSERT_FALSE(expected.stream != nullptr);
+        TEST_ASSERT_EQUAL(expected.status, actual.status);
+        TEST_ASSERT_EQUAL_STRING(expected.etag.c_str(), actual.etag.c_str());
+        TEST_ASSERT_EQUAL_STRING(expected.body.c_str(), readAll(actual, 100).c_str());
+        TEST_ASSERT_EQUAL_STRING(expected.body.c_str(), readAll(actual, ToolCallBody::READ_AHEAD + 1).c_str());
+        TEST_ASSERT_EQUAL_STRING(expected.body.c_str(), actual.text().c_str());
+    }
+
+    // Only single tools/call and tools/list replies stream
+    McpResponse list = streamed.handle(bodies[3].c_str(), bodies[3].size());
+    TEST_ASSERT_TRUE(list.stream != nullptr);
+    McpResponse batch = streamed.handle(bodies[5].c_str(), bodies[5].size());
+    TEST_ASSERT_TRUE(batch.stream == nullptr);
+
+    // Notifications still run and still get no body
+    std::string notification = "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"params\":{\"name\":\"history\"}}";
+    McpResponse none = streamed.handle(notification.c_str(), notification.size());
+    TEST_ASSERT_EQUAL(202, none.status);
+    TEST_ASSERT_FALSE(none.hasBody());
+}
+
+void test_output_arena_held_until_sent() {
+    ToolRegistry registry;
+    addTool(registry, "history", writeHistory);
+    JsonArenaPool pool(4, 2048);
+    McpDispatcher dispatcher(registry, "test", "1.0");
+    dispatcher.setArenaPool(&pool);
+    dispatcher.setStreaming(true);
+
+    std::string body = call(1, "history", 5);
+    {
+        McpResponse response = dispatcher.handle(body.c_str(), body.size());
+        TEST_ASSERT_EQUAL(3, pool.getStats().available);   // The body's arena
+        TEST_ASSERT_TRUE(readAll(response, CHUNK_SIZE).find("\\\"samples\\\"") != std::string::npos);
+    }
+    TEST_ASSERT_EQUAL(4, pool.getStats().available);
+}
+
+// A 2000-sample history: serialized reply vs one reply streamed through a
+// fixed chunk buffer
+void test_streaming_memory_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int SAMPLES = 2000;
+
+    ToolRegistry registry;
+    addTool(registry, "history", writeHistory);
+    McpDispatcher serialized(registry, "test", "1.0");
+    McpDispatcher streamed(registry, "test", "1.0");
+    streamed.setStreaming(true);
+    std::string body = call(1, "history", SAMPLES);
+
+    uint32_t serializedBytes;
+    size_t payload;
+    Clock::time_point start = Clock::now();
+    {
+        AllocScope scope("test.serialized");
+        McpResponse response = serialized.handle(body.c_str(), body.size());
+        payload = response.body.size();
+        serializedBytes = scope.bytes();
+    }
+    double serializedUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    uint32_t streamedBytes;
+    size_t chunks;
+    size_t streamedSize;
+    uint32_t refills;
+    start = Clock::now();
+    {
+        AllocScope scope("test.streamed");
+        McpResponse response = streamed.handle(body.c_str(), body.size());
+        static uint8_t buffer[CHUNK_SIZE];
+        size_t read;
+        chunks = 0;
+        streamedSize = 0;
+        while ((read = response.read(buffer, sizeof(buffer), streamedSize)) > 0) {
+            streamedSize += read;
+            chunks++;
+        }
+        streamedBytes = scope.bytes();
+        refills = static_cast<ToolCallBody*>(response.stream.get())->refills();
+    }
+    double streamedUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    char msg[240];
+    snprintf(msg, sizeof(msg),
+             "%u byte reply: serialized %u bytes allocated, %.0f us; streamed in %u x %u byte chunks "
+             "(%u serializer passes), %u bytes allocated, %.0f us",
+             static_cast<unsigned>(payload), serializedBytes, serializedUs,
+             static_cast<unsigned>(chunks), static_cast<unsigned>(CHUNK_SIZE), refills, streamedBytes, streamedUs);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL(payload, streamedSize);
+    if (AllocTracker::isCompiledIn()) {
+        // The serialized path holds the text and the reply, each about the payload size
+        TEST_ASSERT_GREATER_THAN(payload * 2, serializedBytes);
+        TEST_ASSERT_LESS_THAN(payload, streamedBytes);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(payload / ToolCallBody::READ_AHEAD + 1, refills);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_window_matches_serialize);
+    RUN_TEST(test_escaping_matches_string_value);
+    RUN_TEST(test_streamed_replies_match_serialized);
+    RUN_TEST(test_output_arena_held_until_sent);
+    RUN_TEST(test_streaming_memory_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
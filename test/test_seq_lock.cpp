@@ -0,0 +1,211 @@
+#include <unity.h>
+#include "SeqLock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+// Fields written together; a torn read breaks the relation between them
+struct Snapshot {
+    bool running;
+    int mode;
+    int temperature;
+    uint32_t version;
+};
+
+static Snapshot make(uint32_t version) {
+    return Snapshot{(version & 1) != 0, static_cast<int>(version % 4), 16 + static_cast<int>(version % 15), version};
+}
+
+static bool consistent(const Snapshot& s) {
+    Snapshot expected = make(s.version);
+    return s.running == expected.running && s.mode == expected.mode && s.temperature == expected.temperature;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_store_and_load() {
+    SeqLock<Snapshot> lock(make(0));
+    TEST_ASSERT_EQUAL(2, lock.version());
+    TEST_ASSERT_TRUE(consistent(lock.load()));
+
+    lock.store(make(41));
+    Snapshot read = lock.load();
+    TEST_ASSERT_EQUAL(41, read.version);
+    TEST_ASSERT_TRUE(read.running);
+    TEST_ASSERT_EQUAL(1, read.mode);
+    TEST_ASSERT_EQUAL(4, lock.version());
+
+    // Odd-sized values are padded to whole words
+    struct Text {
+        char bytes[5];
+    };
+    SeqLock<Text> text;
+    Text hello = {{'h', 'e', 'l', 'l', 'o'}};
+    text.store(hello);
+    Text copy;
+    TEST_ASSERT_TRUE(text.tryLoad(copy, 1));
+    TEST_ASSERT_EQUAL_MEMORY(hello.bytes, copy.bytes, 5);
+}
+
+// Writers serialize on a mutex as AirConditioner's do; readers check every
+// copy they get and that versions never go backwards
+void test_stress_readers_and_writers() {
+    const int WRITERS = 2;
+    const int READERS = 4;
+    const uint32_t STORES = 200000;
+
+    SeqLock<Snapshot> lock(make(0));
+    std::mutex writerMutex;
+    uint32_t nextVersion = 1;
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> reads(0);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> backwards(0);
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < READERS; r++) {
+        threads.emplace_back([&] {
+            uint32_t last = 0;
+            uint64_t count = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                Snapshot s = lock.load();
+                torn += consistent(s) ? 0 : 1;
+                backwards += s.version < last ? 1 : 0;
+                last = s.version;
+                count++;
+            }
+            reads += count;
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; w++) {
+        writers.emplace_back([&] {
+            for (uint32_t i = 0; i < STORES / WRITERS; i++) {
+                std::lock_guard<std::mutex> guard(writerMutex);
+                lock.store(make(nextVersion++));
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    done.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u stores from %d writers, %llu reads from %d readers: %u torn, %u out of order",
+             static_cast<unsigned>(STORES), WRITERS, static_cast<unsigned long long>(reads.load()), READERS,
+             static_cast<unsigned>(torn.load()), static_cast<unsigned>(backwards.load()));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(0, torn.load());
+    TEST_ASSERT_EQUAL(0, backwards.load());
+    TEST_ASSERT_EQUAL(STORES, lock.load().version);
+}
+
+void test_try_load_during_stores() {
+    SeqLock<Snapshot> lock(make(0));
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> failed(0);
+    std::atomic<uint32_t> succeeded(0);
+
+    std::thread writer([&] {
+        for (uint32_t i = 1; i <= 200000; i++) {
+            lock.store(make(i));
+        }
+        done.store(true);
+    });
+    while (!done.load()) {
+        Snapshot s;
+        if (lock.tryLoad(s, 1)) {
+            succeeded++;
+            TEST_ASSERT_TRUE(consistent(s));
+        } else {
+            failed++;
+        }
+    }
+    writer.join();
+
+    // Single attempts either fail or hand out a whole value, never a torn one
+    Snapshot s;
+    TEST_ASSERT_TRUE(lock.tryLoad(s, 1));
+    TEST_ASSERT_EQUAL(200000, s.version);
+    TEST_ASSERT_GREATER_THAN(0, succeeded.load());
+}
+
+// Read cost with a writer storing continuously: seqlock copy vs taking
+// the writers' mutex, which is what every reader paid before
+void test_read_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int READS = 1000000;
+
+    SeqLock<Snapshot> lock(make(0));
+    std::mutex writerMutex;
+    Snapshot plain = make(0);
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+        uint32_t version = 1;
+        while (!done.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> guard(writerMutex);
+            plain = make(version);
+            lock.store(make(version));
+            version++;
+        }
+    });
+
+    uint32_t sum = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < READS; i++) {
+        sum += lock.load().version & 1;
+    }
+    double seqNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / READS;
+
+    start = Clock::now();
+    for (int i = 0; i < READS; i++) {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        sum += plain.version & 1;
+    }
+    double mutexNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / READS;
+    done.store(true);
+    writer.join();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "read under write load: seqlock %.0f ns, mutex %.0f ns (checksum %u)",
+             seqNs, mutexNs, static_cast<unsigned>(sum & 1));
+    TEST_MESSAGE(msg);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_store_and_load);
+    RUN_TEST(test_stress_readers_and_writers);
+    RUN_TEST(test_try_load_during_stores);
+    RUN_TEST(test_read_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,167 @@
+#include <unity.h>
+#include "SpanTracer.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+using namespace mcp;
+
+void setUp(void) {
+    SpanTracer::getInstance().setEnabled(true);
+    SpanTracer::getInstance().clear();
+}
+
+void tearDown(void) {
+}
+
+void test_span_nesting() {
+    {
+        TRACE_SPAN("outer");
+        {
+            TraceSpan inner("inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    std::vector<SpanRecord> spans;
+    TEST_ASSERT_EQUAL(2, SpanTracer::getInstance().snapshot(spans));
+
+    // Inner span closes first
+    TEST_ASSERT_EQUAL_STRING("inner", spans[0].name);
+    TEST_ASSERT_EQUAL(1, spans[0].depth);
+    TEST_ASSERT_EQUAL_STRING("outer", spans[1].name);
+    TEST_ASSERT_EQUAL(0, spans[1].depth);
+
+    // Inner span lies within the outer one
+    TEST_ASSERT_TRUE(spans[0].start >= spans[1].start);
+    TEST_ASSERT_TRUE(spans[0].start + spans[0].duration <= spans[1].start + spans[1].duration);
+    TEST_ASSERT_GREATER_OR_EQUAL(2000, spans[0].duration);
+}
+
+void test_span_ring_wraps() {
+    SpanTracer& tracer = SpanTracer::getInstance();
+    for (size_t i = 0; i < SpanTracer::CAPACITY + 10; i++) {
+        tracer.record("wrap", i, i + 1, 0);
+    }
+
+    std::vector<SpanRecord> spans;
+    TEST_ASSERT_EQUAL(SpanTracer::CAPACITY, tracer.snapshot(spans));
+    TEST_ASSERT_EQUAL(SpanTracer::CAPACITY + 10, tracer.totalRecorded());
+    // Oldest surviving span is the 11th one recorded
+    TEST_ASSERT_EQUAL(10, spans.front().start);
+    TEST_ASSERT_EQUAL(SpanTracer::CAPACITY + 9, spans.back().start);
+}
+
+void test_spans_in_one_scope() {
+    {
+        TRACE_SPAN("first");
+        TRACE_SPAN("second");
+    }
+    std::vector<SpanRecord> spans;
+    TEST_ASSERT_EQUAL(2, SpanTracer::getInstance().snapshot(spans));
+    TEST_ASSERT_EQUAL_STRING("second", spans[0].name);
+    TEST_ASSERT_EQUAL(1, spans[0].depth);
+    TEST_ASSERT_EQUAL_STRING("first", spans[1].name);
+}
+
+void test_span_disabled() {
+    SpanTracer::getInstance().setEnabled(false);
+    {
+        TRACE_SPAN("ignored");
+    }
+    std::vector<SpanRecord> spans;
+    TEST_ASSERT_EQUAL(0, SpanTracer::getInstance().snapshot(spans));
+}
+
+void test_chrome_trace_export() {
+    {
+        TRACE_SPAN("tool.setMode");
+        TraceSpan lcd("lcd.\"refresh\"");
+    }
+
+    std::string json;
+    size_t count = SpanTracer::getInstance().exportChromeTrace([&json](const char* data, size_t len) {
+        json.append(data, len);
+    });
+
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT_EQUAL(0, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    TEST_ASSERT_TRUE(json.find("\"name\":\"tool.setMode\",\"ph\":\"X\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("lcd.\\\"refresh\\\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"depth\":1") != std::string::npos);
+    TEST_ASSERT_EQUAL(json.size() - 2, json.rfind("]}"));
+}
+
+void test_concurrent_spans() {
+    const int THREADS = 4;
+    const int SPANS_PER_THREAD = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < SPANS_PER_THREAD; i++) {
+                TRACE_SPAN("worker");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    TEST_ASSERT_EQUAL(THREADS * SPANS_PER_THREAD, SpanTracer::getInstance().totalRecorded());
+
+    std::vector<SpanRecord> spans;
+    SpanTracer::getInstance().snapshot(spans);
+    TEST_ASSERT_EQUAL(SpanTracer::CAPACITY, spans.size());
+    for (const auto& span : spans) {
+        TEST_ASSERT_EQUAL_STRING("worker", span.name);
+    }
+}
+
+void test_span_overhead() {
+    const int ITERATIONS = 200000;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        TRACE_SPAN("bench");
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    double perSpanNs = std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "span overhead: %.1f ns/span (%d spans)", perSpanNs, ITERATIONS);
+    TEST_MESSAGE(msg);
+
+    // Generous bound so the check stays stable on loaded CI hosts
+    TEST_ASSERT_LESS_THAN(2000.0, perSpanNs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_span_nesting);
+    RUN_TEST(test_span_ring_wraps);
+    RUN_TEST(test_spans_in_one_scope);
+    RUN_TEST(test_span_disabled);
+    RUN_TEST(test_chrome_trace_export);
+    RUN_TEST(test_concurrent_spans);
+    RUN_TEST(test_span_overhead);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
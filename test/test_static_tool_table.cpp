@@ -0,0 +1,200 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "StaticToolTable.h"
+#include "ToolRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mcp;
+
+static constexpr const char* AC_NAMES[] = {
+    "turnOn", "turnOff", "setMode", "setTemperature", "getStatus"
+};
+static constexpr StaticToolTable<5> AC_TABLE(AC_NAMES);
+
+// Resolved entirely by the compiler
+static_assert(AC_TABLE.valid(), "AC tool names must be unique");
+static_assert(AC_TABLE.find("setTemperature") == 3, "perfect hash lookup");
+static_assert(AC_TABLE.find("setTemp") == -1, "unknown names miss");
+
+static ToolDefinition makeTool(const std::string& name, int* calls) {
+    ToolDefinition tool;
+    tool.name = name;
+    tool.description = "test";
+    tool.handler = std::make_shared<SimpleToolHandler>([calls](JsonVariantConst, JsonDocument&) {
+        (*calls)++;
+    });
+    return tool;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_static_table_finds_every_name() {
+    for (size_t i = 0; i < AC_TABLE.size(); i++) {
+        TEST_ASSERT_EQUAL((int)i, AC_TABLE.find(AC_NAMES[i]));
+    }
+    TEST_ASSERT_EQUAL(-1, AC_TABLE.find(""));
+    TEST_ASSERT_EQUAL(-1, AC_TABLE.find("turnon"));
+    TEST_ASSERT_EQUAL(-1, AC_TABLE.find(nullptr));
+}
+
+void test_static_table_rejects_duplicates() {
+    static const char* names[] = {"a", "b", "a"};
+    StaticToolTable<3> table(names);
+    TEST_ASSERT_FALSE(table.valid());
+    TEST_ASSERT_EQUAL(-1, table.find("b"));
+}
+
+void test_static_table_large_runtime_build() {
+    std::vector<std::string> storage;
+    for (int i = 0; i < 1000; i++) {
+        storage.push_back("device" + std::to_string(i / 10) + ".tool" + std::to_string(i % 10));
+    }
+    static const char* names[1000];
+    for (int i = 0; i < 1000; i++) {
+        names[i] = storage[i].c_str();
+    }
+    std::unique_ptr<StaticToolTable<1000>> table(new StaticToolTable<1000>(names));
+    TEST_ASSERT_TRUE(table->valid());
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL(i, table->find(storage[i].c_str()));
+    }
+    TEST_ASSERT_EQUAL(-1, table->find("device100.tool0"));
+}
+
+void test_registry_static_and_dynamic_lookup() {
+    int calls = 0;
+    ToolRegistry registry;
+    registry.setStaticTable(AC_TABLE);
+    registry.addTool(makeTool("setMode", &calls));
+    registry.addTool(makeTool("bedroom.setMode", &calls));   // Not in the static table
+
+    JsonDocument result;
+    TEST_ASSERT_TRUE(registry.callTool("setMode", JsonVariantConst(), result));
+    TEST_ASSERT_TRUE(registry.callTool("bedroom.setMode", JsonVariantConst(), result));
+    TEST_ASSERT_EQUAL(2, calls);
+
+    // Known to the static table but not registered
+    TEST_ASSERT_FALSE(registry.callTool("turnOn", JsonVariantConst(), result));
+    TEST_ASSERT_FALSE(registry.callTool("kitchen.setMode", JsonVariantConst(), result));
+
+    TEST_ASSERT_TRUE(registry.removeTool("setMode"));
+    TEST_ASSERT_FALSE(registry.hasTool("setMode"));
+    TEST_ASSERT_TRUE(registry.hasTool("bedroom.setMode"));
+}
+
+static double nsPerLookup(const std::vector<std::string>& queries, int rounds,
+                          const std::function<bool(const char*)>& lookup) {
+    using Clock = std::chrono::steady_clock;
+    size_t found = 0;
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const auto& query : queries) {
+            found += lookup(query.c_str());
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    TEST_ASSERT_EQUAL(queries.size() * rounds, found);
+    return ns / (queries.size() * rounds);
+}
+
+template<size_t N>
+static void benchmarkDispatch() {
+    std::vector<std::string> storage;
+    for (size_t i = 0; i < N; i++) {
+        storage.push_back("device" + std::to_string(i / 5) + "." + AC_NAMES[i % 5]);
+    }
+    static const char* names[N];
+    for (size_t i = 0; i < N; i++) {
+        names[i] = storage[i].c_str();
+    }
+    std::unique_ptr<StaticToolTable<N>> table(new StaticToolTable<N>(names));
+    TEST_ASSERT_TRUE(table->valid());
+
+    std::unordered_map<std::string, size_t> map;
+    for (size_t i = 0; i < N; i++) {
+        map[storage[i]] = i;
+    }
+
+    int calls = 0;
+    ToolRegistry dynamicRegistry;
+    ToolRegistry staticRegistry;
+    staticRegistry.setStaticTable(*table);
+    for (size_t i = 0; i < N; i++) {
+        dynamicRegistry.addTool(makeTool(storage[i], &calls));
+        staticRegistry.addTool(makeTool(storage[i], &calls));
+    }
+
+    const int rounds = 100000 / N;
+    double linear = nsPerLookup(storage, rounds, [&](const char* name) {
+        for (size_t i = 0; i < N; i++) {
+            if (strcmp(names[i], name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    });
+    double unordered = nsPerLookup(storage, rounds, [&](const char* name) {
+        return map.find(name) != map.end();
+    });
+    double perfect = nsPerLookup(storage, rounds, [&](const char* name) {
+        return table->find(name) >= 0;
+    });
+    double registryDynamic = nsPerLookup(storage, rounds, [&](const char* name) {
+        return dynamicRegistry.hasTool(name);
+    });
+    double registryStatic = nsPerLookup(storage, rounds, [&](const char* name) {
+        return staticRegistry.hasTool(name);
+    });
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%4zu tools: linear %.0f ns, unordered_map %.0f ns, perfect hash %.0f ns, "
+             "registry dynamic %.0f ns, registry static %.0f ns",
+             N, linear, unordered, perfect, registryDynamic, registryStatic);
+    TEST_MESSAGE(msg);
+    if (N >= 100) {
+        TEST_ASSERT_LESS_THAN(linear, perfect);
+    }
+}
+
+void test_dispatch_benchmark() {
+    benchmarkDispatch<10>();
+    benchmarkDispatch<100>();
+    benchmarkDispatch<1000>();
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_static_table_finds_every_name);
+    RUN_TEST(test_static_table_rejects_duplicates);
+    RUN_TEST(test_static_table_large_runtime_build);
+    RUN_TEST(test_registry_static_and_dynamic_lookup);
+    RUN_TEST(test_dispatch_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
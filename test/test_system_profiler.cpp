@@ -0,0 +1,203 @@
+#include <unity.h>
+#include "SystemProfiler.h"
+#include <map>
+#include <string>
+
+using namespace mcp;
+
+static std::map<std::string, double> gauges;
+
+static void recordGauge(const char* name, double value) {
+    gauges[name] = value;
+}
+
+void setUp(void) {
+    gauges.clear();
+}
+
+void tearDown(void) {
+}
+
+void test_profiler_task_cpu_share() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+
+    source.setTask(1, "IDLE0", 0, 900);
+    source.setTask(2, "loopTask", 0, 2048);
+    source.setTotalRuntime(1000);
+    profiler.sample();
+
+    // First sample has no baseline: only stack watermarks are published
+    TEST_ASSERT_TRUE(gauges.count("system.task.loopTask.stack") == 1);
+    TEST_ASSERT_TRUE(gauges.count("system.task.loopTask.cpu") == 0);
+    TEST_ASSERT_EQUAL_FLOAT(2048, gauges["system.task.loopTask.stack"]);
+
+    source.setTask(1, "IDLE0", 750, 900);
+    source.setTask(2, "loopTask", 250, 1900);
+    source.setTotalRuntime(2000);
+    profiler.sample();
+
+    TEST_ASSERT_EQUAL_FLOAT(75.0, gauges["system.task.IDLE0.cpu"]);
+    TEST_ASSERT_EQUAL_FLOAT(25.0, gauges["system.task.loopTask.cpu"]);
+    TEST_ASSERT_EQUAL_FLOAT(1900, gauges["system.task.loopTask.stack"]);
+
+    std::vector<SystemProfiler::TaskUsage> usage = profiler.getTaskUsage();
+    TEST_ASSERT_EQUAL(2, usage.size());
+    TEST_ASSERT_EQUAL_STRING("IDLE0", usage[0].name);   // Busiest first
+}
+
+void test_profiler_counter_wrap() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+
+    source.setTask(1, "worker", 0xFFFFFF00u, 1024);
+    source.setTotalRuntime(0xFFFFFF00u);
+    profiler.sample();
+
+    // Both counters wrap past zero between samples
+    source.setTask(1, "worker", 0x00000032u, 1024);
+    source.setTotalRuntime(0x00000064u);
+    profiler.sample();
+
+    // worker ran 0x132 of 0x164 ticks
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 100.0 * 0x132 / 0x164, gauges["system.task.worker.cpu"]);
+}
+
+void test_profiler_heap_fragmentation() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+
+    source.setHeap({200000, 150000, 50000, 0, 0});
+    profiler.sample();
+
+    TEST_ASSERT_EQUAL_FLOAT(0.75, profiler.getFragmentation());
+    TEST_ASSERT_EQUAL_FLOAT(0.75, gauges["system.heap.fragmentation"]);
+    TEST_ASSERT_EQUAL_FLOAT(50000, gauges["system.heap.largest_block"]);
+    // No PSRAM fitted
+    TEST_ASSERT_TRUE(gauges.count("system.psram.used") == 0);
+
+    source.setHeap({200000, 150000, 200000, 8 * 1024 * 1024, 6 * 1024 * 1024});
+    profiler.sample();
+    TEST_ASSERT_EQUAL_FLOAT(0.0, gauges["system.heap.fragmentation"]);
+    TEST_ASSERT_EQUAL_FLOAT(2 * 1024 * 1024, gauges["system.psram.used"]);
+    TEST_ASSERT_EQUAL_FLOAT(6 * 1024 * 1024, gauges["system.psram.free"]);
+}
+
+void test_profiler_loop_latency() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+
+    profiler.recordLoopIteration(100);
+    profiler.recordLoopIteration(300);
+    profiler.sample();
+
+    TEST_ASSERT_EQUAL_FLOAT(200.0, gauges["system.loop.latency.avg"]);
+    TEST_ASSERT_EQUAL_FLOAT(300.0, gauges["system.loop.latency.max"]);
+
+    // Latency is reset after each sample
+    gauges.clear();
+    profiler.sample();
+    TEST_ASSERT_TRUE(gauges.count("system.loop.latency.avg") == 0);
+}
+
+void test_profiler_fixed_cadence() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+    profiler.setInterval(1000);
+
+    int samples = 0;
+    for (uint64_t now = 0; now < 10000; now += 100) {
+        if (profiler.tick(now)) {
+            samples++;
+        }
+    }
+    TEST_ASSERT_EQUAL(10, samples);
+}
+
+void test_profiler_bounded_task_gauges() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+
+    char name[16];
+    for (uint32_t i = 0; i < SystemProfiler::MAX_TRACKED_TASKS + 8; i++) {
+        snprintf(name, sizeof(name), "task%u", i);
+        source.setTask(i, name, 0, 512);
+    }
+    source.setTotalRuntime(1);
+    profiler.sample();
+
+    size_t stackGauges = 0;
+    for (const auto& gauge : gauges) {
+        if (gauge.first.find(".stack") != std::string::npos) {
+            stackGauges++;
+        }
+    }
+    TEST_ASSERT_EQUAL(SystemProfiler::MAX_TRACKED_TASKS, stackGauges);
+}
+
+// Collectors publish their own counters through the profiler's sink, once per sample
+void test_profiler_runs_collectors() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+    uint32_t events = 0;
+    profiler.addCollector([&events](const SystemProfiler::GaugeSink& sink) {
+        sink("test.events", events);
+    });
+
+    events = 41;
+    profiler.sample();
+    TEST_ASSERT_EQUAL_FLOAT(41, gauges["test.events"]);
+    events++;
+    TEST_ASSERT_EQUAL_FLOAT(41, gauges["test.events"]);
+    profiler.sample();
+    TEST_ASSERT_EQUAL_FLOAT(42, gauges["test.events"]);
+}
+
+// Nothing is locked while collectors run: a collector may touch the
+// profiler, and the main loop keeps recording meanwhile
+void test_profiler_publishes_unlocked() {
+    HostStatsSource source;
+    SystemProfiler profiler(source, recordGauge);
+    profiler.addCollector([&profiler](const SystemProfiler::GaugeSink& sink) {
+        profiler.recordLoopIteration(500);
+        sink("test.fragmentation", profiler.getFragmentation());
+    });
+
+    profiler.recordLoopIteration(100);
+    profiler.sample();
+    TEST_ASSERT_EQUAL_FLOAT(100, gauges["system.loop.latency.max"]);
+    TEST_ASSERT_EQUAL(1, static_cast<int>(gauges.count("test.fragmentation")));
+
+    // The iteration recorded during the sample lands in the next window
+    profiler.sample();
+    TEST_ASSERT_EQUAL_FLOAT(500, gauges["system.loop.latency.max"]);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_profiler_task_cpu_share);
+    RUN_TEST(test_profiler_counter_wrap);
+    RUN_TEST(test_profiler_heap_fragmentation);
+    RUN_TEST(test_profiler_loop_latency);
+    RUN_TEST(test_profiler_fixed_cadence);
+    RUN_TEST(test_profiler_bounded_task_gauges);
+    RUN_TEST(test_profiler_runs_collectors);
+    RUN_TEST(test_profiler_publishes_unlocked);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,215 @@
+#include <unity.h>
+#include "TimerWheel.h"
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace mcp;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Delays on both sides of every level boundary, starting just before the
+// 32-bit tick counter wraps
+void test_fires_exactly_at_expiry() {
+    const uint32_t start = 0xFFFFF000u;
+    const uint32_t delays[] = {1, 2, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 262145,
+                               TimerWheel::MAX_DELAY, TimerWheel::MAX_DELAY + 1, TimerWheel::MAX_DELAY + 70000};
+    const size_t count = sizeof(delays) / sizeof(delays[0]);
+
+    TimerWheel wheel(32, start);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(wheel.schedule(start + delays[i], static_cast<uint32_t>(i)) != TimerWheel::INVALID);
+    }
+
+    std::vector<uint32_t> firedAt(count, 0);
+    size_t fired = 0;
+    uint32_t last = start + delays[count - 1];
+    fired += wheel.advance(last, [&](TimerWheel::TimerId, uint32_t payload) {
+        firedAt[payload] = wheel.now();
+    });
+    TEST_ASSERT_EQUAL(count, fired);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(start + delays[i], firedAt[i]);
+    }
+    TEST_ASSERT_EQUAL(0, wheel.size());
+}
+
+// Random schedules, cancels and steps checked against an ordered map
+void test_matches_reference_model() {
+    std::mt19937 random(7);
+    TimerWheel wheel(4096, 1000);
+    std::multimap<uint32_t, uint32_t> reference;   // expiry -> payload
+    std::map<uint32_t, TimerWheel::TimerId> handles;
+    std::map<uint32_t, uint32_t> expiries;
+    uint32_t nextPayload = 0;
+    uint32_t mismatches = 0;
+    size_t fired = 0;
+
+    for (int round = 0; round < 2000; round++) {
+        for (int i = 0; i < 3 && wheel.size() < wheel.capacity(); i++) {
+            uint32_t delay = random() % 4 == 0 ? random() % 300000 : random() % 5000;
+            uint32_t expiry = wheel.now() + delay;
+            uint32_t payload = nextPayload++;
+            handles[payload] = wheel.schedule(expiry, payload);
+            expiries[payload] = expiry;
+            reference.emplace(expiry, payload);
+        }
+        if (!handles.empty() && random() % 2 == 0) {
+            auto victim = handles.begin();
+            std::advance(victim, random() % handles.size());
+            TEST_ASSERT_TRUE(wheel.cancel(victim->second));
+            auto range = reference.equal_range(expiries[victim->first]);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == victim->first) {
+                    reference.erase(it);
+                    break;
+                }
+            }
+            handles.erase(victim);
+        }
+
+        uint32_t target = wheel.now() + random() % 400;
+        fired += wheel.advance(target, [&](TimerWheel::TimerId id, uint32_t payload) {
+            auto expected = reference.begin();
+            mismatches += (expected != reference.end() && expected->first == wheel.now() &&
+                           expiries[payload] == wheel.now() && handles[payload] == id) ? 0 : 1;
+            // Same-tick timers may fire in any order
+            auto range = reference.equal_range(wheel.now());
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == payload) {
+                    reference.erase(it);
+                    break;
+                }
+            }
+            handles.erase(payload);
+        });
+        mismatches += (!reference.empty() && reference.begin()->first <= wheel.now()) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT_EQUAL(reference.size(), wheel.size());
+    TEST_ASSERT_GREATER_THAN(1000, fired);
+}
+
+void test_cancel_and_stale_handles() {
+    TimerWheel wheel(2, 0);
+    TimerWheel::TimerId a = wheel.schedule(10, 1);
+    TimerWheel::TimerId b = wheel.schedule(5000, 2);
+    TEST_ASSERT_TRUE(wheel.pending(a));
+    TEST_ASSERT_EQUAL(TimerWheel::INVALID, wheel.schedule(20, 3));
+
+    TEST_ASSERT_TRUE(wheel.cancel(b));
+    TEST_ASSERT_FALSE(wheel.cancel(b));
+    TEST_ASSERT_FALSE(wheel.pending(b));
+
+    // The freed timer is reused under a new handle; the old one stays dead
+    TimerWheel::TimerId c = wheel.schedule(20, 3);
+    TEST_ASSERT_TRUE(c != b);
+    TEST_ASSERT_FALSE(wheel.cancel(b));
+    TEST_ASSERT_TRUE(wheel.pending(c));
+
+    std::vector<uint32_t> fired;
+    wheel.advance(100, [&](TimerWheel::TimerId, uint32_t payload) { fired.push_back(payload); });
+    TEST_ASSERT_EQUAL(2, fired.size());
+    TEST_ASSERT_EQUAL(1, fired[0]);
+    TEST_ASSERT_EQUAL(3, fired[1]);
+    TEST_ASSERT_FALSE(wheel.pending(a));
+    TEST_ASSERT_FALSE(wheel.cancel(a));
+}
+
+void test_due_timers_and_rescheduling_callbacks() {
+    TimerWheel wheel(8, 500);
+    // At or before now: fires on the next advance, even without a tick
+    wheel.schedule(500, 1);
+    wheel.schedule(100, 2);
+    TEST_ASSERT_EQUAL(2, wheel.advance(500, nullptr));
+
+    // A periodic timer re-arming itself from its callback
+    std::vector<uint32_t> ticks;
+    TimerWheel::FireFunc periodic = [&](TimerWheel::TimerId, uint32_t period) {
+        ticks.push_back(wheel.now());
+        wheel.schedule(wheel.now() + period, period);
+    };
+    wheel.schedule(600, 100);
+    wheel.advance(1000, periodic);
+    TEST_ASSERT_EQUAL(5, ticks.size());
+    TEST_ASSERT_EQUAL_UINT32(1000, ticks.back());
+    TEST_ASSERT_EQUAL(1, wheel.size());
+
+    // Time going backwards fires nothing and does not move the clock
+    TEST_ASSERT_EQUAL(0, wheel.advance(900, periodic));
+    TEST_ASSERT_EQUAL_UINT32(1000, wheel.now());
+
+    wheel.reset(50);
+    TEST_ASSERT_EQUAL(0, wheel.size());
+    TEST_ASSERT_EQUAL(0, wheel.advance(5000, periodic));
+    TEST_ASSERT_EQUAL_UINT32(5000, wheel.now());
+}
+
+// Schedule + cancel and schedule + fire cost per timer with 100 and with
+// 60000 timers pending: the same, since neither walks the pending timers
+void test_timer_wheel_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int OPS = 200000;
+    char msg[200];
+
+    for (size_t pendingCount : {static_cast<size_t>(100), static_cast<size_t>(60000)}) {
+        TimerWheel wheel(pendingCount + 16, 0);
+        std::mt19937 random(1);
+        for (size_t i = 0; i < pendingCount; i++) {
+            wheel.schedule(1000000 + random() % 10000000, 0);
+        }
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < OPS; i++) {
+            wheel.cancel(wheel.schedule(wheel.now() + 1 + random() % 500000, i));
+        }
+        double scheduleCancelNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / OPS;
+
+        // One timer per tick for OPS ticks; the pending ones expire later
+        size_t fired = 0;
+        start = Clock::now();
+        for (int i = 0; i < OPS; i++) {
+            wheel.schedule(wheel.now() + 1, i);
+            fired += wheel.advance(wheel.now() + 1, nullptr);
+        }
+        double fireNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / OPS;
+
+        snprintf(msg, sizeof(msg), "%u timers pending: schedule+cancel %.0f ns, schedule+tick+fire %.0f ns",
+                 static_cast<unsigned>(pendingCount), scheduleCancelNs, fireNs);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL(OPS, fired);
+        TEST_ASSERT_EQUAL(pendingCount, wheel.size());
+    }
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fires_exactly_at_expiry);
+    RUN_TEST(test_matches_reference_model);
+    RUN_TEST(test_cancel_and_stale_handles);
+    RUN_TEST(test_due_timers_and_rescheduling_callbacks);
+    RUN_TEST(test_timer_wheel_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,135 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "ToolHandlers.h"
+#include "AllocTracker.h"
+#include <cstdio>
+#include <functional>
+#include <memory>
+
+using namespace mcp;
+
+// The handler shape used before ViewToolHandler: params and result by value
+class ByValueToolHandler {
+public:
+    using HandlerFunc = std::function<JsonDocument(JsonDocument)>;
+    explicit ByValueToolHandler(HandlerFunc func) : func_(func) {}
+    JsonDocument call(JsonDocument params) { return func_(params); }
+private:
+    HandlerFunc func_;
+};
+
+static const char* CALL_PARAMS =
+    "{\"temperature\":22,\"mode\":1,\"reason\":\"evening schedule\","
+    "\"zones\":[\"bedroom\",\"study\",\"hall\"],\"meta\":{\"source\":\"agent\",\"attempt\":1}}";
+
+void setUp(void) {
+    AllocTracker::getInstance().reset();
+}
+
+void tearDown(void) {
+}
+
+void test_view_handler_reads_params_and_writes_result() {
+    SimpleToolHandler handler([](JsonVariantConst params, JsonDocument& result) {
+        result["temperature"] = params["temperature"].as<int>();
+        result["zones"] = params["zones"].size();
+    });
+
+    JsonDocument params;
+    deserializeJson(params, CALL_PARAMS);
+    JsonDocument result;
+    handler.invoke(params.as<JsonVariantConst>(), result);
+
+    TEST_ASSERT_EQUAL(22, result["temperature"].as<int>());
+    TEST_ASSERT_EQUAL(3, result["zones"].as<int>());
+    // Params are untouched
+    TEST_ASSERT_EQUAL(5, params.size());
+}
+
+void test_view_handler_accepts_missing_params() {
+    SimpleToolHandler handler([](JsonVariantConst params, JsonDocument& result) {
+        result["hasParams"] = !params.isNull();
+        result["temperature"] = params["temperature"] | 25;
+    });
+
+    JsonDocument result;
+    handler.invoke(JsonVariantConst(), result);
+    TEST_ASSERT_FALSE(result["hasParams"].as<bool>());
+    TEST_ASSERT_EQUAL(25, result["temperature"].as<int>());
+}
+
+void test_view_handler_allocates_less_per_call() {
+    const int CALLS = 100;
+    JsonDocument params;
+    deserializeJson(params, CALL_PARAMS);
+
+    ByValueToolHandler byValue([](JsonDocument p) {
+        JsonDocument result;
+        result["temperature"] = p["temperature"].as<int>();
+        return result;
+    });
+    SimpleToolHandler byView([](JsonVariantConst p, JsonDocument& result) {
+        result["temperature"] = p["temperature"].as<int>();
+    });
+
+    uint32_t byValueAllocs;
+    uint32_t byValueBytes;
+    {
+        AllocScope scope("test.by_value");
+        for (int i = 0; i < CALLS; i++) {
+            JsonDocument result = byValue.call(params);
+            TEST_ASSERT_EQUAL(22, result["temperature"].as<int>());
+        }
+        byValueAllocs = scope.allocations();
+        byValueBytes = scope.bytes();
+    }
+
+    uint32_t byViewAllocs;
+    uint32_t byViewBytes;
+    {
+        AllocScope scope("test.by_view");
+        for (int i = 0; i < CALLS; i++) {
+            JsonDocument result;
+            byView.invoke(params.as<JsonVariantConst>(), result);
+            TEST_ASSERT_EQUAL(22, result["temperature"].as<int>());
+        }
+        byViewAllocs = scope.allocations();
+        byViewBytes = scope.bytes();
+    }
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "per tools/call: by value %.1f allocs / %.0f bytes, by view %.1f allocs / %.0f bytes",
+             byValueAllocs / (double)CALLS, byValueBytes / (double)CALLS,
+             byViewAllocs / (double)CALLS, byViewBytes / (double)CALLS);
+    TEST_MESSAGE(msg);
+
+    if (AllocTracker::isCompiledIn()) {
+        TEST_ASSERT_GREATER_THAN(0, byValueAllocs);
+        TEST_ASSERT_LESS_THAN(byValueAllocs, byViewAllocs);
+        TEST_ASSERT_LESS_THAN(byValueBytes, byViewBytes);
+    }
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_view_handler_reads_params_and_writes_result);
+    RUN_TEST(test_view_handler_accepts_missing_params);
+    RUN_TEST(test_view_handler_allocates_less_per_call);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,278 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "ToolRegistry.h"
+#include "McpDispatcher.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace mcp;
+
+static ToolDefinition makeTool(const char* name, int* calls = nullptr) {
+    ToolDefinition tool;
+    tool.name = name;
+    tool.description = std::string("Tool ") + name;
+    tool.params.push_back({"temperature", "integer", "Temperature value", true});
+    tool.params.push_back({"note", "string", "Free text", false});
+    tool.handler = std::make_shared<SimpleToolHandler>([calls](JsonVariantConst params, JsonDocument& result) {
+        if (calls) {
+            (*calls)++;
+        }
+        result["echo"] = params["temperature"].as<int>();
+    });
+    return tool;
+}
+
+static std::string request(McpDispatcher& dispatcher, const std::string& body, int expectedStatus = 200) {
+    McpResponse response = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(expectedStatus, response.status);
+    return response.body;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_tools_list_is_rendered_once() {
+    ToolRegistry registry;
+    registry.addTool(makeTool("setTemperature"));
+    registry.addTool(makeTool("getStatus"));
+
+    std::shared_ptr<const ToolsListCache> first = registry.toolsList();
+    std::shared_ptr<const ToolsListCache> second = registry.toolsList();
+    TEST_ASSERT_TRUE(first.get() == second.get());
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, first->body));
+    TEST_ASSERT_EQUAL(2, doc["tools"].size());
+    TEST_ASSERT_EQUAL_STRING("setTemperature", doc["tools"][0]["name"].as<const char*>());
+    JsonVariantConst schema = doc["tools"][0]["inputSchema"];
+    TEST_ASSERT_EQUAL_STRING("object", schema["type"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("integer", schema["properties"]["temperature"]["type"].as<const char*>());
+    TEST_ASSERT_EQUAL(1, schema["required"].size());
+    TEST_ASSERT_EQUAL_STRING("temperature", schema["required"][0].as<const char*>());
+}
+
+void test_read_only_tools() {
+    ToolRegistry registry;
+    ToolDefinition status = makeTool("getStatus");
+    status.readOnly = true;
+    registry.addTool(std::move(status));
+    registry.addTool(makeTool("setTemperature"));
+
+    TEST_ASSERT_TRUE(registry.isReadOnly("getStatus"));
+    TEST_ASSERT_FALSE(registry.isReadOnly("setTemperature"));
+    TEST_ASSERT_FALSE(registry.isReadOnly("missing"));
+    TEST_ASSERT_FALSE(registry.isReadOnly(nullptr));
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, registry.toolsList()->body));
+    TEST_ASSERT_TRUE(doc["tools"][0]["annotations"]["readOnlyHint"].as<bool>());
+    TEST_ASSERT_TRUE(doc["tools"][1]["annotations"].isNull());
+}
+
+void test_coalesce_key() {
+    ToolRegistry registry;
+    ToolDefinition setTemperature = makeTool("setTemperature");
+    setTemperature.coalesceParam = "temperature";
+    registry.addTool(std::move(setTemperature));
+    registry.addTool(makeTool("turnOn"));
+
+    JsonDocument a;
+    deserializeJson(a, "{\"temperature\":20,\"note\":\"x\"}");
+    JsonDocument b;
+    deserializeJson(b, "{\"temperature\":25,\"note\":\"x\"}");
+    JsonDocument c;
+    deserializeJson(c, "{\"temperature\":25,\"note\":\"y\"}");
+    JsonDocument invalid;
+    deserializeJson(invalid, "{\"temperature\":\"warm\"}");
+
+    std::string key = registry.coalesceKey("setTemperature", a.as<JsonVariantConst>());
+    TEST_ASSERT_FALSE(key.empty());
+    TEST_ASSERT_EQUAL_STRING(key.c_str(), registry.coalesceKey("setTemperature", b.as<JsonVariantConst>()).c_str());
+    TEST_ASSERT_TRUE(key != registry.coalesceKey("setTemperature", c.as<JsonVariantConst>()));
+    TEST_ASSERT_TRUE(registry.coalesceKey("setTemperature", invalid.as<JsonVariantConst>()).empty());
+    TEST_ASSERT_TRUE(registry.coalesceKey("turnOn", a.as<JsonVariantConst>()).empty());
+    TEST_ASSERT_TRUE(registry.coalesceKey("missing", a.as<JsonVariantConst>()).empty());
+}
+
+void test_tools_list_invalidated_on_change() {
+    ToolRegistry registry;
+    registry.addTool(makeTool("turnOn"));
+    std::shared_ptr<const ToolsListCache> before = registry.toolsList();
+    uint32_t revision = registry.revision();
+
+    registry.addTool(makeTool("turnOff"));
+    std::shared_ptr<const ToolsListCache> added = registry.toolsList();
+    TEST_ASSERT_TRUE(before.get() != added.get());
+    TEST_ASSERT_TRUE(before->etag != added->etag);
+    TEST_ASSERT_GREATER_THAN(revision, registry.revision());
+
+    TEST_ASSERT_TRUE(registry.removeTool("turnOff"));
+    TEST_ASSERT_FALSE(registry.removeTool("turnOff"));
+    std::shared_ptr<const ToolsListCache> removed = registry.toolsList();
+    TEST_ASSERT_TRUE(before->body == removed->body);
+    TEST_ASSERT_TRUE(before->etag == removed->etag);
+
+    // A snapshot handed out earlier stays valid
+    TEST_ASSERT_TRUE(added->body.find("turnOff") != std::string::npos);
+}
+
+void test_add_replaces_tool_with_same_name() {
+    ToolRegistry registry;
+    registry.addTool(makeTool("getStatus"));
+    ToolDefinition replacement = makeTool("getStatus");
+    replacement.description = "Replaced";
+    registry.addTool(replacement);
+
+    TEST_ASSERT_EQUAL(1, registry.size());
+    TEST_ASSERT_TRUE(registry.toolsList()->body.find("Replaced") != std::string::npos);
+}
+
+void test_dispatch_tools_list_carries_etag() {
+    ToolRegistry registry;
+    registry.addTool(makeTool("setTemperature"));
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    std::string body = "{\"jsonrpc\":\"2.0\",\"id\":\"abc\",\"method\":\"tools/list\"}";
+    McpResponse response = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(200, response.status);
+    TEST_ASSERT_TRUE(response.etag == registry.toolsList()->etag);
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, response.body));
+    TEST_ASSERT_EQUAL_STRING("abc", doc["id"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("setTemperature", doc["result"]["tools"][0]["name"].as<const char*>());
+
+    // A JSON-RPC request is always answered in full; only GET /mcp/tools
+    // is conditional
+    McpResponse again = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(200, again.status);
+    TEST_ASSERT_TRUE(again.body == response.body);
+
+    registry.addTool(makeTool("getStatus"));
+    McpResponse changed = dispatcher.handle(body.c_str(), body.size());
+    TEST_ASSERT_EQUAL(200, changed.status);
+    TEST_ASSERT_FALSE(changed.etag == response.etag);
+}
+
+void test_dispatch_tools_call() {
+    int calls = 0;
+    ToolRegistry registry;
+    registry.addTool(makeTool("setTemperature", &calls));
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    std::string body = request(dispatcher,
+        "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"tools/call\","
+        "\"params\":{\"name\":\"setTemperature\",\"arguments\":{\"temperature\":23}}}");
+    JsonDocument doc;
+    deserializeJson(doc, body);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(7, doc["id"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("text", doc["result"]["content"][0]["type"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("{\"echo\":23}", doc["result"]["content"][0]["text"].as<const char*>());
+
+    body = request(dispatcher,
+        "{\"jsonrpc\":\"2.0\",\"id\":8,\"method\":\"tools/call\",\"params\":{\"name\":\"missing\"}}");
+    deserializeJson(doc, body);
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_PARAMS, doc["error"]["code"].as<int>());
+}
+
+void test_dispatch_protocol_errors() {
+    ToolRegistry registry;
+    McpDispatcher dispatcher(registry, "test", "1.0");
+    JsonDocument doc;
+
+    deserializeJson(doc, request(dispatcher, "{not json", 400));
+    TEST_ASSERT_EQUAL(McpDispatcher::PARSE_ERROR, doc["error"]["code"].as<int>());
+
+    deserializeJson(doc, request(dispatcher, "{\"jsonrpc\":\"2.0\",\"id\":1}", 400));
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_REQUEST, doc["error"]["code"].as<int>());
+
+    deserializeJson(doc, request(dispatcher, "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"nope\"}"));
+    TEST_ASSERT_EQUAL(McpDispatcher::METHOD_NOT_FOUND, doc["error"]["code"].as<int>());
+
+    // Notifications are acknowledged without a body
+    TEST_ASSERT_TRUE(request(dispatcher, "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}", 202).empty());
+
+    deserializeJson(doc, request(dispatcher, "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"initialize\"}"));
+    TEST_ASSERT_EQUAL_STRING(McpDispatcher::PROTOCOL_VERSION, doc["result"]["protocolVersion"].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("test", doc["result"]["serverInfo"]["name"].as<const char*>());
+}
+
+// Clients polling tools/list: re-render every time vs cached payload vs 304
+void test_tools_list_polling_benchmark() {
+    const int POLLS = 2000;
+    using Clock = std::chrono::steady_clock;
+
+    ToolRegistry registry;
+    const char* names[] = {"turnOn", "turnOff", "setMode", "setTemperature", "getStatus"};
+    for (const char* name : names) {
+        registry.addTool(makeTool(name));
+    }
+    McpDispatcher dispatcher(registry, "test", "1.0");
+    std::string body = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/list\"}";
+    size_t sink = 0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < POLLS; i++) {
+        registry.removeTool("getStatus");   // Force a re-render each poll
+        registry.addTool(makeTool("getStatus"));
+        sink += dispatcher.handle(body.c_str(), body.size()).body.size();
+    }
+    double renderUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / POLLS;
+
+    start = Clock::now();
+    for (int i = 0; i < POLLS; i++) {
+        sink += dispatcher.handle(body.c_str(), body.size()).body.size();
+    }
+    double cachedUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / POLLS;
+
+    std::string etag = registry.toolsList()->etag;
+    start = Clock::now();
+    for (int i = 0; i < POLLS; i++) {
+        // What GET /mcp/tools does before answering 304
+        sink += registry.toolsList()->etag == etag;
+    }
+    double notModifiedUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / POLLS;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "tools/list: re-render %.1f us, cached %.1f us, 304 %.1f us",
+             renderUs, cachedUs, notModifiedUs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(0, sink);
+    TEST_ASSERT_LESS_THAN(renderUs, cachedUs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_tools_list_is_rendered_once);
+    RUN_TEST(test_read_only_tools);
+    RUN_TEST(test_coalesce_key);
+    RUN_TEST(test_tools_list_invalidated_on_change);
+    RUN_TEST(test_add_replaces_tool_with_same_name);
+    RUN_TEST(test_dispatch_tools_list_carries_etag);
+    RUN_TEST(test_dispatch_tools_call);
+    RUN_TEST(test_dispatch_protocol_errors);
+    RUN_TEST(test_tools_list_polling_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
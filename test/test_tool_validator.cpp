@@ -0,0 +1,237 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "McpDispatcher.h"
+#include "ToolRegistry.h"
+#include "ToolValidator.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mcp;
+
+static std::vector<ToolParam> temperatureParams() {
+    std::vector<ToolParam> params;
+    params.push_back({"temperature", "integer", "Temperature value", true, true, 16, 30});
+    params.push_back({"note", "string", "Free text", false});
+    return params;
+}
+
+static ToolDefinition makeTool(const char* name, int* calls) {
+    ToolDefinition tool;
+    tool.name = name;
+    tool.description = std::string("Tool ") + name;
+    tool.params = temperatureParams();
+    tool.handler = std::make_shared<SimpleToolHandler>([calls](JsonVariantConst params, JsonDocument& result) {
+        (*calls)++;
+        result["echo"] = params["temperature"].as<int>();
+    });
+    return tool;
+}
+
+static bool check(const ToolValidator& validator, const char* arguments, std::string& error) {
+    JsonDocument doc;
+    if (arguments) {
+        TEST_ASSERT_FALSE(deserializeJson(doc, arguments));
+    }
+    const char* message = validator.validate(doc.as<JsonVariantConst>());
+    error = message ? message : "";
+    return !message;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_compiles_flat_checks() {
+    ToolValidator validator = ToolValidator::compile(temperatureParams());
+    TEST_ASSERT_EQUAL(2, validator.checks().size());
+    const ToolValidator::FieldCheck& temperature = validator.checks()[0];
+    TEST_ASSERT_EQUAL_STRING("temperature", temperature.name.c_str());
+    TEST_ASSERT_TRUE(temperature.type == ToolValidator::FieldType::Integer);
+    TEST_ASSERT_TRUE(temperature.required && temperature.bounded);
+    TEST_ASSERT_TRUE(validator.checks()[1].type == ToolValidator::FieldType::String);
+    TEST_ASSERT_TRUE(ToolValidator::parseType("uuid") == ToolValidator::FieldType::Any);
+}
+
+void test_accepts_matching_arguments() {
+    ToolValidator validator = ToolValidator::compile(temperatureParams());
+    std::string error;
+    TEST_ASSERT_TRUE(check(validator, "{\"temperature\":16}", error));
+    TEST_ASSERT_TRUE(check(validator, "{\"temperature\":30,\"note\":\"evening\"}", error));
+    // Arguments the schema does not declare are left to the handler
+    TEST_ASSERT_TRUE(check(validator, "{\"temperature\":22,\"extra\":[1,2]}", error));
+    TEST_ASSERT_TRUE(error.empty());
+
+    ToolValidator optional = ToolValidator::compile({{"ifNoneMatch", "string", "etag", false}});
+    TEST_ASSERT_TRUE(check(optional, nullptr, error));
+    TEST_ASSERT_TRUE(check(optional, "{}", error));
+}
+
+void test_rejects_mismatches() {
+    ToolValidator validator = ToolValidator::compile(temperatureParams());
+    std::string error;
+
+    TEST_ASSERT_FALSE(check(validator, nullptr, error));
+    TEST_ASSERT_EQUAL_STRING("missing required argument 'temperature'", error.c_str());
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":null}", error));
+    TEST_ASSERT_FALSE(check(validator, "[22]", error));
+    TEST_ASSERT_EQUAL_STRING("arguments must be an object", error.c_str());
+
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":\"22\"}", error));
+    TEST_ASSERT_EQUAL_STRING("argument 'temperature' must be an integer", error.c_str());
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":22.5}", error));
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":true}", error));
+
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":31}", error));
+    TEST_ASSERT_EQUAL_STRING("argument 'temperature' must be between 16 and 30", error.c_str());
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":-5}", error));
+
+    TEST_ASSERT_FALSE(check(validator, "{\"temperature\":20,\"note\":7}", error));
+    TEST_ASSERT_EQUAL_STRING("argument 'note' must be a string", error.c_str());
+    // A wrong type is reported even when a required argument is also missing
+    TEST_ASSERT_FALSE(check(validator, "{\"note\":7}", error));
+    TEST_ASSERT_EQUAL_STRING("argument 'note' must be a string", error.c_str());
+    TEST_ASSERT_FALSE(check(validator, "{\"extra\":1,\"note\":\"x\"}", error));
+    TEST_ASSERT_EQUAL_STRING("missing required argument 'temperature'", error.c_str());
+}
+
+// Lookup goes through the name index, whatever order the schema and the
+// call list the arguments in
+void test_many_parameters() {
+    std::vector<ToolParam> params;
+    const char* names[] = {"zone", "fan", "mode", "swing", "temperature", "device", "eco"};
+    for (const char* name : names) {
+        params.push_back({name, "integer", name, true, true, 0, 9});
+    }
+    ToolValidator validator = ToolValidator::compile(params, "setAll: ");
+    std::string error;
+    TEST_ASSERT_TRUE(check(validator,
+        "{\"eco\":1,\"device\":2,\"temperature\":3,\"swing\":4,\"mode\":5,\"fan\":6,\"zone\":7}", error));
+    TEST_ASSERT_FALSE(check(validator,
+        "{\"eco\":1,\"device\":2,\"temperature\":3,\"swing\":4,\"fan\":6,\"zone\":7}", error));
+    TEST_ASSERT_EQUAL_STRING("setAll: missing required argument 'mode'", error.c_str());
+    TEST_ASSERT_FALSE(check(validator, "{\"swing\":10}", error));
+    TEST_ASSERT_EQUAL_STRING("setAll: argument 'swing' must be between 0 and 9", error.c_str());
+    TEST_ASSERT_FALSE(check(validator, "7", error));
+    TEST_ASSERT_EQUAL_STRING("setAll: arguments must be an object", error.c_str());
+}
+
+void test_schema_advertises_range() {
+    ToolRegistry registry;
+    int calls = 0;
+    registry.addTool(makeTool("setTemperature", &calls));
+
+    JsonDocument doc;
+    deserializeJson(doc, registry.toolsList()->body);
+    JsonVariantConst temperature = doc["tools"][0]["inputSchema"]["properties"]["temperature"];
+    TEST_ASSERT_EQUAL(16, temperature["minimum"].as<int>());
+    TEST_ASSERT_EQUAL(30, temperature["maximum"].as<int>());
+    TEST_ASSERT_TRUE(doc["tools"][0]["inputSchema"]["properties"]["note"]["minimum"].isNull());
+}
+
+void test_invalid_call_never_reaches_handler() {
+    ToolRegistry registry;
+    int calls = 0;
+    registry.addTool(makeTool("setTemperature", &calls));
+    McpDispatcher dispatcher(registry, "test", "1.0");
+
+    std::string body =
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"setTemperature\"}}";
+    JsonDocument reply;
+    deserializeJson(reply, dispatcher.handle(body.c_str(), body.size()).text());
+    TEST_ASSERT_EQUAL(McpDispatcher::INVALID_PARAMS, reply["error"]["code"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("Invalid arguments for setTemperature: missing required argument 'temperature'",
+                             reply["error"]["message"].as<const char*>());
+    TEST_ASSERT_EQUAL(0, calls);
+
+    JsonDocument args;
+    deserializeJson(args, "{\"temperature\":45}");
+    JsonDocument result;
+    ToolRejection rejection;
+    TEST_ASSERT_FALSE(registry.callTool("setTemperature", args.as<JsonVariantConst>(), result, &rejection));
+    TEST_ASSERT_EQUAL_STRING("Invalid arguments for setTemperature: argument 'temperature' must be between 16 and 30",
+                             rejection.message);
+    // The message outlives a replacement of the tool
+    registry.addTool(makeTool("setTemperature", &calls));
+    TEST_ASSERT_EQUAL_STRING("Invalid arguments for setTemperature: argument 'temperature' must be between 16 and 30",
+                             rejection.message);
+
+    rejection = ToolRejection();
+    TEST_ASSERT_FALSE(registry.callTool("missing", args.as<JsonVariantConst>(), result, &rejection));
+    TEST_ASSERT_NULL(rejection.message);
+    body = "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"missing\"}}";
+    deserializeJson(reply, dispatcher.handle(body.c_str(), body.size()).text());
+    TEST_ASSERT_EQUAL_STRING("Unknown tool: missing", reply["error"]["message"].as<const char*>());
+    TEST_ASSERT_EQUAL(0, calls);
+
+    deserializeJson(args, "{\"temperature\":21}");
+    TEST_ASSERT_TRUE(registry.callTool("setTemperature", args.as<JsonVariantConst>(), result, &rejection));
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(21, result["echo"].as<int>());
+}
+
+// Cost of validating one call, for an accepted and a rejected argument set.
+// Rejections stop at the first failing check and return a prepared message.
+void test_validation_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int CALLS = 200000;
+
+    ToolValidator validator = ToolValidator::compile(temperatureParams());
+    JsonDocument valid;
+    deserializeJson(valid, "{\"temperature\":22,\"note\":\"evening\"}");
+    JsonDocument invalid;
+    deserializeJson(invalid, "{\"temperature\":45}");
+
+    int accepted = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        accepted += validator.validate(valid.as<JsonVariantConst>()) ? 0 : 1;
+    }
+    double validNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / CALLS;
+
+    int rejected = 0;
+    start = Clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        rejected += validator.validate(invalid.as<JsonVariantConst>()) ? 1 : 0;
+    }
+    double invalidNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / CALLS;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "validate (%u checks): %.0f ns accepted, %.0f ns rejected",
+             static_cast<unsigned>(validator.checks().size()), validNs, invalidNs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(CALLS, accepted);
+    TEST_ASSERT_EQUAL(CALLS, rejected);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_compiles_flat_checks);
+    RUN_TEST(test_accepts_matching_arguments);
+    RUN_TEST(test_rejects_mismatches);
+    RUN_TEST(test_many_parameters);
+    RUN_TEST(test_schema_advertises_range);
+    RUN_TEST(test_invalid_call_never_reaches_handler);
+    RUN_TEST(test_validation_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,560 @@
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "McpDispatcher.h"
+#include "ToolRegistry.h"
+#include "ToolWorker.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+// Blocks the "slow" tool until released, so tests can hold the worker busy
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool open = true;
+    int entered = 0;
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = false;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        changed.notify_all();
+    }
+
+    void pass() {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered++;
+        changed.notify_all();
+        changed.wait(lock, [this] { return open; });
+    }
+
+    void waitEntered(int count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this, count] { return entered >= count; });
+    }
+};
+
+// Collects completions, which arrive on the worker thread
+struct Replies {
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::vector<McpResponse> responses;
+    std::vector<std::thread::id> threads;
+
+    ToolWorker::Completion completion() {
+        return [this](McpResponse&& response) {
+            std::lock_guard<std::mutex> lock(mutex);
+            responses.push_back(std::move(response));
+            threads.push_back(std::this_thread::get_id());
+            arrived.notify_all();
+        };
+    }
+
+    bool waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return arrived.wait_for(lock, std::chrono::seconds(5), [this, count] { return responses.size() >= count; });
+    }
+};
+
+struct Fixture {
+    ToolRegistry registry;
+    McpDispatcher dispatcher{registry, "test", "1.0"};
+    Gate gate;
+    std::chrono::microseconds slowCost{0};
+    std::vector<int> order;
+
+    Fixture() {
+        add("record", [this](JsonVariantConst params, JsonDocument& result) {
+            order.push_back(params["n"] | -1);
+            result["n"] = params["n"];
+        });
+        add("slow", [this](JsonVariantConst, JsonDocument& result) {
+            gate.pass();
+            if (slowCost.count() > 0) {
+                std::this_thread::sleep_for(slowCost);
+            }
+            result["done"] = true;
+        });
+        add("peek", [this](JsonVariantConst params, JsonDocument& result) {
+            order.push_back(params["n"] | -1);
+            result["n"] = params["n"];
+        }, true);
+
+        // Last write wins per target, like setTemperature per unit
+        ToolDefinition set;
+        set.name = "set";
+        set.description = "set";
+        set.params.push_back({"n", "integer", "Value", true, true, 0, 100});
+        set.params.push_back({"target", "string", "Target", false});
+        set.coalesceParam = "n";
+        set.handler = std::make_shared<SimpleToolHandler>([this](JsonVariantConst params, JsonDocument& result) {
+            order.push_back(params["n"] | -1);
+            result["n"] = params["n"];
+            result["target"] = params["target"] | "";
+        });
+        registry.addTool(std::move(set));
+    }
+
+    void add(const char* name, SimpleToolHandler::HandlerFunc func, bool readOnly = false) {
+        ToolDefinition tool;
+        tool.name = name;
+        tool.description = name;
+        tool.readOnly = readOnly;
+        tool.handler = std::make_shared<SimpleToolHandler>(std::move(func));
+        registry.addTool(std::move(tool));
+    }
+};
+
+static JsonDocument request(int id, const char* tool, int n = 0) {
+    JsonDocument doc;
+    doc["jsonrpc"] = "2.0";
+    doc["id"] = id;
+    doc["method"] = "tools/call";
+    doc["params"]["name"] = tool;
+    doc["params"]["arguments"]["n"] = n;
+    return doc;
+}
+
+static JsonDocument setRequest(int id, int n, const char* target = nullptr) {
+    JsonDocument doc = request(id, "set", n);
+    if (target) {
+        doc["params"]["arguments"]["target"] = target;
+    }
+    return doc;
+}
+
+static JsonDocument parse(const char* json) {
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    return doc;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_calls_run_on_worker_in_order() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    const int COUNT = 6;
+    Replies replies;
+    for (int i = 0; i < COUNT; i++) {
+        TEST_ASSERT_TRUE(worker.submit(request(i, "record", i), replies.completion()));
+    }
+    TEST_ASSERT_TRUE(replies.waitFor(COUNT));
+    worker.stop();
+
+    for (int i = 0; i < COUNT; i++) {
+        TEST_ASSERT_EQUAL(i, fixture.order[i]);
+        TEST_ASSERT_EQUAL(200, replies.responses[i].status);
+        JsonDocument reply;
+        TEST_ASSERT_FALSE(deserializeJson(reply, replies.responses[i].body));
+        TEST_ASSERT_EQUAL(i, reply["id"].as<int>());
+        TEST_ASSERT_TRUE(replies.threads[i] != std::this_thread::get_id());
+    }
+
+    ToolWorker::Stats stats = worker.getStats();
+    TEST_ASSERT_EQUAL(COUNT, stats.submitted);
+    TEST_ASSERT_EQUAL(COUNT, stats.executed);
+    TEST_ASSERT_EQUAL(0, stats.rejected);
+    TEST_ASSERT_EQUAL(0, stats.depth);
+}
+
+void test_has_tool_calls() {
+    JsonDocument call = request(1, "record");
+    TEST_ASSERT_TRUE(McpDispatcher::hasToolCalls(call));
+
+    JsonDocument list = parse("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/list\"}");
+    TEST_ASSERT_FALSE(McpDispatcher::hasToolCalls(list));
+
+    JsonDocument batch = parse("[{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"ping\"},"
+                               "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"record\"}}]");
+    TEST_ASSERT_TRUE(McpDispatcher::hasToolCalls(batch));
+
+    JsonDocument pings = parse("[{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"ping\"}]");
+    TEST_ASSERT_FALSE(McpDispatcher::hasToolCalls(pings));
+}
+
+void test_reads_only() {
+    Fixture fixture;
+    JsonDocument peek = request(1, "peek");
+    TEST_ASSERT_TRUE(fixture.dispatcher.readsOnly(peek));
+    JsonDocument record = request(1, "record");
+    TEST_ASSERT_FALSE(fixture.dispatcher.readsOnly(record));
+    JsonDocument unknown = request(1, "missing");
+    TEST_ASSERT_FALSE(fixture.dispatcher.readsOnly(unknown));
+
+    JsonDocument reads = parse("[{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"ping\"},"
+                               "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"peek\"}}]");
+    TEST_ASSERT_TRUE(fixture.dispatcher.readsOnly(reads));
+    JsonDocument mixed = parse("[{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"peek\"}},"
+                               "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"record\"}}]");
+    TEST_ASSERT_FALSE(fixture.dispatcher.readsOnly(mixed));
+}
+
+// A command submitted behind a burst of status reads runs before them
+void test_control_calls_overtake_status_reads() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher, 4);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    fixture.gate.close();
+    TEST_ASSERT_TRUE(worker.submit(request(0, "slow"), replies.completion()));
+    fixture.gate.waitEntered(1);
+    for (int i = 1; i <= 4; i++) {
+        TEST_ASSERT_TRUE(worker.submit(request(i, "peek", i), replies.completion()));
+    }
+    // The status lane is full, the control lane is not
+    TEST_ASSERT_FALSE(worker.submit(request(5, "peek", 5), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(request(6, "record", 6), replies.completion()));
+
+    TEST_ASSERT_EQUAL(1, worker.laneStats(ToolWorker::CONTROL_LANE).depth);
+    TEST_ASSERT_EQUAL(4, worker.laneStats(ToolWorker::STATUS_LANE).depth);
+    fixture.gate.release();
+    TEST_ASSERT_TRUE(replies.waitFor(6));
+    worker.stop();
+
+    int expected[] = {6, 1, 2, 3, 4};
+    TEST_ASSERT_EQUAL(5, fixture.order.size());
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(expected[i], fixture.order[i]);
+    }
+    TEST_ASSERT_EQUAL(1, worker.laneStats(ToolWorker::STATUS_LANE).rejected);
+    TEST_ASSERT_EQUAL(1, worker.getStats().rejected);
+}
+
+void test_full_queue_rejects() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher, 2);
+    TEST_ASSERT_FALSE(worker.submit(request(0, "record"), [](McpResponse&&) {}));   // Not started
+
+    TEST_ASSERT_TRUE(worker.start());
+    Replies replies;
+    fixture.gate.close();
+    TEST_ASSERT_TRUE(worker.submit(request(1, "slow"), replies.completion()));
+    fixture.gate.waitEntered(1);   // Worker busy, queue empty
+
+    TEST_ASSERT_TRUE(worker.submit(request(2, "record", 2), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(request(3, "record", 3), replies.completion()));
+    TEST_ASSERT_FALSE(worker.submit(request(4, "record", 4), replies.completion()));
+
+    fixture.gate.release();
+    TEST_ASSERT_TRUE(replies.waitFor(3));
+    worker.stop();
+
+    ToolWorker::Stats stats = worker.getStats();
+    TEST_ASSERT_EQUAL(3, stats.submitted);
+    TEST_ASSERT_EQUAL(1, stats.rejected);
+    TEST_ASSERT_EQUAL(3, stats.executed);
+    TEST_ASSERT_EQUAL(2, stats.highWater);
+}
+
+void test_stop_answers_queued_jobs() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    fixture.gate.close();
+    TEST_ASSERT_TRUE(worker.submit(request(1, "slow"), replies.completion()));
+    fixture.gate.waitEntered(1);
+    TEST_ASSERT_TRUE(worker.submit(request(2, "record", 2), replies.completion()));
+
+    std::thread releaser([&fixture] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        fixture.gate.release();
+    });
+    worker.stop();
+    releaser.join();
+
+    // The running job finishes; the queued one is answered without running
+    TEST_ASSERT_TRUE(replies.waitFor(2));
+    TEST_ASSERT_EQUAL(200, replies.responses[0].status);
+    TEST_ASSERT_EQUAL(503, replies.responses[1].status);
+    TEST_ASSERT_EQUAL(0, fixture.order.size());
+    TEST_ASSERT_FALSE(worker.submit(request(3, "record"), replies.completion()));
+}
+
+// A sweep queued behind a busy worker runs once; every caller gets the
+// final result under its own id
+void test_superseded_calls_coalesce() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    fixture.gate.close();
+    TEST_ASSERT_TRUE(worker.submit(request(0, "slow"), replies.completion()));
+    fixture.gate.waitEntered(1);
+    for (int i = 1; i <= 5; i++) {
+        TEST_ASSERT_TRUE(worker.submit(setRequest(i, 20 + i), replies.completion()));
+    }
+    TEST_ASSERT_EQUAL(1, worker.laneStats(ToolWorker::CONTROL_LANE).depth);
+    fixture.gate.release();
+    TEST_ASSERT_TRUE(replies.waitFor(6));
+    worker.stop();
+
+    TEST_ASSERT_EQUAL(1, fixture.order.size());
+    TEST_ASSERT_EQUAL(25, fixture.order[0]);
+    for (int i = 1; i <= 5; i++) {
+        TEST_ASSERT_EQUAL(200, replies.responses[i].status);
+        JsonDocument reply;
+        TEST_ASSERT_FALSE(deserializeJson(reply, replies.responses[i].text()));
+        TEST_ASSERT_EQUAL_STRING("2.0", reply["jsonrpc"]);
+        TEST_ASSERT_EQUAL(i, reply["id"].as<int>());   // Oldest caller first
+        TEST_ASSERT_EQUAL_STRING("{\"n\":25,\"target\":\"\"}", reply["result"]["content"][0]["text"]);
+    }
+
+    ToolWorker::Stats stats = worker.getStats();
+    TEST_ASSERT_EQUAL(6, stats.submitted);
+    TEST_ASSERT_EQUAL(2, stats.executed);
+    TEST_ASSERT_EQUAL(4, stats.coalesced);
+}
+
+// Calls only move past other coalescing calls, and only merge with the
+// same target and valid arguments
+void test_coalescing_keeps_order() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    fixture.gate.close();
+    TEST_ASSERT_TRUE(worker.submit(request(0, "slow"), replies.completion()));
+    fixture.gate.waitEntered(1);
+    TEST_ASSERT_TRUE(worker.submit(setRequest(1, 1, "a"), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(request(2, "record", 50), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(setRequest(3, 2, "a"), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(setRequest(4, 7, "b"), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(setRequest(5, 3, "a"), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(setRequest(6, 400, "b"), replies.completion()));   // Out of range
+    TEST_ASSERT_TRUE(worker.submit(setRequest(7, 8, "b"), replies.completion()));
+    fixture.gate.release();
+    TEST_ASSERT_TRUE(replies.waitFor(8));
+    worker.stop();
+
+    // a1 stays ahead of record; a2 gives way to a3, which passes b7
+    int expected[] = {1, 50, 7, 3, 8};
+    TEST_ASSERT_EQUAL(5, fixture.order.size());
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(expected[i], fixture.order[i]);
+    }
+    TEST_ASSERT_EQUAL(1, worker.getStats().coalesced);
+
+    for (size_t i = 1; i < replies.responses.size(); i++) {
+        JsonDocument reply;
+        TEST_ASSERT_FALSE(deserializeJson(reply, replies.responses[i].text()));
+        int id = reply["id"];
+        if (id == 3 || id == 5) {
+            TEST_ASSERT_EQUAL_STRING("{\"n\":3,\"target\":\"a\"}", reply["result"]["content"][0]["text"]);
+        }
+        if (id == 6) {
+            TEST_ASSERT_FALSE(reply["error"].isNull());
+        }
+    }
+}
+
+void test_stop_answers_superseded_callers() {
+    Fixture fixture;
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    fixture.gate.close();
+    TEST_ASSERT_TRUE(worker.submit(request(0, "slow"), replies.completion()));
+    fixture.gate.waitEntered(1);
+    TEST_ASSERT_TRUE(worker.submit(setRequest(1, 1), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(setRequest(2, 2), replies.completion()));
+
+    std::thread releaser([&fixture] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        fixture.gate.release();
+    });
+    worker.stop();
+    releaser.join();
+
+    TEST_ASSERT_TRUE(replies.waitFor(3));
+    TEST_ASSERT_EQUAL(503, replies.responses[1].status);
+    TEST_ASSERT_EQUAL(503, replies.responses[2].status);
+}
+
+void test_execution_sink() {
+    Fixture fixture;
+    fixture.slowCost = std::chrono::milliseconds(2);
+    ToolWorker worker(fixture.dispatcher);
+
+    std::mutex mutex;
+    std::vector<uint32_t> samples;
+    worker.setExecutionSink([&](uint32_t executionUs, size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        samples.push_back(executionUs);
+    });
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    TEST_ASSERT_TRUE(worker.submit(request(1, "slow"), replies.completion()));
+    TEST_ASSERT_TRUE(worker.submit(request(2, "record"), replies.completion()));
+    TEST_ASSERT_TRUE(replies.waitFor(2));
+    worker.stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    TEST_ASSERT_EQUAL(2, samples.size());
+    TEST_ASSERT_GREATER_OR_EQUAL(2000, samples[0]);
+
+    ToolWorker::Stats stats = worker.getStats();
+    TEST_ASSERT_GREATER_OR_EQUAL(2000, stats.execMaxUs);
+    TEST_ASSERT_GREATER_OR_EQUAL(samples[0] + samples[1], stats.execTotalUs);
+}
+
+void test_arenas_released_after_jobs() {
+    Fixture fixture;
+    JsonArenaPool pool(4, 2048);
+    fixture.dispatcher.setArenaPool(&pool);
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    for (int i = 0; i < 3; i++) {
+        // Parsed into an arena on the "network thread", as McpEndpoint does
+        JsonArenaPool::Lease arena = fixture.dispatcher.acquireArena();
+        JsonDocument parsed(arena.allocator());
+        std::string body;
+        serializeJson(request(i, "record", i), body);
+        TEST_ASSERT_FALSE(deserializeJson(parsed, body));
+        TEST_ASSERT_TRUE(worker.submit(std::move(parsed), replies.completion(), std::move(arena)));
+    }
+    TEST_ASSERT_TRUE(replies.waitFor(3));
+    worker.stop();
+
+    JsonArenaPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL(4, stats.available);
+    TEST_ASSERT_EQUAL(3, stats.acquired + stats.exhausted);   // Replies share the request's arena
+    TEST_ASSERT_EQUAL(0, stats.overflows);
+    TEST_ASSERT_EQUAL(200, replies.responses[2].status);
+}
+
+// A streamed tools/call holds at most LEASES_PER_REQUEST arenas: its
+// request's, until the job ends, and its output's, until the reply is read
+void test_streamed_calls_lease_two_arenas() {
+    Fixture fixture;
+    const size_t JOBS = 3;
+    JsonArenaPool pool(JOBS * McpDispatcher::LEASES_PER_REQUEST, 2048);
+    fixture.dispatcher.setArenaPool(&pool);
+    fixture.dispatcher.setStreaming(true);
+    ToolWorker worker(fixture.dispatcher);
+    TEST_ASSERT_TRUE(worker.start());
+
+    Replies replies;
+    fixture.gate.close();
+    for (size_t i = 0; i < JOBS; i++) {
+        JsonArenaPool::Lease arena = fixture.dispatcher.acquireArena();
+        JsonDocument parsed(arena.allocator());
+        std::string body;
+        serializeJson(request(i, "slow"), body);
+        TEST_ASSERT_FALSE(deserializeJson(parsed, body));
+        TEST_ASSERT_TRUE(worker.submit(std::move(parsed), replies.completion(), std::move(arena)));
+    }
+    fixture.gate.waitEntered(1);
+    fixture.gate.release();
+    TEST_ASSERT_TRUE(replies.waitFor(JOBS));
+    worker.stop();
+
+    // Requests are done; the unread outputs still hold theirs
+    JsonArenaPool::Stats stats = pool.getStats();
+    TEST_ASSERT_EQUAL(JOBS * McpDispatcher::LEASES_PER_REQUEST, stats.acquired);
+    TEST_ASSERT_EQUAL(0, stats.exhausted);
+    TEST_ASSERT_EQUAL(JOBS, stats.available);
+    TEST_ASSERT_TRUE(replies.responses[0].stream != nullptr);
+    TEST_ASSERT_TRUE(replies.responses[0].text().find("done") != std::string::npos);
+
+    replies.responses.clear();
+    TEST_ASSERT_EQUAL(JOBS * McpDispatcher::LEASES_PER_REQUEST, pool.getStats().available);
+}
+
+// Time the "network thread" spends per request, inline vs handed off, with
+// a tool that takes 5 ms (e.g. an LCD refresh)
+void test_network_thread_benchmark() {
+    using Clock = std::chrono::steady_clock;
+    const int REQUESTS = 20;
+
+    Fixture fixture;
+    fixture.slowCost = std::chrono::milliseconds(5);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < REQUESTS; i++) {
+        JsonDocument doc = request(i, "slow");
+        McpResponse response = fixture.dispatcher.handle(doc, JsonArenaPool::Lease());
+        TEST_ASSERT_EQUAL(200, response.status);
+    }
+    double inlineUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    ToolWorker worker(fixture.dispatcher, REQUESTS);
+    TEST_ASSERT_TRUE(worker.start());
+    Replies replies;
+    start = Clock::now();
+    for (int i = 0; i < REQUESTS; i++) {
+        TEST_ASSERT_TRUE(worker.submit(request(i, "slow"), replies.completion()));
+    }
+    double handoffUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    TEST_ASSERT_TRUE(replies.waitFor(REQUESTS));
+    worker.stop();
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "network thread per request: inline %.0f us, worker hand-off %.1f us; worker exec avg %.0f us",
+             inlineUs / REQUESTS, handoffUs / REQUESTS,
+             static_cast<double>(worker.getStats().execTotalUs) / REQUESTS);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_LESS_THAN(inlineUs / 10, handoffUs);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_calls_run_on_worker_in_order);
+    RUN_TEST(test_has_tool_calls);
+    RUN_TEST(test_reads_only);
+    RUN_TEST(test_control_calls_overtake_status_reads);
+    RUN_TEST(test_full_queue_rejects);
+    RUN_TEST(test_stop_answers_queued_jobs);
+    RUN_TEST(test_superseded_calls_coalesce);
+    RUN_TEST(test_coalescing_keeps_order);
+    RUN_TEST(test_stop_answers_superseded_callers);
+    RUN_TEST(test_execution_sink);
+    RUN_TEST(test_arenas_released_after_jobs);
+    RUN_TEST(test_streamed_calls_lease_two_arenas);
+    RUN_TEST(test_network_thread_benchmark);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif